@@ -0,0 +1,917 @@
+#include "analyzer.h"
+#include "macro.h"
+
+#include <optional>
+
+// Evaluates operands and passes them to the callback; few operands are kept
+// on the native stack, not on the heap
+template <typename Callback>
+static ObjectPtr WithEvaluatedArguments(const ObjectPtrVector& operands, ContextPtr context,
+                                        Callback callback) {
+    if (operands.size() <= kSmallArgumentsCount) {
+        std::array<ObjectPtr, kSmallArgumentsCount> arguments;
+        if (!EvaluateArguments(operands, context, arguments.data())) {
+            return kEscapeMarker;
+        }
+        return callback(ObjectPtrSpan(arguments.data(), operands.size()));
+    }
+    ObjectPtrVector arguments(operands.size());
+    if (!EvaluateArguments(operands, context, arguments.data())) {
+        return kEscapeMarker;
+    }
+    return callback(ObjectPtrSpan(arguments));
+}
+
+static uint64_t syntax_epoch = 0;
+
+uint64_t GetSyntaxEpoch() {
+    return syntax_epoch;
+}
+
+void AdvanceSyntaxEpoch() {
+    ++syntax_epoch;
+}
+
+// Forms are analyzed in the global context, so only top-level bindings change expansions
+static void TrackSyntaxRebinding(const std::string& name, ContextPtr context) {
+    if (context->IsGlobal() && Is<SyntaxRules>(context->Get(name))) {
+        AdvanceSyntaxEpoch();
+    }
+}
+
+// Evaluates a non-empty body, the value of the last expression is the result
+static ObjectPtr EvaluateBody(const ObjectPtrVector& body, ContextPtr context) {
+    for (size_t i = 0; i + 1 < body.size(); ++i) {
+        if (IsEscaping(EvaluateExpression(body[i], context))) {
+            return kEscapeMarker;
+        }
+    }
+    return EvaluateExpression(body.back(), context);
+}
+
+// Scope of the names bound inside of a form being analyzed (e.g. arguments of a lambda).
+// The names hide macros of the outer scopes, so that a local name is never expanded.
+// The scope is pushed onto the analyzed context and popped once the form is analyzed.
+class AnalysisScope {
+public:
+    explicit AnalysisScope(ContextPtr context) : context_(context) {
+        context_->AddEmptyScope();
+    }
+
+    AnalysisScope(const AnalysisScope&) = delete;
+    AnalysisScope& operator=(const AnalysisScope&) = delete;
+
+    ~AnalysisScope() {
+        context_->PopScope();
+    }
+
+    void Hide(const std::string& name) {
+        context_->Bind(name, kUnassignedMarker);
+    }
+
+    void Hide(const std::vector<std::string>& names) {
+        for (const std::string& name : names) {
+            Hide(name);
+        }
+    }
+
+    // Internal defines of a body hide macros in the whole body
+    ObjectPtrVector AnalyzeBody(const ObjectPtrVector& body) {
+        for (ObjectPtr form : body) {
+            if (const std::string* name = FindDefinedName(form)) {
+                Hide(*name);
+            }
+        }
+        return AnalyzeSequence(body, context_);
+    }
+
+private:
+    static const std::string* FindDefinedName(ObjectPtr form) {
+        auto cell = As<Cell>(form);
+        auto keyword = (cell) ? As<Symbol>(cell->GetFirst()) : nullptr;
+        if (!keyword || (keyword->GetName() != kDefineKeyword &&
+                         keyword->GetName() != kDefineMemoizedKeyword)) {
+            return nullptr;
+        }
+        auto rest = As<Cell>(cell->GetSecond());
+        ObjectPtr target = (rest) ? rest->GetFirst() : nullptr;
+        if (auto signature = As<Cell>(target)) {
+            target = signature->GetFirst();
+        }
+        auto symbol = As<Symbol>(target);
+        return (symbol) ? &symbol->GetName() : nullptr;
+    }
+
+    ContextPtr context_;
+};
+
+// Realization of syntax nodes
+
+IfNode::IfNode(ObjectPtr condition, ObjectPtr consequent)
+    : condition_(condition), consequent_(consequent) {
+    AddDependency(condition);
+    AddDependency(consequent);
+}
+
+IfNode::IfNode(ObjectPtr condition, ObjectPtr consequent, ObjectPtr alternative)
+    : condition_(condition),
+      consequent_(consequent),
+      alternative_(alternative),
+      has_alternative_(true) {
+    AddDependency(condition);
+    AddDependency(consequent);
+    AddDependency(alternative);
+}
+
+ObjectPtr IfNode::Evaluate(ContextPtr context) {
+    ObjectPtr condition = EvaluateExpression(condition_, context);
+    if (IsEscaping(condition)) {
+        return condition;
+    }
+    if (IsTruthy(condition)) {
+        return EvaluateExpression(consequent_, context);
+    }
+    return (has_alternative_) ? EvaluateExpression(alternative_, context) : nullptr;
+}
+
+ObjectPtr DefineNode::Evaluate(ContextPtr context) {
+    ObjectPtr value = EvaluateExpression(value_, context);
+    if (IsEscaping(value)) {
+        return value;
+    }
+    TrackSyntaxRebinding(name_, context);
+    context->Define(name_, value);
+    return nullptr;
+}
+
+ObjectPtr SetNode::Evaluate(ContextPtr context) {
+    if (!context->Contains(name_)) {
+        throw NameError("Variable for set must be defined before.");
+    }
+    ObjectPtr value = EvaluateExpression(value_, context);
+    if (IsEscaping(value)) {
+        return value;
+    }
+    TrackSyntaxRebinding(name_, context);
+    context->Change(name_, value);
+    return nullptr;
+}
+
+ObjectPtr DefineSyntaxNode::Evaluate(ContextPtr context) {
+    context->Define(name_, rules_);
+    // expansions of the forms analyzed later may change
+    if (context->IsGlobal()) {
+        AdvanceSyntaxEpoch();
+    }
+    return nullptr;
+}
+
+LambdaNode::LambdaNode(const ObjectPtrVector& args, const ObjectPtrVector& body, bool is_tiered)
+    : args_(args), body_(body), is_tiered_(is_tiered) {
+    for (ObjectPtr arg : args) {
+        AddDependency(arg);
+    }
+    for (ObjectPtr expression : body) {
+        AddDependency(expression);
+    }
+}
+
+ObjectPtr LambdaNode::Evaluate(ContextPtr context) {
+    // the native tier is guarded against rebinding in the global scope only
+    return Heap::Instance().Make<LambdaFunction>(args_, body_, context,
+                                                 is_tiered_ && context->IsGlobal());
+}
+
+AndNode::AndNode(const ObjectPtrVector& operands) : operands_(operands) {
+    for (ObjectPtr operand : operands) {
+        AddDependency(operand);
+    }
+}
+
+ObjectPtr AndNode::Evaluate(ContextPtr context) {
+    if (operands_.empty()) {
+        return kTrueSymbol;
+    }
+    ObjectPtr result = nullptr;
+    for (ObjectPtr operand : operands_) {
+        result = EvaluateExpression(operand, context);
+        if (IsEscaping(result) || !IsTruthy(result)) {
+            return result;
+        }
+    }
+    return result;
+}
+
+OrNode::OrNode(const ObjectPtrVector& operands) : operands_(operands) {
+    for (ObjectPtr operand : operands) {
+        AddDependency(operand);
+    }
+}
+
+ObjectPtr OrNode::Evaluate(ContextPtr context) {
+    if (operands_.empty()) {
+        return kFalseSymbol;
+    }
+    ObjectPtr result = nullptr;
+    for (ObjectPtr operand : operands_) {
+        result = EvaluateExpression(operand, context);
+        if (IsEscaping(result) || IsTruthy(result)) {
+            return result;
+        }
+    }
+    return result;
+}
+
+ApplicationNode::ApplicationNode(ObjectPtr function, const ObjectPtrVector& operands)
+    : function_(function), operands_(operands) {
+    AddDependency(function);
+    for (ObjectPtr operand : operands) {
+        AddDependency(operand);
+    }
+}
+
+ObjectPtr ApplicationNode::Evaluate(ContextPtr context) {
+    ObjectPtr function = EvaluateExpression(function_, context);
+    if (!function) {
+        throw RuntimeError("First element of pair must be applicable.");
+    } else if (IsEscaping(function)) {
+        return function;
+    }
+    return WithEvaluatedArguments(operands_, context, [function](ObjectPtrSpan arguments) {
+        return function->Apply(arguments);
+    });
+}
+
+BeginNode::BeginNode(const ObjectPtrVector& body) : body_(body) {
+    for (ObjectPtr expression : body) {
+        AddDependency(expression);
+    }
+}
+
+ObjectPtr BeginNode::Evaluate(ContextPtr context) {
+    return (body_.empty()) ? nullptr : EvaluateBody(body_, context);
+}
+
+CondArrowNode::CondArrowNode(ObjectPtr test, ObjectPtr receiver)
+    : test_(test), receiver_(receiver) {
+    AddDependency(test);
+    AddDependency(receiver);
+}
+
+CondArrowNode::CondArrowNode(ObjectPtr test, ObjectPtr receiver, ObjectPtr alternative)
+    : test_(test), receiver_(receiver), alternative_(alternative), has_alternative_(true) {
+    AddDependency(test);
+    AddDependency(receiver);
+    AddDependency(alternative);
+}
+
+ObjectPtr CondArrowNode::Evaluate(ContextPtr context) {
+    ObjectPtr value = EvaluateExpression(test_, context);
+    if (IsEscaping(value)) {
+        return value;
+    } else if (!IsTruthy(value)) {
+        return (has_alternative_) ? EvaluateExpression(alternative_, context) : nullptr;
+    }
+    ObjectPtr receiver = EvaluateExpression(receiver_, context);
+    if (!receiver) {
+        throw RuntimeError("Receiver of cond clause must be applicable.");
+    } else if (IsEscaping(receiver)) {
+        return receiver;
+    }
+    return receiver->Apply(ObjectPtrSpan(&value, 1));
+}
+
+CaseNode::CaseNode(ObjectPtr key, const std::vector<ObjectPtrVector>& data,
+                   const ObjectPtrVector& bodies)
+    : key_(key), data_(data), bodies_(bodies) {
+    BuildTables();
+}
+
+CaseNode::CaseNode(ObjectPtr key, const std::vector<ObjectPtrVector>& data,
+                   const ObjectPtrVector& bodies, ObjectPtr else_body)
+    : key_(key), data_(data), bodies_(bodies), else_body_(else_body), has_else_(true) {
+    BuildTables();
+}
+
+void CaseNode::BuildTables() {
+    AddDependency(key_);
+    if (has_else_) {
+        AddDependency(else_body_);
+    }
+    for (size_t i = 0; i < data_.size(); ++i) {
+        AddDependency(bodies_[i]);
+        for (ObjectPtr datum : data_[i]) {
+            AddDependency(datum);
+            // the first clause with the datum wins
+            if (auto number = As<Number>(datum)) {
+                fixnum_clauses_.emplace(number->GetValue(), i);
+            } else if (auto symbol = As<Symbol>(datum)) {
+                symbol_clauses_.emplace(symbol->GetName(), i);
+            } else {
+                other_clauses_.emplace_back(datum, i);
+            }
+        }
+    }
+    if (fixnum_clauses_.empty()) {
+        return;
+    }
+    auto [min, max] = std::minmax_element(
+        fixnum_clauses_.begin(), fixnum_clauses_.end(),
+        [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+    // compared as unsigned, so that the span of any two int64_t fits
+    uint64_t span = static_cast<uint64_t>(max->first) - static_cast<uint64_t>(min->first);
+    if (span >= static_cast<uint64_t>(kMaxJumpTableSize)) {
+        return;
+    }
+    jump_table_min_ = min->first;
+    jump_table_.assign(span + 1, bodies_.size());
+    for (const auto& [value, index] : fixnum_clauses_) {
+        jump_table_[value - jump_table_min_] = index;
+    }
+    fixnum_clauses_.clear();
+}
+
+ObjectPtr CaseNode::FindBody(ObjectPtr value) const {
+    size_t index = bodies_.size();
+    if (auto number = As<Number>(value)) {
+        uint64_t offset =
+            static_cast<uint64_t>(number->GetValue()) - static_cast<uint64_t>(jump_table_min_);
+        if (offset < jump_table_.size()) {
+            index = jump_table_[offset];
+        } else if (auto found = fixnum_clauses_.find(number->GetValue());
+                   found != fixnum_clauses_.end()) {
+            index = found->second;
+        }
+    } else if (auto symbol = As<Symbol>(value)) {
+        auto found = symbol_clauses_.find(symbol->GetName());
+        if (found != symbol_clauses_.end()) {
+            index = found->second;
+        }
+    } else {
+        for (const auto& [datum, clause_index] : other_clauses_) {
+            if (IsEqv(datum, value)) {
+                index = clause_index;
+                break;
+            }
+        }
+    }
+    if (index < bodies_.size()) {
+        return bodies_[index];
+    }
+    return (has_else_) ? else_body_ : nullptr;
+}
+
+ObjectPtr CaseNode::Evaluate(ContextPtr context) {
+    ObjectPtr value = EvaluateExpression(key_, context);
+    if (IsEscaping(value)) {
+        return value;
+    }
+    ObjectPtr body = FindBody(value);
+    return (body) ? EvaluateExpression(body, context) : nullptr;
+}
+
+LetNode::LetNode(LetKind kind, const std::vector<std::string>& names,
+                 const ObjectPtrVector& values, const ObjectPtrVector& body)
+    : kind_(kind), names_(names), values_(values), body_(body) {
+    for (ObjectPtr value : values) {
+        AddDependency(value);
+    }
+    for (ObjectPtr expression : body) {
+        AddDependency(expression);
+    }
+}
+
+ObjectPtr LetNode::Evaluate(ContextPtr context) {
+    if (kind_ != LetKind::LET) {
+        return EvaluateInScope({}, context);
+    }
+    return WithEvaluatedArguments(values_, context, [this, context](ObjectPtrSpan values) {
+        return EvaluateInScope(values, context);
+    });
+}
+
+ObjectPtr LetNode::EvaluateInScope(ObjectPtrSpan values, ContextPtr context) {
+    context->AddEmptyScope();
+    try {
+        if (kind_ == LetKind::LET) {
+            for (size_t i = 0; i < names_.size(); ++i) {
+                context->Define(names_[i], values[i]);
+            }
+        } else {
+            if (kind_ == LetKind::LETREC) {
+                for (const std::string& name : names_) {
+                    context->Bind(name, kUnassignedMarker);
+                }
+            }
+            for (size_t i = 0; i < names_.size(); ++i) {
+                ObjectPtr value = EvaluateExpression(values_[i], context);
+                if (IsEscaping(value)) {
+                    context->PopScope();
+                    return value;
+                }
+                context->Define(names_[i], value);
+            }
+        }
+        ObjectPtr result = EvaluateBody(body_, context);
+        context->PopScope();
+        return result;
+    } catch (...) {
+        context->PopScope();
+        throw;
+    }
+}
+
+LoopNode::LoopNode(const std::string& name, const ObjectPtrVector& args,
+                   const ObjectPtrVector& body)
+    : name_(name), args_(args), body_(body) {
+    for (ObjectPtr arg : args) {
+        AddDependency(arg);
+    }
+    for (ObjectPtr expression : body) {
+        AddDependency(expression);
+    }
+}
+
+ObjectPtr LoopNode::Evaluate(ContextPtr context) {
+    // evaluated in the scope of the loop function's arguments
+    ObjectPtr outer_function = active_function_;
+    active_function_ = context->Get(name_);
+    try {
+        ObjectPtr result = EvaluateBody(body_, context);
+        while (Is<TailCallNode>(result)) {
+            // closures may have captured the arguments of the previous iteration, otherwise
+            // the scope is reused, and the arguments are bound without copying
+            if (context->GetScopes().back()->IsCaptured()) {
+                context->PopScope();
+                context->AddEmptyScope();
+            } else {
+                context->GetScopes().back()->Clear();
+            }
+            for (size_t i = 0; i < args_.size(); ++i) {
+                context->Bind(As<Symbol>(args_[i])->GetName(), next_arguments_[i]);
+            }
+            result = EvaluateBody(body_, context);
+        }
+        active_function_ = outer_function;
+        return result;
+    } catch (...) {
+        active_function_ = outer_function;
+        throw;
+    }
+}
+
+NamedLetNode::NamedLetNode(const ObjectPtrVector& values, LoopNode* loop)
+    : values_(values), loop_(loop) {
+    for (ObjectPtr value : values) {
+        AddDependency(value);
+    }
+    AddDependency(loop);
+}
+
+ObjectPtr NamedLetNode::Evaluate(ContextPtr context) {
+    return WithEvaluatedArguments(values_, context, [this, context](ObjectPtrSpan values) {
+        return ApplyInScope(values, context);
+    });
+}
+
+ObjectPtr NamedLetNode::ApplyInScope(ObjectPtrSpan values, ContextPtr context) {
+    // the loop function sees its own name
+    context->AddEmptyScope();
+    try {
+        context->Bind(loop_->GetName(), Heap::Instance().Make<LambdaFunction>(
+                                            loop_->GetArgs(), ObjectPtrVector{loop_}, context));
+        ObjectPtr result = context->Get(loop_->GetName())->Apply(values);
+        context->PopScope();
+        return result;
+    } catch (...) {
+        context->PopScope();
+        throw;
+    }
+}
+
+TailCallNode::TailCallNode(ObjectPtr function, const ObjectPtrVector& operands)
+    : function_(function), operands_(operands) {
+    AddDependency(function);
+    for (ObjectPtr operand : operands) {
+        AddDependency(operand);
+    }
+}
+
+ObjectPtr TailCallNode::Evaluate(ContextPtr context) {
+    ObjectPtr function = EvaluateExpression(function_, context);
+    if (!function) {
+        throw RuntimeError("First element of pair must be applicable.");
+    } else if (IsEscaping(function)) {
+        return function;
+    }
+    return WithEvaluatedArguments(operands_, context, [this, function](ObjectPtrSpan arguments) {
+        // the loop name may have been rebound to something else
+        if (function != LoopNode::GetActiveFunction()) {
+            return function->Apply(arguments);
+        }
+        LoopNode::SetNextArguments(arguments);
+        return ObjectPtr(this);
+    });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Analyzer functions' realization
+
+ObjectPtr Analyze(ObjectPtr datum, ContextPtr context) {
+    if (!Is<Cell>(datum)) {
+        return datum;
+    }
+    ObjectPtr head = As<Cell>(datum)->GetFirst();
+    ObjectPtrVector operands = ListToVector(As<Cell>(datum)->GetSecond());
+    if (auto symbol = As<Symbol>(head)) {
+        auto special_form = kSpecialFormsMap.find(symbol->GetName());
+        if (special_form != kSpecialFormsMap.end()) {
+            return special_form->second(operands, context);
+        }
+        if (auto macro = As<SyntaxRules>(context->Get(symbol->GetName()))) {
+            return Analyze(macro->Expand(datum), context);
+        }
+    }
+    return Heap::Instance().Make<ApplicationNode>(Analyze(head, context),
+                                                  AnalyzeSequence(operands, context));
+}
+
+ObjectPtrVector AnalyzeSequence(const ObjectPtrVector& data, ContextPtr context) {
+    ObjectPtrVector analyzed(data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+        analyzed[i] = Analyze(data[i], context);
+    }
+    return analyzed;
+}
+
+ObjectPtr AnalyzeQuote(const ObjectPtrVector& operands, ContextPtr) {
+    if (operands.size() != 1) {
+        throw SyntaxError("Wrong syntax for quote.");
+    }
+    return Heap::Instance().Make<QuoteNode>(operands[0]);
+}
+
+ObjectPtr AnalyzeIf(const ObjectPtrVector& operands, ContextPtr context) {
+    if (operands.size() == 2) {
+        return Heap::Instance().Make<IfNode>(Analyze(operands[0], context),
+                                             Analyze(operands[1], context));
+    } else if (operands.size() == 3) {
+        return Heap::Instance().Make<IfNode>(Analyze(operands[0], context),
+                                             Analyze(operands[1], context),
+                                             Analyze(operands[2], context));
+    } else {
+        throw SyntaxError("Wrong number of arguments for if.");
+    }
+}
+
+ObjectPtr AnalyzeDefine(const ObjectPtrVector& operands, ContextPtr context) {
+    if (operands.size() < 2) {
+        throw SyntaxError("Wrong syntax for define.");
+    }
+    if (auto symbol = As<Symbol>(operands[0])) {
+        if (operands.size() != 2) {
+            throw SyntaxError("Wrong syntax for define.");
+        }
+        return Heap::Instance().Make<DefineNode>(symbol->GetName(), Analyze(operands[1], context));
+    } else if (Is<Cell>(operands[0])) {
+        // (define (fn arg1 arg2 ...) body...) == (define fn (lambda (arg1 arg2 ...) body...))
+        auto signature = As<Cell>(operands[0]);
+        if (!Is<Symbol>(signature->GetFirst())) {
+            throw SyntaxError("Function name in define must be a symbol.");
+        }
+        ObjectPtrVector lambda_operands(operands);
+        lambda_operands[0] = signature->GetSecond();
+        return Heap::Instance().Make<DefineNode>(As<Symbol>(signature->GetFirst())->GetName(),
+                                                 AnalyzeLambda(lambda_operands, context));
+    } else {
+        throw SyntaxError("Wrong syntax for define.");
+    }
+}
+
+ObjectPtr AnalyzeSet(const ObjectPtrVector& operands, ContextPtr context) {
+    if (operands.size() != 2) {
+        throw SyntaxError("Wrong syntax for set.");
+    }
+    if (!Is<Symbol>(operands[0])) {
+        throw SyntaxError("First argument for set must be a symbol.");
+    }
+    return Heap::Instance().Make<SetNode>(As<Symbol>(operands[0])->GetName(),
+                                          Analyze(operands[1], context));
+}
+
+ObjectPtr AnalyzeLambda(const ObjectPtrVector& operands, ContextPtr context) {
+    if (operands.size() < 2) {
+        throw SyntaxError("Wrong syntax for lambda declaration.");
+    }
+    // первый элемент - лист с аргументами
+    if (operands[0] && !Is<Cell>(operands[0])) {
+        throw SyntaxError("Wrong format for list of lambda's arguments.");
+    }
+    ObjectPtrVector args = ListToVector(operands[0]);
+    for (ObjectPtr arg : args) {
+        if (!Is<Symbol>(arg)) {
+            throw SyntaxError("Args for lambda declaration must be symbols.");
+        }
+    }
+    AnalysisScope scope{context};
+    for (ObjectPtr arg : args) {
+        scope.Hide(As<Symbol>(arg)->GetName());
+    }
+    ObjectPtrVector body(operands.begin() + 1, operands.end());
+    return Heap::Instance().Make<LambdaNode>(args, scope.AnalyzeBody(body));
+}
+
+ObjectPtr AnalyzeAnd(const ObjectPtrVector& operands, ContextPtr context) {
+    return Heap::Instance().Make<AndNode>(AnalyzeSequence(operands, context));
+}
+
+ObjectPtr AnalyzeOr(const ObjectPtrVector& operands, ContextPtr context) {
+    return Heap::Instance().Make<OrNode>(AnalyzeSequence(operands, context));
+}
+
+ObjectPtr AnalyzeDefineMemoized(const ObjectPtrVector& operands, ContextPtr context) {
+    // (define-memoized (fn args...) body...) == (define fn (memoize (lambda (args...) body...)))
+    if (operands.size() < 2 || !Is<Cell>(operands[0])) {
+        throw SyntaxError("Wrong syntax for define-memoized.");
+    }
+    auto define = As<DefineNode>(AnalyzeDefine(operands, context));
+    // the built-in itself, so the form keeps working if the name is rebound
+    ObjectPtr memoize = Heap::Instance().Make<QuoteNode>(kValidFunctionsMap.at("memoize"));
+    return Heap::Instance().Make<DefineNode>(
+        define->GetName(),
+        Heap::Instance().Make<ApplicationNode>(memoize, ObjectPtrVector{define->GetValue()}));
+}
+
+// Parses ((name value) ...) of let forms, the values are left unanalyzed
+static void ParseBindings(ObjectPtr bindings, const std::string& keyword,
+                          std::vector<std::string>* names, ObjectPtrVector* values) {
+    if (bindings && !Is<Cell>(bindings)) {
+        throw SyntaxError("Wrong syntax for bindings of " + keyword + ".");
+    }
+    for (ObjectPtr binding : ListToVector(bindings)) {
+        ObjectPtrVector pair = ListToVector(binding);
+        if (pair.size() != 2 || !Is<Symbol>(pair[0])) {
+            throw SyntaxError("Wrong syntax for bindings of " + keyword + ".");
+        }
+        names->push_back(As<Symbol>(pair[0])->GetName());
+        values->push_back(pair[1]);
+    }
+}
+
+static ObjectPtr AnalyzeLetForm(LetKind kind, const std::string& keyword,
+                                const ObjectPtrVector& operands, ContextPtr context) {
+    if (operands.size() < 2) {
+        throw SyntaxError("Wrong syntax for " + keyword + ".");
+    }
+    std::vector<std::string> names;
+    ObjectPtrVector values;
+    ParseBindings(operands[0], keyword, &names, &values);
+    if (kind == LetKind::LET) {
+        values = AnalyzeSequence(values, context);
+    }
+    // names of let* are seen by the values after them, names of letrec by all the values
+    AnalysisScope scope{context};
+    if (kind == LetKind::LETREC) {
+        scope.Hide(names);
+    }
+    for (size_t i = 0; kind != LetKind::LET && i < names.size(); ++i) {
+        values[i] = Analyze(values[i], context);
+        scope.Hide(names[i]);
+    }
+    scope.Hide(names);
+    ObjectPtrVector body(operands.begin() + 1, operands.end());
+    return Heap::Instance().Make<LetNode>(kind, names, values, scope.AnalyzeBody(body));
+}
+
+// Turns calls of the named let's loop in tail position of the node into TailCallNodes
+static ObjectPtr MarkTailCalls(ObjectPtr node, const std::string& name, size_t args_count) {
+    auto& heap_ref = Heap::Instance();
+    if (auto application = As<ApplicationNode>(node)) {
+        auto symbol = As<Symbol>(application->GetFunction());
+        if (symbol && symbol->GetName() == name &&
+            application->GetOperands().size() == args_count) {
+            return heap_ref.Make<TailCallNode>(application->GetFunction(),
+                                               application->GetOperands());
+        }
+    } else if (auto if_node = As<IfNode>(node)) {
+        ObjectPtr consequent = MarkTailCalls(if_node->GetConsequent(), name, args_count);
+        if (!if_node->HasAlternative()) {
+            return heap_ref.Make<IfNode>(if_node->GetCondition(), consequent);
+        }
+        return heap_ref.Make<IfNode>(if_node->GetCondition(), consequent,
+                                     MarkTailCalls(if_node->GetAlternative(), name, args_count));
+    } else if (auto and_node = As<AndNode>(node)) {
+        ObjectPtrVector operands = and_node->GetOperands();
+        if (!operands.empty()) {
+            operands.back() = MarkTailCalls(operands.back(), name, args_count);
+        }
+        return heap_ref.Make<AndNode>(operands);
+    } else if (auto or_node = As<OrNode>(node)) {
+        ObjectPtrVector operands = or_node->GetOperands();
+        if (!operands.empty()) {
+            operands.back() = MarkTailCalls(operands.back(), name, args_count);
+        }
+        return heap_ref.Make<OrNode>(operands);
+    } else if (auto begin = As<BeginNode>(node)) {
+        ObjectPtrVector body = begin->GetBody();
+        if (!body.empty()) {
+            body.back() = MarkTailCalls(body.back(), name, args_count);
+        }
+        return heap_ref.Make<BeginNode>(body);
+    } else if (auto arrow = As<CondArrowNode>(node)) {
+        if (!arrow->HasAlternative()) {
+            return node;
+        }
+        return heap_ref.Make<CondArrowNode>(
+            arrow->GetTest(), arrow->GetReceiver(),
+            MarkTailCalls(arrow->GetAlternative(), name, args_count));
+    } else if (auto case_node = As<CaseNode>(node)) {
+        ObjectPtrVector bodies = case_node->GetBodies();
+        for (ObjectPtr& body : bodies) {
+            body = MarkTailCalls(body, name, args_count);
+        }
+        if (!case_node->HasElse()) {
+            return heap_ref.Make<CaseNode>(case_node->GetKey(), case_node->GetData(), bodies);
+        }
+        return heap_ref.Make<CaseNode>(case_node->GetKey(), case_node->GetData(), bodies,
+                                       MarkTailCalls(case_node->GetElseBody(), name, args_count));
+    } else if (auto let = As<LetNode>(node)) {
+        const auto& names = let->GetNames();
+        if (std::find(names.begin(), names.end(), name) != names.end()) {
+            return node;
+        }
+        ObjectPtrVector body = let->GetBody();
+        body.back() = MarkTailCalls(body.back(), name, args_count);
+        return heap_ref.Make<LetNode>(let->GetKind(), names, let->GetValues(), body);
+    }
+    return node;
+}
+
+ObjectPtr AnalyzeLet(const ObjectPtrVector& operands, ContextPtr context) {
+    if (operands.empty() || !Is<Symbol>(operands[0])) {
+        return AnalyzeLetForm(LetKind::LET, kLetKeyword, operands, context);
+    }
+    // (let loop ((arg value) ...) body...)
+    if (operands.size() < 3) {
+        throw SyntaxError("Wrong syntax for named let.");
+    }
+    const std::string& name = As<Symbol>(operands[0])->GetName();
+    std::vector<std::string> names;
+    ObjectPtrVector values;
+    ParseBindings(operands[1], kLetKeyword, &names, &values);
+    values = AnalyzeSequence(values, context);
+    ObjectPtrVector args;
+    for (const std::string& arg_name : names) {
+        args.push_back(Heap::Instance().Make<Symbol>(arg_name));
+    }
+    AnalysisScope scope{context};
+    scope.Hide(name);
+    scope.Hide(names);
+    ObjectPtrVector body = scope.AnalyzeBody(ObjectPtrVector(operands.begin() + 2, operands.end()));
+    // an argument with the loop's name hides the loop
+    if (std::find(names.begin(), names.end(), name) == names.end()) {
+        body.back() = MarkTailCalls(body.back(), name, args.size());
+    }
+    return Heap::Instance().Make<NamedLetNode>(
+        values, Heap::Instance().Make<LoopNode>(name, args, body));
+}
+
+ObjectPtr AnalyzeLetStar(const ObjectPtrVector& operands, ContextPtr context) {
+    return AnalyzeLetForm(LetKind::LET_STAR, kLetStarKeyword, operands, context);
+}
+
+ObjectPtr AnalyzeLetrec(const ObjectPtrVector& operands, ContextPtr context) {
+    return AnalyzeLetForm(LetKind::LETREC, kLetrecKeyword, operands, context);
+}
+
+// A single expression is left as is, so that if and case branches need no begin node.
+// At top level the macros defined by a sequence are seen by its following forms only.
+static ObjectPtr AnalyzeBody(const ObjectPtrVector& body, ContextPtr context) {
+    if (body.size() == 1) {
+        return Analyze(body[0], context);
+    }
+    std::optional<AnalysisScope> scope;
+    if (context->IsGlobal()) {
+        scope.emplace(context);
+    }
+    return Heap::Instance().Make<BeginNode>(AnalyzeSequence(body, context));
+}
+
+static bool IsElseClause(const ObjectPtrVector& clause) {
+    auto symbol = As<Symbol>(clause[0]);
+    return symbol && symbol->GetName() == kElseKeyword;
+}
+
+ObjectPtr AnalyzeBegin(const ObjectPtrVector& operands, ContextPtr context) {
+    if (operands.empty()) {
+        return Heap::Instance().Make<BeginNode>(ObjectPtrVector{});
+    }
+    return AnalyzeBody(operands, context);
+}
+
+// (cond (test body...) (test => receiver) (test) ... (else body...))
+ObjectPtr AnalyzeCond(const ObjectPtrVector& operands, ContextPtr context) {
+    auto& heap_ref = Heap::Instance();
+    // clauses are folded from the last one, each becomes the alternative of the previous
+    ObjectPtr alternative = nullptr;
+    bool has_alternative = false;
+    for (size_t i = operands.size(); i-- > 0;) {
+        if (!Is<Cell>(operands[i])) {
+            throw SyntaxError("Wrong syntax for cond clause.");
+        }
+        ObjectPtrVector clause = ListToVector(operands[i]);
+        if (IsElseClause(clause)) {
+            if (i + 1 != operands.size() || clause.size() < 2) {
+                throw SyntaxError("Wrong syntax for else clause of cond.");
+            }
+            alternative = AnalyzeBody(ObjectPtrVector(clause.begin() + 1, clause.end()), context);
+            has_alternative = true;
+            continue;
+        }
+        ObjectPtr test = Analyze(clause[0], context);
+        auto arrow = (clause.size() > 1) ? As<Symbol>(clause[1]) : nullptr;
+        if (arrow && arrow->GetName() == kArrowKeyword) {
+            if (clause.size() != 3) {
+                throw SyntaxError("Wrong syntax for => clause of cond.");
+            }
+            ObjectPtr receiver = Analyze(clause[2], context);
+            alternative = (has_alternative)
+                              ? heap_ref.Make<CondArrowNode>(test, receiver, alternative)
+                              : heap_ref.Make<CondArrowNode>(test, receiver);
+        } else if (clause.size() == 1) {
+            // the value of the test is the value of the clause
+            alternative = heap_ref.Make<OrNode>(
+                (has_alternative) ? ObjectPtrVector{test, alternative} : ObjectPtrVector{test});
+        } else {
+            ObjectPtr body =
+                AnalyzeBody(ObjectPtrVector(clause.begin() + 1, clause.end()), context);
+            alternative = (has_alternative) ? heap_ref.Make<IfNode>(test, body, alternative)
+                                            : heap_ref.Make<IfNode>(test, body);
+        }
+        has_alternative = true;
+    }
+    return (has_alternative) ? alternative : heap_ref.Make<BeginNode>(ObjectPtrVector{});
+}
+
+// (case key ((datum ...) body...) ... (else body...))
+ObjectPtr AnalyzeCase(const ObjectPtrVector& operands, ContextPtr context) {
+    if (operands.empty()) {
+        throw SyntaxError("Wrong syntax for case.");
+    }
+    std::vector<ObjectPtrVector> data;
+    ObjectPtrVector bodies;
+    for (size_t i = 1; i < operands.size(); ++i) {
+        ObjectPtrVector clause = (Is<Cell>(operands[i])) ? ListToVector(operands[i])
+                                                         : ObjectPtrVector{};
+        if (clause.size() < 2) {
+            throw SyntaxError("Wrong syntax for case clause.");
+        }
+        ObjectPtr body = AnalyzeBody(ObjectPtrVector(clause.begin() + 1, clause.end()), context);
+        if (IsElseClause(clause)) {
+            if (i + 1 != operands.size()) {
+                throw SyntaxError("Else clause of case must be the last one.");
+            }
+            return Heap::Instance().Make<CaseNode>(Analyze(operands[0], context), data, bodies,
+                                                   body);
+        }
+        if (clause[0] && !Is<Cell>(clause[0])) {
+            throw SyntaxError("Data of case clause must be a list.");
+        }
+        data.push_back(ListToVector(clause[0]));
+        bodies.push_back(body);
+    }
+    return Heap::Instance().Make<CaseNode>(Analyze(operands[0], context), data, bodies);
+}
+
+// (define-syntax name (syntax-rules ...)) is bound when evaluated. Inside of a body the macro
+// is also bound in the analysis scope, so that the following forms of the body expand it.
+ObjectPtr AnalyzeDefineSyntax(const ObjectPtrVector& operands, ContextPtr context) {
+    if (operands.size() != 2 || !Is<Symbol>(operands[0])) {
+        throw SyntaxError("Wrong syntax for define-syntax.");
+    }
+    const std::string& name = As<Symbol>(operands[0])->GetName();
+    ObjectPtr rules = MakeSyntaxRules(operands[1]);
+    if (!context->IsGlobal()) {
+        context->Bind(name, rules);
+    }
+    return Heap::Instance().Make<DefineSyntaxNode>(name, rules);
+}
+
+ObjectPtr AnalyzeDelay(const ObjectPtrVector& operands, ContextPtr context) {
+    if (operands.size() != 1) {
+        throw SyntaxError("Wrong syntax for delay.");
+    }
+    return Heap::Instance().Make<DelayNode>(Analyze(operands[0], context));
+}
+
+// (stream-cons first rest) == (cons first (delay rest))
+ObjectPtr AnalyzeStreamCons(const ObjectPtrVector& operands, ContextPtr context) {
+    if (operands.size() != 2) {
+        throw SyntaxError("Wrong syntax for stream-cons.");
+    }
+    ObjectPtr cons = Heap::Instance().Make<QuoteNode>(kValidFunctionsMap.at("cons"));
+    return Heap::Instance().Make<ApplicationNode>(
+        cons, ObjectPtrVector{Analyze(operands[0], context),
+                              Heap::Instance().Make<DelayNode>(Analyze(operands[1], context))});
+}
@@ -0,0 +1,534 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+
+#include "object.h"
+#include "error.h"
+
+// Special forms keywords
+
+const std::string kQuoteKeyword = "quote";
+const std::string kIfKeyword = "if";
+const std::string kDefineKeyword = "define";
+const std::string kSetKeyword = "set!";
+const std::string kLambdaKeyword = "lambda";
+const std::string kAndKeyword = "and";
+const std::string kOrKeyword = "or";
+const std::string kDefineMemoizedKeyword = "define-memoized";
+const std::string kLetKeyword = "let";
+const std::string kLetStarKeyword = "let*";
+const std::string kLetrecKeyword = "letrec";
+const std::string kBeginKeyword = "begin";
+const std::string kCondKeyword = "cond";
+const std::string kCaseKeyword = "case";
+const std::string kElseKeyword = "else";
+const std::string kArrowKeyword = "=>";
+const std::string kDefineSyntaxKeyword = "define-syntax";
+const std::string kDelayKeyword = "delay";
+const std::string kStreamConsKeyword = "stream-cons";
+
+// Max number of arguments passed to a function without heap allocation
+constexpr size_t kSmallArgumentsCount = 8;
+
+// Fixnum data of case are dispatched through an array if they span at most that many values
+constexpr int64_t kMaxJumpTableSize = 1024;
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Syntax nodes
+// Built by the analyzer once per read expression, so evaluating a special form
+// needs no lookup through the context.
+
+class QuoteNode : public Object {
+public:
+    QuoteNode(ObjectPtr datum) : datum_(datum) {
+        AddDependency(datum);
+    }
+
+    ObjectPtr GetDatum() const {
+        return datum_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override {
+        return datum_;
+    }
+
+private:
+    ObjectPtr datum_;
+};
+
+class IfNode : public Object {
+public:
+    IfNode(ObjectPtr condition, ObjectPtr consequent);
+
+    IfNode(ObjectPtr condition, ObjectPtr consequent, ObjectPtr alternative);
+
+    ObjectPtr GetCondition() const {
+        return condition_;
+    }
+
+    ObjectPtr GetConsequent() const {
+        return consequent_;
+    }
+
+    ObjectPtr GetAlternative() const {
+        return alternative_;
+    }
+
+    bool HasAlternative() const {
+        return has_alternative_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override;
+
+private:
+    ObjectPtr condition_;
+    ObjectPtr consequent_;
+    ObjectPtr alternative_ = nullptr;
+    bool has_alternative_ = false;
+};
+
+class DefineNode : public Object {
+public:
+    DefineNode(const std::string& name, ObjectPtr value) : name_(name), value_(value) {
+        AddDependency(value);
+    }
+
+    const std::string& GetName() const {
+        return name_;
+    }
+
+    ObjectPtr GetValue() const {
+        return value_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override;
+
+private:
+    std::string name_;
+    ObjectPtr value_;
+};
+
+class SetNode : public Object {
+public:
+    SetNode(const std::string& name, ObjectPtr value) : name_(name), value_(value) {
+        AddDependency(value);
+    }
+
+    const std::string& GetName() const {
+        return name_;
+    }
+
+    ObjectPtr GetValue() const {
+        return value_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override;
+
+private:
+    std::string name_;
+    ObjectPtr value_;
+};
+
+// Binds the macro in the scope where the define-syntax is evaluated.
+// The rules are set later when the node is read from an image.
+class DefineSyntaxNode : public Object {
+public:
+    DefineSyntaxNode(const std::string& name, ObjectPtr rules) : name_(name), rules_(rules) {
+    }
+
+    const std::string& GetName() const {
+        return name_;
+    }
+
+    ObjectPtr GetRules() const {
+        return rules_;
+    }
+
+    void SetRules(ObjectPtr rules) {
+        rules_ = rules;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override;
+
+protected:
+    void MarkReferences() override {
+        MarkReference(rules_);
+    }
+
+private:
+    std::string name_;
+    ObjectPtr rules_;
+};
+
+class LambdaNode : public Object {
+public:
+    LambdaNode(const ObjectPtrVector& args, const ObjectPtrVector& body, bool is_tiered = false);
+
+    const ObjectPtrVector& GetArgs() const {
+        return args_;
+    }
+
+    const ObjectPtrVector& GetBody() const {
+        return body_;
+    }
+
+    bool IsTiered() const {
+        return is_tiered_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override;
+
+private:
+    ObjectPtrVector args_;
+    ObjectPtrVector body_;
+    // lambdas created at top level may be compiled to native code when hot
+    bool is_tiered_;
+};
+
+class AndNode : public Object {
+public:
+    AndNode(const ObjectPtrVector& operands);
+
+    const ObjectPtrVector& GetOperands() const {
+        return operands_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override;
+
+private:
+    ObjectPtrVector operands_;
+};
+
+class OrNode : public Object {
+public:
+    OrNode(const ObjectPtrVector& operands);
+
+    const ObjectPtrVector& GetOperands() const {
+        return operands_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override;
+
+private:
+    ObjectPtrVector operands_;
+};
+
+class BeginNode : public Object {
+public:
+    BeginNode(const ObjectPtrVector& body);
+
+    const ObjectPtrVector& GetBody() const {
+        return body_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override;
+
+private:
+    ObjectPtrVector body_;
+};
+
+// Clause (test => receiver) of cond, applies the receiver to the true value of the test.
+// The other clauses of cond become if and begin nodes.
+
+class CondArrowNode : public Object {
+public:
+    CondArrowNode(ObjectPtr test, ObjectPtr receiver);
+
+    CondArrowNode(ObjectPtr test, ObjectPtr receiver, ObjectPtr alternative);
+
+    ObjectPtr GetTest() const {
+        return test_;
+    }
+
+    ObjectPtr GetReceiver() const {
+        return receiver_;
+    }
+
+    ObjectPtr GetAlternative() const {
+        return alternative_;
+    }
+
+    bool HasAlternative() const {
+        return has_alternative_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override;
+
+private:
+    ObjectPtr test_;
+    ObjectPtr receiver_;
+    ObjectPtr alternative_ = nullptr;
+    bool has_alternative_ = false;
+};
+
+// (case key ((datum ...) body...) ... (else body...))
+// Fixnum and symbol data are looked up in tables built once with the node: fixnums
+// in a jump table if they are dense enough, in a hash table otherwise. Other data are
+// compared with the key by eqv? one by one.
+
+class CaseNode : public Object {
+public:
+    CaseNode(ObjectPtr key, const std::vector<ObjectPtrVector>& data,
+             const ObjectPtrVector& bodies);
+
+    CaseNode(ObjectPtr key, const std::vector<ObjectPtrVector>& data, const ObjectPtrVector& bodies,
+             ObjectPtr else_body);
+
+    ObjectPtr GetKey() const {
+        return key_;
+    }
+
+    const std::vector<ObjectPtrVector>& GetData() const {
+        return data_;
+    }
+
+    const ObjectPtrVector& GetBodies() const {
+        return bodies_;
+    }
+
+    ObjectPtr GetElseBody() const {
+        return else_body_;
+    }
+
+    bool HasElse() const {
+        return has_else_;
+    }
+
+    // The body for the key value, nullptr if no clause matches and there is no else
+    ObjectPtr FindBody(ObjectPtr value) const;
+
+    ObjectPtr Evaluate(ContextPtr) override;
+
+private:
+    void BuildTables();
+
+    ObjectPtr key_;
+    std::vector<ObjectPtrVector> data_;
+    ObjectPtrVector bodies_;
+    ObjectPtr else_body_ = nullptr;
+    bool has_else_ = false;
+    // clause indices, bodies_.size() where there is no clause
+    int64_t jump_table_min_ = 0;
+    std::vector<size_t> jump_table_;
+    std::unordered_map<int64_t, size_t> fixnum_clauses_;
+    std::unordered_map<std::string, size_t> symbol_clauses_;
+    std::vector<std::pair<ObjectPtr, size_t>> other_clauses_;
+};
+
+// Let forms
+// (let ((name value) ...) body...) and its let* and letrec variants push the bindings
+// as a new scope of the current context, no closure is made for them.
+
+enum class LetKind {
+    // values are evaluated before the scope is pushed
+    LET,
+    // values are evaluated and bound one by one in the new scope
+    LET_STAR,
+    // names are bound before values are evaluated, so values may refer to each other
+    LETREC,
+};
+
+class LetNode : public Object {
+public:
+    LetNode(LetKind kind, const std::vector<std::string>& names, const ObjectPtrVector& values,
+            const ObjectPtrVector& body);
+
+    LetKind GetKind() const {
+        return kind_;
+    }
+
+    const std::vector<std::string>& GetNames() const {
+        return names_;
+    }
+
+    const ObjectPtrVector& GetValues() const {
+        return values_;
+    }
+
+    const ObjectPtrVector& GetBody() const {
+        return body_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override;
+
+private:
+    ObjectPtr EvaluateInScope(ObjectPtrSpan values, ContextPtr context);
+
+    LetKind kind_;
+    std::vector<std::string> names_;
+    ObjectPtrVector values_;
+    ObjectPtrVector body_;
+};
+
+// Named let: (let loop ((arg value) ...) body...)
+// Binds loop to a lambda whose body is a LoopNode. Calls of loop in tail position of
+// the body are TailCallNodes: instead of a nested call they hand their arguments over
+// to the running LoopNode, which rebinds the arguments and evaluates the body again.
+
+class LoopNode : public Object {
+public:
+    LoopNode(const std::string& name, const ObjectPtrVector& args, const ObjectPtrVector& body);
+
+    const std::string& GetName() const {
+        return name_;
+    }
+
+    const ObjectPtrVector& GetArgs() const {
+        return args_;
+    }
+
+    const ObjectPtrVector& GetBody() const {
+        return body_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override;
+
+    // The loop function of the innermost running LoopNode
+    static ObjectPtr GetActiveFunction() {
+        return active_function_;
+    }
+
+    static void SetNextArguments(ObjectPtrSpan arguments) {
+        next_arguments_.assign(arguments.begin(), arguments.end());
+    }
+
+private:
+    std::string name_;
+    ObjectPtrVector args_;
+    ObjectPtrVector body_;
+    // parallel tasks run their loops on their own threads
+    inline static thread_local ObjectPtr active_function_ = nullptr;
+    inline static thread_local ObjectPtrVector next_arguments_;
+};
+
+class NamedLetNode : public Object {
+public:
+    NamedLetNode(const ObjectPtrVector& values, LoopNode* loop);
+
+    const ObjectPtrVector& GetValues() const {
+        return values_;
+    }
+
+    LoopNode* GetLoop() const {
+        return loop_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override;
+
+private:
+    ObjectPtr ApplyInScope(ObjectPtrSpan values, ContextPtr context);
+
+    ObjectPtrVector values_;
+    LoopNode* loop_;
+};
+
+// (delay expression) evaluates to a promise of the expression in the current context
+
+class DelayNode : public Object {
+public:
+    DelayNode(ObjectPtr expression) : expression_(expression) {
+        AddDependency(expression);
+    }
+
+    ObjectPtr GetExpression() const {
+        return expression_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr context) override {
+        return Heap::Instance().Make<Promise>(expression_, context);
+    }
+
+private:
+    ObjectPtr expression_;
+};
+
+// Application of everything that is not a special form: (operator operand ...)
+
+class ApplicationNode : public Object {
+public:
+    ApplicationNode(ObjectPtr function, const ObjectPtrVector& operands);
+
+    ObjectPtr GetFunction() const {
+        return function_;
+    }
+
+    const ObjectPtrVector& GetOperands() const {
+        return operands_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override;
+
+private:
+    ObjectPtr function_;
+    ObjectPtrVector operands_;
+};
+
+// Call of a named let's loop in tail position of its body
+// Evaluates to itself when it jumps to the next iteration of the running loop,
+// otherwise it's an ordinary application.
+
+class TailCallNode : public Object {
+public:
+    TailCallNode(ObjectPtr function, const ObjectPtrVector& operands);
+
+    ObjectPtr GetFunction() const {
+        return function_;
+    }
+
+    const ObjectPtrVector& GetOperands() const {
+        return operands_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override;
+
+private:
+    ObjectPtr function_;
+    ObjectPtrVector operands_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Analyzer functions
+
+ObjectPtr Analyze(ObjectPtr datum, ContextPtr context);
+
+// Incremented each time a macro is defined or a macro's name is rebound at top level,
+// so that forms analyzed in advance (see Interpreter::Prepare) know their expansions are stale.
+uint64_t GetSyntaxEpoch();
+
+// For macros bound not by define-syntax (e.g. restored from an image)
+void AdvanceSyntaxEpoch();
+ObjectPtrVector AnalyzeSequence(const ObjectPtrVector& data, ContextPtr context);
+
+ObjectPtr AnalyzeQuote(const ObjectPtrVector& operands, ContextPtr context);
+ObjectPtr AnalyzeIf(const ObjectPtrVector& operands, ContextPtr context);
+ObjectPtr AnalyzeDefine(const ObjectPtrVector& operands, ContextPtr context);
+ObjectPtr AnalyzeSet(const ObjectPtrVector& operands, ContextPtr context);
+ObjectPtr AnalyzeLambda(const ObjectPtrVector& operands, ContextPtr context);
+ObjectPtr AnalyzeAnd(const ObjectPtrVector& operands, ContextPtr context);
+ObjectPtr AnalyzeOr(const ObjectPtrVector& operands, ContextPtr context);
+ObjectPtr AnalyzeDefineMemoized(const ObjectPtrVector& operands, ContextPtr context);
+ObjectPtr AnalyzeLet(const ObjectPtrVector& operands, ContextPtr context);
+ObjectPtr AnalyzeLetStar(const ObjectPtrVector& operands, ContextPtr context);
+ObjectPtr AnalyzeLetrec(const ObjectPtrVector& operands, ContextPtr context);
+ObjectPtr AnalyzeBegin(const ObjectPtrVector& operands, ContextPtr context);
+ObjectPtr AnalyzeCond(const ObjectPtrVector& operands, ContextPtr context);
+ObjectPtr AnalyzeCase(const ObjectPtrVector& operands, ContextPtr context);
+ObjectPtr AnalyzeDefineSyntax(const ObjectPtrVector& operands, ContextPtr context);
+ObjectPtr AnalyzeDelay(const ObjectPtrVector& operands, ContextPtr context);
+ObjectPtr AnalyzeStreamCons(const ObjectPtrVector& operands, ContextPtr context);
+
+using SpecialFormAnalyzer = ObjectPtr (*)(const ObjectPtrVector&, ContextPtr);
+
+const std::unordered_map<std::string, SpecialFormAnalyzer> kSpecialFormsMap = {
+    {kQuoteKeyword, AnalyzeQuote},   {kIfKeyword, AnalyzeIf},
+    {kDefineKeyword, AnalyzeDefine}, {kSetKeyword, AnalyzeSet},
+    {kLambdaKeyword, AnalyzeLambda}, {kAndKeyword, AnalyzeAnd},
+    {kOrKeyword, AnalyzeOr},         {kDefineMemoizedKeyword, AnalyzeDefineMemoized},
+    {kLetKeyword, AnalyzeLet},       {kLetStarKeyword, AnalyzeLetStar},
+    {kLetrecKeyword, AnalyzeLetrec}, {kBeginKeyword, AnalyzeBegin},
+    {kCondKeyword, AnalyzeCond},     {kCaseKeyword, AnalyzeCase},
+    {kDefineSyntaxKeyword, AnalyzeDefineSyntax},
+    {kDelayKeyword, AnalyzeDelay},   {kStreamConsKeyword, AnalyzeStreamCons}};
@@ -0,0 +1,99 @@
+// Throughput of many small expressions: one Run per expression against RunBatch and RunForms,
+// and of a few templates run over and over: Run with and without its cache against Execute
+// Usage: scheme_tidy_batch_bench [expressions count]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <scheme.h>
+
+static std::vector<std::string> MakeExpressions(size_t count) {
+    std::vector<std::string> expressions;
+    expressions.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string number = std::to_string(i);
+        switch (i % 4) {
+            case 0:
+                expressions.push_back("(define x" + number + " " + number + ")");
+                break;
+            case 1:
+                expressions.push_back("(+ " + number + " (* 2 3) (- 7 1))");
+                break;
+            case 2:
+                expressions.push_back("(car (cdr (list 1 " + number + " 3)))");
+                break;
+            default:
+                expressions.push_back("((lambda (a b) (if (< a b) a b)) " + number + " 5)");
+        }
+    }
+    return expressions;
+}
+
+template <typename Function>
+static void Measure(const std::string& name, size_t count, Function function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << count << " expressions in " << elapsed.count() * 1000
+              << " ms, " << static_cast<size_t>(count / elapsed.count()) << " expressions/s\n";
+}
+
+int main(int argc, char** argv) {
+    size_t count = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 20000;
+    std::vector<std::string> expressions = MakeExpressions(count);
+    std::string forms;
+    for (const std::string& expression : expressions) {
+        forms += expression;
+        forms += '\n';
+    }
+
+    Measure("Run", count, [&] {
+        Interpreter interpreter;
+        for (const std::string& expression : expressions) {
+            interpreter.Run(expression);
+        }
+    });
+    Measure("RunBatch", count, [&] {
+        Interpreter interpreter;
+        interpreter.RunBatch(expressions);
+    });
+    Measure("RunForms", count, [&] {
+        Interpreter interpreter;
+        interpreter.RunForms(forms);
+    });
+
+    // the same few hundred templates, the definitions are made once
+    std::vector<std::string> templates(expressions.begin() + count / 2,
+                                       expressions.begin() + count / 2 + 400);
+    std::erase_if(templates, [](const std::string& expression) {
+        return expression.starts_with("(define");
+    });
+    auto run_templates = [&](Interpreter* interpreter) {
+        for (size_t i = 0; i < count; ++i) {
+            interpreter->Run(templates[i % templates.size()]);
+        }
+    };
+    Measure("Run templates", count, [&] {
+        Interpreter interpreter;
+        run_templates(&interpreter);
+    });
+    Measure("Run templates with cache", count, [&] {
+        Interpreter interpreter;
+        interpreter.SetRunCacheCapacity(templates.size());
+        run_templates(&interpreter);
+    });
+    Measure("Execute templates", count, [&] {
+        Interpreter interpreter;
+        std::vector<PreparedExpression> prepared;
+        for (const std::string& expression : templates) {
+            prepared.push_back(interpreter.Prepare(expression));
+        }
+        for (size_t i = 0; i < count; ++i) {
+            interpreter.Execute(prepared[i % prepared.size()]);
+        }
+    });
+    return 0;
+}
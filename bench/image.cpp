@@ -0,0 +1,54 @@
+// Startup of an interpreter: evaluating a prelude against loading its heap image
+// Usage: scheme_tidy_image_bench [definitions count]
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+#include <scheme.h>
+
+// Procedures and the tables they compute at startup
+static std::string MakePrelude(size_t count) {
+    std::string prelude =
+        "(define (build-table n f) (let loop ((i n) (table '()))"
+        " (if (= i 0) table (loop (- i 1) (cons (f i) table)))))\n";
+    for (size_t i = 0; i < count; ++i) {
+        std::string number = std::to_string(i);
+        prelude += "(define (scale-" + number + " x) (if (< x 0) (- x) (* x " + number + ")))\n"
+                   "(define table-" + number + " (list->vector (build-table 200 scale-" +
+                   number + ")))\n";
+    }
+    return prelude;
+}
+
+template <typename Function>
+static void Measure(const std::string& name, Function function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << elapsed.count() * 1000 << " ms\n";
+}
+
+int main(int argc, char** argv) {
+    size_t count = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 2000;
+    std::string prelude = MakePrelude(count);
+    std::string path = std::filesystem::temp_directory_path() / "scheme_tidy_bench.image";
+    std::string check = "(vector-ref table-" + std::to_string(count - 1) + " 199)";
+
+    Measure("Evaluate the prelude", [&] {
+        Interpreter interpreter;
+        interpreter.RunForms(prelude);
+        interpreter.SaveImage(path);
+        std::cout << check << " = " << interpreter.Run(check) << "\n";
+    });
+    std::cout << "Image: " << std::filesystem::file_size(path) / 1024 << " KB\n";
+    Measure("Load the image", [&] {
+        Interpreter interpreter;
+        interpreter.LoadImage(path);
+        std::cout << check << " = " << interpreter.Run(check) << "\n";
+    });
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,92 @@
+// Throughput of the reader in MB/s: tokens and whole forms, read from a stream and from a buffer
+// Usage: scheme_tidy_parse_bench [source size in MB]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include <scheme.h>
+
+// Hand-written code: short names, single spaces
+static std::string MakeCodeSource(size_t size) {
+    std::string source;
+    for (size_t i = 0; source.size() < size; ++i) {
+        std::string number = std::to_string(i);
+        source += "(define (accumulate-" + number + " items total)\n"
+                  "  (if (null? items) total\n"
+                  "      (accumulate-" + number + " (cdr items) (+ total (* 2 (car items))))))\n"
+                  "(vector-ref #(1 2.5 \"text\" 'quoted) " + number + ")\n";
+    }
+    return source;
+}
+
+// Machine-generated data: long names and numbers, deep indentation
+static std::string MakeDataSource(size_t size) {
+    std::string source;
+    std::string indentation(24, ' ');
+    for (size_t i = 0; source.size() < size; ++i) {
+        std::string number = std::to_string(1000000000000 + i);
+        source += "(record-" + number + "\n" + indentation +
+                  "(identifier-of-the-generated-record-" + number + " " + number + ")\n" +
+                  indentation + "(measurements-of-the-record " + number + "1.25 " + number +
+                  "2.5)\n" + indentation + "(category-alpha-beta-gamma-delta-epsilon))\n";
+    }
+    return source;
+}
+
+template <typename Function>
+static void Measure(const std::string& name, size_t size, Function function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << name << ": " << elapsed.count() * 1000 << " ms, "
+              << size / elapsed.count() / (1 << 20) << " MB/s\n";
+}
+
+static void Tokenize(Tokenizer* tokenizer) {
+    while (!tokenizer->IsEnd()) {
+        tokenizer->Next();
+    }
+}
+
+static void ReadForms(Tokenizer* tokenizer) {
+    // the forms are garbage, every few of them are collected from an empty root
+    Interpreter interpreter;
+    for (size_t i = 1; !tokenizer->IsEnd(); ++i) {
+        Read(tokenizer);
+        if (i % 10000 == 0) {
+            Heap::Instance().MarkAndSweep();
+        }
+    }
+    Heap::Instance().MarkAndSweep();
+}
+
+static void MeasureSource(const std::string& name, const std::string& source) {
+    Measure(name + ", tokens from a stream", source.size(), [&] {
+        std::stringstream stream{source};
+        Tokenizer tokenizer{&stream};
+        Tokenize(&tokenizer);
+    });
+    Measure(name + ", tokens from a buffer", source.size(), [&] {
+        Tokenizer tokenizer{source};
+        Tokenize(&tokenizer);
+    });
+    Measure(name + ", forms from a stream", source.size(), [&] {
+        std::stringstream stream{source};
+        Tokenizer tokenizer{&stream};
+        ReadForms(&tokenizer);
+    });
+    Measure(name + ", forms from a buffer", source.size(), [&] {
+        Tokenizer tokenizer{source};
+        ReadForms(&tokenizer);
+    });
+}
+
+int main(int argc, char** argv) {
+    size_t size = ((argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 8) << 20;
+    MeasureSource("Code", MakeCodeSource(size));
+    MeasureSource("Data", MakeDataSource(size));
+    return 0;
+}
@@ -0,0 +1,336 @@
+#include "bignum.h"
+
+#include <algorithm>
+#include <bit>
+
+constexpr uint64_t kLimbBase = uint64_t(1) << 32;
+// Largest power of ten which fits into a limb, used to convert from and to decimal
+constexpr uint32_t kDecimalChunkBase = 1000000000;
+constexpr size_t kDecimalChunkDigits = 9;
+
+BigInteger::BigInteger(int64_t value) : is_negative_(value < 0) {
+    // negation of the minimal int64_t is done in unsigned arithmetic
+    uint64_t magnitude = (value < 0) ? ~static_cast<uint64_t>(value) + 1 : value;
+    while (magnitude != 0) {
+        magnitude_.push_back(static_cast<uint32_t>(magnitude));
+        magnitude >>= 32;
+    }
+}
+
+BigInteger::BigInteger(const std::string& digits) {
+    size_t start = (!digits.empty() && (digits[0] == '-' || digits[0] == '+')) ? 1 : 0;
+    // the first chunk is shorter, so that the others have exactly 9 digits
+    size_t chunk_end = start + (digits.size() - start) % kDecimalChunkDigits;
+    if (chunk_end == start) {
+        chunk_end += kDecimalChunkDigits;
+    }
+    for (size_t chunk_start = start; chunk_start < digits.size();) {
+        uint32_t chunk = 0;
+        uint32_t chunk_base = 1;
+        for (size_t i = chunk_start; i < chunk_end; ++i) {
+            chunk = chunk * 10 + (digits[i] - '0');
+            chunk_base *= 10;
+        }
+        MultiplyAddSmall(&magnitude_, chunk_base, chunk);
+        chunk_start = chunk_end;
+        chunk_end += kDecimalChunkDigits;
+    }
+    is_negative_ = (start == 1 && digits[0] == '-' && !magnitude_.empty());
+}
+
+BigInteger::BigInteger(Limbs magnitude, bool is_negative) : magnitude_(std::move(magnitude)) {
+    Trim(&magnitude_);
+    is_negative_ = is_negative && !magnitude_.empty();
+}
+
+bool BigInteger::FitsInt64() const {
+    if (magnitude_.size() > 2) {
+        return false;
+    }
+    uint64_t magnitude = 0;
+    for (size_t i = magnitude_.size(); i > 0; --i) {
+        magnitude = (magnitude << 32) | magnitude_[i - 1];
+    }
+    uint64_t limit = static_cast<uint64_t>(INT64_MAX) + (is_negative_ ? 1 : 0);
+    return magnitude <= limit;
+}
+
+int64_t BigInteger::ToInt64() const {
+    uint64_t magnitude = 0;
+    for (size_t i = magnitude_.size(); i > 0; --i) {
+        magnitude = (magnitude << 32) | magnitude_[i - 1];
+    }
+    return static_cast<int64_t>((is_negative_) ? ~magnitude + 1 : magnitude);
+}
+
+double BigInteger::ToDouble() const {
+    double result = 0;
+    for (size_t i = magnitude_.size(); i > 0; --i) {
+        result = result * static_cast<double>(kLimbBase) + magnitude_[i - 1];
+    }
+    return (is_negative_) ? -result : result;
+}
+
+std::string BigInteger::ToString() const {
+    if (magnitude_.empty()) {
+        return "0";
+    }
+    std::vector<uint32_t> chunks;
+    Limbs rest = magnitude_;
+    while (!rest.empty()) {
+        chunks.push_back(DivideSmall(&rest, kDecimalChunkBase));
+    }
+    std::string result = (is_negative_) ? "-" : "";
+    result += std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i > 0; --i) {
+        std::string chunk = std::to_string(chunks[i - 1]);
+        result.append(kDecimalChunkDigits - chunk.size(), '0');
+        result += chunk;
+    }
+    return result;
+}
+
+BigInteger BigInteger::Abs() const {
+    return BigInteger(magnitude_, false);
+}
+
+BigInteger BigInteger::operator-() const {
+    return BigInteger(magnitude_, !is_negative_);
+}
+
+BigInteger operator+(const BigInteger& lhs, const BigInteger& rhs) {
+    if (lhs.is_negative_ == rhs.is_negative_) {
+        return BigInteger(BigInteger::AddMagnitudes(lhs.magnitude_, rhs.magnitude_),
+                          lhs.is_negative_);
+    }
+    if (BigInteger::CompareMagnitudes(lhs.magnitude_, rhs.magnitude_) >= 0) {
+        return BigInteger(BigInteger::SubtractMagnitudes(lhs.magnitude_, rhs.magnitude_),
+                          lhs.is_negative_);
+    }
+    return BigInteger(BigInteger::SubtractMagnitudes(rhs.magnitude_, lhs.magnitude_),
+                      rhs.is_negative_);
+}
+
+BigInteger operator-(const BigInteger& lhs, const BigInteger& rhs) {
+    return lhs + (-rhs);
+}
+
+BigInteger operator*(const BigInteger& lhs, const BigInteger& rhs) {
+    return BigInteger(BigInteger::MultiplyMagnitudes(lhs.magnitude_, rhs.magnitude_),
+                      lhs.is_negative_ != rhs.is_negative_);
+}
+
+BigInteger operator/(const BigInteger& lhs, const BigInteger& rhs) {
+    return BigInteger(BigInteger::DivideMagnitudes(lhs.magnitude_, rhs.magnitude_),
+                      lhs.is_negative_ != rhs.is_negative_);
+}
+
+int Compare(const BigInteger& lhs, const BigInteger& rhs) {
+    if (lhs.is_negative_ != rhs.is_negative_) {
+        return (lhs.is_negative_) ? -1 : 1;
+    }
+    int result = BigInteger::CompareMagnitudes(lhs.magnitude_, rhs.magnitude_);
+    return (lhs.is_negative_) ? -result : result;
+}
+
+void BigInteger::Trim(Limbs* magnitude) {
+    while (!magnitude->empty() && magnitude->back() == 0) {
+        magnitude->pop_back();
+    }
+}
+
+int BigInteger::CompareMagnitudes(const Limbs& lhs, const Limbs& rhs) {
+    if (lhs.size() != rhs.size()) {
+        return (lhs.size() < rhs.size()) ? -1 : 1;
+    }
+    for (size_t i = lhs.size(); i > 0; --i) {
+        if (lhs[i - 1] != rhs[i - 1]) {
+            return (lhs[i - 1] < rhs[i - 1]) ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+BigInteger::Limbs BigInteger::AddMagnitudes(const Limbs& lhs, const Limbs& rhs) {
+    Limbs result = lhs;
+    AddShifted(&result, rhs, 0);
+    return result;
+}
+
+BigInteger::Limbs BigInteger::SubtractMagnitudes(const Limbs& lhs, const Limbs& rhs) {
+    Limbs result(lhs.size());
+    int64_t borrow = 0;
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        int64_t difference = static_cast<int64_t>(lhs[i]) - borrow - ((i < rhs.size()) ? rhs[i] : 0);
+        borrow = (difference < 0) ? 1 : 0;
+        result[i] = static_cast<uint32_t>(difference + borrow * static_cast<int64_t>(kLimbBase));
+    }
+    Trim(&result);
+    return result;
+}
+
+void BigInteger::AddShifted(Limbs* result, const Limbs& value, size_t shift) {
+    if (result->size() < value.size() + shift) {
+        result->resize(value.size() + shift, 0);
+    }
+    uint64_t carry = 0;
+    size_t i = 0;
+    for (; i < value.size() || carry != 0; ++i) {
+        if (shift + i == result->size()) {
+            result->push_back(0);
+        }
+        uint64_t sum = carry + (*result)[shift + i] + ((i < value.size()) ? value[i] : 0);
+        (*result)[shift + i] = static_cast<uint32_t>(sum);
+        carry = sum >> 32;
+    }
+}
+
+BigInteger::Limbs BigInteger::MultiplyMagnitudes(const Limbs& lhs, const Limbs& rhs) {
+    if (lhs.empty() || rhs.empty()) {
+        return {};
+    }
+    if (std::min(lhs.size(), rhs.size()) < kKaratsubaThreshold) {
+        return MultiplySchoolbook(lhs, rhs);
+    }
+    return MultiplyKaratsuba(lhs, rhs);
+}
+
+BigInteger::Limbs BigInteger::MultiplySchoolbook(const Limbs& lhs, const Limbs& rhs) {
+    Limbs result(lhs.size() + rhs.size(), 0);
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < rhs.size(); ++j) {
+            uint64_t product = static_cast<uint64_t>(lhs[i]) * rhs[j] + result[i + j] + carry;
+            result[i + j] = static_cast<uint32_t>(product);
+            carry = product >> 32;
+        }
+        result[i + rhs.size()] = static_cast<uint32_t>(carry);
+    }
+    Trim(&result);
+    return result;
+}
+
+BigInteger::Limbs BigInteger::MultiplyKaratsuba(const Limbs& lhs, const Limbs& rhs) {
+    // lhs = high_lhs * base^half + low_lhs and the same for rhs
+    size_t half = std::max(lhs.size(), rhs.size()) / 2;
+    auto split = [half](const Limbs& value, Limbs* low, Limbs* high) {
+        size_t middle = std::min(half, value.size());
+        *low = Limbs(value.begin(), value.begin() + middle);
+        *high = Limbs(value.begin() + middle, value.end());
+        Trim(low);
+    };
+    Limbs low_lhs, high_lhs, low_rhs, high_rhs;
+    split(lhs, &low_lhs, &high_lhs);
+    split(rhs, &low_rhs, &high_rhs);
+
+    Limbs low = MultiplyMagnitudes(low_lhs, low_rhs);
+    Limbs high = MultiplyMagnitudes(high_lhs, high_rhs);
+    // (low_lhs + high_lhs) * (low_rhs + high_rhs) - low - high
+    Limbs middle = MultiplyMagnitudes(AddMagnitudes(low_lhs, high_lhs),
+                                      AddMagnitudes(low_rhs, high_rhs));
+    middle = SubtractMagnitudes(SubtractMagnitudes(middle, low), high);
+
+    Limbs result = low;
+    AddShifted(&result, middle, half);
+    AddShifted(&result, high, 2 * half);
+    Trim(&result);
+    return result;
+}
+
+void BigInteger::MultiplyAddSmall(Limbs* magnitude, uint32_t factor, uint32_t addend) {
+    uint64_t carry = addend;
+    for (uint32_t& limb : *magnitude) {
+        uint64_t product = static_cast<uint64_t>(limb) * factor + carry;
+        limb = static_cast<uint32_t>(product);
+        carry = product >> 32;
+    }
+    if (carry != 0) {
+        magnitude->push_back(static_cast<uint32_t>(carry));
+    }
+}
+
+uint32_t BigInteger::DivideSmall(Limbs* magnitude, uint32_t divisor) {
+    uint64_t remainder = 0;
+    for (size_t i = magnitude->size(); i > 0; --i) {
+        uint64_t current = (remainder << 32) | (*magnitude)[i - 1];
+        (*magnitude)[i - 1] = static_cast<uint32_t>(current / divisor);
+        remainder = current % divisor;
+    }
+    Trim(magnitude);
+    return static_cast<uint32_t>(remainder);
+}
+
+BigInteger::Limbs BigInteger::DivideMagnitudes(const Limbs& lhs, const Limbs& rhs) {
+    if (CompareMagnitudes(lhs, rhs) < 0) {
+        return {};
+    }
+    if (rhs.size() == 1) {
+        Limbs quotient = lhs;
+        DivideSmall(&quotient, rhs[0]);
+        return quotient;
+    }
+
+    // Knuth's algorithm D: the divisor is normalized so that its top bit is set,
+    // then every quotient limb is estimated from the top limbs and corrected
+    int shift = std::countl_zero(rhs.back());
+    size_t divisor_size = rhs.size();
+    Limbs divisor(divisor_size);
+    Limbs dividend(lhs.size() + 1, 0);
+    for (size_t i = divisor_size; i > 0; --i) {
+        uint64_t lower = (i > 1 && shift != 0) ? (rhs[i - 2] >> (32 - shift)) : 0;
+        divisor[i - 1] = static_cast<uint32_t>((static_cast<uint64_t>(rhs[i - 1]) << shift) | lower);
+    }
+    for (size_t i = lhs.size(); i > 0; --i) {
+        uint64_t lower = (i > 1 && shift != 0) ? (lhs[i - 2] >> (32 - shift)) : 0;
+        dividend[i - 1] = static_cast<uint32_t>((static_cast<uint64_t>(lhs[i - 1]) << shift) | lower);
+    }
+    dividend[lhs.size()] = (shift != 0) ? (lhs.back() >> (32 - shift)) : 0;
+
+    Limbs quotient(lhs.size() - divisor_size + 1, 0);
+    for (size_t j = quotient.size(); j > 0; --j) {
+        size_t position = j - 1;
+        uint64_t top = (static_cast<uint64_t>(dividend[position + divisor_size]) << 32) |
+                       dividend[position + divisor_size - 1];
+        uint64_t estimate = top / divisor[divisor_size - 1];
+        uint64_t remainder = top % divisor[divisor_size - 1];
+        while (estimate >= kLimbBase ||
+               estimate * divisor[divisor_size - 2] >
+                   ((remainder << 32) | dividend[position + divisor_size - 2])) {
+            --estimate;
+            remainder += divisor[divisor_size - 1];
+            if (remainder >= kLimbBase) {
+                break;
+            }
+        }
+
+        // dividend -= estimate * divisor * base^position
+        int64_t borrow = 0;
+        uint64_t carry = 0;
+        for (size_t i = 0; i < divisor_size; ++i) {
+            uint64_t product = estimate * divisor[i] + carry;
+            carry = product >> 32;
+            int64_t difference = static_cast<int64_t>(dividend[position + i]) - borrow -
+                                 static_cast<int64_t>(product & 0xFFFFFFFF);
+            borrow = (difference < 0) ? 1 : 0;
+            dividend[position + i] = static_cast<uint32_t>(difference);
+        }
+        int64_t difference = static_cast<int64_t>(dividend[position + divisor_size]) - borrow -
+                             static_cast<int64_t>(carry);
+        dividend[position + divisor_size] = static_cast<uint32_t>(difference);
+
+        if (difference < 0) {
+            // the estimate was one too large, add the divisor back
+            --estimate;
+            uint64_t sum_carry = 0;
+            for (size_t i = 0; i < divisor_size; ++i) {
+                uint64_t sum = static_cast<uint64_t>(dividend[position + i]) + divisor[i] + sum_carry;
+                dividend[position + i] = static_cast<uint32_t>(sum);
+                sum_carry = sum >> 32;
+            }
+            dividend[position + divisor_size] += static_cast<uint32_t>(sum_carry);
+        }
+        quotient[position] = static_cast<uint32_t>(estimate);
+    }
+    Trim(&quotient);
+    return quotient;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Products of numbers with at least that many limbs each are computed by Karatsuba
+constexpr size_t kKaratsubaThreshold = 32;
+
+// BigInteger
+// Arbitrary-precision integer: a sign and a magnitude in base 2^32, least significant
+// limb first. The magnitude has no leading zero limbs, zero is never negative.
+
+class BigInteger {
+public:
+    BigInteger() = default;
+    BigInteger(int64_t value);
+    // Decimal digits with an optional sign
+    explicit BigInteger(const std::string& digits);
+
+    bool IsNegative() const {
+        return is_negative_;
+    }
+
+    bool IsZero() const {
+        return magnitude_.empty();
+    }
+
+    bool FitsInt64() const;
+    int64_t ToInt64() const;
+    // Nearest double, may be infinite
+    double ToDouble() const;
+    std::string ToString() const;
+
+    BigInteger Abs() const;
+    BigInteger operator-() const;
+
+    friend BigInteger operator+(const BigInteger& lhs, const BigInteger& rhs);
+    friend BigInteger operator-(const BigInteger& lhs, const BigInteger& rhs);
+    friend BigInteger operator*(const BigInteger& lhs, const BigInteger& rhs);
+    // Truncates toward zero as division of int64_t does, the divisor must be non-zero
+    friend BigInteger operator/(const BigInteger& lhs, const BigInteger& rhs);
+
+    // Negative, zero or positive as lhs is less, equal or greater than rhs
+    friend int Compare(const BigInteger& lhs, const BigInteger& rhs);
+
+private:
+    using Limbs = std::vector<uint32_t>;
+
+    BigInteger(Limbs magnitude, bool is_negative);
+
+    static void Trim(Limbs* magnitude);
+    static int CompareMagnitudes(const Limbs& lhs, const Limbs& rhs);
+    static Limbs AddMagnitudes(const Limbs& lhs, const Limbs& rhs);
+    // lhs must not be less than rhs
+    static Limbs SubtractMagnitudes(const Limbs& lhs, const Limbs& rhs);
+    // *result += value * base^shift
+    static void AddShifted(Limbs* result, const Limbs& value, size_t shift);
+    static Limbs MultiplyMagnitudes(const Limbs& lhs, const Limbs& rhs);
+    static Limbs MultiplySchoolbook(const Limbs& lhs, const Limbs& rhs);
+    static Limbs MultiplyKaratsuba(const Limbs& lhs, const Limbs& rhs);
+    // *magnitude = *magnitude * factor + addend
+    static void MultiplyAddSmall(Limbs* magnitude, uint32_t factor, uint32_t addend);
+    // *magnitude /= divisor, returns the remainder
+    static uint32_t DivideSmall(Limbs* magnitude, uint32_t divisor);
+    static Limbs DivideMagnitudes(const Limbs& lhs, const Limbs& rhs);
+
+    Limbs magnitude_;
+    bool is_negative_ = false;
+};
@@ -0,0 +1,158 @@
+#include "char_kernels.h"
+
+#include "tokenizer.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_KERNELS_SUPPORTED
+#include <immintrin.h>
+#endif
+
+template <CharClass kClass>
+static size_t SkipScalar(const char* data, size_t size) {
+    size_t i = 0;
+    while (i < size && HasCharClass(data[i], kClass)) {
+        ++i;
+    }
+    return i;
+}
+
+static const CharKernels kScalarCharKernels = {
+    SkipScalar<SPACE_CLASS>,
+    SkipScalar<DIGIT_CLASS>,
+    SkipScalar<PART_OF_SYMBOL_CLASS>,
+};
+
+#ifdef SIMD_KERNELS_SUPPORTED
+
+// Chars are compared as signed bytes, so bytes outside of ASCII are never in a class.
+// A chunk of chars is mapped to a mask which has all the bits of the chars of the class set,
+// the run ends at the first char with clear bits.
+
+///////////////////////////////////////////////////////////////////////////////
+
+// SSE2 is a part of x86-64, so it's always supported
+
+static __m128i InRangeSse2(__m128i chars, char low, char high) {
+    return _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8(low - 1)),
+                         _mm_cmplt_epi8(chars, _mm_set1_epi8(high + 1)));
+}
+
+static __m128i EqualSse2(__m128i chars, char c) {
+    return _mm_cmpeq_epi8(chars, _mm_set1_epi8(c));
+}
+
+static __m128i SpacesSse2(__m128i chars) {
+    return _mm_or_si128(EqualSse2(chars, SpaceChar), InRangeSse2(chars, '\t', '\r'));
+}
+
+static __m128i DigitsSse2(__m128i chars) {
+    return InRangeSse2(chars, '0', '9');
+}
+
+static __m128i SymbolCharsSse2(__m128i chars) {
+    __m128i lower_chars = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+    __m128i mask = _mm_or_si128(InRangeSse2(lower_chars, 'a', 'z'), DigitsSse2(chars));
+    mask = _mm_or_si128(mask, InRangeSse2(chars, LessSignChar, GreaterSignChar));
+    for (char c : {AsterixChar, SlashChar, PoundChar, UnderscoreChar, MinusChar,
+                   QuestionSignChar, ExclamationSignChar}) {
+        mask = _mm_or_si128(mask, EqualSse2(chars, c));
+    }
+    return mask;
+}
+
+template <CharClass kClass, __m128i (*kMask)(__m128i)>
+static size_t SkipSse2(const char* data, size_t size) {
+    constexpr size_t kChunkSize = sizeof(__m128i);
+    size_t i = 0;
+    for (; i + kChunkSize <= size; i += kChunkSize) {
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        uint32_t others = ~static_cast<uint32_t>(_mm_movemask_epi8(kMask(chars))) & 0xFFFF;
+        if (others) {
+            return i + __builtin_ctz(others);
+        }
+    }
+    return i + SkipScalar<kClass>(data + i, size - i);
+}
+
+static const CharKernels kSse2CharKernels = {
+    SkipSse2<SPACE_CLASS, SpacesSse2>,
+    SkipSse2<DIGIT_CLASS, DigitsSse2>,
+    SkipSse2<PART_OF_SYMBOL_CLASS, SymbolCharsSse2>,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+#define AVX2_KERNEL __attribute__((target("avx2")))
+
+AVX2_KERNEL static __m256i InRangeAvx2(__m256i chars, char low, char high) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8(low - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), chars));
+}
+
+AVX2_KERNEL static __m256i EqualAvx2(__m256i chars, char c) {
+    return _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(c));
+}
+
+AVX2_KERNEL static __m256i SpacesAvx2(__m256i chars) {
+    return _mm256_or_si256(EqualAvx2(chars, SpaceChar), InRangeAvx2(chars, '\t', '\r'));
+}
+
+AVX2_KERNEL static __m256i DigitsAvx2(__m256i chars) {
+    return InRangeAvx2(chars, '0', '9');
+}
+
+AVX2_KERNEL static __m256i SymbolCharsAvx2(__m256i chars) {
+    __m256i lower_chars = _mm256_or_si256(chars, _mm256_set1_epi8(0x20));
+    __m256i mask = _mm256_or_si256(InRangeAvx2(lower_chars, 'a', 'z'), DigitsAvx2(chars));
+    mask = _mm256_or_si256(mask, InRangeAvx2(chars, LessSignChar, GreaterSignChar));
+    for (char c : {AsterixChar, SlashChar, PoundChar, UnderscoreChar, MinusChar,
+                   QuestionSignChar, ExclamationSignChar}) {
+        mask = _mm256_or_si256(mask, EqualAvx2(chars, c));
+    }
+    return mask;
+}
+
+// The tail shorter than a chunk is left to SSE2
+template <CharClass kClass, __m256i (*kMask)(__m256i), __m128i (*kTailMask)(__m128i)>
+AVX2_KERNEL static size_t SkipAvx2(const char* data, size_t size) {
+    constexpr size_t kChunkSize = sizeof(__m256i);
+    size_t i = 0;
+    for (; i + kChunkSize <= size; i += kChunkSize) {
+        __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        uint32_t others = ~static_cast<uint32_t>(_mm256_movemask_epi8(kMask(chars)));
+        if (others) {
+            return i + __builtin_ctz(others);
+        }
+    }
+    return i + SkipSse2<kClass, kTailMask>(data + i, size - i);
+}
+
+static const CharKernels kAvx2CharKernels = {
+    SkipAvx2<SPACE_CLASS, SpacesAvx2, SpacesSse2>,
+    SkipAvx2<DIGIT_CLASS, DigitsAvx2, DigitsSse2>,
+    SkipAvx2<PART_OF_SYMBOL_CLASS, SymbolCharsAvx2, SymbolCharsSse2>,
+};
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+static const CharKernels& SelectCharKernels() {
+#ifdef SIMD_KERNELS_SUPPORTED
+    if (__builtin_cpu_supports("avx2")) {
+        return kAvx2CharKernels;
+    }
+    return kSse2CharKernels;
+#else
+    return kScalarCharKernels;
+#endif
+}
+
+const CharKernels& GetCharKernels() {
+    static const CharKernels& kernels = SelectCharKernels();
+    return kernels;
+}
+
+const CharKernels& GetScalarCharKernels() {
+    return kScalarCharKernels;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+
+// Kernels of the tokenizer which scan runs of chars of one class in a buffer
+// Each returns the length of the run at the start of data, at most size.
+// The set is chosen once by the CPU at hand: AVX2 or SSE2 compare 32 or 16 chars at a time,
+// the scalar set looks every char up in kCharClasses (see tokenizer.h).
+
+struct CharKernels {
+    size_t (*skip_spaces)(const char* data, size_t size);
+    size_t (*skip_digits)(const char* data, size_t size);
+    size_t (*skip_symbol_chars)(const char* data, size_t size);
+};
+
+// The fastest kernels supported by the CPU
+const CharKernels& GetCharKernels();
+
+// Plain loops, available everywhere
+const CharKernels& GetScalarCharKernels();
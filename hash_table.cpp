@@ -0,0 +1,173 @@
+#include "object.h"
+
+// The table grows when it's more than 3/4 full, which keeps probe sequences short
+constexpr size_t kMaxLoadNumerator = 3;
+constexpr size_t kMaxLoadDenominator = 4;
+
+constexpr uint64_t kOccupiedSlotBit = uint64_t(1) << 63;
+
+// Hash table's realization
+
+uint64_t HashTable::Hash(ObjectPtr key) const {
+    uint64_t hash = (equivalence_ == KeyEquivalence::EQUAL) ? HashEqual(key) : HashEqv(key);
+    return hash | kOccupiedSlotBit;
+}
+
+size_t HashTable::FindSlot(ObjectPtr key, uint64_t hash) const {
+    size_t mask = slots_.size() - 1;
+    size_t index = hash & mask;
+    while (slots_[index].hash != 0) {
+        const Slot& slot = slots_[index];
+        if (slot.hash == hash && ((equivalence_ == KeyEquivalence::EQUAL)
+                                      ? IsEqual(slot.key, key)
+                                      : IsEqv(slot.key, key))) {
+            return index;
+        }
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+ObjectPtr* HashTable::Find(ObjectPtr key) {
+    Slot& slot = slots_[FindSlot(key, Hash(key))];
+    return (slot.hash != 0) ? &slot.value : nullptr;
+}
+
+void HashTable::Set(ObjectPtr key, ObjectPtr value) {
+    uint64_t hash = Hash(key);
+    size_t index = FindSlot(key, hash);
+    if (slots_[index].hash != 0) {
+        slots_[index].value = value;
+        return;
+    }
+    if ((count_ + 1) * kMaxLoadDenominator > slots_.size() * kMaxLoadNumerator) {
+        Grow();
+        index = FindSlot(key, hash);
+    }
+    slots_[index] = Slot{hash, key, value};
+    ++count_;
+}
+
+bool HashTable::Erase(ObjectPtr key) {
+    size_t mask = slots_.size() - 1;
+    size_t index = FindSlot(key, Hash(key));
+    if (slots_[index].hash == 0) {
+        return false;
+    }
+    // the following slots of the probe run are shifted back unless that moves
+    // a key before its home slot
+    size_t next = index;
+    while (true) {
+        next = (next + 1) & mask;
+        if (slots_[next].hash == 0) {
+            break;
+        }
+        size_t home = slots_[next].hash & mask;
+        bool stays = (index < next) ? (index < home && home <= next)
+                                    : (index < home || home <= next);
+        if (!stays) {
+            slots_[index] = slots_[next];
+            index = next;
+        }
+    }
+    slots_[index] = Slot{};
+    --count_;
+    return true;
+}
+
+void HashTable::Grow() {
+    std::vector<Slot> old_slots(slots_.size() * 2);
+    old_slots.swap(slots_);
+    size_t mask = slots_.size() - 1;
+    for (const Slot& slot : old_slots) {
+        if (slot.hash == 0) {
+            continue;
+        }
+        size_t index = slot.hash & mask;
+        while (slots_[index].hash != 0) {
+            index = (index + 1) & mask;
+        }
+        slots_[index] = slot;
+    }
+}
+
+ObjectPtrVector HashTable::GetKeys() const {
+    ObjectPtrVector keys;
+    keys.reserve(count_);
+    for (const Slot& slot : slots_) {
+        if (slot.hash != 0) {
+            keys.push_back(slot.key);
+        }
+    }
+    return keys;
+}
+
+std::string HashTable::Serialize() {
+    return "#<hash-table " + std::to_string(count_) + ">";
+}
+
+// Hash table functions' realization
+
+ObjectPtr MakeHashTableFunction::Apply(ObjectPtrSpan arguments) {
+    if (arguments.empty()) {
+        return Heap::Instance().Make<HashTable>(KeyEquivalence::EQUAL);
+    }
+    ThrowIfWrongNumberOfArguments(1, arguments, "Make-hash-table");
+    auto symbol = As<Symbol>(arguments[0]);
+    if (symbol && symbol->GetName() == "equal") {
+        return Heap::Instance().Make<HashTable>(KeyEquivalence::EQUAL);
+    } else if (symbol && symbol->GetName() == "eqv") {
+        return Heap::Instance().Make<HashTable>(KeyEquivalence::EQV);
+    }
+    throw RuntimeError("Equivalence for make-hash-table must be 'equal or 'eqv.");
+}
+
+ObjectPtr HashTableRefFunction::Apply(ObjectPtrSpan arguments) {
+    if (arguments.size() != 2 && arguments.size() != 3) {
+        throw RuntimeError("Wrong number of arguments for hash-table-ref.");
+    }
+    ThrowIfMismatchOperandType<HashTable>(0, arguments,
+                                          "First operand for hash-table-ref must be hash table.");
+    ObjectPtr* value = As<HashTable>(arguments[0])->Find(arguments[1]);
+    if (value) {
+        return *value;
+    } else if (arguments.size() == 3) {
+        return arguments[2];
+    }
+    throw RuntimeError("There is no such key in the hash table.");
+}
+
+ObjectPtr HashTableSetFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(3, arguments, "Hash-table-set");
+    ThrowIfMismatchOperandType<HashTable>(0, arguments,
+                                          "First operand for hash-table-set! must be hash table.");
+    As<HashTable>(arguments[0])->Set(arguments[1], arguments[2]);
+    return nullptr;
+}
+
+ObjectPtr HashTableDeleteFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(2, arguments, "Hash-table-delete");
+    ThrowIfMismatchOperandType<HashTable>(
+        0, arguments, "First operand for hash-table-delete! must be hash table.");
+    As<HashTable>(arguments[0])->Erase(arguments[1]);
+    return nullptr;
+}
+
+ObjectPtr HashTableCountFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Hash-table-count");
+    ThrowIfMismatchOperandType<HashTable>(0, arguments,
+                                          "Operand for hash-table-count must be hash table.");
+    return Heap::Instance().Make<Number>(As<HashTable>(arguments[0])->GetCount());
+}
+
+ObjectPtr HashTableKeysFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Hash-table-keys");
+    ThrowIfMismatchOperandType<HashTable>(0, arguments,
+                                          "Operand for hash-table-keys must be hash table.");
+    ObjectPtrVector keys = As<HashTable>(arguments[0])->GetKeys();
+    ObjectPtr list = nullptr;
+    for (auto it = keys.rbegin(); it != keys.rend(); ++it) {
+        list = Heap::Instance().Make<Cell>(*it, list);
+    }
+    return list;
+}
@@ -1,30 +1,29 @@
 #include "object.h"
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <typeindex>
+#include <unordered_set>
 #include <vector>
 
-ObjectPtrVector EvaluateListArguments(const ObjectPtrVector& vectorized_list, ContextPtr context) {
-    ObjectPtrVector evaluated_vector(vectorized_list.size());
-    for (size_t i = 0; i < vectorized_list.size(); ++i) {
-        evaluated_vector[i] = EvaluateExpression(vectorized_list[i], context);
+bool EvaluateArguments(const ObjectPtrVector& operands, ContextPtr context, ObjectPtr* evaluated) {
+    for (size_t i = 0; i < operands.size(); ++i) {
+        evaluated[i] = EvaluateExpression(operands[i], context);
+        if (IsEscaping(evaluated[i])) {
+            return false;
+        }
     }
-    return evaluated_vector;
+    return true;
 }
 
 ObjectPtr EvaluateExpression(ObjectPtr ast, ContextPtr context) {
-    if (Is<Number>(ast) || Is<BooleanSymbol>(ast) || Is<Symbol>(ast)) {
-        return ast->Evaluate(context);
-    } else if (Is<Cell>(ast)) {
-        ObjectPtr head = As<Cell>(ast)->GetFirst();
-        ObjectPtr tail = As<Cell>(ast)->GetSecond();
-        ObjectPtr symbol_evaluated = EvaluateExpression(head, context);
-        if (!symbol_evaluated) {
-            throw RuntimeError("First element of pair must be applicable.");
-        }
-        ObjectPtr evaluation_result = symbol_evaluated->Apply(ListToVector(tail));
-        return evaluation_result;
-    } else {
+    if (!ast) {
         throw RuntimeError("Cannot evaluate AST.");
     }
+    return ast->Evaluate(context);
 }
 
 ObjectPtrVector ListToVector(ObjectPtr cell) {
@@ -52,22 +51,120 @@ ObjectPtrVector CloneObjectPtrVector(const ObjectPtrVector& list) {
     return cloned_vector;
 }
 
-void ThrowIfZeroDivisors(const ObjectPtrVector& list) {
+bool IsInteger(ObjectPtr ptr) {
+    return Is<Number>(ptr) || Is<BigNumber>(ptr);
+}
+
+bool IsNumber(ObjectPtr ptr) {
+    return IsInteger(ptr) || Is<FloatNumber>(ptr);
+}
+
+void ThrowIfNotNumbers(ObjectPtrSpan list, const std::string& message) {
+    for (ObjectPtr ptr : list) {
+        if (!IsNumber(ptr)) {
+            throw RuntimeError(message);
+        }
+    }
+}
+
+bool HasFloats(ObjectPtrSpan list) {
+    for (ObjectPtr ptr : list) {
+        if (Is<FloatNumber>(ptr)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+BigInteger ToBigInteger(ObjectPtr integer) {
+    if (auto number = As<Number>(integer)) {
+        return BigInteger(number->GetValue());
+    }
+    return As<BigNumber>(integer)->GetValue();
+}
+
+double ToDouble(ObjectPtr number) {
+    if (auto integer = As<Number>(number)) {
+        return static_cast<double>(integer->GetValue());
+    } else if (auto float_number = As<FloatNumber>(number)) {
+        return float_number->GetValue();
+    }
+    return As<BigNumber>(number)->GetValue().ToDouble();
+}
+
+// Exact value of a finite float without a fractional part
+static BigInteger IntegralFloatToBigInteger(double value) {
+    if (std::fabs(value) < 0x1p62) {
+        return BigInteger(static_cast<int64_t>(value));
+    }
+    // value = mantissa * 2^53 * 2^(exponent - 53), where the exponent is above 62
+    int exponent = 0;
+    double mantissa = std::frexp(value, &exponent);
+    BigInteger result{static_cast<int64_t>(std::ldexp(mantissa, 53))};
+    for (int shift = exponent - 53; shift > 0; shift -= 30) {
+        result = result * BigInteger(int64_t{1} << std::min(shift, 30));
+    }
+    return result;
+}
+
+int CompareIntegerToFloat(ObjectPtr integer, double value) {
+    if (std::isinf(value)) {
+        return (value > 0) ? -1 : 1;
+    }
+    if (auto number = As<Number>(integer)) {
+        // integers up to 2^53 are doubles exactly
+        int64_t fixnum = number->GetValue();
+        if (fixnum >= -kMaxExactFloatInteger && fixnum <= kMaxExactFloatInteger) {
+            double fixnum_value = static_cast<double>(fixnum);
+            return (fixnum_value < value) ? -1 : (fixnum_value > value);
+        }
+    }
+    double floor = std::floor(value);
+    int comparison = Compare(ToBigInteger(integer), IntegralFloatToBigInteger(floor));
+    // an integer equal to the floor of a fractional value is less than the value
+    return (comparison == 0 && floor != value) ? -1 : comparison;
+}
+
+ObjectPtr MakeInteger(const BigInteger& value) {
+    if (value.FitsInt64()) {
+        return Heap::Instance().Make<Number>(value.ToInt64());
+    }
+    return Heap::Instance().Make<BigNumber>(value);
+}
+
+std::string SerializeFloat(double value) {
+    if (std::isnan(value)) {
+        return "+nan.0";
+    } else if (std::isinf(value)) {
+        return (value > 0) ? "+inf.0" : "-inf.0";
+    }
+    // the shortest representation which reads back as the same double
+    std::array<char, 32> buffer;
+    auto end = std::to_chars(buffer.begin(), buffer.end(), value).ptr;
+    std::string result(buffer.begin(), end);
+    if (result.find_first_of(".e") == std::string::npos) {
+        result += ".0";
+    }
+    return result;
+}
+
+void ThrowIfZeroDivisors(ObjectPtrSpan list) {
+    // a BigNumber is never zero
     for (size_t i = 1; i < list.size(); ++i) {
-        if (As<Number>(list[i])->GetValue() == 0) {
+        if (Is<Number>(list[i]) && As<Number>(list[i])->GetValue() == 0) {
             throw RuntimeError("Division by zero.");
         }
     }
 }
 
-void ThrowIfWrongNumberOfArguments(size_t number, const ObjectPtrVector& list,
+void ThrowIfWrongNumberOfArguments(size_t number, ObjectPtrSpan list,
                                    const std::string& func_name) {
     if (list.size() != number) {
         throw RuntimeError(func_name + " takes only " + std::to_string(number) + " argument.");
     }
 }
 
-void ValidateArgumentsForListTailAndRef(const ObjectPtrVector& list) {
+void ValidateArgumentsForListTailAndRef(ObjectPtrSpan list) {
     ThrowIfWrongNumberOfArguments(2, list, "List-ref (tail)");
     if (!As<BooleanSymbol>(CheckIfList(list[0]))->IsTrue()) {
         throw RuntimeError("First operand for list-ref (tail) must be list.");
@@ -83,15 +180,144 @@ void ValidateArgumentsForListTailAndRef(const ObjectPtrVector& list) {
 ObjectPtr CheckIfList(ObjectPtr ptr) {
     ObjectPtr cell = ptr;
     if (!Is<Cell>(cell)) {
-        if (!cell) {
-            return Heap::Instance().Make<BooleanSymbol>("#t");
-        } else {
-            return Heap::Instance().Make<BooleanSymbol>("#f");
-        }
+        return GetBooleanSymbol(!cell);
     }
     while (Is<Cell>(As<Cell>(cell)->GetSecond())) {
         cell = As<Cell>(cell)->GetSecond();
     }
-    return (!As<Cell>(cell)->GetSecond()) ? Heap::Instance().Make<BooleanSymbol>("#t")
-                                          : Heap::Instance().Make<BooleanSymbol>("#f");
-}
\ No newline at end of file
+    return GetBooleanSymbol(!As<Cell>(cell)->GetSecond());
+}
+
+bool IsApplicable(ObjectPtr ptr) {
+    // built-in functions have no state, so they are told by their types
+    static const std::unordered_set<std::type_index> kBuiltInTypes = [] {
+        std::unordered_set<std::type_index> types;
+        for (const auto& [name, function] : kValidFunctionsMap) {
+            types.emplace(typeid(*function));
+        }
+        return types;
+    }();
+    return Is<LambdaFunction>(ptr) || Is<MemoizedFunction>(ptr) || Is<EscapeProcedure>(ptr) ||
+           (ptr && kBuiltInTypes.contains(typeid(*ptr)));
+}
+
+bool IsTruthy(ObjectPtr ptr) {
+    return !Is<BooleanSymbol>(ptr) || As<BooleanSymbol>(ptr)->IsTrue();
+}
+
+bool IsEqv(ObjectPtr lhs, ObjectPtr rhs) {
+    if (lhs == rhs) {
+        return true;
+    }
+    if (Is<Number>(lhs) && Is<Number>(rhs)) {
+        return As<Number>(lhs)->GetValue() == As<Number>(rhs)->GetValue();
+    } else if (Is<BigNumber>(lhs) && Is<BigNumber>(rhs)) {
+        return Compare(As<BigNumber>(lhs)->GetValue(), As<BigNumber>(rhs)->GetValue()) == 0;
+    } else if (Is<FloatNumber>(lhs) && Is<FloatNumber>(rhs)) {
+        // bitwise, so that NaN is eqv to itself and 0.0 is not eqv to -0.0
+        return std::bit_cast<uint64_t>(As<FloatNumber>(lhs)->GetValue()) ==
+               std::bit_cast<uint64_t>(As<FloatNumber>(rhs)->GetValue());
+    } else if (Is<Symbol>(lhs) && Is<Symbol>(rhs)) {
+        return As<Symbol>(lhs)->GetName() == As<Symbol>(rhs)->GetName();
+    }
+    return false;
+}
+
+bool IsEqual(ObjectPtr lhs, ObjectPtr rhs) {
+    // lists are walked by their tails without recursion
+    while (Is<Cell>(lhs) && Is<Cell>(rhs)) {
+        if (!IsEqual(As<Cell>(lhs)->GetFirst(), As<Cell>(rhs)->GetFirst())) {
+            return false;
+        }
+        lhs = As<Cell>(lhs)->GetSecond();
+        rhs = As<Cell>(rhs)->GetSecond();
+    }
+    if (Is<String>(lhs) && Is<String>(rhs)) {
+        return As<String>(lhs)->GetView() == As<String>(rhs)->GetView();
+    } else if (Is<Vector>(lhs) && Is<Vector>(rhs)) {
+        const ObjectPtrVector& lhs_elements = As<Vector>(lhs)->GetElements();
+        const ObjectPtrVector& rhs_elements = As<Vector>(rhs)->GetElements();
+        if (lhs_elements.size() != rhs_elements.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < lhs_elements.size(); ++i) {
+            if (!IsEqual(lhs_elements[i], rhs_elements[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return IsEqv(lhs, rhs);
+}
+
+// Finalizer of MurmurHash3, spreads every input bit over the whole hash
+static uint64_t MixHash(uint64_t value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+
+static uint64_t CombineHashes(uint64_t seed, uint64_t hash) {
+    return MixHash(seed ^ (hash + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+uint64_t HashEqv(ObjectPtr object) {
+    if (auto number = As<Number>(object)) {
+        return MixHash(number->GetValue());
+    } else if (auto big_number = As<BigNumber>(object)) {
+        return std::hash<std::string>()(big_number->GetValue().ToString());
+    } else if (auto float_number = As<FloatNumber>(object)) {
+        return MixHash(~std::bit_cast<uint64_t>(float_number->GetValue()));
+    } else if (auto symbol = As<Symbol>(object)) {
+        return std::hash<std::string>()(symbol->GetName());
+    }
+    return MixHash(reinterpret_cast<uintptr_t>(object));
+}
+
+// Elements hashed at most, the rest of a long or cyclic structure doesn't affect the hash
+constexpr size_t kMaxHashedElements = 64;
+
+static uint64_t HashEqual(ObjectPtr object, size_t* budget) {
+    if (*budget == 0) {
+        return 0;
+    }
+    --*budget;
+    if (Is<Cell>(object)) {
+        uint64_t hash = 1;
+        while (Is<Cell>(object) && *budget > 0) {
+            hash = CombineHashes(hash, HashEqual(As<Cell>(object)->GetFirst(), budget));
+            object = As<Cell>(object)->GetSecond();
+        }
+        return (Is<Cell>(object)) ? hash : CombineHashes(hash, HashEqual(object, budget));
+    } else if (auto string = As<String>(object)) {
+        return std::hash<std::string_view>()(string->GetView());
+    } else if (auto vector = As<Vector>(object)) {
+        uint64_t hash = 2;
+        for (ObjectPtr element : vector->GetElements()) {
+            if (*budget == 0) {
+                break;
+            }
+            hash = CombineHashes(hash, HashEqual(element, budget));
+        }
+        return hash;
+    } else if (!object) {
+        return 3;
+    }
+    return HashEqv(object);
+}
+
+uint64_t HashEqual(ObjectPtr object) {
+    size_t budget = kMaxHashedElements;
+    return HashEqual(object, &budget);
+}
+
+uint64_t HashEqualArguments(ObjectPtrSpan arguments) {
+    uint64_t hash = arguments.size();
+    for (ObjectPtr argument : arguments) {
+        hash = CombineHashes(hash, HashEqual(argument));
+    }
+    return hash;
+}
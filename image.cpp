@@ -0,0 +1,843 @@
+#include "image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <typeindex>
+
+#include "analyzer.h"
+#include "macro.h"
+#include "optimizer.h"
+
+// Format: a header and the records of objects, each is a tag, the size of its fields and
+// the fields. Records go in the order the objects can be made in: everything an object is
+// constructed from is recorded before it. Cells, vectors, hash tables, scopes, macros and
+// define-syntax nodes are made empty and filled once all the objects exist, so data, scopes
+// and closures may refer to each other in cycles. A reference is the number of a record counted from 1,
+// 0 is the empty list. Numbers are written in the native byte order.
+
+constexpr char kImageMagic[8] = {'S', 'C', 'M', 'I', 'M', 'A', 'G', 'E'};
+constexpr uint32_t kImageVersion = 1;
+// An image of the other byte order has it reversed
+constexpr uint32_t kImageByteOrderMark = 0x01020304;
+
+enum class ImageTag : uint8_t {
+    // the context and the global scope the image is restored into
+    ROOT_CONTEXT,
+    GLOBAL_SCOPE,
+    CONTEXT,
+    SCOPE,
+    NUMBER,
+    BIG_NUMBER,
+    FLOAT_NUMBER,
+    SYMBOL,
+    BOOLEAN,
+    STRING,
+    BUILT_IN,
+    CELL,
+    VECTOR,
+    S64VECTOR,
+    F64VECTOR,
+    HASH_TABLE,
+    LAMBDA,
+    MEMOIZED,
+    SYNTAX_RULES,
+    QUOTE_NODE,
+    IF_NODE,
+    DEFINE_NODE,
+    SET_NODE,
+    LAMBDA_NODE,
+    AND_NODE,
+    OR_NODE,
+    BEGIN_NODE,
+    COND_ARROW_NODE,
+    CASE_NODE,
+    LET_NODE,
+    LOOP_NODE,
+    NAMED_LET_NODE,
+    DELAY_NODE,
+    APPLICATION_NODE,
+    TAIL_CALL_NODE,
+    GUARDED_NODE,
+    DEFINE_SYNTAX_NODE,
+};
+
+// Built-in functions have no state, so any object of a built-in's type is that built-in
+static const std::string* FindBuiltInName(ObjectPtr object) {
+    static const std::unordered_map<std::type_index, std::string> kBuiltInNames = [] {
+        std::unordered_map<std::type_index, std::string> names;
+        for (const auto& [name, function] : kValidFunctionsMap) {
+            names.emplace(typeid(*function), name);
+        }
+        return names;
+    }();
+    auto found = kBuiltInNames.find(typeid(*object));
+    return (found != kBuiltInNames.end()) ? &found->second : nullptr;
+}
+
+// Objects which are made empty and filled after all the objects are made
+static bool IsFilledLater(ObjectPtr object) {
+    return Is<Cell>(object) || Is<Vector>(object) || Is<HashTable>(object) ||
+           Is<Scope>(object) || Is<SyntaxRules>(object) || Is<DefineSyntaxNode>(object);
+}
+
+// A guard which has fallen back is saved as its original node
+static ObjectPtr Resolve(ObjectPtr object) {
+    auto guarded = As<GuardedNode>(object);
+    return (guarded && guarded->GetActive() != guarded->GetOptimized()) ? guarded->GetOriginal()
+                                                                        : object;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Writing of images
+
+class ImageWriter {
+public:
+    explicit ImageWriter(ContextPtr context)
+        : context_(context), global_scope_(context->GetScopes().front()) {
+        if (!context->IsGlobal()) {
+            throw RuntimeError("Image can be made only at top level.");
+        }
+    }
+
+    std::string Write();
+
+private:
+    // Collects references of an object
+    struct ReferencesSink {
+        void Tag(ImageTag) {
+        }
+        void Count(uint64_t) {
+        }
+        void Integer(int64_t) {
+        }
+        void Float(double) {
+        }
+        void Flag(bool) {
+        }
+        void Name(std::string_view) {
+        }
+        void Bytes(const void*, size_t) {
+        }
+        void Reference(ObjectPtr object) {
+            if (object) {
+                references.push_back(Resolve(object));
+            }
+        }
+
+        ObjectPtrVector references;
+    };
+
+    // Appends the record of an object to the image
+    struct RecordSink {
+        template <typename T>
+        void Append(const T& value) {
+            image->append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+        void Tag(ImageTag tag) {
+            Append(tag);
+            size_position = image->size();
+            Append(uint64_t{0});
+        }
+        void Count(uint64_t count) {
+            Append(count);
+        }
+        void Integer(int64_t value) {
+            Append(value);
+        }
+        void Float(double value) {
+            Append(value);
+        }
+        void Flag(bool value) {
+            Append(static_cast<uint8_t>(value));
+        }
+        void Name(std::string_view name) {
+            Count(name.size());
+            image->append(name);
+        }
+        void Bytes(const void* data, size_t size) {
+            image->append(static_cast<const char*>(data), size);
+        }
+        void Reference(ObjectPtr object) {
+            Append((object) ? numbers->at(Resolve(object)) : uint64_t{0});
+        }
+        // Writes the size of the fields once they are written
+        void Finish() {
+            uint64_t size = image->size() - size_position - sizeof(uint64_t);
+            std::memcpy(image->data() + size_position, &size, sizeof(size));
+        }
+
+        std::string* image;
+        const std::unordered_map<ObjectPtr, uint64_t>* numbers;
+        size_t size_position = 0;
+    };
+
+    template <typename Sink>
+    static void VisitReferences(const ObjectPtrVector& objects, Sink* sink) {
+        sink->Count(objects.size());
+        for (ObjectPtr object : objects) {
+            sink->Reference(object);
+        }
+    }
+
+    // Goes over the fields of the object in the order of its record
+    template <typename Sink>
+    void VisitFields(ObjectPtr object, Sink* sink);
+
+    // Objects reachable from the root context in the order of records
+    ObjectPtrVector CollectObjects();
+
+    ContextPtr context_;
+    ScopePtr global_scope_;
+};
+
+template <typename Sink>
+void ImageWriter::VisitFields(ObjectPtr object, Sink* sink) {
+    if (const std::string* name = FindBuiltInName(object)) {
+        sink->Tag(ImageTag::BUILT_IN);
+        sink->Name(*name);
+    } else if (auto context = As<Context>(object)) {
+        sink->Tag((context == context_) ? ImageTag::ROOT_CONTEXT : ImageTag::CONTEXT);
+        sink->Count(context->GetScopes().size());
+        for (ScopePtr scope : context->GetScopes()) {
+            sink->Reference(scope);
+        }
+    } else if (auto scope = As<Scope>(object)) {
+        std::vector<std::pair<std::string_view, ObjectPtr>> bindings;
+        for (const auto& [name, value] : scope->GetBindings()) {
+            // built-ins are bound in the scope the image is restored into anyway
+            auto built_in = kValidFunctionsMap.find(name);
+            if (scope != global_scope_ || built_in == kValidFunctionsMap.end() ||
+                built_in->second != value) {
+                bindings.emplace_back(name, value);
+            }
+        }
+        sink->Tag((scope == global_scope_) ? ImageTag::GLOBAL_SCOPE : ImageTag::SCOPE);
+        sink->Count(bindings.size());
+        for (const auto& [name, value] : bindings) {
+            sink->Name(name);
+            sink->Reference(value);
+        }
+    } else if (auto number = As<Number>(object)) {
+        sink->Tag(ImageTag::NUMBER);
+        sink->Integer(number->GetValue());
+    } else if (auto big_number = As<BigNumber>(object)) {
+        sink->Tag(ImageTag::BIG_NUMBER);
+        sink->Name(big_number->GetValue().ToString());
+    } else if (auto float_number = As<FloatNumber>(object)) {
+        sink->Tag(ImageTag::FLOAT_NUMBER);
+        sink->Float(float_number->GetValue());
+    } else if (auto symbol = As<Symbol>(object)) {
+        sink->Tag(ImageTag::SYMBOL);
+        sink->Name(symbol->GetName());
+    } else if (auto boolean = As<BooleanSymbol>(object)) {
+        sink->Tag(ImageTag::BOOLEAN);
+        sink->Flag(boolean->IsTrue());
+    } else if (auto string = As<String>(object)) {
+        sink->Tag(ImageTag::STRING);
+        sink->Name(string->GetView());
+    } else if (auto cell = As<Cell>(object)) {
+        sink->Tag(ImageTag::CELL);
+        sink->Reference(cell->GetFirst());
+        sink->Reference(cell->GetSecond());
+    } else if (auto vector = As<Vector>(object)) {
+        sink->Tag(ImageTag::VECTOR);
+        VisitReferences(vector->GetElements(), sink);
+    } else if (auto s64vector = As<S64Vector>(object)) {
+        sink->Tag(ImageTag::S64VECTOR);
+        sink->Count(s64vector->GetSize());
+        sink->Bytes(s64vector->GetData(), s64vector->GetSize() * sizeof(int64_t));
+    } else if (auto f64vector = As<F64Vector>(object)) {
+        sink->Tag(ImageTag::F64VECTOR);
+        sink->Count(f64vector->GetSize());
+        sink->Bytes(f64vector->GetData(), f64vector->GetSize() * sizeof(double));
+    } else if (auto hash_table = As<HashTable>(object)) {
+        sink->Tag(ImageTag::HASH_TABLE);
+        sink->Flag(hash_table->GetEquivalence() == KeyEquivalence::EQUAL);
+        ObjectPtrVector keys = hash_table->GetKeys();
+        sink->Count(keys.size());
+        for (ObjectPtr key : keys) {
+            sink->Reference(key);
+            sink->Reference(*hash_table->Find(key));
+        }
+    } else if (auto lambda = As<LambdaFunction>(object)) {
+        sink->Tag(ImageTag::LAMBDA);
+        VisitReferences(lambda->GetArgs(), sink);
+        VisitReferences(lambda->GetBody(), sink);
+        sink->Reference(lambda->GetCapturedContext());
+        sink->Flag(lambda->IsTiered());
+    } else if (auto memoized = As<MemoizedFunction>(object)) {
+        // the cache isn't saved
+        sink->Tag(ImageTag::MEMOIZED);
+        sink->Reference(memoized->GetFunction());
+        sink->Count(memoized->GetCapacity());
+    } else if (auto syntax_rules = As<SyntaxRules>(object)) {
+        sink->Tag(ImageTag::SYNTAX_RULES);
+        sink->Count(syntax_rules->GetLiterals().size());
+        for (const std::string& literal : syntax_rules->GetLiterals()) {
+            sink->Name(literal);
+        }
+        auto rules = syntax_rules->GetRules();
+        sink->Count(rules.size());
+        for (const auto& [pattern, templ] : rules) {
+            sink->Reference(pattern);
+            sink->Reference(templ);
+        }
+    } else if (auto quote = As<QuoteNode>(object)) {
+        sink->Tag(ImageTag::QUOTE_NODE);
+        sink->Reference(quote->GetDatum());
+    } else if (auto if_node = As<IfNode>(object)) {
+        sink->Tag(ImageTag::IF_NODE);
+        sink->Flag(if_node->HasAlternative());
+        sink->Reference(if_node->GetCondition());
+        sink->Reference(if_node->GetConsequent());
+        sink->Reference(if_node->GetAlternative());
+    } else if (auto define = As<DefineNode>(object)) {
+        sink->Tag(ImageTag::DEFINE_NODE);
+        sink->Name(define->GetName());
+        sink->Reference(define->GetValue());
+    } else if (auto define_syntax = As<DefineSyntaxNode>(object)) {
+        sink->Tag(ImageTag::DEFINE_SYNTAX_NODE);
+        sink->Name(define_syntax->GetName());
+        sink->Reference(define_syntax->GetRules());
+    } else if (auto set = As<SetNode>(object)) {
+        sink->Tag(ImageTag::SET_NODE);
+        sink->Name(set->GetName());
+        sink->Reference(set->GetValue());
+    } else if (auto lambda_node = As<LambdaNode>(object)) {
+        sink->Tag(ImageTag::LAMBDA_NODE);
+        VisitReferences(lambda_node->GetArgs(), sink);
+        VisitReferences(lambda_node->GetBody(), sink);
+        sink->Flag(lambda_node->IsTiered());
+    } else if (auto and_node = As<AndNode>(object)) {
+        sink->Tag(ImageTag::AND_NODE);
+        VisitReferences(and_node->GetOperands(), sink);
+    } else if (auto or_node = As<OrNode>(object)) {
+        sink->Tag(ImageTag::OR_NODE);
+        VisitReferences(or_node->GetOperands(), sink);
+    } else if (auto begin = As<BeginNode>(object)) {
+        sink->Tag(ImageTag::BEGIN_NODE);
+        VisitReferences(begin->GetBody(), sink);
+    } else if (auto cond_arrow = As<CondArrowNode>(object)) {
+        sink->Tag(ImageTag::COND_ARROW_NODE);
+        sink->Flag(cond_arrow->HasAlternative());
+        sink->Reference(cond_arrow->GetTest());
+        sink->Reference(cond_arrow->GetReceiver());
+        sink->Reference(cond_arrow->GetAlternative());
+    } else if (auto case_node = As<CaseNode>(object)) {
+        sink->Tag(ImageTag::CASE_NODE);
+        sink->Reference(case_node->GetKey());
+        sink->Count(case_node->GetData().size());
+        for (const ObjectPtrVector& data : case_node->GetData()) {
+            VisitReferences(data, sink);
+        }
+        VisitReferences(case_node->GetBodies(), sink);
+        sink->Flag(case_node->HasElse());
+        sink->Reference(case_node->GetElseBody());
+    } else if (auto let = As<LetNode>(object)) {
+        sink->Tag(ImageTag::LET_NODE);
+        sink->Count(static_cast<uint64_t>(let->GetKind()));
+        sink->Count(let->GetNames().size());
+        for (const std::string& name : let->GetNames()) {
+            sink->Name(name);
+        }
+        VisitReferences(let->GetValues(), sink);
+        VisitReferences(let->GetBody(), sink);
+    } else if (auto loop = As<LoopNode>(object)) {
+        sink->Tag(ImageTag::LOOP_NODE);
+        sink->Name(loop->GetName());
+        VisitReferences(loop->GetArgs(), sink);
+        VisitReferences(loop->GetBody(), sink);
+    } else if (auto named_let = As<NamedLetNode>(object)) {
+        sink->Tag(ImageTag::NAMED_LET_NODE);
+        VisitReferences(named_let->GetValues(), sink);
+        sink->Reference(named_let->GetLoop());
+    } else if (auto delay = As<DelayNode>(object)) {
+        sink->Tag(ImageTag::DELAY_NODE);
+        sink->Reference(delay->GetExpression());
+    } else if (auto application = As<ApplicationNode>(object)) {
+        sink->Tag(ImageTag::APPLICATION_NODE);
+        sink->Reference(application->GetFunction());
+        VisitReferences(application->GetOperands(), sink);
+    } else if (auto tail_call = As<TailCallNode>(object)) {
+        sink->Tag(ImageTag::TAIL_CALL_NODE);
+        sink->Reference(tail_call->GetFunction());
+        VisitReferences(tail_call->GetOperands(), sink);
+    } else if (auto guarded = As<GuardedNode>(object)) {
+        sink->Tag(ImageTag::GUARDED_NODE);
+        sink->Reference(guarded->GetOptimized());
+        sink->Reference(guarded->GetOriginal());
+    } else {
+        throw RuntimeError("Only data, procedures and macros can be saved to an image.");
+    }
+}
+
+ObjectPtrVector ImageWriter::CollectObjects() {
+    // all the reachable objects
+    std::unordered_set<ObjectPtr> reachable{context_};
+    ObjectPtrVector found{context_};
+    for (size_t i = 0; i < found.size(); ++i) {
+        ReferencesSink sink;
+        VisitFields(found[i], &sink);
+        for (ObjectPtr reference : sink.references) {
+            if (Is<SyntaxRules>(reference) && !Is<Scope>(found[i]) &&
+                !Is<DefineSyntaxNode>(found[i])) {
+                throw RuntimeError("Macros can be saved to an image only as values of names.");
+            }
+            if (reachable.insert(reference).second) {
+                found.push_back(reference);
+            }
+        }
+    }
+
+    // then ordered so that objects go after everything they are made of
+    struct Frame {
+        ObjectPtr object;
+        ObjectPtrVector dependencies;
+        size_t next = 0;
+    };
+    ObjectPtrVector ordered;
+    ordered.reserve(found.size());
+    std::unordered_set<ObjectPtr> visited;
+    std::vector<Frame> frames;
+    auto enter = [&](ObjectPtr object) {
+        visited.insert(object);
+        Frame frame{object, {}};
+        if (!IsFilledLater(object)) {
+            ReferencesSink sink;
+            VisitFields(object, &sink);
+            frame.dependencies = std::move(sink.references);
+        }
+        frames.push_back(std::move(frame));
+    };
+    for (ObjectPtr object : found) {
+        if (visited.contains(object)) {
+            continue;
+        }
+        enter(object);
+        while (!frames.empty()) {
+            Frame& frame = frames.back();
+            if (frame.next == frame.dependencies.size()) {
+                ordered.push_back(frame.object);
+                frames.pop_back();
+            } else if (ObjectPtr dependency = frame.dependencies[frame.next++];
+                       !visited.contains(dependency)) {
+                enter(dependency);
+            }
+        }
+    }
+    return ordered;
+}
+
+std::string ImageWriter::Write() {
+    ObjectPtrVector objects = CollectObjects();
+    std::unordered_map<ObjectPtr, uint64_t> numbers;
+    for (size_t i = 0; i < objects.size(); ++i) {
+        numbers.emplace(objects[i], i + 1);
+    }
+
+    std::string image(kImageMagic, sizeof(kImageMagic));
+    RecordSink sink{&image, &numbers};
+    sink.Append(kImageVersion);
+    sink.Append(kImageByteOrderMark);
+    sink.Append(static_cast<uint64_t>(objects.size()));
+    for (ObjectPtr object : objects) {
+        VisitFields(object, &sink);
+        sink.Finish();
+    }
+    return image;
+}
+
+std::string MakeImage(ContextPtr context) {
+    return ImageWriter{context}.Write();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Reading of images
+
+class ImageReader {
+public:
+    ImageReader(std::string_view image, ContextPtr context)
+        : image_(image), context_(context), global_scope_(context->GetScopes().front()) {
+    }
+
+    void Read();
+
+private:
+    [[noreturn]] static void ThrowBroken() {
+        throw RuntimeError("Image is broken.");
+    }
+
+    template <typename T>
+    T ReadValue() {
+        if (image_.size() - position_ < sizeof(T)) {
+            ThrowBroken();
+        }
+        T value;
+        std::memcpy(&value, image_.data() + position_, sizeof(T));
+        position_ += sizeof(T);
+        return value;
+    }
+
+    // A count of items, each of them takes at least that many bytes
+    uint64_t ReadCount(size_t item_size = 1) {
+        uint64_t count = ReadValue<uint64_t>();
+        if (count > (image_.size() - position_) / item_size) {
+            ThrowBroken();
+        }
+        return count;
+    }
+
+    bool ReadFlag() {
+        return ReadValue<uint8_t>() != 0;
+    }
+
+    std::string_view ReadName() {
+        uint64_t size = ReadCount();
+        std::string_view name = image_.substr(position_, size);
+        position_ += size;
+        return name;
+    }
+
+    // Records refer only to the records before them, except for the fields filled later
+    ObjectPtr ReadReference() {
+        uint64_t number = ReadValue<uint64_t>();
+        if (number > objects_.size()) {
+            ThrowBroken();
+        }
+        return (number > 0) ? objects_[number - 1] : nullptr;
+    }
+
+    template <typename T>
+    T* ReadReferenceTo() {
+        auto object = As<T>(ReadReference());
+        if (!object) {
+            ThrowBroken();
+        }
+        return object;
+    }
+
+    ObjectPtrVector ReadReferences() {
+        ObjectPtrVector objects(ReadCount(sizeof(uint64_t)));
+        for (ObjectPtr& object : objects) {
+            object = ReadReference();
+        }
+        return objects;
+    }
+
+    // Arguments of lambdas and loops
+    ObjectPtrVector ReadSymbols() {
+        ObjectPtrVector symbols = ReadReferences();
+        for (ObjectPtr symbol : symbols) {
+            if (!Is<Symbol>(symbol)) {
+                ThrowBroken();
+            }
+        }
+        return symbols;
+    }
+
+    // Bodies of lambdas, lets and loops evaluate to their last expression
+    ObjectPtrVector ReadBody() {
+        ObjectPtrVector body = ReadReferences();
+        if (body.empty()) {
+            ThrowBroken();
+        }
+        return body;
+    }
+
+    template <typename T>
+    std::vector<T> ReadElements() {
+        std::vector<T> elements(ReadCount(sizeof(T)));
+        std::memcpy(elements.data(), image_.data() + position_, elements.size() * sizeof(T));
+        position_ += elements.size() * sizeof(T);
+        return elements;
+    }
+
+    ObjectPtr MakeObject(ImageTag tag);
+    void FillObject(ImageTag tag, ObjectPtr object);
+    ObjectPtr MakeSyntaxRules();
+
+    struct Record {
+        ImageTag tag;
+        size_t number;
+        // where the fields start
+        size_t position;
+    };
+
+    std::string_view image_;
+    size_t position_ = 0;
+    ContextPtr context_;
+    ScopePtr global_scope_;
+    ObjectPtrVector objects_;
+    std::vector<Record> filled_later_;
+};
+
+ObjectPtr ImageReader::MakeObject(ImageTag tag) {
+    Heap& heap = Heap::Instance();
+    switch (tag) {
+        case ImageTag::ROOT_CONTEXT:
+            return context_;
+        case ImageTag::GLOBAL_SCOPE:
+            return global_scope_;
+        case ImageTag::CONTEXT: {
+            ContextPtr context = heap.Make<Context>();
+            for (uint64_t count = ReadCount(sizeof(uint64_t)); count > 0; --count) {
+                context->AddScope(ReadReferenceTo<Scope>());
+            }
+            return context;
+        }
+        case ImageTag::SCOPE:
+            return heap.Make<Scope>();
+        case ImageTag::NUMBER:
+            return heap.Make<Number>(ReadValue<int64_t>());
+        case ImageTag::BIG_NUMBER:
+            return heap.Make<BigNumber>(BigInteger(std::string(ReadName())));
+        case ImageTag::FLOAT_NUMBER:
+            return heap.Make<FloatNumber>(ReadValue<double>());
+        case ImageTag::SYMBOL:
+            return heap.Make<Symbol>(ReadName());
+        case ImageTag::BOOLEAN:
+            return GetBooleanSymbol(ReadFlag());
+        case ImageTag::STRING:
+            return heap.Make<String>(std::string(ReadName()));
+        case ImageTag::BUILT_IN: {
+            auto found = kValidFunctionsMap.find(std::string(ReadName()));
+            if (found == kValidFunctionsMap.end()) {
+                ThrowBroken();
+            }
+            return found->second;
+        }
+        case ImageTag::CELL:
+            return heap.Make<Cell>(nullptr, nullptr);
+        case ImageTag::VECTOR:
+            return heap.Make<Vector>(ReadCount(sizeof(uint64_t)), nullptr);
+        case ImageTag::S64VECTOR:
+            return heap.Make<S64Vector>(ReadElements<int64_t>());
+        case ImageTag::F64VECTOR:
+            return heap.Make<F64Vector>(ReadElements<double>());
+        case ImageTag::HASH_TABLE: {
+            bool is_equal = ReadFlag();
+            return heap.Make<HashTable>((is_equal) ? KeyEquivalence::EQUAL : KeyEquivalence::EQV);
+        }
+        case ImageTag::LAMBDA: {
+            ObjectPtrVector args = ReadSymbols();
+            ObjectPtrVector body = ReadBody();
+            ContextPtr context = ReadReferenceTo<Context>();
+            return heap.Make<LambdaFunction>(args, body, context, ReadFlag());
+        }
+        case ImageTag::MEMOIZED: {
+            ObjectPtr function = ReadReference();
+            if (!IsApplicable(function)) {
+                ThrowBroken();
+            }
+            return heap.Make<MemoizedFunction>(function, ReadValue<uint64_t>());
+        }
+        case ImageTag::SYNTAX_RULES:
+            // made once the data of its rules are filled
+            return nullptr;
+        case ImageTag::QUOTE_NODE:
+            return heap.Make<QuoteNode>(ReadReference());
+        case ImageTag::IF_NODE:
+        case ImageTag::COND_ARROW_NODE: {
+            bool has_alternative = ReadFlag();
+            ObjectPtr first = ReadReference();
+            ObjectPtr second = ReadReference();
+            ObjectPtr alternative = ReadReference();
+            if (tag == ImageTag::IF_NODE) {
+                return (has_alternative) ? heap.Make<IfNode>(first, second, alternative)
+                                         : heap.Make<IfNode>(first, second);
+            }
+            return (has_alternative) ? heap.Make<CondArrowNode>(first, second, alternative)
+                                     : heap.Make<CondArrowNode>(first, second);
+        }
+        case ImageTag::DEFINE_NODE: {
+            std::string name{ReadName()};
+            return heap.Make<DefineNode>(name, ReadReference());
+        }
+        case ImageTag::DEFINE_SYNTAX_NODE:
+            // the macro is set once it's made
+            return heap.Make<DefineSyntaxNode>(std::string(ReadName()), nullptr);
+        case ImageTag::SET_NODE: {
+            std::string name{ReadName()};
+            return heap.Make<SetNode>(name, ReadReference());
+        }
+        case ImageTag::LAMBDA_NODE: {
+            ObjectPtrVector args = ReadSymbols();
+            ObjectPtrVector body = ReadBody();
+            return heap.Make<LambdaNode>(args, body, ReadFlag());
+        }
+        case ImageTag::AND_NODE:
+            return heap.Make<AndNode>(ReadReferences());
+        case ImageTag::OR_NODE:
+            return heap.Make<OrNode>(ReadReferences());
+        case ImageTag::BEGIN_NODE:
+            return heap.Make<BeginNode>(ReadReferences());
+        case ImageTag::CASE_NODE: {
+            ObjectPtr key = ReadReference();
+            std::vector<ObjectPtrVector> data(ReadCount(sizeof(uint64_t)));
+            for (ObjectPtrVector& clause_data : data) {
+                clause_data = ReadReferences();
+            }
+            ObjectPtrVector bodies = ReadReferences();
+            if (bodies.size() != data.size()) {
+                ThrowBroken();
+            }
+            bool has_else = ReadFlag();
+            ObjectPtr else_body = ReadReference();
+            return (has_else) ? heap.Make<CaseNode>(key, data, bodies, else_body)
+                              : heap.Make<CaseNode>(key, data, bodies);
+        }
+        case ImageTag::LET_NODE: {
+            uint64_t kind = ReadValue<uint64_t>();
+            if (kind > static_cast<uint64_t>(LetKind::LETREC)) {
+                ThrowBroken();
+            }
+            std::vector<std::string> names(ReadCount(sizeof(uint64_t)));
+            for (std::string& name : names) {
+                name = ReadName();
+            }
+            ObjectPtrVector values = ReadReferences();
+            if (values.size() != names.size()) {
+                ThrowBroken();
+            }
+            return heap.Make<LetNode>(static_cast<LetKind>(kind), names, values, ReadBody());
+        }
+        case ImageTag::LOOP_NODE: {
+            std::string name{ReadName()};
+            ObjectPtrVector args = ReadSymbols();
+            return heap.Make<LoopNode>(name, args, ReadBody());
+        }
+        case ImageTag::NAMED_LET_NODE: {
+            ObjectPtrVector values = ReadReferences();
+            return heap.Make<NamedLetNode>(values, ReadReferenceTo<LoopNode>());
+        }
+        case ImageTag::DELAY_NODE:
+            return heap.Make<DelayNode>(ReadReference());
+        case ImageTag::APPLICATION_NODE: {
+            ObjectPtr function = ReadReference();
+            return heap.Make<ApplicationNode>(function, ReadReferences());
+        }
+        case ImageTag::TAIL_CALL_NODE: {
+            ObjectPtr function = ReadReference();
+            return heap.Make<TailCallNode>(function, ReadReferences());
+        }
+        case ImageTag::GUARDED_NODE: {
+            ObjectPtr optimized = ReadReference();
+            return heap.Make<GuardedNode>(optimized, ReadReference());
+        }
+    }
+    ThrowBroken();
+}
+
+void ImageReader::FillObject(ImageTag tag, ObjectPtr object) {
+    switch (tag) {
+        case ImageTag::GLOBAL_SCOPE:
+        case ImageTag::SCOPE:
+            for (uint64_t count = ReadCount(); count > 0; --count) {
+                std::string name{ReadName()};
+                As<Scope>(object)->Bind(name, ReadReference());
+            }
+            break;
+        case ImageTag::CELL:
+            As<Cell>(object)->SetFirst(ReadReference());
+            As<Cell>(object)->SetSecond(ReadReference());
+            break;
+        case ImageTag::VECTOR: {
+            ObjectPtrVector elements = ReadReferences();
+            for (size_t i = 0; i < elements.size(); ++i) {
+                As<Vector>(object)->Set(i, elements[i]);
+            }
+            break;
+        }
+        case ImageTag::HASH_TABLE:
+            ReadFlag();
+            for (uint64_t count = ReadCount(); count > 0; --count) {
+                ObjectPtr key = ReadReference();
+                As<HashTable>(object)->Set(key, ReadReference());
+            }
+            break;
+        case ImageTag::DEFINE_SYNTAX_NODE:
+            ReadName();
+            As<DefineSyntaxNode>(object)->SetRules(ReadReferenceTo<SyntaxRules>());
+            break;
+        default:
+            break;
+    }
+}
+
+ObjectPtr ImageReader::MakeSyntaxRules() {
+    std::unordered_set<std::string> literals;
+    for (uint64_t count = ReadCount(); count > 0; --count) {
+        literals.emplace(ReadName());
+    }
+    std::vector<std::pair<ObjectPtr, ObjectPtr>> rules(ReadCount(2 * sizeof(uint64_t)));
+    for (auto& [pattern, templ] : rules) {
+        // the keyword of a pattern is skipped when it's matched
+        pattern = ReadReference();
+        if (!Is<Cell>(pattern)) {
+            ThrowBroken();
+        }
+        templ = ReadReference();
+    }
+    return Heap::Instance().Make<SyntaxRules>(literals, rules);
+}
+
+void ImageReader::Read() {
+    if (!image_.starts_with(std::string_view(kImageMagic, sizeof(kImageMagic)))) {
+        throw RuntimeError("Not an image.");
+    }
+    position_ = sizeof(kImageMagic);
+    if (ReadValue<uint32_t>() != kImageVersion || ReadValue<uint32_t>() != kImageByteOrderMark) {
+        throw RuntimeError("Image of another version or byte order.");
+    }
+    uint64_t count = ReadCount(sizeof(ImageTag) + sizeof(uint64_t));
+    objects_.reserve(count);
+
+    // the objects are made in the order of records, the rest of their fields are filled then
+    for (uint64_t number = 1; number <= count; ++number) {
+        ImageTag tag = ReadValue<ImageTag>();
+        size_t end = position_ + sizeof(uint64_t);
+        end += ReadCount();
+        Record record{tag, number, position_};
+        objects_.push_back(MakeObject(tag));
+        if (position_ > end) {
+            ThrowBroken();
+        }
+        if (tag == ImageTag::GLOBAL_SCOPE || tag == ImageTag::SCOPE || tag == ImageTag::CELL ||
+            tag == ImageTag::VECTOR || tag == ImageTag::HASH_TABLE ||
+            tag == ImageTag::SYNTAX_RULES || tag == ImageTag::DEFINE_SYNTAX_NODE) {
+            filled_later_.push_back(record);
+        }
+        position_ = end;
+    }
+    if (position_ != image_.size()) {
+        ThrowBroken();
+    }
+
+    // macros read the data of their rules, hash tables hash their keys,
+    // scopes and define-syntax nodes are filled last so that all the values they bind exist
+    auto fill = [this](std::initializer_list<ImageTag> tags) {
+        for (const Record& record : filled_later_) {
+            if (std::find(tags.begin(), tags.end(), record.tag) == tags.end()) {
+                continue;
+            }
+            position_ = record.position;
+            if (record.tag == ImageTag::SYNTAX_RULES) {
+                objects_[record.number - 1] = MakeSyntaxRules();
+            } else {
+                FillObject(record.tag, objects_[record.number - 1]);
+            }
+        }
+    };
+    fill({ImageTag::CELL, ImageTag::VECTOR});
+    fill({ImageTag::SYNTAX_RULES});
+    fill({ImageTag::HASH_TABLE, ImageTag::GLOBAL_SCOPE, ImageTag::SCOPE,
+          ImageTag::DEFINE_SYNTAX_NODE});
+    AdvanceSyntaxEpoch();
+}
+
+void RestoreImage(std::string_view image, ContextPtr context) {
+    ImageReader{image, context}.Read();
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "object.h"
+
+// Heap images
+// An image keeps the global bindings of an interpreter together with everything reachable
+// from them: data, closures with their analyzed bodies and captured scopes, macros.
+// Objects refer to each other by their numbers in the image rather than by addresses,
+// and built-in functions are referred to by their names, so an image made by one process
+// is restored by any other process of the same build. Promises, futures and escape
+// procedures can't be saved.
+// Loading is eager: the file is mapped only to be read, every object of the image is made
+// on the heap before RestoreImage returns, and nothing refers to the mapped pages after.
+
+// Image of the global scope of a top-level context
+std::string MakeImage(ContextPtr context);
+
+// Binds the names of the image in the global scope of the context,
+// RuntimeError if the image is broken
+void RestoreImage(std::string_view image, ContextPtr context);
@@ -0,0 +1,704 @@
+#include "jit.h"
+#include "parallel.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define NATIVE_TIER_SUPPORTED
+#endif
+
+// Assembler's realization
+
+Assembler::Label Assembler::NewLabel() {
+    label_positions_.push_back(SIZE_MAX);
+    return label_positions_.size() - 1;
+}
+
+void Assembler::Bind(Label label) {
+    label_positions_[label] = code_.size();
+}
+
+void Assembler::Push(Register reg) {
+    if (Code(reg) >= 8) {
+        code_.push_back(0x41);
+    }
+    code_.push_back(0x50 | (Code(reg) & 7));
+}
+
+void Assembler::Pop(Register reg) {
+    if (Code(reg) >= 8) {
+        code_.push_back(0x41);
+    }
+    code_.push_back(0x58 | (Code(reg) & 7));
+}
+
+void Assembler::Mov(Register dst, Register src) {
+    EmitRegisterOperation(0x89, Code(src), Code(dst));
+}
+
+void Assembler::MovImmediate(Register dst, int64_t value) {
+    EmitRex(0, Code(dst));
+    code_.push_back(0xB8 | (Code(dst) & 7));
+    EmitImmediate(value, 8);
+}
+
+void Assembler::Load(Register dst, Register base, int32_t offset) {
+    EmitMemoryOperation(0x8B, dst, base, offset);
+}
+
+void Assembler::Store(Register base, int32_t offset, Register src) {
+    EmitMemoryOperation(0x89, src, base, offset);
+}
+
+void Assembler::Add(Register dst, Register src) {
+    EmitRegisterOperation(0x01, Code(src), Code(dst));
+}
+
+void Assembler::Sub(Register dst, Register src) {
+    EmitRegisterOperation(0x29, Code(src), Code(dst));
+}
+
+void Assembler::IMul(Register dst, Register src) {
+    EmitRex(Code(dst), Code(src));
+    code_.push_back(0x0F);
+    code_.push_back(0xAF);
+    code_.push_back(0xC0 | ((Code(dst) & 7) << 3) | (Code(src) & 7));
+}
+
+void Assembler::Cmp(Register lhs, Register rhs) {
+    EmitRegisterOperation(0x39, Code(rhs), Code(lhs));
+}
+
+void Assembler::Test(Register lhs, Register rhs) {
+    EmitRegisterOperation(0x85, Code(rhs), Code(lhs));
+}
+
+void Assembler::Neg(Register reg) {
+    EmitRegisterOperation(0xF7, 3, Code(reg));
+}
+
+void Assembler::Inc(Register reg) {
+    EmitRegisterOperation(0xFF, 0, Code(reg));
+}
+
+void Assembler::Dec(Register reg) {
+    EmitRegisterOperation(0xFF, 1, Code(reg));
+}
+
+void Assembler::Cqo() {
+    code_.push_back(0x48);
+    code_.push_back(0x99);
+}
+
+void Assembler::IDiv(Register divisor) {
+    EmitRegisterOperation(0xF7, 7, Code(divisor));
+}
+
+void Assembler::AddImmediate(Register dst, int32_t value) {
+    EmitRegisterOperation(0x81, 0, Code(dst));
+    EmitImmediate(value, 4);
+}
+
+void Assembler::CMov(Condition condition, Register dst, Register src) {
+    EmitRex(Code(dst), Code(src));
+    code_.push_back(0x0F);
+    code_.push_back(0x40 | Code(condition));
+    code_.push_back(0xC0 | ((Code(dst) & 7) << 3) | (Code(src) & 7));
+}
+
+void Assembler::SetRax(Condition condition) {
+    // setcc al; movzx rax, al
+    code_.insert(code_.end(), {0x0F, static_cast<uint8_t>(0x90 | Code(condition)), 0xC0});
+    code_.insert(code_.end(), {0x48, 0x0F, 0xB6, 0xC0});
+}
+
+void Assembler::Jump(Label label) {
+    code_.push_back(0xE9);
+    EmitLabelDisplacement(label);
+}
+
+void Assembler::JumpIf(Condition condition, Label label) {
+    code_.push_back(0x0F);
+    code_.push_back(0x80 | Code(condition));
+    EmitLabelDisplacement(label);
+}
+
+void Assembler::Call(Label label) {
+    code_.push_back(0xE8);
+    EmitLabelDisplacement(label);
+}
+
+void Assembler::Ret() {
+    code_.push_back(0xC3);
+}
+
+std::vector<uint8_t> Assembler::Finish() {
+    for (const auto& [position, label] : fixups_) {
+        // displacement is counted from the end of the instruction
+        auto displacement = static_cast<int32_t>(static_cast<int64_t>(label_positions_[label]) -
+                                                 static_cast<int64_t>(position + 4));
+        std::memcpy(code_.data() + position, &displacement, sizeof(displacement));
+    }
+    return code_;
+}
+
+void Assembler::EmitRex(uint8_t reg, uint8_t rm) {
+    // REX.W with extension bits of ModRM's reg and rm fields
+    code_.push_back(0x48 | ((reg >> 3) << 2) | (rm >> 3));
+}
+
+void Assembler::EmitRegisterOperation(uint8_t opcode, uint8_t reg, uint8_t rm) {
+    EmitRex(reg, rm);
+    code_.push_back(opcode);
+    code_.push_back(0xC0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+void Assembler::EmitMemoryOperation(uint8_t opcode, Register reg, Register base,
+                                    int32_t offset) {
+    EmitRex(Code(reg), Code(base));
+    code_.push_back(opcode);
+    code_.push_back(0x80 | ((Code(reg) & 7) << 3) | (Code(base) & 7));
+    if ((Code(base) & 7) == Code(Register::RSP)) {
+        // rsp as a base needs the SIB byte
+        code_.push_back(0x24);
+    }
+    EmitImmediate(static_cast<uint32_t>(offset), 4);
+}
+
+void Assembler::EmitLabelDisplacement(Label label) {
+    fixups_.emplace_back(code_.size(), label);
+    EmitImmediate(0, 4);
+}
+
+void Assembler::EmitImmediate(uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        code_.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// NativeCode's realization
+
+NativeCode::NativeCode(const std::vector<uint8_t>& code, NativeType return_type,
+                       const std::string& self_name)
+    : size_(code.size()),
+      return_type_(return_type),
+      self_name_(self_name),
+      rebinding_epoch_(Scope::GetRebindingEpoch()) {
+#ifdef NATIVE_TIER_SUPPORTED
+    void* memory =
+        mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return;
+    }
+    std::memcpy(memory, code.data(), size_);
+    if (mprotect(memory, size_, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size_);
+        return;
+    }
+    memory_ = memory;
+#endif
+}
+
+NativeCode::~NativeCode() {
+#ifdef NATIVE_TIER_SUPPORTED
+    if (memory_) {
+        munmap(memory_, size_);
+    }
+#endif
+}
+
+bool NativeCode::AreAssumptionsValid(ObjectPtr self, ContextPtr context) const {
+    return rebinding_epoch_ == Scope::GetRebindingEpoch() &&
+           (self_name_.empty() || context->Get(self_name_) == self);
+}
+
+bool NativeCode::Run(const int64_t* reversed_arguments, int64_t* result) const {
+    using EntryFunction = int64_t (*)(const int64_t*, int64_t*);
+    return reinterpret_cast<EntryFunction>(memory_)(reversed_arguments, result) != 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// NativeCompiler's realization
+
+NativeCompiler::NativeCompiler(const ObjectPtrVector& args, const ObjectPtrVector& body,
+                               ContextPtr context, ObjectPtr self)
+    : args_(args), body_(body), context_(context), self_(self) {
+}
+
+std::shared_ptr<NativeCode> NativeCompiler::Compile() {
+#ifdef NATIVE_TIER_SUPPORTED
+    if (body_.size() != 1 || args_.size() > kSmallArgumentsCount) {
+        return nullptr;
+    }
+    NativeType type;
+    bool is_known = false;
+    if (!InferType(body_[0], &type, &is_known)) {
+        return nullptr;
+    }
+    // a function which only calls itself never returns, its type doesn't matter
+    self_type_ = (is_known) ? type : NativeType::INTEGER;
+    is_self_type_known_ = true;
+    if (!InferType(body_[0], &type, &is_known) || type != self_type_) {
+        return nullptr;
+    }
+
+    function_label_ = assembler_.NewLabel();
+    loop_label_ = assembler_.NewLabel();
+    deoptimization_label_ = assembler_.NewLabel();
+
+    // entry(reversed_arguments, result) saves the stack pointer to unwind to on
+    // deoptimization in r15 and keeps the allowed depth of self calls in r14
+    assembler_.Push(Register::RBP);
+    assembler_.Push(Register::R14);
+    assembler_.Push(Register::R15);
+    assembler_.Mov(Register::R15, Register::RSP);
+    assembler_.Push(Register::RSI);
+    assembler_.MovImmediate(Register::R14, kMaxNativeCallDepth);
+    assembler_.Call(function_label_);
+    assembler_.Pop(Register::RSI);
+    assembler_.Store(Register::RSI, 0, Register::RAX);
+    assembler_.MovImmediate(Register::RAX, 1);
+    assembler_.Pop(Register::R15);
+    assembler_.Pop(Register::R14);
+    assembler_.Pop(Register::RBP);
+    assembler_.Ret();
+
+    assembler_.Bind(deoptimization_label_);
+    assembler_.Mov(Register::RSP, Register::R15);
+    assembler_.MovImmediate(Register::RAX, 0);
+    assembler_.Pop(Register::R15);
+    assembler_.Pop(Register::R14);
+    assembler_.Pop(Register::RBP);
+    assembler_.Ret();
+
+    // function(reversed_arguments) keeps parameter i at [rbp - 8 * (i + 1)]
+    // and returns the value in rax
+    assembler_.Bind(function_label_);
+    assembler_.Push(Register::RBP);
+    assembler_.Mov(Register::RBP, Register::RSP);
+    assembler_.Dec(Register::R14);
+    assembler_.JumpIf(Condition::EQUAL, deoptimization_label_);
+    for (size_t i = 0; i < args_.size(); ++i) {
+        assembler_.Load(Register::RAX, Register::RDI, 8 * (args_.size() - 1 - i));
+        assembler_.Push(Register::RAX);
+    }
+    assembler_.Bind(loop_label_);
+    EmitNode(body_[0], true);
+    assembler_.Inc(Register::R14);
+    assembler_.Mov(Register::RSP, Register::RBP);
+    assembler_.Pop(Register::RBP);
+    assembler_.Ret();
+
+    auto code = std::make_shared<NativeCode>(assembler_.Finish(), self_type_, self_name_);
+    return (code->IsValid()) ? code : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
+bool NativeCompiler::ResolveOperation(ObjectPtr function, NativeOperation* operation) {
+    auto symbol = As<Symbol>(function);
+    size_t index = 0;
+    if (!symbol || FindParameter(function, &index) || !context_->Contains(symbol->GetName())) {
+        return false;
+    }
+    const std::string& name = symbol->GetName();
+    ObjectPtr value = context_->Get(name);
+    if (value == self_) {
+        if (!self_name_.empty() && self_name_ != name) {
+            return false;
+        }
+        self_name_ = name;
+        *operation = NativeOperation::SELF_CALL;
+        return true;
+    }
+    // only rebinding of built-in names in the global scope is tracked by the rebinding epoch,
+    // so names bound in local scopes are left to the interpreter
+    if (!kValidFunctionsMap.contains(name)) {
+        return false;
+    }
+    const ScopePtrVector& scopes = context_->GetScopes();
+    for (size_t i = 1; i < scopes.size(); ++i) {
+        if (scopes[i]->Contains(name)) {
+            return false;
+        }
+    }
+    if (Is<PlusFunction>(value)) {
+        *operation = NativeOperation::ADD;
+    } else if (Is<MinusFunction>(value)) {
+        *operation = NativeOperation::SUBTRACT;
+    } else if (Is<MultiplyFunction>(value)) {
+        *operation = NativeOperation::MULTIPLY;
+    } else if (Is<DivisionFunction>(value)) {
+        *operation = NativeOperation::DIVIDE;
+    } else if (Is<AbsFunction>(value)) {
+        *operation = NativeOperation::ABS;
+    } else if (Is<MaxFunction>(value)) {
+        *operation = NativeOperation::MAX;
+    } else if (Is<MinFunction>(value)) {
+        *operation = NativeOperation::MIN;
+    } else if (Is<LessFunction>(value)) {
+        *operation = NativeOperation::LESS;
+    } else if (Is<LessEqualFunction>(value)) {
+        *operation = NativeOperation::LESS_EQUAL;
+    } else if (Is<EqualFunction>(value)) {
+        *operation = NativeOperation::EQUAL;
+    } else if (Is<GreaterFunction>(value)) {
+        *operation = NativeOperation::GREATER;
+    } else if (Is<GrEqualFunction>(value)) {
+        *operation = NativeOperation::GREATER_EQUAL;
+    } else if (Is<NegFunction>(value)) {
+        *operation = NativeOperation::NOT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool NativeCompiler::FindParameter(ObjectPtr node, size_t* index) {
+    auto symbol = As<Symbol>(node);
+    if (!symbol) {
+        return false;
+    }
+    // the last of parameters with the same name wins
+    for (size_t i = args_.size(); i > 0; --i) {
+        if (As<Symbol>(args_[i - 1])->GetName() == symbol->GetName()) {
+            *index = i - 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool NativeCompiler::InferType(ObjectPtr node, NativeType* type, bool* is_known) {
+    size_t index = 0;
+    *is_known = true;
+    if (Is<Number>(node) || FindParameter(node, &index)) {
+        *type = NativeType::INTEGER;
+        return true;
+    } else if (Is<BooleanSymbol>(node)) {
+        *type = NativeType::BOOLEAN;
+        return true;
+    } else if (auto guarded = As<GuardedNode>(node)) {
+        return InferType(guarded->GetActive(), type, is_known);
+    } else if (auto application = As<ApplicationNode>(node)) {
+        return InferApplicationType(application, type, is_known);
+    } else if (auto if_node = As<IfNode>(node)) {
+        // the value of if without alternative can be () which is not a fixnum
+        NativeType condition_type, consequent_type, alternative_type;
+        bool is_condition_known = false, is_consequent_known = false;
+        bool is_alternative_known = false;
+        if (!if_node->HasAlternative() ||
+            !InferType(if_node->GetCondition(), &condition_type, &is_condition_known) ||
+            !InferType(if_node->GetConsequent(), &consequent_type, &is_consequent_known) ||
+            !InferType(if_node->GetAlternative(), &alternative_type, &is_alternative_known)) {
+            return false;
+        }
+        if (is_consequent_known && is_alternative_known && consequent_type != alternative_type) {
+            return false;
+        }
+        *type = (is_consequent_known) ? consequent_type : alternative_type;
+        *is_known = is_consequent_known || is_alternative_known;
+        return true;
+    }
+    return false;
+}
+
+bool NativeCompiler::InferApplicationType(ApplicationNode* node, NativeType* type,
+                                          bool* is_known) {
+    NativeOperation operation;
+    if (!ResolveOperation(node->GetFunction(), &operation)) {
+        return false;
+    }
+    const ObjectPtrVector& operands = node->GetOperands();
+    *is_known = true;
+    if (operation == NativeOperation::NOT) {
+        // not accepts an operand of any type
+        NativeType operand_type;
+        bool is_operand_known = false;
+        *type = NativeType::BOOLEAN;
+        return operands.size() == 1 && InferType(operands[0], &operand_type, &is_operand_known);
+    }
+    for (ObjectPtr operand : operands) {
+        NativeType operand_type;
+        bool is_operand_known = false;
+        if (!InferType(operand, &operand_type, &is_operand_known) ||
+            (is_operand_known && operand_type != NativeType::INTEGER)) {
+            return false;
+        }
+    }
+    switch (operation) {
+        case NativeOperation::ADD:
+        case NativeOperation::MULTIPLY:
+            *type = NativeType::INTEGER;
+            return true;
+        case NativeOperation::SUBTRACT:
+        case NativeOperation::DIVIDE:
+        case NativeOperation::MAX:
+        case NativeOperation::MIN:
+            // calls without operands throw
+            *type = NativeType::INTEGER;
+            return !operands.empty();
+        case NativeOperation::ABS:
+            *type = NativeType::INTEGER;
+            return operands.size() == 1;
+        case NativeOperation::SELF_CALL:
+            *type = self_type_;
+            *is_known = is_self_type_known_;
+            return operands.size() == args_.size();
+        default:
+            *type = NativeType::BOOLEAN;
+            return true;
+    }
+}
+
+void NativeCompiler::EmitNode(ObjectPtr node, bool is_tail) {
+    size_t index = 0;
+    if (auto number = As<Number>(node)) {
+        assembler_.MovImmediate(Register::RAX, number->GetValue());
+    } else if (auto boolean = As<BooleanSymbol>(node)) {
+        assembler_.MovImmediate(Register::RAX, boolean->IsTrue());
+    } else if (FindParameter(node, &index)) {
+        assembler_.Load(Register::RAX, Register::RBP, -8 * static_cast<int32_t>(index + 1));
+    } else if (auto guarded = As<GuardedNode>(node)) {
+        EmitNode(guarded->GetActive(), is_tail);
+    } else if (auto application = As<ApplicationNode>(node)) {
+        EmitApplication(application, is_tail);
+    } else if (auto if_node = As<IfNode>(node)) {
+        NativeType condition_type;
+        bool is_known = false;
+        InferType(if_node->GetCondition(), &condition_type, &is_known);
+        EmitNode(if_node->GetCondition(), false);
+        if (condition_type == NativeType::INTEGER) {
+            // every number is true
+            EmitNode(if_node->GetConsequent(), is_tail);
+            return;
+        }
+        Assembler::Label alternative = assembler_.NewLabel();
+        Assembler::Label end = assembler_.NewLabel();
+        assembler_.Test(Register::RAX, Register::RAX);
+        assembler_.JumpIf(Condition::EQUAL, alternative);
+        EmitNode(if_node->GetConsequent(), is_tail);
+        assembler_.Jump(end);
+        assembler_.Bind(alternative);
+        EmitNode(if_node->GetAlternative(), is_tail);
+        assembler_.Bind(end);
+    }
+}
+
+void NativeCompiler::EmitApplication(ApplicationNode* node, bool is_tail) {
+    NativeOperation operation;
+    ResolveOperation(node->GetFunction(), &operation);
+    const ObjectPtrVector& operands = node->GetOperands();
+    switch (operation) {
+        case NativeOperation::ADD:
+        case NativeOperation::SUBTRACT:
+        case NativeOperation::MULTIPLY:
+        case NativeOperation::DIVIDE:
+        case NativeOperation::MAX:
+        case NativeOperation::MIN:
+            EmitFold(operation, operands);
+            break;
+        case NativeOperation::ABS:
+            // abs of the minimal fixnum overflows
+            EmitNode(operands[0], false);
+            assembler_.Mov(Register::RCX, Register::RAX);
+            assembler_.Neg(Register::RAX);
+            assembler_.JumpIf(Condition::OVERFLOWS, deoptimization_label_);
+            assembler_.CMov(Condition::NEGATIVE, Register::RAX, Register::RCX);
+            break;
+        case NativeOperation::NOT: {
+            // not of anything except #f is #f
+            NativeType operand_type;
+            bool is_known = false;
+            InferType(operands[0], &operand_type, &is_known);
+            EmitNode(operands[0], false);
+            if (operand_type == NativeType::BOOLEAN) {
+                assembler_.Test(Register::RAX, Register::RAX);
+                assembler_.SetRax(Condition::EQUAL);
+            } else {
+                assembler_.MovImmediate(Register::RAX, 0);
+            }
+            break;
+        }
+        case NativeOperation::SELF_CALL:
+            EmitSelfCall(operands, is_tail);
+            break;
+        default:
+            EmitComparison(operation, operands);
+            break;
+    }
+}
+
+void NativeCompiler::EmitFold(NativeOperation operation, const ObjectPtrVector& operands) {
+    if (operands.empty()) {
+        assembler_.MovImmediate(Register::RAX, (operation == NativeOperation::ADD) ? 0 : 1);
+        return;
+    }
+    EmitNode(operands[0], false);
+    for (size_t i = 1; i < operands.size(); ++i) {
+        assembler_.Push(Register::RAX);
+        EmitNode(operands[i], false);
+        assembler_.Mov(Register::RCX, Register::RAX);
+        assembler_.Pop(Register::RAX);
+        switch (operation) {
+            case NativeOperation::ADD:
+                assembler_.Add(Register::RAX, Register::RCX);
+                assembler_.JumpIf(Condition::OVERFLOWS, deoptimization_label_);
+                break;
+            case NativeOperation::SUBTRACT:
+                assembler_.Sub(Register::RAX, Register::RCX);
+                assembler_.JumpIf(Condition::OVERFLOWS, deoptimization_label_);
+                break;
+            case NativeOperation::MULTIPLY:
+                assembler_.IMul(Register::RAX, Register::RCX);
+                assembler_.JumpIf(Condition::OVERFLOWS, deoptimization_label_);
+                break;
+            case NativeOperation::DIVIDE: {
+                // the interpreter reports division by zero, idiv traps on min / -1
+                Assembler::Label divide = assembler_.NewLabel();
+                Assembler::Label end = assembler_.NewLabel();
+                assembler_.Test(Register::RCX, Register::RCX);
+                assembler_.JumpIf(Condition::EQUAL, deoptimization_label_);
+                assembler_.MovImmediate(Register::RDX, -1);
+                assembler_.Cmp(Register::RCX, Register::RDX);
+                assembler_.JumpIf(Condition::NOT_EQUAL, divide);
+                assembler_.Neg(Register::RAX);
+                assembler_.JumpIf(Condition::OVERFLOWS, deoptimization_label_);
+                assembler_.Jump(end);
+                assembler_.Bind(divide);
+                assembler_.Cqo();
+                assembler_.IDiv(Register::RCX);
+                assembler_.Bind(end);
+                break;
+            }
+            case NativeOperation::MAX:
+                assembler_.Cmp(Register::RAX, Register::RCX);
+                assembler_.CMov(Condition::LESS, Register::RAX, Register::RCX);
+                break;
+            default:
+                assembler_.Cmp(Register::RAX, Register::RCX);
+                assembler_.CMov(Condition::GREATER, Register::RAX, Register::RCX);
+                break;
+        }
+    }
+}
+
+void NativeCompiler::EmitComparison(NativeOperation operation, const ObjectPtrVector& operands) {
+    Condition condition = Condition::GREATER_EQUAL;
+    if (operation == NativeOperation::LESS) {
+        condition = Condition::LESS;
+    } else if (operation == NativeOperation::LESS_EQUAL) {
+        condition = Condition::LESS_EQUAL;
+    } else if (operation == NativeOperation::EQUAL) {
+        condition = Condition::EQUAL;
+    } else if (operation == NativeOperation::GREATER) {
+        condition = Condition::GREATER;
+    }
+
+    // all operands are computed before comparing as in the interpreter,
+    // operand i is at [rsp + 8 * (size - 1 - i)]
+    size_t size = operands.size();
+    for (ObjectPtr operand : operands) {
+        EmitNode(operand, false);
+        assembler_.Push(Register::RAX);
+    }
+    Assembler::Label fail = assembler_.NewLabel();
+    Assembler::Label end = assembler_.NewLabel();
+    for (size_t i = 1; i < size; ++i) {
+        assembler_.Load(Register::RAX, Register::RSP, 8 * (size - i));
+        assembler_.Load(Register::RCX, Register::RSP, 8 * (size - 1 - i));
+        assembler_.Cmp(Register::RAX, Register::RCX);
+        assembler_.JumpIf(Invert(condition), fail);
+    }
+    assembler_.MovImmediate(Register::RAX, 1);
+    assembler_.Jump(end);
+    assembler_.Bind(fail);
+    assembler_.MovImmediate(Register::RAX, 0);
+    assembler_.Bind(end);
+    if (size > 0) {
+        assembler_.AddImmediate(Register::RSP, 8 * size);
+    }
+}
+
+void NativeCompiler::EmitSelfCall(const ObjectPtrVector& operands, bool is_tail) {
+    for (ObjectPtr operand : operands) {
+        EmitNode(operand, false);
+        assembler_.Push(Register::RAX);
+    }
+    if (is_tail) {
+        // a tail call reuses the frame
+        for (size_t i = operands.size(); i > 0; --i) {
+            assembler_.Pop(Register::RAX);
+            assembler_.Store(Register::RBP, -8 * static_cast<int32_t>(i), Register::RAX);
+        }
+        assembler_.Jump(loop_label_);
+        return;
+    }
+    assembler_.Mov(Register::RDI, Register::RSP);
+    assembler_.Call(function_label_);
+    if (!operands.empty()) {
+        assembler_.AddImmediate(Register::RSP, 8 * operands.size());
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// LambdaFunction's native tier
+
+ObjectPtr LambdaFunction::ApplyNative(ObjectPtrSpan arguments) {
+    // calls in parallel tasks run the code compiled before, but neither compile nor
+    // deoptimize it
+    bool is_shared = Scheduler::IsRunningTask();
+    auto deoptimize = [this, is_shared]() -> ObjectPtr {
+        if (!is_shared && ++deoptimizations_count_ >= kMaxDeoptimizationsCount) {
+            native_code_.reset();
+        }
+        return nullptr;
+    };
+
+    if (deoptimizations_count_ >= kMaxDeoptimizationsCount) {
+        return nullptr;
+    }
+    if (is_shared) {
+        if (!native_code_ || !native_code_->AreAssumptionsValid(this, captured_context_)) {
+            return nullptr;
+        }
+    } else if (native_code_ && !native_code_->AreAssumptionsValid(this, captured_context_)) {
+        // compiled again when it gets hot under the new bindings
+        native_code_.reset();
+        calls_count_ = 0;
+        return deoptimize();
+    }
+    if (!native_code_) {
+        if (++calls_count_ < kJitCallsThreshold) {
+            return nullptr;
+        }
+        native_code_ = NativeCompiler(args_, body_, captured_context_, this).Compile();
+        if (!native_code_) {
+            deoptimizations_count_ = kMaxDeoptimizationsCount;
+            return nullptr;
+        }
+    }
+
+    std::array<int64_t, kSmallArgumentsCount> reversed_arguments;
+    for (size_t i = 0; i < arguments.size(); ++i) {
+        auto number = As<Number>(arguments[i]);
+        if (!number) {
+            return deoptimize();
+        }
+        reversed_arguments[arguments.size() - 1 - i] = number->GetValue();
+    }
+    int64_t result = 0;
+    if (!native_code_->Run(reversed_arguments.data(), &result)) {
+        return deoptimize();
+    }
+    if (native_code_->GetReturnType() == NativeType::BOOLEAN) {
+        return GetBooleanSymbol(result != 0);
+    }
+    return Heap::Instance().Make<Number>(result);
+}
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "analyzer.h"
+#include "optimizer.h"
+
+// Baseline native tier
+// Tiered lambdas count their calls; a hot one whose body is a pure fixnum expression
+// (+ - * / abs min max, comparisons, not, if and calls of itself) is compiled to x86-64 code.
+// Native code never allocates and has no side effects, so on any failed guard (overflow,
+// zero divisor, too deep recursion) the call is simply re-run by the interpreter.
+
+// Number of calls after which a tiered lambda is compiled
+constexpr size_t kJitCallsThreshold = 1000;
+// Native self calls deeper than that give the call back to the interpreter
+constexpr int64_t kMaxNativeCallDepth = 10000;
+// Native code which failed that many times is dropped for good
+constexpr size_t kMaxDeoptimizationsCount = 16;
+
+///////////////////////////////////////////////////////////////////////////////
+
+// x86-64 assembler
+// Emits just the instructions the compiler needs. Jumps and calls use 32-bit relative
+// displacements, so the code is position independent.
+
+enum class Register : uint8_t {
+    RAX = 0,
+    RCX = 1,
+    RDX = 2,
+    RSP = 4,
+    RBP = 5,
+    RSI = 6,
+    RDI = 7,
+    R14 = 14,
+    R15 = 15,
+};
+
+// Condition codes, the lowest bit inverts a condition
+enum class Condition : uint8_t {
+    OVERFLOWS = 0x0,
+    EQUAL = 0x4,
+    NOT_EQUAL = 0x5,
+    NEGATIVE = 0x8,
+    LESS = 0xC,
+    GREATER_EQUAL = 0xD,
+    LESS_EQUAL = 0xE,
+    GREATER = 0xF,
+};
+
+inline uint8_t Code(Register reg) {
+    return static_cast<uint8_t>(reg);
+}
+
+inline uint8_t Code(Condition condition) {
+    return static_cast<uint8_t>(condition);
+}
+
+inline Condition Invert(Condition condition) {
+    return static_cast<Condition>(Code(condition) ^ 1);
+}
+
+class Assembler {
+public:
+    using Label = size_t;
+
+    Label NewLabel();
+    void Bind(Label label);
+
+    void Push(Register reg);
+    void Pop(Register reg);
+    void Mov(Register dst, Register src);
+    void MovImmediate(Register dst, int64_t value);
+    // dst = [base + offset]
+    void Load(Register dst, Register base, int32_t offset);
+    // [base + offset] = src
+    void Store(Register base, int32_t offset, Register src);
+
+    void Add(Register dst, Register src);
+    void Sub(Register dst, Register src);
+    void IMul(Register dst, Register src);
+    void Cmp(Register lhs, Register rhs);
+    void Test(Register lhs, Register rhs);
+    void Neg(Register reg);
+    void Inc(Register reg);
+    void Dec(Register reg);
+    // rdx:rax = sign extension of rax
+    void Cqo();
+    // rax = rdx:rax / divisor
+    void IDiv(Register divisor);
+    void AddImmediate(Register dst, int32_t value);
+    void CMov(Condition condition, Register dst, Register src);
+    // rax = condition ? 1 : 0
+    void SetRax(Condition condition);
+
+    void Jump(Label label);
+    void JumpIf(Condition condition, Label label);
+    void Call(Label label);
+    void Ret();
+
+    // Resolves jumps to labels, all labels must be bound
+    std::vector<uint8_t> Finish();
+
+private:
+    void EmitRex(uint8_t reg, uint8_t rm);
+    void EmitRegisterOperation(uint8_t opcode, uint8_t reg, uint8_t rm);
+    void EmitMemoryOperation(uint8_t opcode, Register reg, Register base, int32_t offset);
+    void EmitLabelDisplacement(Label label);
+    void EmitImmediate(uint64_t value, size_t size);
+
+    std::vector<uint8_t> code_;
+    std::vector<size_t> label_positions_;
+    // positions of 32-bit displacements to patch with the label they point to
+    std::vector<std::pair<size_t, Label>> fixups_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+// NativeCode
+// Executable copy of compiled code with the assumptions it was compiled under.
+
+enum class NativeType { INTEGER, BOOLEAN };
+
+class NativeCode {
+public:
+    NativeCode(const std::vector<uint8_t>& code, NativeType return_type,
+               const std::string& self_name);
+    NativeCode(const NativeCode&) = delete;
+    NativeCode& operator=(const NativeCode&) = delete;
+    ~NativeCode();
+
+    bool IsValid() const {
+        return memory_ != nullptr;
+    }
+
+    NativeType GetReturnType() const {
+        return return_type_;
+    }
+
+    // Built-ins are still in place and the lambda's name still refers to the lambda
+    bool AreAssumptionsValid(ObjectPtr self, ContextPtr context) const;
+
+    // Arguments are stored in reverse order; false if the code gave up
+    bool Run(const int64_t* reversed_arguments, int64_t* result) const;
+
+private:
+    void* memory_ = nullptr;
+    size_t size_ = 0;
+    NativeType return_type_;
+    // empty if the lambda doesn't call itself
+    std::string self_name_;
+    uint64_t rebinding_epoch_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+// NativeCompiler
+
+enum class NativeOperation {
+    ADD,
+    SUBTRACT,
+    MULTIPLY,
+    DIVIDE,
+    ABS,
+    MAX,
+    MIN,
+    LESS,
+    LESS_EQUAL,
+    EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+    NOT,
+    SELF_CALL,
+};
+
+class NativeCompiler {
+public:
+    NativeCompiler(const ObjectPtrVector& args, const ObjectPtrVector& body, ContextPtr context,
+                   ObjectPtr self);
+
+    // nullptr if the lambda can't be compiled
+    std::shared_ptr<NativeCode> Compile();
+
+private:
+    bool ResolveOperation(ObjectPtr function, NativeOperation* operation);
+    bool FindParameter(ObjectPtr node, size_t* index);
+    // Type of the node's value; *is_known is false while it depends only on self calls
+    // and their type is not known yet
+    bool InferType(ObjectPtr node, NativeType* type, bool* is_known);
+    bool InferApplicationType(ApplicationNode* node, NativeType* type, bool* is_known);
+
+    void EmitNode(ObjectPtr node, bool is_tail);
+    void EmitApplication(ApplicationNode* node, bool is_tail);
+    void EmitFold(NativeOperation operation, const ObjectPtrVector& operands);
+    void EmitComparison(NativeOperation operation, const ObjectPtrVector& operands);
+    void EmitSelfCall(const ObjectPtrVector& operands, bool is_tail);
+
+    const ObjectPtrVector& args_;
+    const ObjectPtrVector& body_;
+    ContextPtr context_;
+    ObjectPtr self_;
+    std::string self_name_;
+    NativeType self_type_ = NativeType::INTEGER;
+    bool is_self_type_known_ = false;
+
+    Assembler assembler_;
+    Assembler::Label function_label_ = 0;
+    Assembler::Label loop_label_ = 0;
+    Assembler::Label deoptimization_label_ = 0;
+};
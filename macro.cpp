@@ -0,0 +1,250 @@
+#include "macro.h"
+#include "analyzer.h"
+
+static bool IsSymbolNamed(ObjectPtr object, const std::string& name) {
+    auto symbol = As<Symbol>(object);
+    return symbol && symbol->GetName() == name;
+}
+
+// Length of the proper part of the list
+static size_t CountElements(ObjectPtr list) {
+    size_t count = 0;
+    for (; Is<Cell>(list); list = As<Cell>(list)->GetSecond()) {
+        ++count;
+    }
+    return count;
+}
+
+// SyntaxRules' realization
+
+SyntaxRules::SyntaxRules(const std::unordered_set<std::string>& literals,
+                         const std::vector<std::pair<ObjectPtr, ObjectPtr>>& rules)
+    : literals_(literals) {
+    for (const auto& [pattern, templ] : rules) {
+        AddDependency(pattern);
+        AddDependency(templ);
+        std::vector<std::string> variables;
+        CollectVariables(pattern, &variables);
+        Rule rule{pattern, templ, {}};
+        CollectBinders(templ, {variables.begin(), variables.end()}, &rule.binders);
+        rules_.push_back(std::move(rule));
+    }
+}
+
+std::vector<std::pair<ObjectPtr, ObjectPtr>> SyntaxRules::GetRules() const {
+    std::vector<std::pair<ObjectPtr, ObjectPtr>> rules;
+    for (const Rule& rule : rules_) {
+        rules.emplace_back(rule.pattern, rule.templ);
+    }
+    return rules;
+}
+
+ObjectPtr SyntaxRules::Expand(ObjectPtr form) {
+    for (const Rule& rule : rules_) {
+        Bindings bindings;
+        // the keyword position of the pattern is ignored
+        if (!Match(As<Cell>(rule.pattern)->GetSecond(), As<Cell>(form)->GetSecond(),
+                   &bindings)) {
+            continue;
+        }
+        // dots can't be a part of symbols read by the tokenizer, so no name of the use
+        // clashes with the renamed ones
+        Renames renames;
+        ++renames_count_;
+        for (const std::string& name : rule.binders) {
+            renames[name] =
+                Heap::Instance().Make<Symbol>(name + "." + std::to_string(renames_count_));
+        }
+        return Instantiate(rule.templ, bindings, renames, false);
+    }
+    throw SyntaxError("No syntax-rules pattern matches the use of macro.");
+}
+
+bool SyntaxRules::IsPatternVariable(ObjectPtr pattern) const {
+    auto symbol = As<Symbol>(pattern);
+    return symbol && symbol->GetName() != kEllipsisName && symbol->GetName() != kUnderscoreName &&
+           !literals_.contains(symbol->GetName());
+}
+
+void SyntaxRules::CollectVariables(ObjectPtr pattern, std::vector<std::string>* variables) const {
+    if (IsPatternVariable(pattern)) {
+        variables->push_back(As<Symbol>(pattern)->GetName());
+    } else if (auto cell = As<Cell>(pattern)) {
+        CollectVariables(cell->GetFirst(), variables);
+        CollectVariables(cell->GetSecond(), variables);
+    }
+}
+
+void SyntaxRules::CollectBinders(ObjectPtr templ, const std::unordered_set<std::string>& variables,
+                                 std::unordered_set<std::string>* binders) const {
+    auto cell = As<Cell>(templ);
+    if (!cell || IsSymbolNamed(cell->GetFirst(), kQuoteKeyword)) {
+        return;
+    }
+    ObjectPtrVector elements = ListToVector(templ);
+    auto add_binder = [&variables, binders](ObjectPtr name) {
+        auto symbol = As<Symbol>(name);
+        if (symbol && symbol->GetName() != kEllipsisName &&
+            !variables.contains(symbol->GetName())) {
+            binders->insert(symbol->GetName());
+        }
+    };
+    auto head = As<Symbol>(elements[0]);
+    if (head && head->GetName() == kLambdaKeyword && elements.size() > 1) {
+        for (ObjectPtr arg : ListToVector(elements[1])) {
+            add_binder(arg);
+        }
+    } else if (head && (head->GetName() == kLetKeyword || head->GetName() == kLetStarKeyword ||
+                        head->GetName() == kLetrecKeyword)) {
+        size_t bindings_index = 1;
+        if (elements.size() > 1 && Is<Symbol>(elements[1])) {
+            // named let
+            add_binder(elements[1]);
+            bindings_index = 2;
+        }
+        if (bindings_index < elements.size()) {
+            for (ObjectPtr binding : ListToVector(elements[bindings_index])) {
+                if (auto binding_cell = As<Cell>(binding)) {
+                    add_binder(binding_cell->GetFirst());
+                }
+            }
+        }
+    }
+    for (ObjectPtr element : elements) {
+        CollectBinders(element, variables, binders);
+    }
+}
+
+bool SyntaxRules::Match(ObjectPtr pattern, ObjectPtr form, Bindings* bindings) const {
+    if (auto symbol = As<Symbol>(pattern)) {
+        if (symbol->GetName() == kUnderscoreName) {
+            return true;
+        } else if (literals_.contains(symbol->GetName())) {
+            return IsSymbolNamed(form, symbol->GetName());
+        }
+        (*bindings)[symbol->GetName()] = Binding{form, {}, false};
+        return true;
+    }
+    auto cell = As<Cell>(pattern);
+    if (!cell) {
+        return (pattern) ? IsEqual(pattern, form) : !form;
+    }
+    auto next = As<Cell>(cell->GetSecond());
+    if (!next || !IsSymbolNamed(next->GetFirst(), kEllipsisName)) {
+        auto form_cell = As<Cell>(form);
+        return form_cell && Match(cell->GetFirst(), form_cell->GetFirst(), bindings) &&
+               Match(cell->GetSecond(), form_cell->GetSecond(), bindings);
+    }
+
+    // (element ... rest): the element takes all the elements not needed by the rest
+    ObjectPtr rest = next->GetSecond();
+    size_t rest_count = CountElements(rest);
+    size_t form_count = CountElements(form);
+    if (form_count < rest_count) {
+        return false;
+    }
+    std::vector<std::string> variables;
+    CollectVariables(cell->GetFirst(), &variables);
+    for (const std::string& variable : variables) {
+        (*bindings)[variable] = Binding{nullptr, {}, true};
+    }
+    for (size_t i = 0; i < form_count - rest_count; ++i) {
+        Bindings repetition;
+        if (!Match(cell->GetFirst(), As<Cell>(form)->GetFirst(), &repetition)) {
+            return false;
+        }
+        for (const std::string& variable : variables) {
+            (*bindings)[variable].sequence.push_back(std::move(repetition[variable]));
+        }
+        form = As<Cell>(form)->GetSecond();
+    }
+    return Match(rest, form, bindings);
+}
+
+ObjectPtr SyntaxRules::Instantiate(ObjectPtr templ, const Bindings& bindings,
+                                   const Renames& renames, bool is_quoted) const {
+    if (auto symbol = As<Symbol>(templ)) {
+        auto binding = bindings.find(symbol->GetName());
+        if (binding != bindings.end()) {
+            if (binding->second.is_sequence) {
+                throw SyntaxError("Pattern variable under ellipsis must be followed by ellipsis.");
+            }
+            return binding->second.value;
+        }
+        auto rename = renames.find(symbol->GetName());
+        return (rename != renames.end() && !is_quoted) ? rename->second : templ;
+    }
+    auto cell = As<Cell>(templ);
+    if (!cell) {
+        return templ;
+    }
+    auto& heap_ref = Heap::Instance();
+    auto next = As<Cell>(cell->GetSecond());
+    if (!next || !IsSymbolNamed(next->GetFirst(), kEllipsisName)) {
+        bool is_rest_quoted = is_quoted || IsSymbolNamed(cell->GetFirst(), kQuoteKeyword);
+        return heap_ref.Make<Cell>(Instantiate(cell->GetFirst(), bindings, renames, is_quoted),
+                                   Instantiate(cell->GetSecond(), bindings, renames,
+                                               is_rest_quoted));
+    }
+
+    // (element ... rest): the element is repeated for each value of its sequence variables
+    std::vector<std::string> variables;
+    CollectVariables(cell->GetFirst(), &variables);
+    std::vector<std::string> sequence_variables;
+    size_t count = 0;
+    for (const std::string& variable : variables) {
+        auto binding = bindings.find(variable);
+        if (binding == bindings.end() || !binding->second.is_sequence) {
+            continue;
+        }
+        if (!sequence_variables.empty() && binding->second.sequence.size() != count) {
+            throw SyntaxError("Pattern variables under one ellipsis must match equally often.");
+        }
+        sequence_variables.push_back(variable);
+        count = binding->second.sequence.size();
+    }
+    if (sequence_variables.empty()) {
+        throw SyntaxError("Ellipsis in template must follow a pattern variable under ellipsis.");
+    }
+    ObjectPtrVector repeated(count);
+    for (size_t i = 0; i < count; ++i) {
+        Bindings repetition = bindings;
+        for (const std::string& variable : sequence_variables) {
+            repetition[variable] = bindings.at(variable).sequence[i];
+        }
+        repeated[i] = Instantiate(cell->GetFirst(), repetition, renames, is_quoted);
+    }
+    ObjectPtr result = Instantiate(next->GetSecond(), bindings, renames, is_quoted);
+    for (auto it = repeated.rbegin(); it != repeated.rend(); ++it) {
+        result = heap_ref.Make<Cell>(*it, result);
+    }
+    return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Helper functions' realization
+
+SyntaxRules* MakeSyntaxRules(ObjectPtr spec) {
+    ObjectPtrVector parts = (Is<Cell>(spec)) ? ListToVector(spec) : ObjectPtrVector{};
+    if (parts.size() < 2 || !IsSymbolNamed(parts[0], kSyntaxRulesKeyword) ||
+        (parts[1] && !Is<Cell>(parts[1]))) {
+        throw SyntaxError("Wrong syntax for syntax-rules.");
+    }
+    std::unordered_set<std::string> literals;
+    for (ObjectPtr literal : ListToVector(parts[1])) {
+        if (!Is<Symbol>(literal)) {
+            throw SyntaxError("Literals of syntax-rules must be symbols.");
+        }
+        literals.insert(As<Symbol>(literal)->GetName());
+    }
+    std::vector<std::pair<ObjectPtr, ObjectPtr>> rules;
+    for (size_t i = 2; i < parts.size(); ++i) {
+        ObjectPtrVector rule = (Is<Cell>(parts[i])) ? ListToVector(parts[i]) : ObjectPtrVector{};
+        if (rule.size() != 2 || !Is<Cell>(rule[0])) {
+            throw SyntaxError("Rule of syntax-rules must be a list pattern and a template.");
+        }
+        rules.emplace_back(rule[0], rule[1]);
+    }
+    return Heap::Instance().Make<SyntaxRules>(literals, rules);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <unordered_set>
+
+#include "object.h"
+
+const std::string kSyntaxRulesKeyword = "syntax-rules";
+const std::string kUnderscoreName = "_";
+
+// SyntaxRules object
+// Transformer of (define-syntax name (syntax-rules (literal ...) (pattern template) ...)).
+// It's bound to the macro's name where the define-syntax is evaluated, and the analyzer
+// replaces uses of the name by their expansions before analyzing them. A local name hides
+// the macro of the same name.
+// Hygiene is partial: names bound by lambda and let forms of a template are renamed in each
+// expansion, so they never capture names of the use. Free names of a template aren't
+// renamed, they are looked up where the macro is used, so a local binding of the use
+// (e.g. of if or list) changes the expansion's meaning.
+
+class SyntaxRules : public Object {
+public:
+    SyntaxRules(const std::unordered_set<std::string>& literals,
+                const std::vector<std::pair<ObjectPtr, ObjectPtr>>& rules);
+
+    // Expansion of the form by the first matching rule, SyntaxError if none matches
+    ObjectPtr Expand(ObjectPtr form);
+
+    const std::unordered_set<std::string>& GetLiterals() const {
+        return literals_;
+    }
+
+    // (pattern, template) pairs of the rules
+    std::vector<std::pair<ObjectPtr, ObjectPtr>> GetRules() const;
+
+    // The transformer is shared by all the names the macro is bound to
+    ObjectPtr Clone() override {
+        return this;
+    }
+
+    std::string Serialize() override {
+        return "#<syntax-rules>";
+    }
+
+private:
+    // Values of a pattern variable: a datum, or a sequence of values for each repetition
+    // of an ellipsis the variable is under
+    struct Binding {
+        ObjectPtr value = nullptr;
+        std::vector<Binding> sequence;
+        bool is_sequence = false;
+    };
+
+    using Bindings = std::unordered_map<std::string, Binding>;
+    using Renames = std::unordered_map<std::string, ObjectPtr>;
+
+    struct Rule {
+        ObjectPtr pattern;
+        ObjectPtr templ;
+        // symbols of the template bound by its own lambda and let forms
+        std::unordered_set<std::string> binders;
+    };
+
+    bool IsPatternVariable(ObjectPtr pattern) const;
+    void CollectVariables(ObjectPtr pattern, std::vector<std::string>* variables) const;
+    void CollectBinders(ObjectPtr templ, const std::unordered_set<std::string>& variables,
+                        std::unordered_set<std::string>* binders) const;
+
+    bool Match(ObjectPtr pattern, ObjectPtr form, Bindings* bindings) const;
+    ObjectPtr Instantiate(ObjectPtr templ, const Bindings& bindings, const Renames& renames,
+                          bool is_quoted) const;
+
+    std::unordered_set<std::string> literals_;
+    std::vector<Rule> rules_;
+    inline static size_t renames_count_ = 0;
+};
+
+// Helper functions
+
+// (syntax-rules (literal ...) (pattern template) ...) to its transformer
+SyntaxRules* MakeSyntaxRules(ObjectPtr spec);
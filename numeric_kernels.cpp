@@ -0,0 +1,434 @@
+#include "numeric_kernels.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define AVX2_KERNELS_SUPPORTED
+#include <immintrin.h>
+#endif
+
+constexpr size_t kLanesCount = 4;
+
+template <Comparison kComparison, typename T>
+bool Holds(T lhs, T rhs) {
+    if constexpr (kComparison == Comparison::LESS) {
+        return lhs < rhs;
+    } else if constexpr (kComparison == Comparison::LESS_EQUAL) {
+        return lhs <= rhs;
+    } else if constexpr (kComparison == Comparison::EQUAL) {
+        return lhs == rhs;
+    } else if constexpr (kComparison == Comparison::GREATER) {
+        return lhs > rhs;
+    } else {
+        return lhs >= rhs;
+    }
+}
+
+// Lanes of a double accumulator are added pairwise, as in every kernel set
+static double ReduceLanes(const double* lanes) {
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Scalar kernels
+
+static bool SumS64Scalar(const int64_t* data, size_t size, int64_t* result) {
+    int64_t sum = 0;
+    for (size_t i = 0; i < size; ++i) {
+        if (__builtin_add_overflow(sum, data[i], &sum)) {
+            return false;
+        }
+    }
+    *result = sum;
+    return true;
+}
+
+static double SumF64Scalar(const double* data, size_t size) {
+    double lanes[kLanesCount] = {};
+    for (size_t i = 0; i < size; ++i) {
+        lanes[i % kLanesCount] += data[i];
+    }
+    return ReduceLanes(lanes);
+}
+
+template <typename T>
+T MinScalar(const T* data, size_t size) {
+    T result = data[0];
+    for (size_t i = 1; i < size; ++i) {
+        result = (result > data[i]) ? data[i] : result;
+    }
+    return result;
+}
+
+template <typename T>
+T MaxScalar(const T* data, size_t size) {
+    T result = data[0];
+    for (size_t i = 1; i < size; ++i) {
+        result = (result > data[i]) ? result : data[i];
+    }
+    return result;
+}
+
+static double DotF64Scalar(const double* lhs, const double* rhs, size_t size) {
+    double lanes[kLanesCount] = {};
+    for (size_t i = 0; i < size; ++i) {
+        lanes[i % kLanesCount] += lhs[i] * rhs[i];
+    }
+    return ReduceLanes(lanes);
+}
+
+static bool AddS64Scalar(const int64_t* lhs, const int64_t* rhs, int64_t* result, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        if (__builtin_add_overflow(lhs[i], rhs[i], &result[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void AddF64Scalar(const double* lhs, const double* rhs, double* result, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        result[i] = lhs[i] + rhs[i];
+    }
+}
+
+static void MulF64Scalar(const double* lhs, const double* rhs, double* result, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        result[i] = lhs[i] * rhs[i];
+    }
+}
+
+static void ScaleF64Scalar(const double* data, double factor, double* result, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        result[i] = data[i] * factor;
+    }
+}
+
+template <Comparison kComparison, typename T>
+void MaskScalar(const T* data, T threshold, int64_t* result, size_t from, size_t size) {
+    for (size_t i = from; i < size; ++i) {
+        result[i] = Holds<kComparison>(data[i], threshold);
+    }
+}
+
+template <typename T>
+void MaskScalar(const T* data, T threshold, Comparison comparison, int64_t* result,
+                size_t size) {
+    switch (comparison) {
+        case Comparison::LESS:
+            return MaskScalar<Comparison::LESS>(data, threshold, result, 0, size);
+        case Comparison::LESS_EQUAL:
+            return MaskScalar<Comparison::LESS_EQUAL>(data, threshold, result, 0, size);
+        case Comparison::EQUAL:
+            return MaskScalar<Comparison::EQUAL>(data, threshold, result, 0, size);
+        case Comparison::GREATER:
+            return MaskScalar<Comparison::GREATER>(data, threshold, result, 0, size);
+        case Comparison::GREATER_EQUAL:
+            return MaskScalar<Comparison::GREATER_EQUAL>(data, threshold, result, 0, size);
+    }
+}
+
+static const NumericKernels kScalarNumericKernels = {
+    SumS64Scalar,
+    SumF64Scalar,
+    MinScalar<int64_t>,
+    MaxScalar<int64_t>,
+    MinScalar<double>,
+    MaxScalar<double>,
+    DotF64Scalar,
+    AddS64Scalar,
+    AddF64Scalar,
+    MulF64Scalar,
+    ScaleF64Scalar,
+    MaskScalar<int64_t>,
+    MaskScalar<double>,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+// AVX2 kernels
+// Four elements are processed per instruction, the remainder is done by scalar code.
+
+#ifdef AVX2_KERNELS_SUPPORTED
+
+#define AVX2_KERNEL __attribute__((target("avx2")))
+
+AVX2_KERNEL static __m256i LoadS64(const int64_t* data) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+}
+
+AVX2_KERNEL static void StoreS64(int64_t* data, __m256i value) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(data), value);
+}
+
+// Lanes whose signed sum overflowed have the sign bit set
+AVX2_KERNEL static __m256i SumOverflows(__m256i lhs, __m256i rhs, __m256i sum) {
+    return _mm256_and_si256(_mm256_xor_si256(sum, lhs), _mm256_xor_si256(sum, rhs));
+}
+
+AVX2_KERNEL static bool HasSignBits(__m256i value) {
+    return _mm256_movemask_pd(_mm256_castsi256_pd(value)) != 0;
+}
+
+AVX2_KERNEL static bool SumS64Avx2(const int64_t* data, size_t size, int64_t* result) {
+    __m256i sum = _mm256_setzero_si256();
+    __m256i overflows = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + kLanesCount <= size; i += kLanesCount) {
+        __m256i next = LoadS64(data + i);
+        __m256i next_sum = _mm256_add_epi64(sum, next);
+        overflows = _mm256_or_si256(overflows, SumOverflows(sum, next, next_sum));
+        sum = next_sum;
+    }
+    if (HasSignBits(overflows)) {
+        return false;
+    }
+    int64_t lanes[kLanesCount];
+    StoreS64(lanes, sum);
+    int64_t total = 0;
+    for (int64_t lane : lanes) {
+        if (__builtin_add_overflow(total, lane, &total)) {
+            return false;
+        }
+    }
+    for (; i < size; ++i) {
+        if (__builtin_add_overflow(total, data[i], &total)) {
+            return false;
+        }
+    }
+    *result = total;
+    return true;
+}
+
+AVX2_KERNEL static double SumF64Avx2(const double* data, size_t size) {
+    __m256d sum = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + kLanesCount <= size; i += kLanesCount) {
+        sum = _mm256_add_pd(sum, _mm256_loadu_pd(data + i));
+    }
+    double lanes[kLanesCount];
+    _mm256_storeu_pd(lanes, sum);
+    for (; i < size; ++i) {
+        lanes[i % kLanesCount] += data[i];
+    }
+    return ReduceLanes(lanes);
+}
+
+// Picks the lesser (or greater) element of each lane, the way MinScalar and MaxScalar do
+template <bool kIsMin>
+AVX2_KERNEL int64_t ExtremumS64Avx2(const int64_t* data, size_t size) {
+    if (size < kLanesCount) {
+        return (kIsMin) ? MinScalar(data, size) : MaxScalar(data, size);
+    }
+    __m256i result = LoadS64(data);
+    size_t i = kLanesCount;
+    for (; i + kLanesCount <= size; i += kLanesCount) {
+        __m256i next = LoadS64(data + i);
+        __m256i greater = _mm256_cmpgt_epi64(result, next);
+        result = (kIsMin) ? _mm256_blendv_epi8(result, next, greater)
+                          : _mm256_blendv_epi8(next, result, greater);
+    }
+    int64_t lanes[kLanesCount + kLanesCount - 1];
+    StoreS64(lanes, result);
+    size_t count = kLanesCount;
+    for (; i < size; ++i) {
+        lanes[count++] = data[i];
+    }
+    return (kIsMin) ? MinScalar(lanes, count) : MaxScalar(lanes, count);
+}
+
+template <bool kIsMin>
+AVX2_KERNEL double ExtremumF64Avx2(const double* data, size_t size) {
+    if (size < kLanesCount) {
+        return (kIsMin) ? MinScalar(data, size) : MaxScalar(data, size);
+    }
+    __m256d result = _mm256_loadu_pd(data);
+    size_t i = kLanesCount;
+    for (; i + kLanesCount <= size; i += kLanesCount) {
+        __m256d next = _mm256_loadu_pd(data + i);
+        result = (kIsMin) ? _mm256_min_pd(next, result) : _mm256_max_pd(next, result);
+    }
+    double lanes[kLanesCount + kLanesCount - 1];
+    _mm256_storeu_pd(lanes, result);
+    size_t count = kLanesCount;
+    for (; i < size; ++i) {
+        lanes[count++] = data[i];
+    }
+    return (kIsMin) ? MinScalar(lanes, count) : MaxScalar(lanes, count);
+}
+
+AVX2_KERNEL static double DotF64Avx2(const double* lhs, const double* rhs, size_t size) {
+    __m256d sum = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + kLanesCount <= size; i += kLanesCount) {
+        __m256d product = _mm256_mul_pd(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i));
+        sum = _mm256_add_pd(sum, product);
+    }
+    double lanes[kLanesCount];
+    _mm256_storeu_pd(lanes, sum);
+    for (; i < size; ++i) {
+        lanes[i % kLanesCount] += lhs[i] * rhs[i];
+    }
+    return ReduceLanes(lanes);
+}
+
+AVX2_KERNEL static bool AddS64Avx2(const int64_t* lhs, const int64_t* rhs, int64_t* result,
+                                   size_t size) {
+    __m256i overflows = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + kLanesCount <= size; i += kLanesCount) {
+        __m256i lhs_lanes = LoadS64(lhs + i);
+        __m256i rhs_lanes = LoadS64(rhs + i);
+        __m256i sum = _mm256_add_epi64(lhs_lanes, rhs_lanes);
+        overflows = _mm256_or_si256(overflows, SumOverflows(lhs_lanes, rhs_lanes, sum));
+        StoreS64(result + i, sum);
+    }
+    if (HasSignBits(overflows)) {
+        return false;
+    }
+    return AddS64Scalar(lhs + i, rhs + i, result + i, size - i);
+}
+
+AVX2_KERNEL static void AddF64Avx2(const double* lhs, const double* rhs, double* result,
+                                   size_t size) {
+    size_t i = 0;
+    for (; i + kLanesCount <= size; i += kLanesCount) {
+        _mm256_storeu_pd(result + i,
+                         _mm256_add_pd(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i)));
+    }
+    AddF64Scalar(lhs + i, rhs + i, result + i, size - i);
+}
+
+AVX2_KERNEL static void MulF64Avx2(const double* lhs, const double* rhs, double* result,
+                                   size_t size) {
+    size_t i = 0;
+    for (; i + kLanesCount <= size; i += kLanesCount) {
+        _mm256_storeu_pd(result + i,
+                         _mm256_mul_pd(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i)));
+    }
+    MulF64Scalar(lhs + i, rhs + i, result + i, size - i);
+}
+
+AVX2_KERNEL static void ScaleF64Avx2(const double* data, double factor, double* result,
+                                     size_t size) {
+    __m256d factors = _mm256_set1_pd(factor);
+    size_t i = 0;
+    for (; i + kLanesCount <= size; i += kLanesCount) {
+        _mm256_storeu_pd(result + i, _mm256_mul_pd(_mm256_loadu_pd(data + i), factors));
+    }
+    ScaleF64Scalar(data + i, factor, result + i, size - i);
+}
+
+// Comparisons give all ones in lanes where they hold, these are turned into ones
+template <Comparison kComparison>
+AVX2_KERNEL void MaskS64Avx2For(const int64_t* data, int64_t threshold, int64_t* result,
+                             size_t size) {
+    __m256i thresholds = _mm256_set1_epi64x(threshold);
+    __m256i ones = _mm256_set1_epi64x(1);
+    size_t i = 0;
+    for (; i + kLanesCount <= size; i += kLanesCount) {
+        __m256i next = LoadS64(data + i);
+        __m256i mask;
+        if constexpr (kComparison == Comparison::LESS) {
+            mask = _mm256_and_si256(_mm256_cmpgt_epi64(thresholds, next), ones);
+        } else if constexpr (kComparison == Comparison::LESS_EQUAL) {
+            mask = _mm256_andnot_si256(_mm256_cmpgt_epi64(next, thresholds), ones);
+        } else if constexpr (kComparison == Comparison::EQUAL) {
+            mask = _mm256_and_si256(_mm256_cmpeq_epi64(next, thresholds), ones);
+        } else if constexpr (kComparison == Comparison::GREATER) {
+            mask = _mm256_and_si256(_mm256_cmpgt_epi64(next, thresholds), ones);
+        } else {
+            mask = _mm256_andnot_si256(_mm256_cmpgt_epi64(thresholds, next), ones);
+        }
+        StoreS64(result + i, mask);
+    }
+    MaskScalar<kComparison>(data, threshold, result, i, size);
+}
+
+template <Comparison kComparison>
+AVX2_KERNEL void MaskF64Avx2For(const double* data, double threshold, int64_t* result,
+                             size_t size) {
+    // ordered predicates, so NaN compares with nothing as in scalar code
+    constexpr int kPredicate = (kComparison == Comparison::LESS)         ? _CMP_LT_OQ
+                               : (kComparison == Comparison::LESS_EQUAL) ? _CMP_LE_OQ
+                               : (kComparison == Comparison::EQUAL)      ? _CMP_EQ_OQ
+                               : (kComparison == Comparison::GREATER)    ? _CMP_GT_OQ
+                                                                         : _CMP_GE_OQ;
+    __m256d thresholds = _mm256_set1_pd(threshold);
+    __m256i ones = _mm256_set1_epi64x(1);
+    size_t i = 0;
+    for (; i + kLanesCount <= size; i += kLanesCount) {
+        __m256d mask = _mm256_cmp_pd(_mm256_loadu_pd(data + i), thresholds, kPredicate);
+        StoreS64(result + i, _mm256_and_si256(_mm256_castpd_si256(mask), ones));
+    }
+    MaskScalar<kComparison>(data, threshold, result, i, size);
+}
+
+AVX2_KERNEL static void MaskS64Avx2(const int64_t* data, int64_t threshold,
+                                    Comparison comparison, int64_t* result, size_t size) {
+    switch (comparison) {
+        case Comparison::LESS:
+            return MaskS64Avx2For<Comparison::LESS>(data, threshold, result, size);
+        case Comparison::LESS_EQUAL:
+            return MaskS64Avx2For<Comparison::LESS_EQUAL>(data, threshold, result, size);
+        case Comparison::EQUAL:
+            return MaskS64Avx2For<Comparison::EQUAL>(data, threshold, result, size);
+        case Comparison::GREATER:
+            return MaskS64Avx2For<Comparison::GREATER>(data, threshold, result, size);
+        case Comparison::GREATER_EQUAL:
+            return MaskS64Avx2For<Comparison::GREATER_EQUAL>(data, threshold, result, size);
+    }
+}
+
+AVX2_KERNEL static void MaskF64Avx2(const double* data, double threshold, Comparison comparison,
+                                    int64_t* result, size_t size) {
+    switch (comparison) {
+        case Comparison::LESS:
+            return MaskF64Avx2For<Comparison::LESS>(data, threshold, result, size);
+        case Comparison::LESS_EQUAL:
+            return MaskF64Avx2For<Comparison::LESS_EQUAL>(data, threshold, result, size);
+        case Comparison::EQUAL:
+            return MaskF64Avx2For<Comparison::EQUAL>(data, threshold, result, size);
+        case Comparison::GREATER:
+            return MaskF64Avx2For<Comparison::GREATER>(data, threshold, result, size);
+        case Comparison::GREATER_EQUAL:
+            return MaskF64Avx2For<Comparison::GREATER_EQUAL>(data, threshold, result, size);
+    }
+}
+
+static const NumericKernels kAvx2NumericKernels = {
+    SumS64Avx2,
+    SumF64Avx2,
+    ExtremumS64Avx2<true>,
+    ExtremumS64Avx2<false>,
+    ExtremumF64Avx2<true>,
+    ExtremumF64Avx2<false>,
+    DotF64Avx2,
+    AddS64Avx2,
+    AddF64Avx2,
+    MulF64Avx2,
+    ScaleF64Avx2,
+    MaskS64Avx2,
+    MaskF64Avx2,
+};
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+static const NumericKernels& SelectNumericKernels() {
+#ifdef AVX2_KERNELS_SUPPORTED
+    if (__builtin_cpu_supports("avx2")) {
+        return kAvx2NumericKernels;
+    }
+#endif
+    return kScalarNumericKernels;
+}
+
+const NumericKernels& GetNumericKernels() {
+    static const NumericKernels& kernels = SelectNumericKernels();
+    return kernels;
+}
+
+const NumericKernels& GetScalarNumericKernels() {
+    return kScalarNumericKernels;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Bulk kernels of homogeneous numeric vectors
+// Each kernel set is chosen once by the CPU at hand: AVX2 where it's supported,
+// plain loops otherwise. Sums and dot products of doubles accumulate in four lanes
+// (element i goes to lane i % 4) in every set, so all sets give the same results.
+
+enum class Comparison { LESS, LESS_EQUAL, EQUAL, GREATER, GREATER_EQUAL };
+
+struct NumericKernels {
+    // false on overflow, the sum must be computed another way then
+    bool (*sum_s64)(const int64_t* data, size_t size, int64_t* result);
+    double (*sum_f64)(const double* data, size_t size);
+    // size must be positive
+    int64_t (*min_s64)(const int64_t* data, size_t size);
+    int64_t (*max_s64)(const int64_t* data, size_t size);
+    double (*min_f64)(const double* data, size_t size);
+    double (*max_f64)(const double* data, size_t size);
+    double (*dot_f64)(const double* lhs, const double* rhs, size_t size);
+    // false on overflow, then the contents of result are unspecified
+    bool (*add_s64)(const int64_t* lhs, const int64_t* rhs, int64_t* result, size_t size);
+    void (*add_f64)(const double* lhs, const double* rhs, double* result, size_t size);
+    void (*mul_f64)(const double* lhs, const double* rhs, double* result, size_t size);
+    void (*scale_f64)(const double* data, double factor, double* result, size_t size);
+    // result[i] is 1 if data[i] compares with the threshold, 0 otherwise
+    void (*mask_s64)(const int64_t* data, int64_t threshold, Comparison comparison,
+                     int64_t* result, size_t size);
+    void (*mask_f64)(const double* data, double threshold, Comparison comparison,
+                     int64_t* result, size_t size);
+};
+
+// The fastest kernels supported by the CPU
+const NumericKernels& GetNumericKernels();
+
+// Plain loops, available everywhere
+const NumericKernels& GetScalarNumericKernels();
@@ -1,9 +1,22 @@
 #include "object.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <new>
+
+BooleanSymbol* const kTrueSymbol = Heap::Instance().MakePermanent<BooleanSymbol>(kTrueTokenName);
+BooleanSymbol* const kFalseSymbol = Heap::Instance().MakePermanent<BooleanSymbol>(kFalseTokenName);
+EscapeMarker* const kEscapeMarker = Heap::Instance().MakePermanent<EscapeMarker>();
+UnassignedMarker* const kUnassignedMarker = Heap::Instance().MakePermanent<UnassignedMarker>();
 
 // Realization of methods for working with heap
 
 void Heap::MarkAndSweep() {
     root_->Mark();
+    for (const auto& [object, pins_count] : pinned_) {
+        Object::MarkReference(object);
+    }
     for (size_t i = 0; i < heap_.size(); ++i) {
         while (i < heap_.size() && !heap_[i]->IsConnected()) {
             std::swap(heap_[i], heap_.back());
@@ -14,16 +27,138 @@ void Heap::MarkAndSweep() {
             heap_[i]->ResetMarkFlag();
         }
     }
+    for (ObjectPtr ptr : permanent_) {
+        ptr->ResetMarkFlag();
+    }
 }
 
-ObjectPtr Symbol::Evaluate(ContextPtr context) {
-    if (context->Contains(name_)) {
-        ObjectPtr eval_symbol = context->Get(name_);
-        eval_symbol->SetContext(context);
-        return eval_symbol;
+// Float boxes' realization
+
+// Freed boxes are linked through their own memory
+struct FreeFloatBox {
+    FreeFloatBox* next;
+};
+
+// Each thread has its own list, boxes are only freed by the collector on the interpreter's thread
+static thread_local FreeFloatBox* free_float_boxes = nullptr;
+static thread_local size_t free_float_boxes_count = 0;
+// Boxes over that are given back to the system allocator
+constexpr size_t kMaxFreeFloatBoxes = 4096;
+
+void* FloatNumber::operator new(size_t size) {
+    if (!free_float_boxes) {
+        return ::operator new(size);
+    }
+    FreeFloatBox* box = free_float_boxes;
+    free_float_boxes = box->next;
+    --free_float_boxes_count;
+    return box;
+}
+
+void FloatNumber::operator delete(void* ptr) {
+    if (free_float_boxes_count == kMaxFreeFloatBoxes) {
+        ::operator delete(ptr);
+        return;
+    }
+    free_float_boxes = new (ptr) FreeFloatBox{free_float_boxes};
+    ++free_float_boxes_count;
+}
+
+std::string FloatNumber::Serialize() {
+    return SerializeFloat(value_);
+}
+
+// String's realization
+
+String* String::Concatenate(String* lhs, String* rhs) {
+    size_t length = lhs->length_ + rhs->length_;
+    if (length <= kMaxShortStringLength) {
+        std::string value(lhs->GetView());
+        value += rhs->GetView();
+        return Heap::Instance().Make<String>(std::move(value));
+    }
+    std::shared_ptr<std::string> buffer = lhs->buffer_;
+    if (!buffer || buffer->size() != lhs->length_ || Scheduler::IsRunningTask()) {
+        // the buffer is extended by another string already, or other parallel tasks
+        // may read it
+        buffer = std::make_shared<std::string>(lhs->GetView());
+    }
+    if (rhs->buffer_ == buffer) {
+        // the buffer may be reallocated while a part of it is appended
+        buffer->append(std::string(rhs->GetView()));
     } else {
+        buffer->append(rhs->GetView());
+    }
+    return Heap::Instance().Make<String>(buffer, length);
+}
+
+std::string String::Serialize() {
+    std::string result;
+    result.push_back(DoubleQuoteChar);
+    for (char c : GetView()) {
+        if (c == DoubleQuoteChar || c == BackslashChar) {
+            result.push_back(BackslashChar);
+            result.push_back(c);
+        } else if (c == '\n') {
+            result += "\\n";
+        } else if (c == '\t') {
+            result += "\\t";
+        } else {
+            result.push_back(c);
+        }
+    }
+    result.push_back(DoubleQuoteChar);
+    return result;
+}
+
+ObjectPtr Symbol::Evaluate(ContextPtr context) {
+    if (!context->Contains(*name_)) {
         throw NameError("There are no such name.");
     }
+    ObjectPtr value = context->Get(*name_);
+    if (value == kUnassignedMarker) {
+        throw RuntimeError("Name is used before its value is assigned.");
+    }
+    return value;
+}
+
+ObjectPtr BooleanSymbol::Clone() {
+    return GetBooleanSymbol(is_true_);
+}
+
+ObjectPtr Cell::Clone() {
+    // the cells of the list are cloned in a loop, only elements are cloned recursively
+    auto& heap_ref = Heap::Instance();
+    Cell* cloned_list = heap_ref.Make<Cell>((first_) ? first_->Clone() : nullptr, nullptr);
+    Cell* last_cell = cloned_list;
+    ObjectPtr rest = second_;
+    while (Is<Cell>(rest)) {
+        ObjectPtr element = As<Cell>(rest)->first_;
+        Cell* cloned_cell = heap_ref.Make<Cell>((element) ? element->Clone() : nullptr, nullptr);
+        last_cell->second_ = cloned_cell;
+        last_cell = cloned_cell;
+        rest = As<Cell>(rest)->second_;
+    }
+    last_cell->second_ = (rest) ? rest->Clone() : nullptr;
+    return cloned_list;
+}
+
+void Cell::MarkReferences() {
+    MarkReference(first_);
+    ObjectPtr rest = second_;
+    // the rests of lists and of forced streams may be long, so they are marked in a loop
+    while (rest) {
+        if (auto cell = As<Cell>(rest); cell && !cell->IsConnected()) {
+            cell->is_connected_to_root = true;
+            MarkReference(cell->first_);
+            rest = cell->second_;
+        } else if (auto promise = As<Promise>(rest); promise && promise->GetForcedValue()) {
+            rest = promise->MarkWithoutValue();
+        } else {
+            break;
+        }
+    }
+    MarkReference(rest);
 }
 
 std::string Cell::Serialize() {
@@ -33,7 +168,8 @@ std::string Cell::Serialize() {
     ObjectPtr cell = GetSecond();
     while (Is<Cell>(cell)) {
         result.push_back(SpaceChar);
-        result += (cell) ? As<Cell>(cell)->GetFirst()->Serialize() : kEmptyListString;
+        ObjectPtr element = As<Cell>(cell)->GetFirst();
+        result += (element) ? element->Serialize() : kEmptyListString;
         cell = As<Cell>(cell)->GetSecond();
     }
     if (cell) {
@@ -43,62 +179,68 @@ std::string Cell::Serialize() {
     return result;
 }
 
+std::string Vector::Serialize() {
+    std::string result;
+    result.push_back(PoundChar);
+    result.push_back(OpenBracketChar);
+    for (size_t i = 0; i < elements_.size(); ++i) {
+        if (i > 0) {
+            result.push_back(SpaceChar);
+        }
+        result += (elements_[i]) ? elements_[i]->Serialize() : kEmptyListString;
+    }
+    result.push_back(CloseBracketChar);
+    return result;
+}
+
 // Some predicate functions' realization.
 
-ObjectPtr NullPredicateFunction::Apply(const ObjectPtrVector &vectorized_list) {
-    ObjectPtrVector eval_list = EvaluateListArguments(vectorized_list, context_);
-    ThrowIfWrongNumberOfArguments(1, vectorized_list, "Predicate");
-    return (!eval_list[0]) ? Heap::Instance().Make<BooleanSymbol>(kTrueTokenName)
-                           : Heap::Instance().Make<BooleanSymbol>(kFalseTokenName);
+ObjectPtr NullPredicateFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Predicate");
+    return GetBooleanSymbol(!arguments[0]);
 }
 
-ObjectPtr ListPredicateFunction::Apply(const ObjectPtrVector &vectorized_list) {
-    ObjectPtrVector eval_list = EvaluateListArguments(vectorized_list, context_);
-    ThrowIfWrongNumberOfArguments(1, eval_list, "Predicate");
-    return CheckIfList(eval_list[0]);
+ObjectPtr ListPredicateFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Predicate");
+    return CheckIfList(arguments[0]);
 }
 
 // Some pair functions' realization.
 
-ObjectPtr ConsFunction::Apply(const ObjectPtrVector &vectorized_list) {
-    ObjectPtrVector eval_list = EvaluateListArguments(vectorized_list, context_);
-    ThrowIfWrongNumberOfArguments(2, eval_list, "Cons");
-    return Heap::Instance().Make<Cell>(eval_list[0], eval_list[1]);
+ObjectPtr ConsFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(2, arguments, "Cons");
+    return Heap::Instance().Make<Cell>(arguments[0], arguments[1]);
 }
 
-ObjectPtr CarFunction::Apply(const ObjectPtrVector &vectorized_list) {
-    ObjectPtrVector eval_list = EvaluateListArguments(vectorized_list, context_);
-    ThrowIfWrongNumberOfArguments(1, eval_list, "Car");
-    ThrowIfMismatchOperandsType<Cell>(eval_list, "Operand must be cell.");
-    return As<Cell>(eval_list[0])->GetFirst();
+ObjectPtr CarFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Car");
+    ThrowIfMismatchOperandsType<Cell>(arguments, "Operand must be cell.");
+    return As<Cell>(arguments[0])->GetFirst();
 }
 
-ObjectPtr CdrFunction::Apply(const ObjectPtrVector &vectorized_list) {
-    ObjectPtrVector eval_list = EvaluateListArguments(vectorized_list, context_);
-    ThrowIfWrongNumberOfArguments(1, eval_list, "Cdr");
-    ThrowIfMismatchOperandsType<Cell>(eval_list, "Operand must be cell.");
-    return As<Cell>(eval_list[0])->GetSecond();
+ObjectPtr CdrFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Cdr");
+    ThrowIfMismatchOperandsType<Cell>(arguments, "Operand must be cell.");
+    return As<Cell>(arguments[0])->GetSecond();
 }
 
 // Some list functions' realization.
 
-ObjectPtr ToListFunction::Apply(const ObjectPtrVector &vectorized_list) {
-    ObjectPtrVector eval_list = EvaluateListArguments(vectorized_list, context_);
-    if (eval_list.empty()) {
+ObjectPtr ToListFunction::Apply(ObjectPtrSpan arguments) {
+    if (arguments.empty()) {
         return nullptr;
     }
-    ObjectPtr last_cell = Heap::Instance().Make<Cell>(eval_list[eval_list.size() - 1], nullptr);
-    for (int64_t i = eval_list.size() - 2; i >= 0; --i) {
-        last_cell = Heap::Instance().Make<Cell>(eval_list[i], last_cell);
+    ObjectPtr last_cell = Heap::Instance().Make<Cell>(arguments[arguments.size() - 1], nullptr);
+    for (int64_t i = arguments.size() - 2; i >= 0; --i) {
+        last_cell = Heap::Instance().Make<Cell>(arguments[i], last_cell);
     }
     return last_cell;
 }
 
-ObjectPtr ListRefFunction::Apply(const ObjectPtrVector &vectorized_list) {
-    ObjectPtrVector eval_list = EvaluateListArguments(vectorized_list, context_);
-    ValidateArgumentsForListTailAndRef(eval_list);
-    ObjectPtr cell = eval_list[0];
-    int64_t required_number = As<Number>(eval_list[1])->GetValue();
+ObjectPtr ListRefFunction::Apply(ObjectPtrSpan arguments) {
+    ValidateArgumentsForListTailAndRef(arguments);
+    ObjectPtr cell = arguments[0];
+    int64_t required_number = As<Number>(arguments[1])->GetValue();
     if (!cell) {
         throw RuntimeError("Index for list-ref must less than list size.");
     }
@@ -113,11 +255,10 @@ ObjectPtr ListRefFunction::Apply(const ObjectPtrVector &vectorized_list) {
     return As<Cell>(cell)->GetFirst();
 }
 
-ObjectPtr ListTailFunction::Apply(const ObjectPtrVector &vectorized_list) {
-    ObjectPtrVector eval_list = EvaluateListArguments(vectorized_list, context_);
-    ValidateArgumentsForListTailAndRef(eval_list);
-    ObjectPtr cell = eval_list[0];
-    int64_t required_number = As<Number>(eval_list[1])->GetValue();
+ObjectPtr ListTailFunction::Apply(ObjectPtrSpan arguments) {
+    ValidateArgumentsForListTailAndRef(arguments);
+    ObjectPtr cell = arguments[0];
+    int64_t required_number = As<Number>(arguments[1])->GetValue();
     int64_t count = 0;
     while (count != required_number && cell && Is<Cell>(As<Cell>(cell)->GetSecond())) {
         cell = As<Cell>(cell)->GetSecond();
@@ -134,176 +275,704 @@ ObjectPtr ListTailFunction::Apply(const ObjectPtrVector &vectorized_list) {
 
 // Some other functions' realization.
 
-ObjectPtr AbsFunction::Apply(const ObjectPtrVector &vectorized_list) {
-    ObjectPtrVector eval_list = EvaluateListArguments(vectorized_list, context_);
-    ThrowIfWrongNumberOfArguments(1, eval_list, "Abs");
-    ThrowIfMismatchOperandsType<Number>(eval_list, "Operands must be numbers.");
-    int64_t result = std::abs(As<Number>(eval_list[0])->GetValue());
-    return Heap::Instance().Make<Number>(result);
+ObjectPtr AbsFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Abs");
+    ThrowIfNotNumbers(arguments, "Operands must be numbers.");
+    if (auto float_number = As<FloatNumber>(arguments[0])) {
+        return Heap::Instance().Make<FloatNumber>(std::fabs(float_number->GetValue()));
+    }
+    auto number = As<Number>(arguments[0]);
+    if (number && number->GetValue() != INT64_MIN) {
+        return Heap::Instance().Make<Number>(std::abs(number->GetValue()));
+    }
+    return MakeInteger(ToBigInteger(arguments[0]).Abs());
+}
+
+ObjectPtr NumberPredicateFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Predicate");
+    return GetBooleanSymbol(IsNumber(arguments[0]));
 }
 
-ObjectPtr NegFunction::Apply(const ObjectPtrVector &vectorized_list) {
-    ObjectPtrVector eval_list = EvaluateListArguments(vectorized_list, context_);
-    ThrowIfWrongNumberOfArguments(1, eval_list, "Not");
-    if (auto p = As<BooleanSymbol>(eval_list[0])) {
-        return (p->IsTrue()) ? Heap::Instance().Make<BooleanSymbol>(kFalseTokenName)
-                             : Heap::Instance().Make<BooleanSymbol>(kTrueTokenName);
+ObjectPtr NegFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Not");
+    if (auto p = As<BooleanSymbol>(arguments[0])) {
+        return GetBooleanSymbol(!p->IsTrue());
     }
-    return Heap::Instance().Make<BooleanSymbol>(kFalseTokenName);
+    return kFalseSymbol;
 }
 
-ObjectPtr QuoteFunction::Apply(const ObjectPtrVector &vectorized_list) {
-    ThrowIfWrongNumberOfArguments(1, vectorized_list, "Quote");
-    return vectorized_list[0];
+// Pair mutations' realization
+
+ObjectPtr SetCar::Apply(ObjectPtrSpan arguments) {
+    if (arguments.size() != 2) {
+        throw SyntaxError("Wrong syntax for set-car.");
+    }
+    if (!Is<Cell>(arguments[0])) {
+        throw RuntimeError("First operand for set-car must be a cell.");
+    }
+    As<Cell>(arguments[0])->SetFirst(arguments[1]);
+    return nullptr;
+}
+
+ObjectPtr SetCdr::Apply(ObjectPtrSpan arguments) {
+    if (arguments.size() != 2) {
+        throw SyntaxError("Wrong syntax for set-cdr.");
+    }
+    if (!Is<Cell>(arguments[0])) {
+        throw RuntimeError("First operand for set-cdr must be a cell.");
+    }
+    As<Cell>(arguments[0])->SetSecond(arguments[1]);
+    return nullptr;
 }
 
-// Some logic functions' realization.
+// String functions' realization
 
-ObjectPtr AndFunction::Apply(const ObjectPtrVector &vectorized_list) {
-    for (size_t i = 0; i < vectorized_list.size(); ++i) {
-        ObjectPtr eval_ptr = EvaluateExpression(vectorized_list[i], context_);
-        if (auto p = As<BooleanSymbol>(eval_ptr)) {
-            if (!p->IsTrue()) {
-                return eval_ptr;
-            }
-        }
-        if (i == vectorized_list.size() - 1) {
-            return eval_ptr;
-        }
+ObjectPtr StringLengthFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "String-length");
+    ThrowIfMismatchOperandType<String>(0, arguments, "Operand for string-length must be string.");
+    return Heap::Instance().Make<Number>(As<String>(arguments[0])->GetLength());
+}
+
+ObjectPtr StringAppendFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfMismatchOperandsType<String>(arguments, "Operands for string-append must be strings.");
+    if (arguments.empty()) {
+        return Heap::Instance().Make<String>(std::string());
+    }
+    String* result = As<String>(arguments[0]);
+    for (size_t i = 1; i < arguments.size(); ++i) {
+        result = String::Concatenate(result, As<String>(arguments[i]));
+    }
+    return result;
+}
+
+ObjectPtr SubstringFunction::Apply(ObjectPtrSpan arguments) {
+    if (arguments.size() != 2 && arguments.size() != 3) {
+        throw RuntimeError("Wrong number of arguments for substring.");
+    }
+    ThrowIfMismatchOperandType<String>(0, arguments, "First operand for substring must be string.");
+    ThrowIfMismatchOperandsType<Number>(arguments.subspan(1),
+                                        "Bounds for substring must be numbers.");
+    auto string = As<String>(arguments[0]);
+    int64_t start = As<Number>(arguments[1])->GetValue();
+    int64_t end = (arguments.size() == 3) ? As<Number>(arguments[2])->GetValue()
+                                          : static_cast<int64_t>(string->GetLength());
+    if (start < 0 || start > end || static_cast<uint64_t>(end) > string->GetLength()) {
+        throw RuntimeError("Bounds for substring are out of range.");
+    }
+    return Heap::Instance().Make<String>(std::string(string->GetView().substr(start, end - start)));
+}
+
+ObjectPtr StringToSymbolFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "String->symbol");
+    ThrowIfMismatchOperandType<String>(0, arguments, "Operand for string->symbol must be string.");
+    return Heap::Instance().Make<Symbol>(std::string(As<String>(arguments[0])->GetView()));
+}
+
+ObjectPtr SymbolToStringFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Symbol->string");
+    ThrowIfMismatchOperandType<Symbol>(0, arguments, "Operand for symbol->string must be symbol.");
+    return Heap::Instance().Make<String>(As<Symbol>(arguments[0])->GetName());
+}
+
+// Vector functions' realization
+
+ObjectPtr MakeVectorFunction::Apply(ObjectPtrSpan arguments) {
+    if (arguments.empty() || arguments.size() > 2) {
+        throw RuntimeError("Wrong number of arguments for make-vector.");
+    }
+    ThrowIfMismatchOperandType<Number>(0, arguments, "Size for make-vector must be number.");
+    int64_t size = As<Number>(arguments[0])->GetValue();
+    if (size < 0) {
+        throw RuntimeError("Size for make-vector must be non-negative.");
     }
-    return Heap::Instance().Make<BooleanSymbol>(kTrueTokenName);
+    ObjectPtr fill = (arguments.size() == 2) ? arguments[1] : Heap::Instance().Make<Number>(0);
+    return Heap::Instance().Make<Vector>(static_cast<size_t>(size), fill);
+}
+
+ObjectPtr VectorFunction::Apply(ObjectPtrSpan arguments) {
+    return Heap::Instance().Make<Vector>(ObjectPtrVector(arguments.begin(), arguments.end()));
+}
+
+ObjectPtr VectorRefFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(2, arguments, "Vector-ref");
+    ValidateArgumentsForVectorAccess<Vector>(arguments, "vector-ref");
+    return As<Vector>(arguments[0])->Get(As<Number>(arguments[1])->GetValue());
+}
+
+ObjectPtr VectorSetFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(3, arguments, "Vector-set");
+    ValidateArgumentsForVectorAccess<Vector>(arguments, "vector-set!");
+    As<Vector>(arguments[0])->Set(As<Number>(arguments[1])->GetValue(), arguments[2]);
+    return nullptr;
+}
+
+ObjectPtr VectorLengthFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Vector-length");
+    ThrowIfMismatchOperandType<Vector>(0, arguments, "Operand for vector-length must be vector.");
+    return Heap::Instance().Make<Number>(As<Vector>(arguments[0])->GetSize());
+}
+
+ObjectPtr VectorToListFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Vector->list");
+    ThrowIfMismatchOperandType<Vector>(0, arguments, "Operand for vector->list must be vector.");
+    const ObjectPtrVector& elements = As<Vector>(arguments[0])->GetElements();
+    ObjectPtr list = nullptr;
+    for (auto it = elements.rbegin(); it != elements.rend(); ++it) {
+        list = Heap::Instance().Make<Cell>(*it, list);
+    }
+    return list;
+}
+
+ObjectPtr ListToVectorFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "List->vector");
+    if (!As<BooleanSymbol>(CheckIfList(arguments[0]))->IsTrue()) {
+        throw RuntimeError("Operand for list->vector must be list.");
+    }
+    return Heap::Instance().Make<Vector>(ListToVector(arguments[0]));
+}
+
+// Numeric vectors' realization
+
+template <>
+const std::string& S64Vector::GetTypeName() {
+    static const std::string type_name = "s64vector";
+    return type_name;
+}
+
+template <>
+const std::string& F64Vector::GetTypeName() {
+    static const std::string type_name = "f64vector";
+    return type_name;
+}
+
+template <>
+bool S64Vector::IsElement(ObjectPtr object) {
+    return Is<Number>(object);
+}
+
+template <>
+bool F64Vector::IsElement(ObjectPtr object) {
+    return IsNumber(object);
+}
+
+template <>
+int64_t S64Vector::ToElement(ObjectPtr object) {
+    return As<Number>(object)->GetValue();
+}
+
+template <>
+double F64Vector::ToElement(ObjectPtr object) {
+    return ToDouble(object);
 }
 
-ObjectPtr OrFunction::Apply(const ObjectPtrVector &vectorized_list) {
-    for (size_t i = 0; i < vectorized_list.size(); ++i) {
-        ObjectPtr eval_ptr = EvaluateExpression(vectorized_list[i], context_);
-        if (!Is<BooleanSymbol>(eval_ptr) || As<BooleanSymbol>(eval_ptr)->IsTrue()) {
-            return eval_ptr;
+template <>
+ObjectPtr S64Vector::MakeElement(int64_t element) {
+    return Heap::Instance().Make<Number>(element);
+}
+
+template <>
+ObjectPtr F64Vector::MakeElement(double element) {
+    return Heap::Instance().Make<FloatNumber>(element);
+}
+
+template <typename T>
+std::string NumericVector<T>::Serialize() {
+    // #s64(1 2 3) or #f64(1.0 2.5)
+    std::string result;
+    result.push_back(PoundChar);
+    result += GetTypeName().substr(0, 3);
+    result.push_back(OpenBracketChar);
+    for (size_t i = 0; i < elements_.size(); ++i) {
+        if (i > 0) {
+            result.push_back(SpaceChar);
         }
-        if (i == vectorized_list.size() - 1) {
-            return eval_ptr;
+        if constexpr (std::is_same_v<T, int64_t>) {
+            result += std::to_string(elements_[i]);
+        } else {
+            result += SerializeFloat(elements_[i]);
         }
     }
-    return Heap::Instance().Make<BooleanSymbol>(kFalseTokenName);
+    result.push_back(CloseBracketChar);
+    return result;
 }
 
-// Define & set's realization
+template <typename T>
+NumericVector<T>* ToNumericVector(ObjectPtr object) {
+    if (!Is<NumericVector<T>>(object)) {
+        throw RuntimeError("Operand must be " + NumericVector<T>::GetTypeName() + ".");
+    }
+    return As<NumericVector<T>>(object);
+}
 
-ObjectPtr DefineFunction::Apply(const ObjectPtrVector &vectorized_list) {
-    if (vectorized_list.size() < 2) {
-        throw SyntaxError("Wrong syntax for define.");
+template <typename T>
+T ToNumericVectorElement(ObjectPtr object) {
+    if (!NumericVector<T>::IsElement(object)) {
+        throw RuntimeError("Wrong type of " + NumericVector<T>::GetTypeName() + " element.");
     }
-    if (Is<Symbol>(vectorized_list[0])) {
-        std::string var_name = As<Symbol>(vectorized_list[0])->GetName();
-        if (vectorized_list.size() != 2) {
-            throw SyntaxError("Wrong syntax for define.");
+    return NumericVector<T>::ToElement(object);
+}
+
+template <typename T>
+void ThrowIfDifferentSizes(NumericVector<T>* lhs, NumericVector<T>* rhs) {
+    if (lhs->GetSize() != rhs->GetSize()) {
+        throw RuntimeError("Operands of " + NumericVector<T>::GetTypeName() +
+                           " functions must have equal lengths.");
+    }
+}
+
+Comparison ToComparison(ObjectPtr function) {
+    if (Is<LessFunction>(function)) {
+        return Comparison::LESS;
+    } else if (Is<LessEqualFunction>(function)) {
+        return Comparison::LESS_EQUAL;
+    } else if (Is<EqualFunction>(function)) {
+        return Comparison::EQUAL;
+    } else if (Is<GreaterFunction>(function)) {
+        return Comparison::GREATER;
+    } else if (Is<GrEqualFunction>(function)) {
+        return Comparison::GREATER_EQUAL;
+    }
+    throw RuntimeError("First operand for mask must be a comparison.");
+}
+
+template <typename T>
+ObjectPtr MakeNumericVectorFunction<T>::Apply(ObjectPtrSpan arguments) {
+    if (arguments.empty() || arguments.size() > 2) {
+        throw RuntimeError("Wrong number of arguments for make-" +
+                           NumericVector<T>::GetTypeName() + ".");
+    }
+    ThrowIfMismatchOperandType<Number>(0, arguments, "Size of a vector must be number.");
+    int64_t size = As<Number>(arguments[0])->GetValue();
+    if (size < 0) {
+        throw RuntimeError("Size of a vector must be non-negative.");
+    }
+    T fill = (arguments.size() == 2) ? ToNumericVectorElement<T>(arguments[1]) : T();
+    return Heap::Instance().Make<NumericVector<T>>(static_cast<size_t>(size), fill);
+}
+
+template <typename T>
+ObjectPtr NumericVectorFunction<T>::Apply(ObjectPtrSpan arguments) {
+    std::vector<T> elements(arguments.size());
+    for (size_t i = 0; i < arguments.size(); ++i) {
+        elements[i] = ToNumericVectorElement<T>(arguments[i]);
+    }
+    return Heap::Instance().Make<NumericVector<T>>(std::move(elements));
+}
+
+template <typename T>
+ObjectPtr NumericVectorRefFunction<T>::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(2, arguments, "Vector-ref");
+    ValidateArgumentsForVectorAccess<NumericVector<T>>(arguments,
+                                                       NumericVector<T>::GetTypeName() + "-ref");
+    int64_t index = As<Number>(arguments[1])->GetValue();
+    return NumericVector<T>::MakeElement(As<NumericVector<T>>(arguments[0])->Get(index));
+}
+
+template <typename T>
+ObjectPtr NumericVectorSetFunction<T>::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(3, arguments, "Vector-set");
+    ValidateArgumentsForVectorAccess<NumericVector<T>>(arguments,
+                                                       NumericVector<T>::GetTypeName() + "-set!");
+    T value = ToNumericVectorElement<T>(arguments[2]);
+    As<NumericVector<T>>(arguments[0])->Set(As<Number>(arguments[1])->GetValue(), value);
+    return nullptr;
+}
+
+template <typename T>
+ObjectPtr NumericVectorLengthFunction<T>::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Vector-length");
+    return Heap::Instance().Make<Number>(ToNumericVector<T>(arguments[0])->GetSize());
+}
+
+template <typename T>
+ObjectPtr NumericVectorToListFunction<T>::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Vector->list");
+    NumericVector<T>* vector = ToNumericVector<T>(arguments[0]);
+    ObjectPtr list = nullptr;
+    for (size_t i = vector->GetSize(); i > 0; --i) {
+        list = Heap::Instance().Make<Cell>(NumericVector<T>::MakeElement(vector->Get(i - 1)), list);
+    }
+    return list;
+}
+
+template <typename T>
+ObjectPtr ListToNumericVectorFunction<T>::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "List->vector");
+    if (!As<BooleanSymbol>(CheckIfList(arguments[0]))->IsTrue()) {
+        throw RuntimeError("Operand for list->vector must be list.");
+    }
+    ObjectPtrVector list = ListToVector(arguments[0]);
+    std::vector<T> elements(list.size());
+    for (size_t i = 0; i < list.size(); ++i) {
+        elements[i] = ToNumericVectorElement<T>(list[i]);
+    }
+    return Heap::Instance().Make<NumericVector<T>>(std::move(elements));
+}
+
+template <typename T, typename Functor>
+ObjectPtr NumericVectorFoldFunction<T, Functor>::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Vector fold");
+    NumericVector<T>* vector = ToNumericVector<T>(arguments[0]);
+    const T* data = vector->GetData();
+    size_t size = vector->GetSize();
+    const NumericKernels& kernels = GetNumericKernels();
+    if constexpr (std::is_same_v<Functor, Plus>) {
+        if constexpr (std::is_same_v<T, int64_t>) {
+            int64_t sum = 0;
+            if (kernels.sum_s64(data, size, &sum)) {
+                return Heap::Instance().Make<Number>(sum);
+            }
+            // partial sums are flushed to a bignum on overflow
+            BigInteger big_sum;
+            int64_t partial_sum = 0;
+            for (size_t i = 0; i < size; ++i) {
+                if (__builtin_add_overflow(partial_sum, data[i], &sum)) {
+                    big_sum = big_sum + BigInteger(partial_sum);
+                    sum = data[i];
+                }
+                partial_sum = sum;
+            }
+            return MakeInteger(big_sum + BigInteger(partial_sum));
+        } else {
+            return Heap::Instance().Make<FloatNumber>(kernels.sum_f64(data, size));
         }
-        context_->Define(var_name, EvaluateExpression(vectorized_list[1], context_));
-    } else if (Is<Cell>(vectorized_list[0])) {
-        ObjectPtrVector signature =
-            ListToVector(vectorized_list[0]);  // fn - arg1 - arg2 - arg3 - ...
-        std::string func_name = As<Symbol>(signature[0])->GetName();
-        ObjectPtrVector args(signature.size() - 1);
-        for (size_t i = 1; i < signature.size(); ++i) {
-            args[i - 1] = signature[i];
+    } else {
+        if (size == 0) {
+            throw RuntimeError("Few arguments.");
         }
-        ObjectPtrVector body(vectorized_list.size() - 1);
-        for (size_t i = 1; i < vectorized_list.size(); ++i) {
-            body[i - 1] = vectorized_list[i];
+        constexpr bool kIsMin = std::is_same_v<Functor, Min>;
+        if constexpr (std::is_same_v<T, int64_t>) {
+            return NumericVector<T>::MakeElement((kIsMin) ? kernels.min_s64(data, size)
+                                                          : kernels.max_s64(data, size));
+        } else {
+            return NumericVector<T>::MakeElement((kIsMin) ? kernels.min_f64(data, size)
+                                                          : kernels.max_f64(data, size));
         }
-        context_->Define(func_name, Heap::Instance().Make<LambdaFunction>(args, body, context_));
+    }
+}
+
+template <typename T>
+ObjectPtr NumericVectorDotFunction<T>::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(2, arguments, "Vector-dot");
+    NumericVector<T>* lhs = ToNumericVector<T>(arguments[0]);
+    NumericVector<T>* rhs = ToNumericVector<T>(arguments[1]);
+    ThrowIfDifferentSizes(lhs, rhs);
+    if constexpr (std::is_same_v<T, double>) {
+        return Heap::Instance().Make<FloatNumber>(
+            GetNumericKernels().dot_f64(lhs->GetData(), rhs->GetData(), lhs->GetSize()));
     } else {
-        throw SyntaxError("Wrong syntax for define.");
+        // there is no 64-bit multiplication in AVX2, so products are checked one by one
+        BigInteger big_sum;
+        int64_t partial_sum = 0;
+        for (size_t i = 0; i < lhs->GetSize(); ++i) {
+            int64_t product = 0;
+            int64_t sum = 0;
+            if (__builtin_mul_overflow(lhs->Get(i), rhs->Get(i), &product)) {
+                big_sum = big_sum + BigInteger(lhs->Get(i)) * BigInteger(rhs->Get(i));
+                continue;
+            }
+            if (__builtin_add_overflow(partial_sum, product, &sum)) {
+                big_sum = big_sum + BigInteger(partial_sum);
+                sum = product;
+            }
+            partial_sum = sum;
+        }
+        return MakeInteger(big_sum + BigInteger(partial_sum));
     }
-    return nullptr;
 }
 
-ObjectPtr SetFunction::Apply(const ObjectPtrVector &vectorized_list) {
-    if (vectorized_list.size() != 2) {
-        throw SyntaxError("Wrong syntax for set.");
+template <typename T, typename Functor>
+ObjectPtr NumericVectorMapFunction<T, Functor>::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(2, arguments, "Vector map");
+    NumericVector<T>* lhs = ToNumericVector<T>(arguments[0]);
+    NumericVector<T>* rhs = ToNumericVector<T>(arguments[1]);
+    ThrowIfDifferentSizes(lhs, rhs);
+    size_t size = lhs->GetSize();
+    auto result = Heap::Instance().Make<NumericVector<T>>(size, T());
+    const NumericKernels& kernels = GetNumericKernels();
+    constexpr bool kIsSum = std::is_same_v<Functor, Plus>;
+    if constexpr (std::is_same_v<T, double>) {
+        auto kernel = (kIsSum) ? kernels.add_f64 : kernels.mul_f64;
+        kernel(lhs->GetData(), rhs->GetData(), result->GetData(), size);
+    } else if constexpr (kIsSum) {
+        if (!kernels.add_s64(lhs->GetData(), rhs->GetData(), result->GetData(), size)) {
+            throw RuntimeError("Overflow in s64vector-add.");
+        }
+    } else {
+        for (size_t i = 0; i < size; ++i) {
+            if (!Multiplies()(lhs->Get(i), rhs->Get(i), result->GetData() + i)) {
+                throw RuntimeError("Overflow in s64vector-mul.");
+            }
+        }
     }
-    ThrowIfMismatchOperandType<Symbol>(0, vectorized_list,
-                                       "First argument for define must be a symbol");
-    std::string var_name = As<Symbol>(vectorized_list[0])->GetName();
-    if (!context_->Contains(var_name)) {
-        throw NameError("Variable for set must be defined before.");
+    return result;
+}
+
+template <typename T>
+ObjectPtr NumericVectorScaleFunction<T>::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(2, arguments, "Vector-scale");
+    NumericVector<T>* vector = ToNumericVector<T>(arguments[0]);
+    T factor = ToNumericVectorElement<T>(arguments[1]);
+    size_t size = vector->GetSize();
+    auto result = Heap::Instance().Make<NumericVector<T>>(size, T());
+    if constexpr (std::is_same_v<T, double>) {
+        GetNumericKernels().scale_f64(vector->GetData(), factor, result->GetData(), size);
+    } else {
+        for (size_t i = 0; i < size; ++i) {
+            if (!Multiplies()(vector->Get(i), factor, result->GetData() + i)) {
+                throw RuntimeError("Overflow in s64vector-scale.");
+            }
+        }
     }
-    context_->Change(var_name, EvaluateExpression(vectorized_list[1], context_));
-    return nullptr;
+    return result;
 }
 
-ObjectPtr SetCar::Apply(const ObjectPtrVector &vectorized_list) {
-    if (vectorized_list.size() != 2) {
-        throw SyntaxError("Wrong syntax for set-car.");
+template <typename T>
+ObjectPtr NumericVectorMaskFunction<T>::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(3, arguments, "Vector-mask");
+    Comparison comparison = ToComparison(arguments[0]);
+    NumericVector<T>* vector = ToNumericVector<T>(arguments[1]);
+    T threshold = ToNumericVectorElement<T>(arguments[2]);
+    size_t size = vector->GetSize();
+    auto result = Heap::Instance().Make<S64Vector>(size, 0);
+    const NumericKernels& kernels = GetNumericKernels();
+    if constexpr (std::is_same_v<T, int64_t>) {
+        kernels.mask_s64(vector->GetData(), threshold, comparison, result->GetData(), size);
+    } else {
+        kernels.mask_f64(vector->GetData(), threshold, comparison, result->GetData(), size);
     }
-    ObjectPtr eval_first_arg = EvaluateExpression(vectorized_list[0], context_);
-    if (!Is<Cell>(eval_first_arg)) {
-        throw RuntimeError("First operand for set-car must be a cell.");
+    return result;
+}
+
+template class NumericVector<int64_t>;
+template class NumericVector<double>;
+template class MakeNumericVectorFunction<int64_t>;
+template class MakeNumericVectorFunction<double>;
+template class NumericVectorFunction<int64_t>;
+template class NumericVectorFunction<double>;
+template class NumericVectorRefFunction<int64_t>;
+template class NumericVectorRefFunction<double>;
+template class NumericVectorSetFunction<int64_t>;
+template class NumericVectorSetFunction<double>;
+template class NumericVectorLengthFunction<int64_t>;
+template class NumericVectorLengthFunction<double>;
+template class NumericVectorToListFunction<int64_t>;
+template class NumericVectorToListFunction<double>;
+template class ListToNumericVectorFunction<int64_t>;
+template class ListToNumericVectorFunction<double>;
+template class NumericVectorFoldFunction<int64_t, Plus>;
+template class NumericVectorFoldFunction<int64_t, Min>;
+template class NumericVectorFoldFunction<int64_t, Max>;
+template class NumericVectorFoldFunction<double, Plus>;
+template class NumericVectorFoldFunction<double, Min>;
+template class NumericVectorFoldFunction<double, Max>;
+template class NumericVectorDotFunction<int64_t>;
+template class NumericVectorDotFunction<double>;
+template class NumericVectorMapFunction<int64_t, Plus>;
+template class NumericVectorMapFunction<int64_t, Multiplies>;
+template class NumericVectorMapFunction<double, Plus>;
+template class NumericVectorMapFunction<double, Multiplies>;
+template class NumericVectorScaleFunction<int64_t>;
+template class NumericVectorScaleFunction<double>;
+template class NumericVectorMaskFunction<int64_t>;
+template class NumericVectorMaskFunction<double>;
+
+// Escape's realization
+
+ObjectPtr EscapeProcedure::Apply(ObjectPtrSpan arguments) {
+    if (arguments.size() > 1) {
+        throw RuntimeError("Wrong number of arguments for escape continuation.");
     }
-    As<Cell>(eval_first_arg)->SetFirst(EvaluateExpression(vectorized_list[1], context_));
-    return nullptr;
+    if (!is_valid_) {
+        throw RuntimeError("Escape continuation is called after its call/ec returned.");
+    }
+    target_ = this;
+    value_ = (arguments.empty()) ? nullptr : arguments[0];
+    return kEscapeMarker;
 }
 
-ObjectPtr SetCdr::Apply(const ObjectPtrVector &vectorized_list) {
-    if (vectorized_list.size() != 2) {
-        throw SyntaxError("Wrong syntax for set-cdr.");
+ObjectPtr CallWithEscapeFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Call/ec");
+    if (!arguments[0]) {
+        throw RuntimeError("Operand for call/ec must be applicable.");
     }
-    ObjectPtr eval_first_arg = EvaluateExpression(vectorized_list[0], context_);
-    if (!Is<Cell>(eval_first_arg)) {
-        throw RuntimeError("First operand for set-car must be a cell.");
+    auto escape = Heap::Instance().Make<EscapeProcedure>();
+    ObjectPtr escape_argument = escape;
+    ObjectPtr result = nullptr;
+    try {
+        result = arguments[0]->Apply(ObjectPtrSpan(&escape_argument, 1));
+    } catch (...) {
+        escape->Invalidate();
+        throw;
     }
-    As<Cell>(eval_first_arg)->SetSecond(EvaluateExpression(vectorized_list[1], context_));
-    return nullptr;
+    escape->Invalidate();
+    if (!IsEscaping(result)) {
+        return result;
+    }
+    // an escape to an outer call/ec goes on
+    ObjectPtr* value = escape->FindEscapeValue();
+    if (!value) {
+        return result;
+    }
+    result = *value;
+    EscapeProcedure::FinishEscape();
+    return result;
 }
 
-// IF's realization
+// Memoized function's realization
 
-ObjectPtr IfFunction::Apply(const ObjectPtrVector &vectorized_list) {
-    if (vectorized_list.size() == 2) {
-        ObjectPtr evaluated_condition = EvaluateExpression(vectorized_list[0], context_);
-        if (!Is<BooleanSymbol>(evaluated_condition) ||
-            As<BooleanSymbol>(evaluated_condition)->IsTrue()) {
-            return EvaluateExpression(vectorized_list[1], context_);
+// Copy of the cells and vectors of an argument, which are the only mutable objects
+// compared by contents. Shared and cyclic parts stay shared and cyclic in the copy.
+static ObjectPtr CopyArgument(ObjectPtr argument,
+                              std::unordered_map<ObjectPtr, ObjectPtr>* copies) {
+    if (!Is<Cell>(argument) && !Is<Vector>(argument)) {
+        return argument;
+    }
+    auto found = copies->find(argument);
+    if (found != copies->end()) {
+        return found->second;
+    }
+    auto& heap_ref = Heap::Instance();
+    if (auto vector = As<Vector>(argument)) {
+        auto copy = heap_ref.Make<Vector>(vector->GetElements());
+        copies->emplace(argument, copy);
+        for (size_t i = 0; i < copy->GetSize(); ++i) {
+            copy->Set(i, CopyArgument(copy->Get(i), copies));
         }
-        return nullptr;
-    } else if (vectorized_list.size() == 3) {
-        ObjectPtr evaluated_condition = EvaluateExpression(vectorized_list[0], context_);
-        if (!Is<BooleanSymbol>(evaluated_condition) ||
-            As<BooleanSymbol>(evaluated_condition)->IsTrue()) {
-            return EvaluateExpression(vectorized_list[1], context_);
+        return copy;
+    }
+    // the cells of a list are copied in a loop, only elements are copied recursively
+    Cell* first_copy = nullptr;
+    Cell* last_copy = nullptr;
+    ObjectPtr rest = argument;
+    while (Is<Cell>(rest) && !copies->contains(rest)) {
+        auto copy = heap_ref.Make<Cell>(nullptr, nullptr);
+        copies->emplace(rest, copy);
+        copy->SetFirst(CopyArgument(As<Cell>(rest)->GetFirst(), copies));
+        if (last_copy) {
+            last_copy->SetSecond(copy);
         } else {
-            return EvaluateExpression(vectorized_list[2], context_);
+            first_copy = copy;
         }
-    } else {
-        throw SyntaxError("Wrong number of arguments for if.");
+        last_copy = copy;
+        rest = As<Cell>(rest)->GetSecond();
     }
+    last_copy->SetSecond(CopyArgument(rest, copies));
+    return first_copy;
 }
 
-// Lambda's realization
+MemoizedFunction::CacheEntries::iterator MemoizedFunction::Find(ObjectPtrSpan arguments,
+                                                                uint64_t hash) {
+    auto [begin, end] = index_.equal_range(hash);
+    for (auto it = begin; it != end; ++it) {
+        const ObjectPtrVector& cached = it->second->arguments;
+        if (std::equal(cached.begin(), cached.end(), arguments.begin(), arguments.end(),
+                       IsEqual)) {
+            return it->second;
+        }
+    }
+    return entries_.end();
+}
 
-ObjectPtr LambdaDeclaration::Apply(const ObjectPtrVector &vectorized_list) {
-    if (vectorized_list.size() < 2) {
-        throw SyntaxError("Wrong syntax for lambda declaration.");
+void MemoizedFunction::Evict(CacheEntries::iterator entry) {
+    // the entry is found by identity, its arguments aren't compared or hashed again
+    auto [begin, end] = index_.equal_range(entry->hash);
+    for (auto it = begin; it != end; ++it) {
+        if (it->second == entry) {
+            index_.erase(it);
+            break;
+        }
+    }
+    entries_.erase(entry);
+}
+
+ObjectPtr MemoizedFunction::Apply(ObjectPtrSpan arguments) {
+    uint64_t hash = HashEqualArguments(arguments);
+    {
+        std::lock_guard lock(mutex_);
+        auto found = Find(arguments, hash);
+        if (found != entries_.end()) {
+            ++hits_count_;
+            entries_.splice(entries_.begin(), entries_, found);
+            return found->result;
+        }
+        ++misses_count_;
     }
-    // первый элемент - лист с аргументами
-    if (vectorized_list[0] && !Is<Cell>(vectorized_list[0])) {
-        throw SyntaxError("Wrong format for list of lambda's arguments.");
+    ObjectPtr result = function_->Apply(arguments);
+    if (IsEscaping(result)) {
+        return result;
+    }
+    std::lock_guard lock(mutex_);
+    // a recursive call may have cached the same arguments meanwhile
+    if (Find(arguments, hash) != entries_.end()) {
+        return result;
+    }
+    ObjectPtrVector copied_arguments(arguments.size());
+    std::unordered_map<ObjectPtr, ObjectPtr> copies;
+    for (size_t i = 0; i < arguments.size(); ++i) {
+        copied_arguments[i] = CopyArgument(arguments[i], &copies);
+    }
+    entries_.push_front(CacheEntry{std::move(copied_arguments), result, hash});
+    index_.emplace(hash, entries_.begin());
+    if (entries_.size() > capacity_) {
+        Evict(std::prev(entries_.end()));
+    }
+    return result;
+}
+
+void MemoizedFunction::Clear() {
+    std::lock_guard lock(mutex_);
+    index_.clear();
+    entries_.clear();
+    hits_count_ = 0;
+    misses_count_ = 0;
+}
+
+ObjectPtr MemoizeFunction::Apply(ObjectPtrSpan arguments) {
+    if (arguments.empty() || arguments.size() > 2) {
+        throw RuntimeError("Wrong number of arguments for memoize.");
     }
-    ObjectPtrVector args = ListToVector(vectorized_list[0]);  // аргументы-переменные
-    ThrowIfMismatchOperandsType<Symbol>(args, "Args for lambda declaration must be symbols.");
-    ObjectPtrVector body(vectorized_list.size() - 1);
-    for (size_t i = 1; i < vectorized_list.size(); ++i) {
-        body[i - 1] = vectorized_list[i];
+    ThrowIfMismatchOperandType<LambdaFunction>(0, arguments,
+                                               "First operand for memoize must be lambda.");
+    size_t capacity = kDefaultMemoizeCapacity;
+    if (arguments.size() == 2) {
+        ThrowIfMismatchOperandType<Number>(1, arguments, "Capacity for memoize must be number.");
+        if (As<Number>(arguments[1])->GetValue() <= 0) {
+            throw RuntimeError("Capacity for memoize must be positive.");
+        }
+        capacity = As<Number>(arguments[1])->GetValue();
     }
-    return Heap::Instance().Make<LambdaFunction>(args, body, context_);
+    return Heap::Instance().Make<MemoizedFunction>(arguments[0], capacity);
+}
+
+ObjectPtr MemoizeStatsFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Memoize-stats");
+    ThrowIfMismatchOperandType<MemoizedFunction>(
+        0, arguments, "Operand for memoize-stats must be memoized function.");
+    auto function = As<MemoizedFunction>(arguments[0]);
+    auto& heap_ref = Heap::Instance();
+    return heap_ref.Make<Cell>(
+        heap_ref.Make<Number>(function->GetHitsCount()),
+        heap_ref.Make<Cell>(heap_ref.Make<Number>(function->GetMissesCount()),
+                            heap_ref.Make<Cell>(heap_ref.Make<Number>(function->GetCount()),
+                                                nullptr)));
+}
+
+ObjectPtr MemoizeClearFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Memoize-clear");
+    ThrowIfMismatchOperandType<MemoizedFunction>(
+        0, arguments, "Operand for memoize-clear! must be memoized function.");
+    As<MemoizedFunction>(arguments[0])->Clear();
+    return nullptr;
 }
 
+// Lambda's realization
+
 LambdaFunction::LambdaFunction(const ObjectPtrVector &args, const ObjectPtrVector &body,
-                               ContextPtr context)
-    : args_(args), body_(body) {
+                               ContextPtr context, bool is_tiered)
+    : args_(args), body_(body), is_tiered_(is_tiered) {
     captured_context_ = Heap::Instance().Make<Context>(*context);
     AddDependency(captured_context_);
-    current_context_ = captured_context_;
     for (size_t i = 0; i < args.size(); ++i) {
         AddDependency(args[i]);
     }
@@ -312,19 +981,36 @@ LambdaFunction::LambdaFunction(const ObjectPtrVector &args, const ObjectPtrVecto
     }
 }
 
-ObjectPtr LambdaFunction::Apply(const ObjectPtrVector &vectorized_list) {
-    captured_context_->AddEmptyScope();
-    if (args_.size() != vectorized_list.size()) {
+ObjectPtr LambdaFunction::Apply(ObjectPtrSpan arguments) {
+    if (args_.size() != arguments.size()) {
         throw RuntimeError("Wrong number of args for lambda call.");
     }
-    for (size_t i = 0; i < args_.size(); ++i) {
-        captured_context_->Define(As<Symbol>(args_[i])->GetName(),
-                                  EvaluateExpression(vectorized_list[i], current_context_));
+    if (is_tiered_) {
+        if (ObjectPtr result = ApplyNative(arguments)) {
+            return result;
+        }
     }
-    for (size_t i = 0; i < body_.size() - 1; ++i) {
-        EvaluateExpression(body_[i], captured_context_);
+    // calls in parallel tasks may run at once, so each of them gets its own scope stack
+    ContextPtr context = (Scheduler::IsRunningTask())
+                             ? Heap::Instance().Make<Context>(*captured_context_)
+                             : captured_context_;
+    context->AddEmptyScope();
+    try {
+        for (size_t i = 0; i < args_.size(); ++i) {
+            context->Define(As<Symbol>(args_[i])->GetName(), arguments[i]);
+        }
+        ObjectPtr ans = nullptr;
+        for (size_t i = 0; i < body_.size(); ++i) {
+            ans = EvaluateExpression(body_[i], context);
+            if (IsEscaping(ans)) {
+                break;
+            }
+        }
+        context->PopScope();
+        return ans;
+    } catch (...) {
+        // scope of the failed call must not stay in the captured context
+        context->PopScope();
+        throw;
     }
-    ObjectPtr ans = EvaluateExpression(body_[body_.size() - 1], captured_context_);
-    captured_context_->PopScope();
-    return ans;
 }
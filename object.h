@@ -1,18 +1,30 @@
 #pragma once
 
+#include <atomic>
+#include <cmath>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <span>
 #include <string>
+#include <string_view>
 #include <functional>
 #include <unordered_map>
 #include <unordered_set>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "tokenizer.h"
+#include "symbol_table.h"
 #include "error.h"
+#include "bignum.h"
+#include "numeric_kernels.h"
 
 class Object;
 using ObjectPtr = Object*;
 using ObjectPtrVector = std::vector<ObjectPtr>;
+using ObjectPtrSpan = std::span<const ObjectPtr>;
 
 class Scope;
 using ScopePtr = Scope*;
@@ -33,7 +45,7 @@ public:
         throw RuntimeError("Not implemented.");
     }
 
-    virtual ObjectPtr Apply(const ObjectPtrVector&) {
+    virtual ObjectPtr Apply(ObjectPtrSpan) {
         throw RuntimeError("Not implemented.");
     }
 
@@ -41,12 +53,14 @@ public:
         throw RuntimeError("Not implemented.");
     }
 
-    virtual void SetContext(ContextPtr) {
+    virtual std::string Serialize() {
         throw RuntimeError("Not implemented.");
     }
 
-    virtual std::string Serialize() {
-        throw RuntimeError("Not implemented.");
+    // Pure function has no side effects and returns equal immutable results for equal
+    // arguments, so its calls on constants may be computed before evaluation.
+    virtual bool IsPure() const {
+        return false;
     }
 
 protected:
@@ -61,9 +75,14 @@ protected:
     void Mark() {
         is_connected_to_root = true;
         for (ObjectPtr dependence : dependencies_) {
-            if (dependence && !dependence->IsConnected()) {
-                dependence->Mark();
-            }
+            MarkReference(dependence);
+        }
+        MarkReferences();
+    }
+
+    static void MarkReference(ObjectPtr object) {
+        if (object && !object->IsConnected()) {
+            object->Mark();
         }
     }
 
@@ -76,6 +95,10 @@ protected:
     }
 
 protected:
+    // Marks references which aren't kept in dependencies_ (e.g. elements of a vector)
+    virtual void MarkReferences() {
+    }
+
     friend class Heap;
     bool is_connected_to_root = false;
     std::unordered_set<Object*> dependencies_;
@@ -93,6 +116,9 @@ public:
         for (ObjectPtr ptr : heap_) {
             delete ptr;
         }
+        for (ObjectPtr ptr : permanent_) {
+            delete ptr;
+        }
     }
 
     void SetRoot(ObjectPtr root) {
@@ -100,9 +126,29 @@ public:
     }
 
     template <typename ObjectType, typename... Args>
-    ObjectType* Make(Args... args) {
+    ObjectType* Make(Args&&... args) {
+        ObjectType* allocated_object = new ObjectType(std::forward<Args>(args)...);
+        ObjectPtrVector& objects = (allocation_buffer_) ? *allocation_buffer_ : heap_;
+        objects.push_back(allocated_object);
+        return allocated_object;
+    }
+
+    // Objects made by the calling thread go to the buffer until they are adopted,
+    // so that parallel tasks don't share the heap (see parallel.h)
+    static void SetAllocationBuffer(ObjectPtrVector* buffer) {
+        allocation_buffer_ = buffer;
+    }
+
+    void AdoptObjects(ObjectPtrVector* objects) {
+        heap_.insert(heap_.end(), objects->begin(), objects->end());
+        objects->clear();
+    }
+
+    // Objects which are never collected (e.g. built-in functions shared by all interpreters)
+    template <typename ObjectType, typename... Args>
+    ObjectType* MakePermanent(Args... args) {
         ObjectType* allocated_object = new ObjectType(args...);
-        heap_.push_back(allocated_object);
+        permanent_.push_back(allocated_object);
         return allocated_object;
     }
 
@@ -113,9 +159,29 @@ public:
 
     void MarkAndSweep();
 
+    // Pinned objects are kept alive like the root, each Pin must be paired with an Unpin
+    void Pin(ObjectPtr object) {
+        ++pinned_[object];
+    }
+
+    // Unpinning an object which isn't pinned is a no-op
+    void Unpin(ObjectPtr object) {
+        auto found = pinned_.find(object);
+        if (found != pinned_.end() && --found->second == 0) {
+            pinned_.erase(found);
+        }
+    }
+
+    size_t GetObjectsCount() const {
+        return heap_.size();
+    }
+
 private:
     ObjectPtrVector heap_;
+    ObjectPtrVector permanent_;
     ObjectPtr root_;
+    std::unordered_map<ObjectPtr, size_t> pinned_;
+    inline static thread_local ObjectPtrVector* allocation_buffer_ = nullptr;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -150,8 +216,9 @@ public:
         return value_;
     }
 
+    // Numbers are immutable, so a literal evaluates to itself
     ObjectPtr Evaluate(ContextPtr) override {
-        return Heap::Instance().Make<Number>(value_);
+        return this;
     }
 
     std::string Serialize() override {
@@ -162,45 +229,94 @@ public:
         return Heap::Instance().Make<Number>(value_);
     }
 
-    virtual void SetContext(ContextPtr) override{};
-
 private:
     int64_t value_;
 };
 
+// Integer which doesn't fit into int64_t. Arithmetic gives a Number back as soon as
+// the result fits again, so a BigNumber is never equal to a Number.
+
+class BigNumber : public Object {
+public:
+    BigNumber(const BigInteger& value) : value_(value){};
+
+    const BigInteger& GetValue() const {
+        return value_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override {
+        return this;
+    }
+
+    std::string Serialize() override {
+        return value_.ToString();
+    }
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<BigNumber>(value_);
+    }
+
+private:
+    BigInteger value_;
+};
+
+// Inexact number. Boxes of floats are recycled through a free list,
+// so float loops don't go to the system allocator on every operation.
+
+class FloatNumber : public Object {
+public:
+    FloatNumber(double value) : value_(value){};
+
+    FloatNumber(const FloatConstantToken& constant_token) : value_(constant_token.value){};
+
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr);
+
+    double GetValue() const {
+        return value_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override {
+        return this;
+    }
+
+    std::string Serialize() override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<FloatNumber>(value_);
+    }
+
+private:
+    double value_;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 // Symbol-like objects
 
+// Keeps an interned name, see symbol_table.h
 class Symbol : public Object {
 public:
-    Symbol(const std::string& name) : name_(std::move(name)){};
+    Symbol(std::string_view name) : name_(&InternSymbolName(name)){};
 
-    Symbol(const SymbolToken& symbol_token) : name_(std::move(symbol_token.name)){};
+    Symbol(const SymbolToken& symbol_token) : Symbol(symbol_token.GetName()){};
 
     const std::string& GetName() const {
-        return name_;
+        return *name_;
     }
 
     ObjectPtr Evaluate(ContextPtr) override;
 
     virtual std::string Serialize() override {
-        return name_;
-    }
-
-    virtual void SetContext(ContextPtr context) override {
-        context_ = context;
+        return *name_;
     }
 
     ObjectPtr Clone() override {
-        ObjectPtr cloned_symbol = Heap::Instance().Make<Symbol>(name_);
-        cloned_symbol->SetContext(context_);
-        return cloned_symbol;
+        return Heap::Instance().Make<Symbol>(*name_);
     }
 
 private:
-    std::string name_;
-    ContextPtr context_;
+    const std::string* name_;
 };
 
 class BooleanSymbol : public Object {
@@ -213,18 +329,14 @@ public:
     };
 
     ObjectPtr Evaluate(ContextPtr) override {
-        return Heap::Instance().Make<BooleanSymbol>(name_);
+        return this;
     }
 
     virtual std::string Serialize() override {
         return name_;
     }
 
-    void SetContext(ContextPtr) override{};
-
-    ObjectPtr Clone() override {
-        return Heap::Instance().Make<BooleanSymbol>(name_);
-    }
+    ObjectPtr Clone() override;
 
     bool IsTrue() {
         return is_true_;
@@ -235,16 +347,81 @@ private:
     bool is_true_;
 };
 
+// Shared #t and #f objects
+// Booleans are immutable, so they are never allocated during evaluation.
+
+extern BooleanSymbol* const kTrueSymbol;
+extern BooleanSymbol* const kFalseSymbol;
+
+inline BooleanSymbol* GetBooleanSymbol(bool value) {
+    return (value) ? kTrueSymbol : kFalseSymbol;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// String objects
+
+// Strings up to that length fit into the inline storage of std::string
+constexpr size_t kMaxShortStringLength = 15;
+
+// Immutable string. Short strings are kept inline, long ones are prefixes of shared buffers.
+// Appending to the string which ends its buffer extends the buffer in place, so the strings
+// built one after another by appends share one buffer, and building a big string is linear.
+
+class String : public Object {
+public:
+    String(std::string value) : length_(value.size()) {
+        if (length_ > kMaxShortStringLength) {
+            buffer_ = std::make_shared<std::string>(std::move(value));
+        } else {
+            short_value_ = std::move(value);
+        }
+    };
+
+    String(const StringToken& string_token) : String(string_token.value){};
+
+    // The first length characters of a shared buffer
+    String(std::shared_ptr<std::string> buffer, size_t length)
+        : buffer_(std::move(buffer)), length_(length){};
+
+    static String* Concatenate(String* lhs, String* rhs);
+
+    size_t GetLength() const {
+        return length_;
+    }
+
+    // Valid until the next concatenation
+    std::string_view GetView() const {
+        if (buffer_) {
+            return std::string_view(*buffer_).substr(0, length_);
+        }
+        return short_value_;
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override {
+        return this;
+    }
+
+    ObjectPtr Clone() override {
+        return this;
+    }
+
+    // Written as a literal, with quotes and escapes
+    std::string Serialize() override;
+
+private:
+    std::string short_value_;
+    std::shared_ptr<std::string> buffer_;
+    size_t length_;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 
 // Cell-like objects
 
 class Cell : public Object {
 public:
-    Cell(ObjectPtr first, ObjectPtr second) : first_(first), second_(second) {
-        AddDependency(first);
-        AddDependency(second);
-    };
+    Cell(ObjectPtr first, ObjectPtr second) : first_(first), second_(second){};
 
     ObjectPtr GetFirst() const {
         return first_;
@@ -255,30 +432,217 @@ public:
     }
 
     void SetFirst(ObjectPtr first) {
-        RemoveDependency(first_);
-        AddDependency(first);
         first_ = first;
     }
 
     void SetSecond(ObjectPtr second) {
-        RemoveDependency(second_);
-        AddDependency(second);
         second_ = second;
     }
 
+    ObjectPtr Clone() override;
+
+    std::string Serialize() override;
+
+protected:
+    // Cells are the most numerous objects, so they are traced right from their fields
+    // rather than through dependencies_. The rest of a list is followed in a loop, so that
+    // long lists don't exhaust the stack.
+    void MarkReferences() override;
+
+private:
+    ObjectPtr first_;
+    ObjectPtr second_;
+};
+
+// Vector object
+// Elements are stored contiguously and traced by the collector right from the storage.
+// Vectors are shared by reference as in Scheme, so binding one to a name doesn't copy it.
+
+class Vector : public Object {
+public:
+    Vector(size_t size, ObjectPtr fill) : elements_(size, fill){};
+
+    Vector(const ObjectPtrVector& elements) : elements_(elements){};
+
+    static const std::string& GetTypeName() {
+        static const std::string type_name = "vector";
+        return type_name;
+    }
+
+    size_t GetSize() const {
+        return elements_.size();
+    }
+
+    ObjectPtr Get(size_t index) const {
+        return elements_[index];
+    }
+
+    void Set(size_t index, ObjectPtr value) {
+        elements_[index] = value;
+    }
+
+    const ObjectPtrVector& GetElements() const {
+        return elements_;
+    }
+
+    // Vector literals are self-evaluating
+    ObjectPtr Evaluate(ContextPtr) override {
+        return this;
+    }
+
+    ObjectPtr Clone() override {
+        return this;
+    }
+
+    std::string Serialize() override;
+
+protected:
+    void MarkReferences() override {
+        for (ObjectPtr element : elements_) {
+            MarkReference(element);
+        }
+    }
+
+private:
+    ObjectPtrVector elements_;
+};
+
+// Homogeneous numeric vectors: s64vector and f64vector
+// Elements are stored unboxed, so bulk functions run the kernels of numeric_kernels.h
+// right over the storage. Like vectors, they are shared by reference.
+
+template <typename T>
+class NumericVector : public Object {
+public:
+    NumericVector(size_t size, T fill) : elements_(size, fill){};
+
+    NumericVector(std::vector<T> elements) : elements_(std::move(elements)){};
+
+    // s64vector or f64vector
+    static const std::string& GetTypeName();
+    static bool IsElement(ObjectPtr object);
+    // The object must be an element
+    static T ToElement(ObjectPtr object);
+    static ObjectPtr MakeElement(T element);
+
+    size_t GetSize() const {
+        return elements_.size();
+    }
+
+    T Get(size_t index) const {
+        return elements_[index];
+    }
+
+    void Set(size_t index, T value) {
+        elements_[index] = value;
+    }
+
+    const T* GetData() const {
+        return elements_.data();
+    }
+
+    T* GetData() {
+        return elements_.data();
+    }
+
+    ObjectPtr Evaluate(ContextPtr) override {
+        return this;
+    }
+
     ObjectPtr Clone() override {
-        ObjectPtr cloned_first = (first_) ? first_->Clone() : nullptr;
-        ObjectPtr cloned_second = (second_) ? second_->Clone() : nullptr;
-        return Heap::Instance().Make<Cell>(cloned_first, cloned_second);
+        return this;
+    }
+
+    std::string Serialize() override;
+
+private:
+    std::vector<T> elements_;
+};
+
+using S64Vector = NumericVector<int64_t>;
+using F64Vector = NumericVector<double>;
+
+template <>
+const std::string& S64Vector::GetTypeName();
+template <>
+const std::string& F64Vector::GetTypeName();
+template <>
+bool S64Vector::IsElement(ObjectPtr object);
+template <>
+bool F64Vector::IsElement(ObjectPtr object);
+template <>
+int64_t S64Vector::ToElement(ObjectPtr object);
+template <>
+double F64Vector::ToElement(ObjectPtr object);
+template <>
+ObjectPtr S64Vector::MakeElement(int64_t element);
+template <>
+ObjectPtr F64Vector::MakeElement(double element);
+
+// Hash table object
+// Open addressing with linear probing over a single array of slots. Deletions shift
+// the following slots back, so there are no tombstones. Keys must not be mutated while
+// they are in a table.
+
+constexpr size_t kMinHashTableCapacity = 8;
+
+// EQV compares numbers, symbols and booleans by value and anything else by identity,
+// EQUAL also compares the contents of cells, strings and vectors
+enum class KeyEquivalence { EQV, EQUAL };
+
+class HashTable : public Object {
+public:
+    HashTable(KeyEquivalence equivalence)
+        : equivalence_(equivalence), slots_(kMinHashTableCapacity){};
+
+    // nullptr if there is no such key
+    ObjectPtr* Find(ObjectPtr key);
+    void Set(ObjectPtr key, ObjectPtr value);
+    // false if there was no such key
+    bool Erase(ObjectPtr key);
+
+    size_t GetCount() const {
+        return count_;
     }
 
-    void SetContext(ContextPtr) override{};
+    KeyEquivalence GetEquivalence() const {
+        return equivalence_;
+    }
+
+    ObjectPtrVector GetKeys() const;
+
+    ObjectPtr Clone() override {
+        return this;
+    }
 
     std::string Serialize() override;
 
+protected:
+    void MarkReferences() override {
+        for (const Slot& slot : slots_) {
+            if (slot.hash != 0) {
+                MarkReference(slot.key);
+                MarkReference(slot.value);
+            }
+        }
+    }
+
 private:
-    ObjectPtr first_;
-    ObjectPtr second_;
+    // Hash of an empty slot is zero, hashes of keys always have the highest bit set
+    struct Slot {
+        uint64_t hash = 0;
+        ObjectPtr key = nullptr;
+        ObjectPtr value = nullptr;
+    };
+
+    uint64_t Hash(ObjectPtr key) const;
+    // Index of the key's slot, or of the empty slot where it would be inserted
+    size_t FindSlot(ObjectPtr key, uint64_t hash) const;
+    void Grow();
+
+    KeyEquivalence equivalence_;
+    std::vector<Slot> slots_;
+    size_t count_ = 0;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -287,7 +651,27 @@ private:
 
 ObjectPtr EvaluateExpression(ObjectPtr, ContextPtr);
 
-ObjectPtrVector EvaluateListArguments(const ObjectPtrVector&, ContextPtr);
+// false if an escape is in progress, evaluated is incomplete then
+bool EvaluateArguments(const ObjectPtrVector&, ContextPtr, ObjectPtr* evaluated);
+
+// Escapes of call/ec
+// Calling an escape procedure doesn't throw: it stores its value and evaluates to
+// kEscapeMarker. Every evaluation step returns the marker right away as its own result,
+// so the evaluator's frames unwind by plain returns up to the call/ec of the procedure.
+
+class EscapeMarker : public Object {};
+
+extern EscapeMarker* const kEscapeMarker;
+
+inline bool IsEscaping(ObjectPtr result) {
+    return result == kEscapeMarker;
+}
+
+// Value of a letrec name until its initializer is evaluated, reading it is an error
+
+class UnassignedMarker : public Object {};
+
+extern UnassignedMarker* const kUnassignedMarker;
 
 // Declaration of helper functions.
 
@@ -296,8 +680,7 @@ ObjectPtrVector ListToVector(ObjectPtr cell);
 ObjectPtrVector CloneObjectPtrVector [[maybe_unused]] (const ObjectPtrVector& vectorized_list);
 
 template <typename RequiredType>
-void ThrowIfMismatchOperandsType(const ObjectPtrVector& vectorized_list,
-                                 const std::string& message) {
+void ThrowIfMismatchOperandsType(ObjectPtrSpan vectorized_list, const std::string& message) {
     for (const auto& ptr : vectorized_list) {
         if (!Is<RequiredType>(ptr)) {
             throw RuntimeError(message);
@@ -306,31 +689,156 @@ void ThrowIfMismatchOperandsType(const ObjectPtrVector& vectorized_list,
 }
 
 template <typename RequiredType>
-void ThrowIfMismatchOperandType(size_t number, const ObjectPtrVector& vectorized_list,
+void ThrowIfMismatchOperandType(size_t number, ObjectPtrSpan vectorized_list,
                                 const std::string& message) {
     if (!Is<RequiredType>(vectorized_list[number])) {
         throw RuntimeError(message);
     }
 }
 
-void ThrowIfZeroDivisors(const ObjectPtrVector&);
+void ThrowIfZeroDivisors(ObjectPtrSpan);
+
+void ThrowIfWrongNumberOfArguments(size_t, ObjectPtrSpan, const std::string&);
 
-void ThrowIfWrongNumberOfArguments(size_t, const ObjectPtrVector&, const std::string&);
+void ValidateArgumentsForListTailAndRef(ObjectPtrSpan);
 
-void ValidateArgumentsForListTailAndRef(const ObjectPtrVector&);
+// Checks a vector and an index in its range, the first two of the arguments
+template <typename VectorType>
+void ValidateArgumentsForVectorAccess(ObjectPtrSpan list, const std::string& function_name) {
+    ThrowIfMismatchOperandType<VectorType>(
+        0, list, "First operand for " + function_name + " must be " + VectorType::GetTypeName() + ".");
+    ThrowIfMismatchOperandType<Number>(1, list,
+                                       "Index for " + function_name + " must be number.");
+    int64_t index = As<Number>(list[1])->GetValue();
+    if (index < 0 || static_cast<uint64_t>(index) >= As<VectorType>(list[0])->GetSize()) {
+        throw RuntimeError("Index for " + function_name + " is out of range.");
+    }
+}
 
 ObjectPtr CheckIfList(ObjectPtr);
 
-template <typename T>
+// Built-in functions, lambdas, memoized functions and escape procedures
+bool IsApplicable(ObjectPtr);
+
+bool IsTruthy(ObjectPtr);
+
+bool IsEqv(ObjectPtr lhs, ObjectPtr rhs);
+
+bool IsEqual(ObjectPtr lhs, ObjectPtr rhs);
+
+// Hashes consistent with IsEqv and IsEqual
+uint64_t HashEqv(ObjectPtr object);
+
+uint64_t HashEqual(ObjectPtr object);
+
+// Hash of argument lists consistent with IsEqual of each argument
+uint64_t HashEqualArguments(ObjectPtrSpan arguments);
+
+bool IsInteger(ObjectPtr);
+
+// Integer or float
+bool IsNumber(ObjectPtr);
+
+void ThrowIfNotNumbers(ObjectPtrSpan, const std::string& message);
+
+bool HasFloats(ObjectPtrSpan);
+
+BigInteger ToBigInteger(ObjectPtr integer);
+
+double ToDouble(ObjectPtr number);
+
+// Integers of at most that magnitude are converted to doubles exactly
+constexpr int64_t kMaxExactFloatInteger = int64_t{1} << 53;
+
+// Negative, zero or positive as the integer is less, equal or greater than the float,
+// which must not be NaN. The integer isn't rounded to a double.
+int CompareIntegerToFloat(ObjectPtr integer, double value);
+
+// Number if the value fits into int64_t, BigNumber otherwise
+ObjectPtr MakeInteger(const BigInteger& value);
+
+// Shortest representation which reads back as the same double, always with a dot
+std::string SerializeFloat(double value);
+
+// Arithmetic functors
+// The fixnum overload returns false on overflow instead of wrapping,
+// then the computation goes on with BigInteger. If any operand is a float,
+// everything is computed in doubles.
+
+struct Plus {
+    bool operator()(int64_t a, int64_t b, int64_t* result) const {
+        return !__builtin_add_overflow(a, b, result);
+    }
+    BigInteger operator()(const BigInteger& a, const BigInteger& b) const {
+        return a + b;
+    }
+    double operator()(double a, double b) const {
+        return a + b;
+    }
+};
+
+struct Minus {
+    bool operator()(int64_t a, int64_t b, int64_t* result) const {
+        return !__builtin_sub_overflow(a, b, result);
+    }
+    BigInteger operator()(const BigInteger& a, const BigInteger& b) const {
+        return a - b;
+    }
+    double operator()(double a, double b) const {
+        return a - b;
+    }
+};
+
+struct Multiplies {
+    bool operator()(int64_t a, int64_t b, int64_t* result) const {
+        return !__builtin_mul_overflow(a, b, result);
+    }
+    BigInteger operator()(const BigInteger& a, const BigInteger& b) const {
+        return a * b;
+    }
+    double operator()(double a, double b) const {
+        return a * b;
+    }
+};
+
+struct Divides {
+    bool operator()(int64_t a, int64_t b, int64_t* result) const {
+        if (a == INT64_MIN && b == -1) {
+            return false;
+        }
+        *result = a / b;
+        return true;
+    }
+    BigInteger operator()(const BigInteger& a, const BigInteger& b) const {
+        return a / b;
+    }
+    double operator()(double a, double b) const {
+        return a / b;
+    }
+};
+
 struct Max {
-    T operator()(T a, T b) {
+    bool operator()(int64_t a, int64_t b, int64_t* result) const {
+        *result = (a > b) ? a : b;
+        return true;
+    }
+    BigInteger operator()(const BigInteger& a, const BigInteger& b) const {
+        return (Compare(a, b) > 0) ? a : b;
+    }
+    double operator()(double a, double b) const {
         return (a > b) ? a : b;
     }
 };
 
-template <typename T>
 struct Min {
-    T operator()(T a, T b) {
+    bool operator()(int64_t a, int64_t b, int64_t* result) const {
+        *result = (a > b) ? b : a;
+        return true;
+    }
+    BigInteger operator()(const BigInteger& a, const BigInteger& b) const {
+        return (Compare(a, b) > 0) ? b : a;
+    }
+    double operator()(double a, double b) const {
         return (a > b) ? b : a;
     }
 };
@@ -344,42 +852,63 @@ class BinaryFoldFunction : public Object {
 public:
     BinaryFoldFunction() = default;
 
-    ObjectPtr Apply(const ObjectPtrVector& vectorized_list) override {
-        ObjectPtrVector eval_list = EvaluateListArguments(vectorized_list, context_);
-        ThrowIfMismatchOperandsType<Number>(eval_list, "Operands must be numbers.");
-        if constexpr (std::is_same_v<Functor, std::divides<int64_t>>) {
-            ThrowIfZeroDivisors(eval_list);
+    ObjectPtr Apply(ObjectPtrSpan arguments) override {
+        ThrowIfNotNumbers(arguments, "Operands must be numbers.");
+        if constexpr (std::is_same_v<Functor, Divides>) {
+            ThrowIfZeroDivisors(arguments);
         }
-        if (eval_list.empty()) {
+        if (arguments.empty()) {
             return ApplyToEmptyList();
         }
-        int64_t result = As<Number>(eval_list.front())->GetValue();
-        for (size_t i = 1; i < eval_list.size(); ++i) {
-            result = Functor()(result, As<Number>(eval_list[i])->GetValue());
+        // fixnums are folded until an overflow or a bignum operand
+        size_t i = 1;
+        auto first = As<Number>(arguments.front());
+        int64_t result = (first) ? first->GetValue() : 0;
+        if (first) {
+            for (; i < arguments.size(); ++i) {
+                auto number = As<Number>(arguments[i]);
+                int64_t next = 0;
+                if (!number || !Functor()(result, number->GetValue(), &next)) {
+                    break;
+                }
+                result = next;
+            }
+            if (i == arguments.size()) {
+                return Heap::Instance().Make<Number>(result);
+            }
+        }
+        if (HasFloats(arguments)) {
+            // intermediate results stay unboxed
+            double float_result = ToDouble(arguments.front());
+            for (size_t j = 1; j < arguments.size(); ++j) {
+                float_result = Functor()(float_result, ToDouble(arguments[j]));
+            }
+            return Heap::Instance().Make<FloatNumber>(float_result);
+        }
+        BigInteger big_result = (first) ? BigInteger(result) : ToBigInteger(arguments.front());
+        for (; i < arguments.size(); ++i) {
+            big_result = Functor()(big_result, ToBigInteger(arguments[i]));
         }
-        return Heap::Instance().Make<Number>(result);
+        return MakeInteger(big_result);
     }
 
     ObjectPtr ApplyToEmptyList() {
-        if constexpr (std::is_same_v<Functor, std::plus<int64_t>>) {
+        if constexpr (std::is_same_v<Functor, Plus>) {
             return Heap::Instance().Make<Number>(0);
-        } else if (std::is_same_v<Functor, std::multiplies<int64_t>>) {
+        } else if (std::is_same_v<Functor, Multiplies>) {
             return Heap::Instance().Make<Number>(1);
         } else {
             throw RuntimeError("Few arguments.");
         }
     }
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
-    }
-
     ObjectPtr Clone() override {
         return Heap::Instance().Make<BinaryFoldFunction<Functor>>();
     }
 
-private:
-    ContextPtr context_;
+    bool IsPure() const override {
+        return true;
+    }
 };
 
 template <typename Functor>
@@ -387,484 +916,1260 @@ class MonotonicFunction : public Object {
 public:
     MonotonicFunction() = default;
 
-    ObjectPtr Apply(const ObjectPtrVector& vectorized_list) override {
-        ObjectPtrVector eval_list = EvaluateListArguments(vectorized_list, context_);
-        ThrowIfMismatchOperandsType<Number>(eval_list, "Operands must be numbers.");
-        for (size_t i = 1; i < eval_list.size(); ++i) {
-            if (!Functor()(As<Number>(eval_list[i - 1])->GetValue(),
-                           As<Number>(eval_list[i])->GetValue())) {
-                return Heap::Instance().Make<BooleanSymbol>("#f");
+    ObjectPtr Apply(ObjectPtrSpan arguments) override {
+        ThrowIfNotNumbers(arguments, "Operands must be numbers.");
+        for (size_t i = 1; i < arguments.size(); ++i) {
+            if (!Holds(arguments[i - 1], arguments[i])) {
+                return kFalseSymbol;
             }
         }
-        return Heap::Instance().Make<BooleanSymbol>("#t");
+        return kTrueSymbol;
     }
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<MonotonicFunction<Functor>>();
+    }
+
+    bool Holds(ObjectPtr lhs, ObjectPtr rhs) {
+        auto lhs_number = As<Number>(lhs);
+        auto rhs_number = As<Number>(rhs);
+        if (lhs_number && rhs_number) {
+            return Functor()(lhs_number->GetValue(), rhs_number->GetValue());
+        }
+        auto lhs_float = As<FloatNumber>(lhs);
+        auto rhs_float = As<FloatNumber>(rhs);
+        if (lhs_float && rhs_float) {
+            return Functor()(lhs_float->GetValue(), rhs_float->GetValue());
+        } else if (rhs_float) {
+            // NaN is neither less, nor equal, nor greater than anything
+            return !std::isnan(rhs_float->GetValue()) &&
+                   Functor()(CompareIntegerToFloat(lhs, rhs_float->GetValue()), 0);
+        } else if (lhs_float) {
+            return !std::isnan(lhs_float->GetValue()) &&
+                   Functor()(0, CompareIntegerToFloat(rhs, lhs_float->GetValue()));
+        }
+        return Functor()(Compare(ToBigInteger(lhs), ToBigInteger(rhs)), 0);
+    }
+
+    bool IsPure() const override {
+        return true;
+    }
+};
+
+template <typename Type>
+class PredicateFunction : public Object {
+public:
+    PredicateFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan arguments) override {
+        ThrowIfWrongNumberOfArguments(1, arguments, "Predicate");
+        return GetBooleanSymbol(Is<Type>(arguments[0]));
+    }
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<PredicateFunction<Type>>();
+    }
+
+    bool IsPure() const override {
+        return true;
+    }
+};
+
+class NullPredicateFunction : public Object {
+public:
+    NullPredicateFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<NullPredicateFunction>();
+    }
+
+    bool IsPure() const override {
+        return true;
+    }
+};
+
+class ListPredicateFunction : public Object {
+public:
+    ListPredicateFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<ListPredicateFunction>();
+    }
+
+    bool IsPure() const override {
+        return true;
+    }
+};
+
+// Pair functions
+
+class ConsFunction : public Object {
+public:
+    ConsFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<ConsFunction>();
+    }
+};
+
+class CarFunction : public Object {
+public:
+    CarFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<CarFunction>();
+    }
+};
+
+class CdrFunction : public Object {
+public:
+    CdrFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<CdrFunction>();
+    }
+};
+
+// List functions
+
+class ToListFunction : public Object {
+public:
+    ToListFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<ToListFunction>();
+    }
+};
+
+class ListRefFunction : public Object {
+public:
+    ListRefFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<ListRefFunction>();
+    }
+};
+
+class ListTailFunction : public Object {
+public:
+    ListTailFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<ListTailFunction>();
+    }
+};
+
+// Some other functions
+
+class AbsFunction : public Object {
+public:
+    AbsFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<AbsFunction>();
+    }
+
+    bool IsPure() const override {
+        return true;
+    }
+};
+
+class NumberPredicateFunction : public Object {
+public:
+    NumberPredicateFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<NumberPredicateFunction>();
+    }
+
+    bool IsPure() const override {
+        return true;
+    }
+};
+
+class NegFunction : public Object {
+public:
+    NegFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<NegFunction>();
+    }
+
+    bool IsPure() const override {
+        return true;
+    }
+};
+
+// Pair mutations
+
+class SetCar : public Object {
+public:
+    SetCar() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<SetCar>();
+    }
+};
+
+class SetCdr : public Object {
+public:
+    SetCdr() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<SetCdr>();
+    }
+};
+
+// String functions
+
+template <typename Functor>
+class StringComparisonFunction : public Object {
+public:
+    StringComparisonFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan arguments) override {
+        ThrowIfMismatchOperandsType<String>(arguments, "Operands must be strings.");
+        for (size_t i = 1; i < arguments.size(); ++i) {
+            if (!Functor()(As<String>(arguments[i - 1])->GetView(),
+                           As<String>(arguments[i])->GetView())) {
+                return kFalseSymbol;
+            }
+        }
+        return kTrueSymbol;
     }
 
     ObjectPtr Clone() override {
-        return Heap::Instance().Make<MonotonicFunction<Functor>>();
+        return Heap::Instance().Make<StringComparisonFunction<Functor>>();
+    }
+
+    bool IsPure() const override {
+        return true;
+    }
+};
+
+class StringLengthFunction : public Object {
+public:
+    StringLengthFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<StringLengthFunction>();
+    }
+
+    bool IsPure() const override {
+        return true;
+    }
+};
+
+class StringAppendFunction : public Object {
+public:
+    StringAppendFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<StringAppendFunction>();
+    }
+};
+
+class SubstringFunction : public Object {
+public:
+    SubstringFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<SubstringFunction>();
+    }
+};
+
+class StringToSymbolFunction : public Object {
+public:
+    StringToSymbolFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<StringToSymbolFunction>();
+    }
+};
+
+class SymbolToStringFunction : public Object {
+public:
+    SymbolToStringFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<SymbolToStringFunction>();
+    }
+};
+
+// Vector functions
+
+class MakeVectorFunction : public Object {
+public:
+    MakeVectorFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<MakeVectorFunction>();
+    }
+};
+
+class VectorFunction : public Object {
+public:
+    VectorFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<VectorFunction>();
+    }
+};
+
+class VectorRefFunction : public Object {
+public:
+    VectorRefFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<VectorRefFunction>();
+    }
+};
+
+class VectorSetFunction : public Object {
+public:
+    VectorSetFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<VectorSetFunction>();
+    }
+};
+
+class VectorLengthFunction : public Object {
+public:
+    VectorLengthFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<VectorLengthFunction>();
+    }
+};
+
+class VectorToListFunction : public Object {
+public:
+    VectorToListFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<VectorToListFunction>();
+    }
+};
+
+class ListToVectorFunction : public Object {
+public:
+    ListToVectorFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<ListToVectorFunction>();
+    }
+};
+
+// Hash table functions
+
+class MakeHashTableFunction : public Object {
+public:
+    MakeHashTableFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<MakeHashTableFunction>();
+    }
+};
+
+class HashTableRefFunction : public Object {
+public:
+    HashTableRefFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<HashTableRefFunction>();
+    }
+};
+
+class HashTableSetFunction : public Object {
+public:
+    HashTableSetFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<HashTableSetFunction>();
+    }
+};
+
+class HashTableDeleteFunction : public Object {
+public:
+    HashTableDeleteFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<HashTableDeleteFunction>();
+    }
+};
+
+class HashTableCountFunction : public Object {
+public:
+    HashTableCountFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<HashTableCountFunction>();
+    }
+};
+
+class HashTableKeysFunction : public Object {
+public:
+    HashTableKeysFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<HashTableKeysFunction>();
+    }
+};
+
+// Numeric vector functions
+// Defined for S64Vector and F64Vector in object.cpp
+
+template <typename T>
+class MakeNumericVectorFunction : public Object {
+public:
+    MakeNumericVectorFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<MakeNumericVectorFunction<T>>();
+    }
+};
+
+template <typename T>
+class NumericVectorFunction : public Object {
+public:
+    NumericVectorFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<NumericVectorFunction<T>>();
+    }
+};
+
+template <typename T>
+class NumericVectorRefFunction : public Object {
+public:
+    NumericVectorRefFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<NumericVectorRefFunction<T>>();
+    }
+};
+
+template <typename T>
+class NumericVectorSetFunction : public Object {
+public:
+    NumericVectorSetFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<NumericVectorSetFunction<T>>();
+    }
+};
+
+template <typename T>
+class NumericVectorLengthFunction : public Object {
+public:
+    NumericVectorLengthFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<NumericVectorLengthFunction<T>>();
     }
-
-private:
-    ContextPtr context_;
 };
 
-template <typename Type>
-class PredicateFunction : public Object {
+template <typename T>
+class NumericVectorToListFunction : public Object {
 public:
-    PredicateFunction() = default;
+    NumericVectorToListFunction() = default;
 
-    ObjectPtr Apply(const ObjectPtrVector& vectorized_list) override {
-        ObjectPtrVector eval_list = EvaluateListArguments(vectorized_list, context_);
-        ThrowIfWrongNumberOfArguments(1, eval_list, "Predicate");
-        return (Is<Type>(eval_list[0])) ? Heap::Instance().Make<BooleanSymbol>("#t")
-                                        : Heap::Instance().Make<BooleanSymbol>("#f");
-    }
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<NumericVectorToListFunction<T>>();
     }
+};
+
+template <typename T>
+class ListToNumericVectorFunction : public Object {
+public:
+    ListToNumericVectorFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
     ObjectPtr Clone() override {
-        return Heap::Instance().Make<PredicateFunction<Type>>();
+        return Heap::Instance().Make<ListToNumericVectorFunction<T>>();
     }
-
-private:
-    ContextPtr context_;
 };
 
-class NullPredicateFunction : public Object {
+// Sum, minimum or maximum of the elements (Functor is Plus, Min or Max)
+template <typename T, typename Functor>
+class NumericVectorFoldFunction : public Object {
 public:
-    NullPredicateFunction() = default;
+    NumericVectorFoldFunction() = default;
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<NumericVectorFoldFunction<T, Functor>>();
     }
+};
+
+template <typename T>
+class NumericVectorDotFunction : public Object {
+public:
+    NumericVectorDotFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
     ObjectPtr Clone() override {
-        return Heap::Instance().Make<NullPredicateFunction>();
+        return Heap::Instance().Make<NumericVectorDotFunction<T>>();
     }
-
-private:
-    ContextPtr context_;
 };
 
-class ListPredicateFunction : public Object {
+// Elementwise sum or product of two vectors (Functor is Plus or Multiplies)
+template <typename T, typename Functor>
+class NumericVectorMapFunction : public Object {
 public:
-    ListPredicateFunction() = default;
+    NumericVectorMapFunction() = default;
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<NumericVectorMapFunction<T, Functor>>();
     }
+};
+
+template <typename T>
+class NumericVectorScaleFunction : public Object {
+public:
+    NumericVectorScaleFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
     ObjectPtr Clone() override {
-        return Heap::Instance().Make<ListPredicateFunction>();
+        return Heap::Instance().Make<NumericVectorScaleFunction<T>>();
     }
+};
 
-private:
-    ContextPtr context_;
+// (s64vector-mask < v x) gives an s64vector with 1 where the comparison holds, 0 elsewhere
+template <typename T>
+class NumericVectorMaskFunction : public Object {
+public:
+    NumericVectorMaskFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<NumericVectorMaskFunction<T>>();
+    }
 };
 
-// Pair functions
+// LambdaFunction object
+// Создаётся при вычислении LambdaNode (выражение вида lambda (args) (body))
+// и захватывает контекст, в котором был объявлен
 
-class ConsFunction : public Object {
+class NativeCode;
+
+class LambdaFunction : public Object {
 public:
-    ConsFunction() = default;
+    LambdaFunction(const ObjectPtrVector& args, const ObjectPtrVector& body, ContextPtr context,
+                   bool is_tiered = false);
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<LambdaFunction>(args_, body_, captured_context_, is_tiered_);
     }
 
-    ObjectPtr Clone() override {
-        return Heap::Instance().Make<ConsFunction>();
+    const ObjectPtrVector& GetArgs() const {
+        return args_;
+    }
+
+    const ObjectPtrVector& GetBody() const {
+        return body_;
+    }
+
+    ContextPtr GetCapturedContext() const {
+        return captured_context_;
+    }
+
+    bool IsTiered() const {
+        return is_tiered_;
     }
 
 private:
-    ContextPtr context_;
+    // Runs the call in native code once the lambda is hot (see jit.h),
+    // nullptr if the call is left to the interpreter
+    ObjectPtr ApplyNative(ObjectPtrSpan arguments);
+
+    ObjectPtrVector args_;
+    ObjectPtrVector body_;
+    ContextPtr captured_context_;
+    bool is_tiered_;
+    size_t calls_count_ = 0;
+    size_t deoptimizations_count_ = 0;
+    std::shared_ptr<NativeCode> native_code_;
 };
 
-class CarFunction : public Object {
+// EscapeProcedure object
+// The continuation call/ec passes to its argument. It's valid until that call/ec returns.
+
+class EscapeProcedure : public Object {
 public:
-    CarFunction() = default;
+    EscapeProcedure() = default;
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+    ObjectPtr Apply(ObjectPtrSpan arguments) override;
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
+    ObjectPtr Clone() override {
+        return this;
     }
 
-    ObjectPtr Clone() override {
-        return Heap::Instance().Make<CarFunction>();
+    std::string Serialize() override {
+        return "#<continuation>";
+    }
+
+    void Invalidate() {
+        is_valid_ = false;
+    }
+
+    // The value of the escape in progress if this procedure is its target, nullptr otherwise
+    ObjectPtr* FindEscapeValue() {
+        return (target_ == this) ? &value_ : nullptr;
+    }
+
+    static void FinishEscape() {
+        target_ = nullptr;
+        value_ = nullptr;
     }
 
 private:
-    ContextPtr context_;
+    bool is_valid_ = true;
+    // parallel tasks escape on their own threads
+    inline static thread_local EscapeProcedure* target_ = nullptr;
+    inline static thread_local ObjectPtr value_ = nullptr;
 };
 
-class CdrFunction : public Object {
-public:
-    CdrFunction() = default;
+// (call-with-escape-continuation proc), call/ec: applies proc to an escape procedure,
+// calling it returns its argument from call/ec at once
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+class CallWithEscapeFunction : public Object {
+public:
+    CallWithEscapeFunction() = default;
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
-    }
+    ObjectPtr Apply(ObjectPtrSpan arguments) override;
 
     ObjectPtr Clone() override {
-        return Heap::Instance().Make<CdrFunction>();
+        return Heap::Instance().Make<CallWithEscapeFunction>();
     }
-
-private:
-    ContextPtr context_;
 };
 
-// List functions
+// MemoizedFunction object
+// Wraps a function whose result depends on its arguments only. Results are cached by
+// equal arguments, the least recently used entry is evicted when the cache is full.
+// Entries keep copies of mutable arguments, so mutating an argument later doesn't
+// affect the cache. The cache is traced by the collector, so its entries die together
+// with the function.
 
-class ToListFunction : public Object {
+constexpr size_t kDefaultMemoizeCapacity = 10000;
+
+class MemoizedFunction : public Object {
 public:
-    ToListFunction() = default;
+    MemoizedFunction(ObjectPtr function, size_t capacity) : function_(function), capacity_(capacity) {
+        AddDependency(function);
+    }
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+    ObjectPtr Apply(ObjectPtrSpan arguments) override;
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
+    // The cache is shared by all the names the function is bound to
+    ObjectPtr Clone() override {
+        return this;
     }
 
-    ObjectPtr Clone() override {
-        return Heap::Instance().Make<ToListFunction>();
+    ObjectPtr GetFunction() const {
+        return function_;
     }
 
-private:
-    ContextPtr context_;
-};
+    size_t GetCapacity() const {
+        return capacity_;
+    }
 
-class ListRefFunction : public Object {
-public:
-    ListRefFunction() = default;
+    size_t GetHitsCount() const {
+        return hits_count_;
+    }
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+    size_t GetMissesCount() const {
+        return misses_count_;
+    }
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
+    size_t GetCount() const {
+        return entries_.size();
     }
 
-    ObjectPtr Clone() override {
-        return Heap::Instance().Make<ListRefFunction>();
+    void Clear();
+
+protected:
+    void MarkReferences() override {
+        for (const CacheEntry& entry : entries_) {
+            for (ObjectPtr argument : entry.arguments) {
+                MarkReference(argument);
+            }
+            MarkReference(entry.result);
+        }
     }
 
 private:
-    ContextPtr context_;
+    struct CacheEntry {
+        ObjectPtrVector arguments;
+        ObjectPtr result;
+        uint64_t hash;
+    };
+
+    using CacheEntries = std::list<CacheEntry>;
+
+    CacheEntries::iterator Find(ObjectPtrSpan arguments, uint64_t hash);
+    void Evict(CacheEntries::iterator entry);
+
+    ObjectPtr function_;
+    size_t capacity_;
+    // the most recently used entry goes first, the index maps hashes of arguments to entries
+    CacheEntries entries_;
+    std::unordered_multimap<uint64_t, CacheEntries::iterator> index_;
+    // parallel tasks may call the function at once
+    std::mutex mutex_;
+    size_t hits_count_ = 0;
+    size_t misses_count_ = 0;
 };
 
-class ListTailFunction : public Object {
+// (memoize f [capacity]), (memoize-stats f) gives (hits misses entries)
+
+class MemoizeFunction : public Object {
 public:
-    ListTailFunction() = default;
+    MemoizeFunction() = default;
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<MemoizeFunction>();
     }
+};
+
+class MemoizeStatsFunction : public Object {
+public:
+    MemoizeStatsFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
     ObjectPtr Clone() override {
-        return Heap::Instance().Make<ListTailFunction>();
+        return Heap::Instance().Make<MemoizeStatsFunction>();
     }
+};
 
-private:
-    ContextPtr context_;
+class MemoizeClearFunction : public Object {
+public:
+    MemoizeClearFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
+
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<MemoizeClearFunction>();
+    }
 };
 
-// Some other functions
+// Promise object
+// Made by (delay expression) with the context of the form, or by a native stream producer
+// (see stream.h) for the rest of its stream. The first force computes the value, later
+// forces give the same value at once. The expression and the context are dropped then.
 
-class AbsFunction : public Object {
+class StreamGenerator;
+
+class Promise : public Object {
 public:
-    AbsFunction() = default;
+    Promise(ObjectPtr expression, ContextPtr context);
+
+    // Already forced promise of make-promise
+    explicit Promise(ObjectPtr value) : value_(value), is_forced_(true) {
+        AddDependency(value);
+    }
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+    // The rest of a native stream: the next pair of elements or an empty list
+    explicit Promise(std::shared_ptr<StreamGenerator> generator)
+        : generator_(std::move(generator)) {
+    }
+
+    ObjectPtr Force();
+
+    // The forced value, nullptr if the promise isn't forced
+    ObjectPtr GetForcedValue() const {
+        return (is_forced_) ? value_ : nullptr;
+    }
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
+    // Marks a forced promise but not its value, the only object it refers to, and returns
+    // the value, nullptr if the promise is already marked. The pairs of a long forced stream
+    // are then marked in a loop, see Cell.
+    ObjectPtr MarkWithoutValue() {
+        if (is_connected_to_root) {
+            return nullptr;
+        }
+        is_connected_to_root = true;
+        return value_;
     }
 
+    // The promise is forced once for all the names it's bound to
     ObjectPtr Clone() override {
-        return Heap::Instance().Make<AbsFunction>();
+        return this;
     }
 
+    std::string Serialize() override {
+        return "#<promise>";
+    }
+
+protected:
+    void MarkReferences() override;
+
 private:
-    ContextPtr context_;
+    ObjectPtr value_ = nullptr;
+    ObjectPtr expression_ = nullptr;
+    ContextPtr context_ = nullptr;
+    std::shared_ptr<StreamGenerator> generator_;
+    bool is_forced_ = false;
 };
 
-class NegFunction : public Object {
+// Promise and stream functions
+// A stream is an empty list or a pair whose cdr is a promise of the rest of the stream.
+// Realization is in stream.cpp.
+
+class ForceFunction : public Object {
 public:
-    NegFunction() = default;
+    ForceFunction() = default;
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<ForceFunction>();
     }
+};
+
+class MakePromiseFunction : public Object {
+public:
+    MakePromiseFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
     ObjectPtr Clone() override {
-        return Heap::Instance().Make<NegFunction>();
+        return Heap::Instance().Make<MakePromiseFunction>();
     }
-
-private:
-    ContextPtr context_;
 };
 
-class QuoteFunction : public Object {
+class StreamPairPredicateFunction : public Object {
 public:
-    QuoteFunction() = default;
+    StreamPairPredicateFunction() = default;
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
-
-    void SetContext(ContextPtr) override{};
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
     ObjectPtr Clone() override {
-        return Heap::Instance().Make<QuoteFunction>();
+        return Heap::Instance().Make<StreamPairPredicateFunction>();
     }
 };
 
-// Logic functions
-
-class AndFunction : public Object {
+class StreamCarFunction : public Object {
 public:
-    AndFunction() = default;
+    StreamCarFunction() = default;
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<StreamCarFunction>();
     }
+};
+
+class StreamCdrFunction : public Object {
+public:
+    StreamCdrFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
     ObjectPtr Clone() override {
-        return Heap::Instance().Make<AndFunction>();
+        return Heap::Instance().Make<StreamCdrFunction>();
     }
-
-private:
-    ContextPtr context_;
 };
 
-class OrFunction : public Object {
+// (stream-range first past [step]), (stream-from first [step]) is infinite
+
+class StreamRangeFunction : public Object {
 public:
-    OrFunction() = default;
+    StreamRangeFunction() = default;
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<StreamRangeFunction>();
     }
+};
+
+class StreamFromFunction : public Object {
+public:
+    StreamFromFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
     ObjectPtr Clone() override {
-        return Heap::Instance().Make<OrFunction>();
+        return Heap::Instance().Make<StreamFromFunction>();
     }
-
-private:
-    ContextPtr context_;
 };
 
-// Define & set
+// (stream-map f stream), (stream-filter pred stream), (stream-take n stream)
+// and (list->stream list) are lazy: they give streams of native producers
 
-class DefineFunction : public Object {
+class StreamMapFunction : public Object {
 public:
-    DefineFunction() = default;
+    StreamMapFunction() = default;
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<StreamMapFunction>();
     }
+};
+
+class StreamFilterFunction : public Object {
+public:
+    StreamFilterFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
     ObjectPtr Clone() override {
-        return Heap::Instance().Make<DefineFunction>();
+        return Heap::Instance().Make<StreamFilterFunction>();
     }
-
-private:
-    ContextPtr context_;
 };
 
-class SetFunction : public Object {
+class StreamTakeFunction : public Object {
 public:
-    SetFunction() = default;
+    StreamTakeFunction() = default;
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<StreamTakeFunction>();
     }
+};
+
+class ListToStreamFunction : public Object {
+public:
+    ListToStreamFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
     ObjectPtr Clone() override {
-        return Heap::Instance().Make<SetFunction>();
+        return Heap::Instance().Make<ListToStreamFunction>();
     }
-
-private:
-    ContextPtr context_;
 };
 
-class SetCar : public Object {
+// (stream->list stream [n]) and (stream-fold f init stream) consume the stream,
+// fold calls (f accumulated element) for each element. The heap is collected only between
+// runs, so the consumed elements are kept until the run ends.
+
+class StreamToListFunction : public Object {
 public:
-    SetCar() = default;
+    StreamToListFunction() = default;
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<StreamToListFunction>();
     }
+};
+
+class StreamFoldFunction : public Object {
+public:
+    StreamFoldFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
     ObjectPtr Clone() override {
-        return Heap::Instance().Make<SetCar>();
+        return Heap::Instance().Make<StreamFoldFunction>();
     }
-
-private:
-    ContextPtr context_;
 };
 
-class SetCdr : public Object {
+// Future object
+// (future thunk) queues a call of the thunk to the scheduler of parallel.h, (touch f)
+// waits for its value. Queued futures run in parallel at the first touch, pmap or pfold.
+
+struct FutureState;
+
+class Future : public Object {
 public:
-    SetCdr() = default;
+    explicit Future(ObjectPtr thunk);
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+    // Cancels the call if it hasn't run yet
+    ~Future() override;
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
-    }
+    ObjectPtr Touch();
 
     ObjectPtr Clone() override {
-        return Heap::Instance().Make<SetCdr>();
+        return this;
     }
 
+    std::string Serialize() override {
+        return "#<future>";
+    }
+
+protected:
+    void MarkReferences() override;
+
 private:
-    ContextPtr context_;
+    std::shared_ptr<FutureState> state_;
 };
 
-// If-condition
+// Parallel functions
+// Realization is in parallel.cpp.
 
-class IfFunction : public Object {
+class FutureFunction : public Object {
 public:
-    IfFunction() = default;
+    FutureFunction() = default;
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
-    void SetContext(ContextPtr context) override {
-        context_ = context;
+    ObjectPtr Clone() override {
+        return Heap::Instance().Make<FutureFunction>();
     }
+};
+
+class TouchFunction : public Object {
+public:
+    TouchFunction() = default;
+
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
     ObjectPtr Clone() override {
-        return Heap::Instance().Make<IfFunction>();
+        return Heap::Instance().Make<TouchFunction>();
     }
-
-private:
-    ContextPtr context_;
 };
 
-// LambdaDeclaration object
-// Создаётся в выражении вида lambda (args) (body)
-// После применения к нему аргументов и тела, вычисляется уже в Lambda-функцию
+// (pmap f list) applies f to chunks of the list in parallel, (pfold f init list)
+// folds chunks in parallel and then their results from init, so f must be associative
 
-class LambdaDeclaration : public Object {
+class ParallelMapFunction : public Object {
 public:
-    LambdaDeclaration() = default;
+    ParallelMapFunction() = default;
 
-    ObjectPtr Apply(const ObjectPtrVector&) override;
-
-    void SetContext(ContextPtr context) override {
-        context_ = context;
-    };
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
     ObjectPtr Clone() override {
-        return Heap::Instance().Make<LambdaDeclaration>();
+        return Heap::Instance().Make<ParallelMapFunction>();
     }
-
-private:
-    ContextPtr context_;
 };
 
-class LambdaFunction : public Object {
+class ParallelFoldFunction : public Object {
 public:
-    LambdaFunction(const ObjectPtrVector& args, const ObjectPtrVector& body, ContextPtr context);
-
-    ObjectPtr Apply(const ObjectPtrVector&) override;
+    ParallelFoldFunction() = default;
 
-    void SetContext(ContextPtr context) override {
-        current_context_ = context;
-    }
+    ObjectPtr Apply(ObjectPtrSpan) override;
 
     ObjectPtr Clone() override {
-        ObjectPtr cloned_lambda =
-            Heap::Instance().Make<LambdaFunction>(args_, body_, captured_context_);
-        cloned_lambda->SetContext(current_context_);
-        return cloned_lambda;
+        return Heap::Instance().Make<ParallelFoldFunction>();
     }
-
-private:
-    ObjectPtrVector args_;
-    ObjectPtrVector body_;
-    ContextPtr captured_context_;
-    ContextPtr current_context_;
 };
 
 // Valid built-in functions map
 
-using PlusFunction = BinaryFoldFunction<std::plus<int64_t>>;
-using MinusFunction = BinaryFoldFunction<std::minus<int64_t>>;
-using MultiplyFunction = BinaryFoldFunction<std::multiplies<int64_t>>;
-using DivisionFunction = BinaryFoldFunction<std::divides<int64_t>>;
-using MaxFunction = BinaryFoldFunction<Max<int64_t>>;
-using MinFunction = BinaryFoldFunction<Min<int64_t>>;
-using LessFunction = MonotonicFunction<std::less<int64_t>>;
-using LessEqualFunction = MonotonicFunction<std::less_equal<int64_t>>;
-using EqualFunction = MonotonicFunction<std::equal_to<int64_t>>;
-using GreaterFunction = MonotonicFunction<std::greater<int64_t>>;
-using GrEqualFunction = MonotonicFunction<std::greater_equal<int64_t>>;
-using IsNumPred = PredicateFunction<Number>;
+using PlusFunction = BinaryFoldFunction<Plus>;
+using MinusFunction = BinaryFoldFunction<Minus>;
+using MultiplyFunction = BinaryFoldFunction<Multiplies>;
+using DivisionFunction = BinaryFoldFunction<Divides>;
+using MaxFunction = BinaryFoldFunction<Max>;
+using MinFunction = BinaryFoldFunction<Min>;
+using LessFunction = MonotonicFunction<std::less<>>;
+using LessEqualFunction = MonotonicFunction<std::less_equal<>>;
+using EqualFunction = MonotonicFunction<std::equal_to<>>;
+using GreaterFunction = MonotonicFunction<std::greater<>>;
+using GrEqualFunction = MonotonicFunction<std::greater_equal<>>;
+using IsNumPred = NumberPredicateFunction;
 using IsBoolPred = PredicateFunction<BooleanSymbol>;
 using IsPairPred = PredicateFunction<Cell>;
 using SymbolPred = PredicateFunction<Symbol>;
+using IsVectorPred = PredicateFunction<Vector>;
+using IsStringPred = PredicateFunction<String>;
+using IsHashTablePred = PredicateFunction<HashTable>;
+using IsPromisePred = PredicateFunction<Promise>;
+using IsFuturePred = PredicateFunction<Future>;
+using StringEqualFunction = StringComparisonFunction<std::equal_to<>>;
+using StringLessFunction = StringComparisonFunction<std::less<>>;
 
 const std::unordered_map<std::string, ObjectPtr> kValidFunctionsMap = {
-    {"+", Heap::Instance().Make<PlusFunction>()},
-    {"-", Heap::Instance().Make<MinusFunction>()},
-    {"*", Heap::Instance().Make<MultiplyFunction>()},
-    {"/", Heap::Instance().Make<DivisionFunction>()},
-    {"min", Heap::Instance().Make<MinFunction>()},
-    {"max", Heap::Instance().Make<MaxFunction>()},
-    {"abs", Heap::Instance().Make<AbsFunction>()},
-    {"<", Heap::Instance().Make<LessFunction>()},
-    {"<=", Heap::Instance().Make<LessEqualFunction>()},
-    {"=", Heap::Instance().Make<EqualFunction>()},
-    {">", Heap::Instance().Make<GreaterFunction>()},
-    {">=", Heap::Instance().Make<GrEqualFunction>()},
-    {"number?", Heap::Instance().Make<IsNumPred>()},
-    {"boolean?", Heap::Instance().Make<IsBoolPred>()},
-    {"quote", Heap::Instance().Make<QuoteFunction>()},
-    {"not", Heap::Instance().Make<NegFunction>()},
-    {"and", Heap::Instance().Make<AndFunction>()},
-    {"pair?", Heap::Instance().Make<IsPairPred>()},
-    {"or", Heap::Instance().Make<OrFunction>()},
-    {"list-ref", Heap::Instance().Make<ListRefFunction>()},
-    {"list?", Heap::Instance().Make<ListPredicateFunction>()},
-    {"cons", Heap::Instance().Make<ConsFunction>()},
-    {"car", Heap::Instance().Make<CarFunction>()},
-    {"cdr", Heap::Instance().Make<CdrFunction>()},
-    {"list", Heap::Instance().Make<ToListFunction>()},
-    {"null?", Heap::Instance().Make<NullPredicateFunction>()},
-    {"list-tail", Heap::Instance().Make<ListTailFunction>()},
-    {"symbol?", Heap::Instance().Make<SymbolPred>()},
-    {"define", Heap::Instance().Make<DefineFunction>()},
-    {"set!", Heap::Instance().Make<SetFunction>()},
-    {"if", Heap::Instance().Make<IfFunction>()},
-    {"set-car!", Heap::Instance().Make<SetCar>()},
-    {"set-cdr!", Heap::Instance().Make<SetCdr>()},
-    {"lambda", Heap::Instance().Make<LambdaDeclaration>()}};
+    {"+", Heap::Instance().MakePermanent<PlusFunction>()},
+    {"-", Heap::Instance().MakePermanent<MinusFunction>()},
+    {"*", Heap::Instance().MakePermanent<MultiplyFunction>()},
+    {"/", Heap::Instance().MakePermanent<DivisionFunction>()},
+    {"min", Heap::Instance().MakePermanent<MinFunction>()},
+    {"max", Heap::Instance().MakePermanent<MaxFunction>()},
+    {"abs", Heap::Instance().MakePermanent<AbsFunction>()},
+    {"<", Heap::Instance().MakePermanent<LessFunction>()},
+    {"<=", Heap::Instance().MakePermanent<LessEqualFunction>()},
+    {"=", Heap::Instance().MakePermanent<EqualFunction>()},
+    {">", Heap::Instance().MakePermanent<GreaterFunction>()},
+    {">=", Heap::Instance().MakePermanent<GrEqualFunction>()},
+    {"number?", Heap::Instance().MakePermanent<IsNumPred>()},
+    {"boolean?", Heap::Instance().MakePermanent<IsBoolPred>()},
+    {"not", Heap::Instance().MakePermanent<NegFunction>()},
+    {"pair?", Heap::Instance().MakePermanent<IsPairPred>()},
+    {"list-ref", Heap::Instance().MakePermanent<ListRefFunction>()},
+    {"list?", Heap::Instance().MakePermanent<ListPredicateFunction>()},
+    {"cons", Heap::Instance().MakePermanent<ConsFunction>()},
+    {"car", Heap::Instance().MakePermanent<CarFunction>()},
+    {"cdr", Heap::Instance().MakePermanent<CdrFunction>()},
+    {"list", Heap::Instance().MakePermanent<ToListFunction>()},
+    {"null?", Heap::Instance().MakePermanent<NullPredicateFunction>()},
+    {"list-tail", Heap::Instance().MakePermanent<ListTailFunction>()},
+    {"symbol?", Heap::Instance().MakePermanent<SymbolPred>()},
+    {"set-car!", Heap::Instance().MakePermanent<SetCar>()},
+    {"set-cdr!", Heap::Instance().MakePermanent<SetCdr>()},
+    {"string?", Heap::Instance().MakePermanent<IsStringPred>()},
+    {"string-length", Heap::Instance().MakePermanent<StringLengthFunction>()},
+    {"string-append", Heap::Instance().MakePermanent<StringAppendFunction>()},
+    {"substring", Heap::Instance().MakePermanent<SubstringFunction>()},
+    {"string=?", Heap::Instance().MakePermanent<StringEqualFunction>()},
+    {"string<?", Heap::Instance().MakePermanent<StringLessFunction>()},
+    {"string->symbol", Heap::Instance().MakePermanent<StringToSymbolFunction>()},
+    {"symbol->string", Heap::Instance().MakePermanent<SymbolToStringFunction>()},
+    {"call-with-escape-continuation", Heap::Instance().MakePermanent<CallWithEscapeFunction>()},
+    {"call/ec", Heap::Instance().MakePermanent<CallWithEscapeFunction>()},
+    {"call-with-current-continuation", Heap::Instance().MakePermanent<CallWithEscapeFunction>()},
+    {"call/cc", Heap::Instance().MakePermanent<CallWithEscapeFunction>()},
+    {"memoize", Heap::Instance().MakePermanent<MemoizeFunction>()},
+    {"memoize-stats", Heap::Instance().MakePermanent<MemoizeStatsFunction>()},
+    {"memoize-clear!", Heap::Instance().MakePermanent<MemoizeClearFunction>()},
+    {"force", Heap::Instance().MakePermanent<ForceFunction>()},
+    {"make-promise", Heap::Instance().MakePermanent<MakePromiseFunction>()},
+    {"promise?", Heap::Instance().MakePermanent<IsPromisePred>()},
+    {"stream-null?", Heap::Instance().MakePermanent<NullPredicateFunction>()},
+    {"stream-pair?", Heap::Instance().MakePermanent<StreamPairPredicateFunction>()},
+    {"stream-car", Heap::Instance().MakePermanent<StreamCarFunction>()},
+    {"stream-cdr", Heap::Instance().MakePermanent<StreamCdrFunction>()},
+    {"stream-range", Heap::Instance().MakePermanent<StreamRangeFunction>()},
+    {"stream-from", Heap::Instance().MakePermanent<StreamFromFunction>()},
+    {"stream-map", Heap::Instance().MakePermanent<StreamMapFunction>()},
+    {"stream-filter", Heap::Instance().MakePermanent<StreamFilterFunction>()},
+    {"stream-take", Heap::Instance().MakePermanent<StreamTakeFunction>()},
+    {"list->stream", Heap::Instance().MakePermanent<ListToStreamFunction>()},
+    {"stream->list", Heap::Instance().MakePermanent<StreamToListFunction>()},
+    {"stream-fold", Heap::Instance().MakePermanent<StreamFoldFunction>()},
+    {"future", Heap::Instance().MakePermanent<FutureFunction>()},
+    {"future?", Heap::Instance().MakePermanent<IsFuturePred>()},
+    {"touch", Heap::Instance().MakePermanent<TouchFunction>()},
+    {"pmap", Heap::Instance().MakePermanent<ParallelMapFunction>()},
+    {"pfold", Heap::Instance().MakePermanent<ParallelFoldFunction>()},
+    {"hash-table?", Heap::Instance().MakePermanent<IsHashTablePred>()},
+    {"make-hash-table", Heap::Instance().MakePermanent<MakeHashTableFunction>()},
+    {"hash-table-ref", Heap::Instance().MakePermanent<HashTableRefFunction>()},
+    {"hash-table-set!", Heap::Instance().MakePermanent<HashTableSetFunction>()},
+    {"hash-table-delete!", Heap::Instance().MakePermanent<HashTableDeleteFunction>()},
+    {"hash-table-count", Heap::Instance().MakePermanent<HashTableCountFunction>()},
+    {"hash-table-keys", Heap::Instance().MakePermanent<HashTableKeysFunction>()},
+    {"vector?", Heap::Instance().MakePermanent<IsVectorPred>()},
+    {"make-vector", Heap::Instance().MakePermanent<MakeVectorFunction>()},
+    {"vector", Heap::Instance().MakePermanent<VectorFunction>()},
+    {"vector-ref", Heap::Instance().MakePermanent<VectorRefFunction>()},
+    {"vector-set!", Heap::Instance().MakePermanent<VectorSetFunction>()},
+    {"vector-length", Heap::Instance().MakePermanent<VectorLengthFunction>()},
+    {"vector->list", Heap::Instance().MakePermanent<VectorToListFunction>()},
+    {"list->vector", Heap::Instance().MakePermanent<ListToVectorFunction>()},
+    {"make-s64vector", Heap::Instance().MakePermanent<MakeNumericVectorFunction<int64_t>>()},
+    {"s64vector", Heap::Instance().MakePermanent<NumericVectorFunction<int64_t>>()},
+    {"s64vector?", Heap::Instance().MakePermanent<PredicateFunction<NumericVector<int64_t>>>()},
+    {"s64vector-ref", Heap::Instance().MakePermanent<NumericVectorRefFunction<int64_t>>()},
+    {"s64vector-set!", Heap::Instance().MakePermanent<NumericVectorSetFunction<int64_t>>()},
+    {"s64vector-length", Heap::Instance().MakePermanent<NumericVectorLengthFunction<int64_t>>()},
+    {"s64vector->list", Heap::Instance().MakePermanent<NumericVectorToListFunction<int64_t>>()},
+    {"list->s64vector", Heap::Instance().MakePermanent<ListToNumericVectorFunction<int64_t>>()},
+    {"s64vector-sum", Heap::Instance().MakePermanent<NumericVectorFoldFunction<int64_t, Plus>>()},
+    {"s64vector-min", Heap::Instance().MakePermanent<NumericVectorFoldFunction<int64_t, Min>>()},
+    {"s64vector-max", Heap::Instance().MakePermanent<NumericVectorFoldFunction<int64_t, Max>>()},
+    {"s64vector-dot", Heap::Instance().MakePermanent<NumericVectorDotFunction<int64_t>>()},
+    {"s64vector-add", Heap::Instance().MakePermanent<NumericVectorMapFunction<int64_t, Plus>>()},
+    {"s64vector-mul", Heap::Instance().MakePermanent<NumericVectorMapFunction<int64_t, Multiplies>>()},
+    {"s64vector-scale", Heap::Instance().MakePermanent<NumericVectorScaleFunction<int64_t>>()},
+    {"s64vector-mask", Heap::Instance().MakePermanent<NumericVectorMaskFunction<int64_t>>()},
+    {"make-f64vector", Heap::Instance().MakePermanent<MakeNumericVectorFunction<double>>()},
+    {"f64vector", Heap::Instance().MakePermanent<NumericVectorFunction<double>>()},
+    {"f64vector?", Heap::Instance().MakePermanent<PredicateFunction<NumericVector<double>>>()},
+    {"f64vector-ref", Heap::Instance().MakePermanent<NumericVectorRefFunction<double>>()},
+    {"f64vector-set!", Heap::Instance().MakePermanent<NumericVectorSetFunction<double>>()},
+    {"f64vector-length", Heap::Instance().MakePermanent<NumericVectorLengthFunction<double>>()},
+    {"f64vector->list", Heap::Instance().MakePermanent<NumericVectorToListFunction<double>>()},
+    {"list->f64vector", Heap::Instance().MakePermanent<ListToNumericVectorFunction<double>>()},
+    {"f64vector-sum", Heap::Instance().MakePermanent<NumericVectorFoldFunction<double, Plus>>()},
+    {"f64vector-min", Heap::Instance().MakePermanent<NumericVectorFoldFunction<double, Min>>()},
+    {"f64vector-max", Heap::Instance().MakePermanent<NumericVectorFoldFunction<double, Max>>()},
+    {"f64vector-dot", Heap::Instance().MakePermanent<NumericVectorDotFunction<double>>()},
+    {"f64vector-add", Heap::Instance().MakePermanent<NumericVectorMapFunction<double, Plus>>()},
+    {"f64vector-mul", Heap::Instance().MakePermanent<NumericVectorMapFunction<double, Multiplies>>()},
+    {"f64vector-scale", Heap::Instance().MakePermanent<NumericVectorScaleFunction<double>>()},
+    {"f64vector-mask", Heap::Instance().MakePermanent<NumericVectorMaskFunction<double>>()},};
 
 // Scope and context realizations
 
@@ -872,35 +2177,80 @@ class Scope : public Object {
 public:
     Scope() = default;
 
-    Scope(const std::unordered_map<std::string, ObjectPtr>& scope_map) : scope_map_(scope_map) {
-        for (const auto& pair : scope_map) {
-            AddDependency(pair.second);
-        }
-    };
+    // Global scope initialized with built-in functions
+    Scope(const std::unordered_map<std::string, ObjectPtr>& scope_map)
+        : scope_map_(scope_map), is_global_(true){};
 
     bool Contains(const std::string& symbol_name) {
         return scope_map_.contains(symbol_name);
     }
 
     ObjectPtr Get(const std::string& symbol_name) {
-        return scope_map_[symbol_name];
+        auto found = scope_map_.find(symbol_name);
+        return (found != scope_map_.end()) ? found->second : nullptr;
     }
 
     void Define(const std::string& symbol_name, ObjectPtr value) {
-        ObjectPtr cloned_value = value->Clone();
-        AddDependency(cloned_value);
-        scope_map_[symbol_name] = cloned_value;
+        Bind(symbol_name, (value) ? value->Clone() : nullptr);
+    }
+
+    // Binds the value itself rather than its copy (e.g. an object restored from an image)
+    void Bind(const std::string& symbol_name, ObjectPtr value) {
+        TrackRebinding(symbol_name);
+        scope_map_[symbol_name] = value;
+    }
+
+    const std::unordered_map<std::string, ObjectPtr>& GetBindings() const {
+        return scope_map_;
+    }
+
+    // Drops all the bindings, so that the scope can be reused (e.g. by the next iteration
+    // of a loop)
+    void Clear() {
+        scope_map_.clear();
+    }
+
+    // Set once a copy of a context shares the scope, e.g. when a closure captures it.
+    // Calls in parallel tasks copy contexts at once, so the flag is atomic.
+    bool IsCaptured() const {
+        return is_captured_.load(std::memory_order_relaxed);
+    }
+
+    void SetCaptured() {
+        is_captured_.store(true, std::memory_order_relaxed);
     }
 
     void Change(const std::string& symbol_name, ObjectPtr value) {
-        RemoveDependency(scope_map_[symbol_name]);
-        ObjectPtr cloned_value = value->Clone();
-        AddDependency(cloned_value);
-        scope_map_[symbol_name] = cloned_value;
+        TrackRebinding(symbol_name);
+        scope_map_[symbol_name] = (value) ? value->Clone() : nullptr;
+    }
+
+    // Incremented each time a built-in name is rebound in a global scope, so that code
+    // optimized in assumption of built-ins can check they are still in place.
+    static uint64_t GetRebindingEpoch() {
+        return rebinding_epoch_;
+    }
+
+protected:
+    // Bindings are traced right from the map: a value bound to several names stays
+    // reachable until all of them are rebound
+    void MarkReferences() override {
+        for (const auto& [symbol_name, value] : scope_map_) {
+            MarkReference(value);
+        }
     }
 
 private:
+    void TrackRebinding(const std::string& symbol_name) {
+        if (is_global_ && kValidFunctionsMap.contains(symbol_name)) {
+            ++rebinding_epoch_;
+        }
+    }
+
     std::unordered_map<std::string, ObjectPtr> scope_map_;
+    bool is_global_ = false;
+    std::atomic<bool> is_captured_ = false;
+    inline static uint64_t rebinding_epoch_ = 0;
 };
 
 class Context : public Object {
@@ -910,6 +2260,9 @@ public:
     Context(const Context& other) {
         context_ = other.context_;
         dependencies_ = other.dependencies_;
+        for (ScopePtr scope : context_) {
+            scope->SetCaptured();
+        }
     }
 
     bool Contains(const std::string& symbol_name) {
@@ -925,6 +2278,11 @@ public:
         context_[context_.size() - 1]->Define(symbol_name, value);
     }
 
+    // Binds the value itself rather than its copy in the innermost scope
+    void Bind(const std::string& symbol_name, ObjectPtr value) {
+        context_.back()->Bind(symbol_name, value);
+    }
+
     void Change(const std::string& symbol_name, ObjectPtr value) {
         for (int64_t i = context_.size() - 1; i >= 0; --i) {
             if (context_[i]->Contains(symbol_name)) {
@@ -934,6 +2292,16 @@ public:
         }
     }
 
+    // Scopes from the global one to the innermost one
+    const ScopePtrVector& GetScopes() const {
+        return context_;
+    }
+
+    // Context of top-level code: nothing but the global scope
+    bool IsGlobal() const {
+        return context_.size() == 1;
+    }
+
     void AddScope(ScopePtr scope_ptr) {
         AddDependency(scope_ptr);
         context_.push_back(scope_ptr);
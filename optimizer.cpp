@@ -0,0 +1,408 @@
+#include "optimizer.h"
+
+#include <typeinfo>
+
+// GuardedNode's realization
+
+GuardedNode::GuardedNode(ObjectPtr optimized, ObjectPtr original)
+    : optimized_(optimized),
+      original_(original),
+      rebinding_epoch_(Scope::GetRebindingEpoch()) {
+    AddDependency(optimized);
+    AddDependency(original);
+}
+
+ObjectPtr GuardedNode::GetActive() const {
+    return (rebinding_epoch_ == Scope::GetRebindingEpoch()) ? optimized_ : original_;
+}
+
+ObjectPtr GuardedNode::Evaluate(ContextPtr context) {
+    return EvaluateExpression(GetActive(), context);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Optimizer's realization
+
+Optimizer::Optimizer(ContextPtr context, OptimizationLevel level)
+    : context_(context), level_(level) {
+}
+
+ObjectPtr Optimizer::Optimize(ObjectPtr node) {
+    if (level_ == OptimizationLevel::NONE) {
+        return node;
+    }
+    CollectReboundNames(node);
+    return OptimizeNode(node);
+}
+
+ObjectPtr Optimizer::OptimizeNode(ObjectPtr node) {
+    if (auto application = As<ApplicationNode>(node)) {
+        return OptimizeApplication(application);
+    } else if (auto if_node = As<IfNode>(node)) {
+        return OptimizeIf(if_node);
+    } else if (auto and_node = As<AndNode>(node)) {
+        return OptimizeAnd(and_node);
+    } else if (auto or_node = As<OrNode>(node)) {
+        return OptimizeOr(or_node);
+    } else if (auto lambda = As<LambdaNode>(node)) {
+        return OptimizeLambda(lambda);
+    } else if (auto let = As<LetNode>(node)) {
+        return OptimizeLet(let);
+    } else if (auto named_let = As<NamedLetNode>(node)) {
+        return OptimizeNamedLet(named_let);
+    } else if (auto tail_call = As<TailCallNode>(node)) {
+        return OptimizeTailCall(tail_call);
+    } else if (auto begin = As<BeginNode>(node)) {
+        return OptimizeBegin(begin);
+    } else if (auto arrow = As<CondArrowNode>(node)) {
+        return OptimizeCondArrow(arrow);
+    } else if (auto case_node = As<CaseNode>(node)) {
+        return OptimizeCase(case_node);
+    } else if (auto delay = As<DelayNode>(node)) {
+        ObjectPtr expression = OptimizeNode(delay->GetExpression());
+        return (expression == delay->GetExpression())
+                   ? node
+                   : Heap::Instance().Make<DelayNode>(expression);
+    } else if (auto define = As<DefineNode>(node)) {
+        ObjectPtr value = OptimizeNode(define->GetValue());
+        return (value == define->GetValue())
+                   ? node
+                   : Heap::Instance().Make<DefineNode>(define->GetName(), value);
+    } else if (auto set = As<SetNode>(node)) {
+        ObjectPtr value = OptimizeNode(set->GetValue());
+        return (value == set->GetValue()) ? node
+                                          : Heap::Instance().Make<SetNode>(set->GetName(), value);
+    }
+    return node;
+}
+
+ObjectPtrVector Optimizer::OptimizeSequence(const ObjectPtrVector& nodes, bool* changed) {
+    ObjectPtrVector optimized(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        optimized[i] = OptimizeNode(nodes[i]);
+        *changed = *changed || (optimized[i] != nodes[i]);
+    }
+    return optimized;
+}
+
+ObjectPtr Optimizer::OptimizeApplication(ApplicationNode* node) {
+    bool changed = false;
+    ObjectPtr function = OptimizeNode(node->GetFunction());
+    ObjectPtrVector operands = OptimizeSequence(node->GetOperands(), &changed);
+    ObjectPtr application = node;
+    if (changed || function != node->GetFunction()) {
+        application = Heap::Instance().Make<ApplicationNode>(function, operands);
+    }
+
+    ObjectPtr pure_function = ResolvePureFunction(function);
+    if (!pure_function) {
+        return application;
+    }
+    ObjectPtrVector values(operands.size());
+    for (size_t i = 0; i < operands.size(); ++i) {
+        bool is_guarded = false;
+        if (!GetConstantValue(operands[i], &values[i], &is_guarded)) {
+            return application;
+        }
+    }
+    try {
+        return Heap::Instance().Make<GuardedNode>(MakeConstantNode(pure_function->Apply(values)),
+                                                  application);
+    } catch (const RuntimeError&) {
+        // e.g. division by zero must be reported when the call is evaluated
+        return application;
+    }
+}
+
+ObjectPtr Optimizer::OptimizeIf(IfNode* node) {
+    ObjectPtr condition = OptimizeNode(node->GetCondition());
+    ObjectPtr consequent = OptimizeNode(node->GetConsequent());
+    ObjectPtr alternative =
+        (node->HasAlternative()) ? OptimizeNode(node->GetAlternative()) : nullptr;
+    ObjectPtr if_node = node;
+    if (condition != node->GetCondition() || consequent != node->GetConsequent() ||
+        alternative != node->GetAlternative()) {
+        if_node = (node->HasAlternative())
+                      ? Heap::Instance().Make<IfNode>(condition, consequent, alternative)
+                      : Heap::Instance().Make<IfNode>(condition, consequent);
+    }
+
+    ObjectPtr value;
+    bool is_guarded = false;
+    if (!GetConstantValue(condition, &value, &is_guarded)) {
+        return if_node;
+    }
+    ObjectPtr branch = consequent;
+    if (!IsTruthy(value)) {
+        branch = (node->HasAlternative()) ? alternative : MakeConstantNode(nullptr);
+    }
+    return (is_guarded) ? Heap::Instance().Make<GuardedNode>(branch, if_node) : branch;
+}
+
+ObjectPtr Optimizer::OptimizeAnd(AndNode* node) {
+    bool changed = false;
+    ObjectPtrVector operands = OptimizeSequence(node->GetOperands(), &changed);
+    ObjectPtrVector kept;
+    bool is_guarded = false;
+    for (size_t i = 0; i < operands.size(); ++i) {
+        ObjectPtr value;
+        bool is_last = (i + 1 == operands.size());
+        if (GetConstantValue(operands[i], &value, &is_guarded)) {
+            if (!IsTruthy(value)) {
+                // operands after the first false one are never evaluated
+                kept.push_back(operands[i]);
+                break;
+            } else if (!is_last) {
+                continue;
+            }
+        }
+        kept.push_back(operands[i]);
+    }
+
+    ObjectPtr and_node = node;
+    if (changed) {
+        and_node = Heap::Instance().Make<AndNode>(operands);
+    }
+    if (kept.size() == operands.size()) {
+        return and_node;
+    }
+    ObjectPtr simplified = (kept.size() == 1) ? kept[0] : Heap::Instance().Make<AndNode>(kept);
+    return (is_guarded) ? Heap::Instance().Make<GuardedNode>(simplified, and_node) : simplified;
+}
+
+ObjectPtr Optimizer::OptimizeOr(OrNode* node) {
+    bool changed = false;
+    ObjectPtrVector operands = OptimizeSequence(node->GetOperands(), &changed);
+    ObjectPtrVector kept;
+    bool is_guarded = false;
+    for (size_t i = 0; i < operands.size(); ++i) {
+        ObjectPtr value;
+        bool is_last = (i + 1 == operands.size());
+        if (GetConstantValue(operands[i], &value, &is_guarded)) {
+            if (IsTruthy(value)) {
+                // operands after the first true one are never evaluated
+                kept.push_back(operands[i]);
+                break;
+            } else if (!is_last) {
+                continue;
+            }
+        }
+        kept.push_back(operands[i]);
+    }
+
+    ObjectPtr or_node = node;
+    if (changed) {
+        or_node = Heap::Instance().Make<OrNode>(operands);
+    }
+    if (kept.size() == operands.size()) {
+        return or_node;
+    }
+    ObjectPtr simplified = (kept.size() == 1) ? kept[0] : Heap::Instance().Make<OrNode>(kept);
+    return (is_guarded) ? Heap::Instance().Make<GuardedNode>(simplified, or_node) : simplified;
+}
+
+ObjectPtr Optimizer::OptimizeLambda(LambdaNode* node) {
+    bool changed = false;
+    ObjectPtrVector body = OptimizeSequence(node->GetBody(), &changed);
+    bool is_tiered = (level_ == OptimizationLevel::NATIVE_CODE);
+    return (changed || is_tiered)
+               ? Heap::Instance().Make<LambdaNode>(node->GetArgs(), body, is_tiered)
+               : node;
+}
+
+ObjectPtr Optimizer::OptimizeLet(LetNode* node) {
+    bool changed = false;
+    ObjectPtrVector values = OptimizeSequence(node->GetValues(), &changed);
+    ObjectPtrVector body = OptimizeSequence(node->GetBody(), &changed);
+    return (changed) ? Heap::Instance().Make<LetNode>(node->GetKind(), node->GetNames(), values,
+                                                      body)
+                     : node;
+}
+
+ObjectPtr Optimizer::OptimizeNamedLet(NamedLetNode* node) {
+    bool changed = false;
+    ObjectPtrVector values = OptimizeSequence(node->GetValues(), &changed);
+    LoopNode* loop = node->GetLoop();
+    bool body_changed = false;
+    ObjectPtrVector body = OptimizeSequence(loop->GetBody(), &body_changed);
+    if (body_changed) {
+        loop = Heap::Instance().Make<LoopNode>(loop->GetName(), loop->GetArgs(), body);
+    }
+    return (changed || body_changed) ? Heap::Instance().Make<NamedLetNode>(values, loop) : node;
+}
+
+ObjectPtr Optimizer::OptimizeTailCall(TailCallNode* node) {
+    bool changed = false;
+    ObjectPtrVector operands = OptimizeSequence(node->GetOperands(), &changed);
+    return (changed) ? Heap::Instance().Make<TailCallNode>(node->GetFunction(), operands) : node;
+}
+
+ObjectPtr Optimizer::OptimizeBegin(BeginNode* node) {
+    bool changed = false;
+    ObjectPtrVector body = OptimizeSequence(node->GetBody(), &changed);
+    return (changed) ? Heap::Instance().Make<BeginNode>(body) : node;
+}
+
+ObjectPtr Optimizer::OptimizeCondArrow(CondArrowNode* node) {
+    ObjectPtr test = OptimizeNode(node->GetTest());
+    ObjectPtr receiver = OptimizeNode(node->GetReceiver());
+    ObjectPtr alternative =
+        (node->HasAlternative()) ? OptimizeNode(node->GetAlternative()) : nullptr;
+    if (test == node->GetTest() && receiver == node->GetReceiver() &&
+        alternative == node->GetAlternative()) {
+        return node;
+    }
+    return (node->HasAlternative())
+               ? Heap::Instance().Make<CondArrowNode>(test, receiver, alternative)
+               : Heap::Instance().Make<CondArrowNode>(test, receiver);
+}
+
+ObjectPtr Optimizer::OptimizeCase(CaseNode* node) {
+    ObjectPtr key = OptimizeNode(node->GetKey());
+    bool changed = (key != node->GetKey());
+    ObjectPtrVector bodies = OptimizeSequence(node->GetBodies(), &changed);
+    ObjectPtr else_body = (node->HasElse()) ? OptimizeNode(node->GetElseBody()) : nullptr;
+    CaseNode* case_node = node;
+    if (changed || else_body != node->GetElseBody()) {
+        case_node = (node->HasElse()) ? Heap::Instance().Make<CaseNode>(key, node->GetData(),
+                                                                        bodies, else_body)
+                                      : Heap::Instance().Make<CaseNode>(key, node->GetData(),
+                                                                        bodies);
+    }
+
+    ObjectPtr value;
+    bool is_guarded = false;
+    if (!GetConstantValue(key, &value, &is_guarded)) {
+        return case_node;
+    }
+    ObjectPtr body = case_node->FindBody(value);
+    if (!body) {
+        body = MakeConstantNode(nullptr);
+    }
+    return (is_guarded) ? Heap::Instance().Make<GuardedNode>(body, case_node) : body;
+}
+
+ObjectPtr Optimizer::ResolvePureFunction(ObjectPtr function) {
+    auto symbol = As<Symbol>(function);
+    if (!symbol || rebound_names_.contains(symbol->GetName()) ||
+        !context_->Contains(symbol->GetName())) {
+        return nullptr;
+    }
+    // only built-in names are folded, the guard tracks rebinding of them and not of aliases
+    auto built_in = kValidFunctionsMap.find(symbol->GetName());
+    if (built_in == kValidFunctionsMap.end()) {
+        return nullptr;
+    }
+    // each translation unit has its own copy of the map, so the built-in is told by its type
+    ObjectPtr value = context_->Get(symbol->GetName());
+    if (!value || typeid(*value) != typeid(*built_in->second)) {
+        return nullptr;
+    }
+    return (value->IsPure()) ? value : nullptr;
+}
+
+void Optimizer::CollectReboundNames(ObjectPtr node) {
+    if (auto application = As<ApplicationNode>(node)) {
+        CollectReboundNames(application->GetFunction());
+        for (ObjectPtr operand : application->GetOperands()) {
+            CollectReboundNames(operand);
+        }
+    } else if (auto if_node = As<IfNode>(node)) {
+        CollectReboundNames(if_node->GetCondition());
+        CollectReboundNames(if_node->GetConsequent());
+        CollectReboundNames(if_node->GetAlternative());
+    } else if (auto and_node = As<AndNode>(node)) {
+        for (ObjectPtr operand : and_node->GetOperands()) {
+            CollectReboundNames(operand);
+        }
+    } else if (auto or_node = As<OrNode>(node)) {
+        for (ObjectPtr operand : or_node->GetOperands()) {
+            CollectReboundNames(operand);
+        }
+    } else if (auto lambda = As<LambdaNode>(node)) {
+        for (ObjectPtr arg : lambda->GetArgs()) {
+            rebound_names_.insert(As<Symbol>(arg)->GetName());
+        }
+        for (ObjectPtr expression : lambda->GetBody()) {
+            CollectReboundNames(expression);
+        }
+    } else if (auto let = As<LetNode>(node)) {
+        for (const std::string& name : let->GetNames()) {
+            rebound_names_.insert(name);
+        }
+        for (ObjectPtr value : let->GetValues()) {
+            CollectReboundNames(value);
+        }
+        for (ObjectPtr expression : let->GetBody()) {
+            CollectReboundNames(expression);
+        }
+    } else if (auto named_let = As<NamedLetNode>(node)) {
+        LoopNode* loop = named_let->GetLoop();
+        rebound_names_.insert(loop->GetName());
+        for (ObjectPtr arg : loop->GetArgs()) {
+            rebound_names_.insert(As<Symbol>(arg)->GetName());
+        }
+        for (ObjectPtr value : named_let->GetValues()) {
+            CollectReboundNames(value);
+        }
+        for (ObjectPtr expression : loop->GetBody()) {
+            CollectReboundNames(expression);
+        }
+    } else if (auto tail_call = As<TailCallNode>(node)) {
+        for (ObjectPtr operand : tail_call->GetOperands()) {
+            CollectReboundNames(operand);
+        }
+    } else if (auto begin = As<BeginNode>(node)) {
+        for (ObjectPtr expression : begin->GetBody()) {
+            CollectReboundNames(expression);
+        }
+    } else if (auto arrow = As<CondArrowNode>(node)) {
+        CollectReboundNames(arrow->GetTest());
+        CollectReboundNames(arrow->GetReceiver());
+        CollectReboundNames(arrow->GetAlternative());
+    } else if (auto case_node = As<CaseNode>(node)) {
+        CollectReboundNames(case_node->GetKey());
+        for (ObjectPtr body : case_node->GetBodies()) {
+            CollectReboundNames(body);
+        }
+        CollectReboundNames(case_node->GetElseBody());
+    } else if (auto delay = As<DelayNode>(node)) {
+        CollectReboundNames(delay->GetExpression());
+    } else if (auto define = As<DefineNode>(node)) {
+        rebound_names_.insert(define->GetName());
+        CollectReboundNames(define->GetValue());
+    } else if (auto define_syntax = As<DefineSyntaxNode>(node)) {
+        rebound_names_.insert(define_syntax->GetName());
+    } else if (auto set = As<SetNode>(node)) {
+        rebound_names_.insert(set->GetName());
+        CollectReboundNames(set->GetValue());
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Helper functions' realization
+
+bool GetConstantValue(ObjectPtr node, ObjectPtr* value, bool* is_guarded) {
+    if (IsNumber(node) || Is<BooleanSymbol>(node)) {
+        *value = node;
+        return true;
+    } else if (auto quote = As<QuoteNode>(node)) {
+        *value = quote->GetDatum();
+        return true;
+    } else if (auto guarded = As<GuardedNode>(node)) {
+        if (GetConstantValue(guarded->GetOptimized(), value, is_guarded)) {
+            *is_guarded = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+ObjectPtr MakeConstantNode(ObjectPtr value) {
+    if (IsNumber(value) || Is<BooleanSymbol>(value)) {
+        return value;
+    }
+    return Heap::Instance().Make<QuoteNode>(value);
+}
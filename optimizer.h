@@ -0,0 +1,87 @@
+#pragma once
+
+#include <unordered_set>
+
+#include "analyzer.h"
+
+enum class OptimizationLevel {
+    NONE,
+    CONSTANT_FOLDING,
+    // constant folding and compilation of hot fixnum lambdas to native code
+    NATIVE_CODE,
+};
+
+const OptimizationLevel kDefaultOptimizationLevel = OptimizationLevel::CONSTANT_FOLDING;
+
+///////////////////////////////////////////////////////////////////////////////
+
+// GuardedNode object
+// Result of an optimization which relies on built-in functions (e.g. a folded call).
+// Falls back to the original node as soon as some built-in name is rebound.
+
+class GuardedNode : public Object {
+public:
+    GuardedNode(ObjectPtr optimized, ObjectPtr original);
+
+    ObjectPtr GetOptimized() const {
+        return optimized_;
+    }
+
+    ObjectPtr GetOriginal() const {
+        return original_;
+    }
+
+    // The node Evaluate currently delegates to
+    ObjectPtr GetActive() const;
+
+    ObjectPtr Evaluate(ContextPtr) override;
+
+private:
+    ObjectPtr optimized_;
+    ObjectPtr original_;
+    uint64_t rebinding_epoch_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Optimizer
+// Runs between Analyze and evaluation: folds calls of pure built-ins on constants,
+// prunes dead if branches, picks case clauses for constant keys and simplifies and/or with constant operands.
+// Calls which throw on constants are left as is, so errors still happen at runtime.
+
+class Optimizer {
+public:
+    Optimizer(ContextPtr context, OptimizationLevel level);
+
+    ObjectPtr Optimize(ObjectPtr node);
+
+private:
+    ObjectPtr OptimizeNode(ObjectPtr node);
+    ObjectPtrVector OptimizeSequence(const ObjectPtrVector& nodes, bool* changed);
+
+    ObjectPtr OptimizeApplication(ApplicationNode* node);
+    ObjectPtr OptimizeIf(IfNode* node);
+    ObjectPtr OptimizeAnd(AndNode* node);
+    ObjectPtr OptimizeOr(OrNode* node);
+    ObjectPtr OptimizeLambda(LambdaNode* node);
+    ObjectPtr OptimizeLet(LetNode* node);
+    ObjectPtr OptimizeNamedLet(NamedLetNode* node);
+    ObjectPtr OptimizeTailCall(TailCallNode* node);
+    ObjectPtr OptimizeBegin(BeginNode* node);
+    ObjectPtr OptimizeCondArrow(CondArrowNode* node);
+    ObjectPtr OptimizeCase(CaseNode* node);
+
+    ObjectPtr ResolvePureFunction(ObjectPtr function);
+    void CollectReboundNames(ObjectPtr node);
+
+    ContextPtr context_;
+    OptimizationLevel level_;
+    // names which may be bound to something else than a built-in inside the expression
+    std::unordered_set<std::string> rebound_names_;
+};
+
+// Helper functions
+
+bool GetConstantValue(ObjectPtr node, ObjectPtr* value, bool* is_guarded);
+
+ObjectPtr MakeConstantNode(ObjectPtr value);
@@ -0,0 +1,287 @@
+#include "parallel.h"
+
+#include <algorithm>
+#include <array>
+
+// At least one worker besides the interpreter's thread, so that tasks always run
+// on more than one thread, even on a single core
+constexpr size_t kMinThreadsCount = 2;
+
+// Lists are split into a few chunks per thread, so that threads which finish early
+// steal the rest of the work
+constexpr size_t kChunksPerThread = 4;
+
+// TaskGroup's realization
+
+void TaskGroup::RethrowIfFailed() {
+    std::lock_guard lock(error_mutex_);
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Scheduler's realization
+
+Scheduler::Scheduler() {
+    size_t threads_count = std::max<size_t>(std::thread::hardware_concurrency(), kMinThreadsCount);
+    for (size_t i = 0; i < threads_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 1; i < threads_count; ++i) {
+        workers_[i]->thread = std::thread(&Scheduler::RunWorker, this, i);
+    }
+}
+
+Scheduler::~Scheduler() {
+    {
+        std::lock_guard lock(section_mutex_);
+        is_stopping_ = true;
+    }
+    section_changed_.notify_all();
+    for (size_t i = 1; i < workers_.size(); ++i) {
+        workers_[i]->thread.join();
+    }
+}
+
+void Scheduler::Spawn(TaskGroup* group, Task task) {
+    group->remaining_.fetch_add(1, std::memory_order_relaxed);
+    pending_count_.fetch_add(1, std::memory_order_relaxed);
+    Worker& worker = *workers_[worker_index_];
+    std::lock_guard lock(worker.mutex);
+    worker.tasks.emplace_back(group, std::move(task));
+}
+
+void Scheduler::Wait(TaskGroup* group) {
+    if (IsRunningTask()) {
+        // a nested wait: other threads are busy with the section already
+        while (!group->IsFinished()) {
+            if (!RunNextTask()) {
+                std::this_thread::yield();
+            }
+        }
+    } else if (pending_count_.load(std::memory_order_acquire) > 0) {
+        {
+            std::lock_guard lock(section_mutex_);
+            is_section_active_.store(true, std::memory_order_release);
+        }
+        section_changed_.notify_all();
+        while (pending_count_.load(std::memory_order_acquire) > 0) {
+            if (!RunNextTask()) {
+                std::this_thread::yield();
+            }
+        }
+        {
+            // a worker may have checked the section just before it ended
+            std::unique_lock lock(section_mutex_);
+            is_section_active_.store(false, std::memory_order_release);
+            section_changed_.wait(lock, [this] { return workers_in_section_ == 0; });
+        }
+        // every worker has left the section, so the buffers are not touched until the next one
+        for (size_t i = 1; i < workers_.size(); ++i) {
+            Heap::Instance().AdoptObjects(&workers_[i]->objects);
+        }
+    }
+    group->RethrowIfFailed();
+}
+
+bool Scheduler::RunNextTask() {
+    std::pair<TaskGroup*, Task> task(nullptr, nullptr);
+    {
+        Worker& worker = *workers_[worker_index_];
+        std::lock_guard lock(worker.mutex);
+        if (!worker.tasks.empty()) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        }
+    }
+    for (size_t i = 1; i < workers_.size() && !task.first; ++i) {
+        Worker& victim = *workers_[(worker_index_ + i) % workers_.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+    if (!task.first) {
+        return false;
+    }
+
+    TaskGroup* group = task.first;
+    ++running_tasks_count_;
+    try {
+        task.second();
+    } catch (...) {
+        std::lock_guard lock(group->error_mutex_);
+        if (!group->error_) {
+            group->error_ = std::current_exception();
+        }
+    }
+    --running_tasks_count_;
+    group->remaining_.fetch_sub(1, std::memory_order_release);
+    pending_count_.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void Scheduler::RunWorker(size_t index) {
+    worker_index_ = index;
+    Heap::SetAllocationBuffer(&workers_[index]->objects);
+    while (true) {
+        {
+            std::unique_lock lock(section_mutex_);
+            section_changed_.wait(lock, [this] {
+                return is_section_active_.load(std::memory_order_relaxed) || is_stopping_;
+            });
+            if (is_stopping_) {
+                return;
+            }
+            ++workers_in_section_;
+        }
+        // the wait doesn't end while a worker is in the section, so the worker never takes
+        // the tasks of the next one
+        while (is_section_active_.load(std::memory_order_acquire)) {
+            if (!RunNextTask()) {
+                std::this_thread::yield();
+            }
+        }
+        {
+            std::lock_guard lock(section_mutex_);
+            --workers_in_section_;
+        }
+        section_changed_.notify_all();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Helper functions
+
+// An escape can't leave the thread of its task
+static ObjectPtr ApplyInTask(ObjectPtr function, ObjectPtrSpan arguments) {
+    ObjectPtr result = function->Apply(arguments);
+    if (IsEscaping(result)) {
+        EscapeProcedure::FinishEscape();
+        throw RuntimeError("Escape from a parallel task is not supported.");
+    }
+    return result;
+}
+
+// Bounds of the chunks [begin, end) of size elements
+static std::vector<std::pair<size_t, size_t>> SplitIntoChunks(size_t size) {
+    size_t chunks_count =
+        std::min(size, Scheduler::Instance().GetThreadsCount() * kChunksPerThread);
+    std::vector<std::pair<size_t, size_t>> chunks;
+    for (size_t i = 0; i < chunks_count; ++i) {
+        chunks.emplace_back(size * i / chunks_count, size * (i + 1) / chunks_count);
+    }
+    return chunks;
+}
+
+static ObjectPtrVector GetListOperand(ObjectPtrSpan arguments, size_t number,
+                                      const std::string& function_name) {
+    if (!IsApplicable(arguments[0])) {
+        throw RuntimeError("First operand for " + function_name + " must be applicable.");
+    } else if (!IsTruthy(CheckIfList(arguments[number]))) {
+        throw RuntimeError("List operand for " + function_name + " must be proper list.");
+    }
+    return ListToVector(arguments[number]);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Future's realization
+
+Future::Future(ObjectPtr thunk) : state_(std::make_shared<FutureState>()) {
+    state_->thunk = thunk;
+    AddDependency(thunk);
+    Scheduler::Instance().Spawn(&state_->group, [state = state_] {
+        if (!state->is_cancelled) {
+            state->value = ApplyInTask(state->thunk, {});
+        }
+    });
+}
+
+Future::~Future() {
+    // the collector runs between sections only, so the task can't be running now
+    state_->is_cancelled = true;
+}
+
+ObjectPtr Future::Touch() {
+    Scheduler::Instance().Wait(&state_->group);
+    return state_->value;
+}
+
+void Future::MarkReferences() {
+    MarkReference(state_->value);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Parallel functions' realization
+
+ObjectPtr FutureFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Future");
+    if (!IsApplicable(arguments[0])) {
+        throw RuntimeError("Operand for future must be applicable.");
+    }
+    return Heap::Instance().Make<Future>(arguments[0]);
+}
+
+ObjectPtr TouchFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Touch");
+    ThrowIfMismatchOperandType<Future>(0, arguments, "Operand for touch must be future.");
+    return As<Future>(arguments[0])->Touch();
+}
+
+ObjectPtr ParallelMapFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(2, arguments, "Pmap");
+    ObjectPtr function = arguments[0];
+    ObjectPtrVector elements = GetListOperand(arguments, 1, "pmap");
+    ObjectPtrVector results(elements.size());
+    TaskGroup group;
+    for (auto [begin, end] : SplitIntoChunks(elements.size())) {
+        Scheduler::Instance().Spawn(&group, [&, begin, end] {
+            for (size_t i = begin; i < end; ++i) {
+                results[i] = ApplyInTask(function, ObjectPtrSpan(&elements[i], 1));
+            }
+        });
+    }
+    Scheduler::Instance().Wait(&group);
+    ObjectPtr list = nullptr;
+    for (auto it = results.rbegin(); it != results.rend(); ++it) {
+        list = Heap::Instance().Make<Cell>(*it, list);
+    }
+    return list;
+}
+
+ObjectPtr ParallelFoldFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(3, arguments, "Pfold");
+    ObjectPtr function = arguments[0];
+    ObjectPtrVector elements = GetListOperand(arguments, 2, "pfold");
+    std::vector<std::pair<size_t, size_t>> chunks = SplitIntoChunks(elements.size());
+    ObjectPtrVector folded(chunks.size());
+    TaskGroup group;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        Scheduler::Instance().Spawn(&group, [&, i] {
+            auto [begin, end] = chunks[i];
+            ObjectPtr accumulated = elements[begin];
+            for (size_t j = begin + 1; j < end; ++j) {
+                std::array<ObjectPtr, 2> call_arguments = {accumulated, elements[j]};
+                accumulated = ApplyInTask(function, call_arguments);
+            }
+            folded[i] = accumulated;
+        });
+    }
+    Scheduler::Instance().Wait(&group);
+    // chunks are folded in order, which gives the sequential result for associative f
+    ObjectPtr accumulated = arguments[1];
+    for (ObjectPtr value : folded) {
+        std::array<ObjectPtr, 2> call_arguments = {accumulated, value};
+        accumulated = function->Apply(call_arguments);
+        if (IsEscaping(accumulated)) {
+            return accumulated;
+        }
+    }
+    return accumulated;
+}
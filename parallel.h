@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "object.h"
+
+// Work-stealing scheduler of parallel evaluation
+// Every thread has a deque of tasks: it takes tasks from the back of its own deque
+// and steals from the front of the others' deques when it runs out of them.
+// Tasks run only while the interpreter's thread waits for some of them (touch, pmap,
+// pfold), and such a wait returns only when every queued task is finished. So tasks
+// never overlap with evaluation on the interpreter's thread, and the collector, which
+// runs between Runs, always finds the workers idle: the end of a wait is the safepoint.
+// Objects made by a task go to the allocation buffer of its thread (see Heap) and are
+// handed over to the heap at the end of the wait, once every worker has left the section.
+// Tasks must not mutate objects shared with other tasks (set!, set-car!, vector-set!,
+// forcing a shared promise): only pure code is safe to run in parallel.
+
+class TaskGroup {
+public:
+    TaskGroup() = default;
+
+    bool IsFinished() const {
+        return remaining_.load(std::memory_order_acquire) == 0;
+    }
+
+    // Rethrows the first exception of the group's tasks
+    void RethrowIfFailed();
+
+private:
+    friend class Scheduler;
+
+    std::atomic<size_t> remaining_ = 0;
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+};
+
+class Scheduler {
+public:
+    using Task = std::function<void()>;
+
+    static Scheduler& Instance() {
+        static Scheduler scheduler;
+        return scheduler;
+    }
+
+    ~Scheduler();
+
+    // Queues the task to the deque of the calling thread
+    void Spawn(TaskGroup* group, Task task);
+
+    // Runs tasks until the group is finished, then rethrows its first exception.
+    // On the interpreter's thread it runs all the queued tasks, not just the group's.
+    void Wait(TaskGroup* group);
+
+    // Threads tasks are spread across, the interpreter's one included
+    size_t GetThreadsCount() const {
+        return workers_.size();
+    }
+
+    // true inside a task, where calls must not touch state shared between threads
+    static bool IsRunningTask() {
+        return running_tasks_count_ > 0;
+    }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::pair<TaskGroup*, Task>> tasks;
+        // allocation buffer, unused by the interpreter's thread
+        ObjectPtrVector objects;
+        std::thread thread;
+    };
+
+    Scheduler();
+
+    bool RunNextTask();
+    void RunWorker(size_t index);
+
+    // workers_[0] is the interpreter's thread
+    std::vector<std::unique_ptr<Worker>> workers_;
+    // queued and running tasks
+    std::atomic<size_t> pending_count_ = 0;
+    std::mutex section_mutex_;
+    std::condition_variable section_changed_;
+    std::atomic<bool> is_section_active_ = false;
+    // workers which may still take tasks, the section ends once they all leave it
+    size_t workers_in_section_ = 0;
+    bool is_stopping_ = false;
+
+    inline static thread_local size_t worker_index_ = 0;
+    inline static thread_local size_t running_tasks_count_ = 0;
+};
+
+// State of a future shared with its task, the task is skipped if the future is collected
+// before it runs
+struct FutureState {
+    ObjectPtr thunk = nullptr;
+    ObjectPtr value = nullptr;
+    TaskGroup group;
+    bool is_cancelled = false;
+};
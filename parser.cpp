@@ -1,70 +1,146 @@
 #include "parser.h"
 
-ObjectPtr Read(Tokenizer* tokenizer) {
-    if (tokenizer->IsEnd()) {
-        throw SyntaxError("No tokens to read.");
-    }
-    Token next = tokenizer->GetToken();
-    tokenizer->Next();
+// A list, vector or quote whose elements are being read
+struct ReadFrame {
+    enum class Kind { LIST, VECTOR, QUOTE };
+
+    Kind kind = Kind::LIST;
+    ObjectPtrVector elements = {};
+    // the datum after the dot of a list
+    ObjectPtr tail = nullptr;
+    bool is_after_dot = false;
+};
+
+static ObjectPtr MakeAtom(const Token& token) {
     auto& heap_ref = Heap::Instance();
-    size_t index_of_cur_token = next.index();
-    if (index_of_cur_token == BRACKET_TOKEN) {
-        if (std::get<BracketToken>(next) == BracketToken::CLOSE) {
-            throw SyntaxError("Close bracket in the start of the expression.");
-        }
-        Cell* list_ptr = ReadList(tokenizer);
-        if (!AtCloseBracket(tokenizer)) {
-            throw SyntaxError("Wrong syntax! Not enough close brackets.");
-        }
-        tokenizer->Next();
-        return list_ptr;
-    } else if (index_of_cur_token == CONSTANT_TOKEN) {
-        return heap_ref.Make<Number>(std::get<ConstantToken>(next));
-    } else if (index_of_cur_token == SYMBOL_TOKEN) {
-        return SpecifySymbolObject(std::get<SymbolToken>(next));
-    } else if (index_of_cur_token == QUOTE_TOKEN) {
-        if (tokenizer->IsEnd()) {
-            throw SyntaxError("Wrong syntax for quote.");
-        }
-        return heap_ref.Make<Cell>(heap_ref.Make<Symbol>("quote"),
-                                   heap_ref.Make<Cell>(Read(tokenizer), nullptr));
-    } else if (index_of_cur_token == DOT_TOKEN) {
+    size_t index_of_token = token.index();
+    if (index_of_token == CONSTANT_TOKEN) {
+        return heap_ref.Make<Number>(std::get<ConstantToken>(token));
+    } else if (index_of_token == BIG_CONSTANT_TOKEN) {
+        return heap_ref.Make<BigNumber>(BigInteger(std::get<BigConstantToken>(token).digits));
+    } else if (index_of_token == FLOAT_CONSTANT_TOKEN) {
+        return heap_ref.Make<FloatNumber>(std::get<FloatConstantToken>(token));
+    } else if (index_of_token == STRING_TOKEN) {
+        return heap_ref.Make<String>(std::get<StringToken>(token));
+    } else if (index_of_token == SYMBOL_TOKEN) {
+        return SpecifySymbolObject(std::get<SymbolToken>(token));
+    } else if (index_of_token == DOT_TOKEN) {
         throw SyntaxError("Wrong syntax! Probably dot in a wrong place.");
     } else {
         throw SyntaxError("Wrong syntax!");
     }
 }
 
-bool AtCloseBracket(Tokenizer* tokenizer) {
-    if (tokenizer->GetToken().index() == BRACKET_TOKEN) {
-        return (std::get<BracketToken>(tokenizer->GetToken()) == BracketToken::CLOSE);
+// Looks at the token after an element of the frame: skips the dot of a dotted list,
+// and the close bracket if it ends the frame
+static bool IsFrameFinished(Tokenizer* tokenizer, ReadFrame* frame) {
+    if (tokenizer->IsEnd()) {
+        throw SyntaxError("Wrong syntax! Not enough close brackets.");
+    }
+    if (AtCloseBracket(tokenizer)) {
+        tokenizer->Next();
+        return true;
+    }
+    if (frame->is_after_dot) {
+        throw SyntaxError("Wrong syntax! Not enough close brackets.");
+    }
+    if (tokenizer->GetToken().index() == DOT_TOKEN) {
+        if (frame->kind == ReadFrame::Kind::VECTOR) {
+            throw SyntaxError("Wrong syntax! Dot in a vector literal.");
+        } else if (frame->elements.empty()) {
+            throw SyntaxError("Wrong syntax! Probably dot in a wrong place.");
+        }
+        tokenizer->Next();
+        frame->is_after_dot = true;
     }
     return false;
 }
 
-Cell* ReadList(Tokenizer* tokenizer) {
-    if (AtCloseBracket(tokenizer)) {
-        return nullptr;
+static ObjectPtr MakeDatum(const ReadFrame& frame) {
+    if (frame.kind == ReadFrame::Kind::VECTOR) {
+        return Heap::Instance().Make<Vector>(frame.elements);
     }
-    ObjectPtr first_elem = Read(tokenizer);
-    Token cur_token = tokenizer->GetToken();
-    if (cur_token.index() == BRACKET_TOKEN) {
-        if (std::get<BracketToken>(cur_token) == BracketToken::CLOSE) {
-            return Heap::Instance().Make<Cell>(first_elem, nullptr);
-        }
+    ObjectPtr list = frame.tail;
+    for (auto it = frame.elements.rbegin(); it != frame.elements.rend(); ++it) {
+        list = Heap::Instance().Make<Cell>(*it, list);
     }
-    if (cur_token.index() == DOT_TOKEN) {
+    return list;
+}
+
+ObjectPtr Read(Tokenizer* tokenizer, size_t max_depth) {
+    auto& heap_ref = Heap::Instance();
+    std::vector<ReadFrame> frames;
+    while (true) {
+        if (tokenizer->IsEnd()) {
+            throw SyntaxError(frames.empty() ? "No tokens to read."
+                                             : "Wrong syntax! Not enough close brackets.");
+        }
+        Token next = tokenizer->GetToken();
         tokenizer->Next();
-        return Heap::Instance().Make<Cell>(first_elem, Read(tokenizer));
-    } else {
-        return Heap::Instance().Make<Cell>(first_elem, ReadList(tokenizer));
+        size_t index_of_cur_token = next.index();
+        ObjectPtr datum = nullptr;
+        if (index_of_cur_token == BRACKET_TOKEN || index_of_cur_token == VECTOR_OPEN_TOKEN ||
+            index_of_cur_token == QUOTE_TOKEN) {
+            if (index_of_cur_token == BRACKET_TOKEN &&
+                std::get<BracketToken>(next) == BracketToken::CLOSE) {
+                throw SyntaxError("Close bracket in the start of the expression.");
+            } else if (frames.size() == max_depth) {
+                throw SyntaxError("Expression is nested too deep.");
+            }
+            if (index_of_cur_token == QUOTE_TOKEN) {
+                if (tokenizer->IsEnd()) {
+                    throw SyntaxError("Wrong syntax for quote.");
+                }
+                frames.push_back({ReadFrame::Kind::QUOTE});
+                continue;
+            }
+            frames.push_back({(index_of_cur_token == BRACKET_TOKEN) ? ReadFrame::Kind::LIST
+                                                                    : ReadFrame::Kind::VECTOR});
+            if (!IsFrameFinished(tokenizer, &frames.back())) {
+                continue;
+            }
+            datum = MakeDatum(frames.back());
+            frames.pop_back();
+        } else {
+            datum = MakeAtom(next);
+        }
+
+        // the datum may finish the frames on the top of the stack
+        while (true) {
+            if (frames.empty()) {
+                return datum;
+            }
+            ReadFrame& frame = frames.back();
+            if (frame.kind == ReadFrame::Kind::QUOTE) {
+                datum = heap_ref.Make<Cell>(heap_ref.Make<Symbol>(kQuoteSymbolName),
+                                            heap_ref.Make<Cell>(datum, nullptr));
+            } else {
+                if (frame.is_after_dot) {
+                    frame.tail = datum;
+                } else {
+                    frame.elements.push_back(datum);
+                }
+                if (!IsFrameFinished(tokenizer, &frame)) {
+                    break;
+                }
+                datum = MakeDatum(frame);
+            }
+            frames.pop_back();
+        }
     }
 }
 
+bool AtCloseBracket(Tokenizer* tokenizer) {
+    if (tokenizer->GetToken().index() == BRACKET_TOKEN) {
+        return (std::get<BracketToken>(tokenizer->GetToken()) == BracketToken::CLOSE);
+    }
+    return false;
+}
+
 ObjectPtr SpecifySymbolObject(const SymbolToken& symbol_token) {
-    std::string symbol_name = symbol_token.GetName();
+    std::string_view symbol_name = symbol_token.GetName();
     if (symbol_name == kFalseTokenName || symbol_name == kTrueTokenName) {
-        return Heap::Instance().Make<BooleanSymbol>(symbol_name);
+        return GetBooleanSymbol(symbol_name == kTrueTokenName);
     }
     return Heap::Instance().Make<Symbol>(symbol_name);
 }
\ No newline at end of file
@@ -12,6 +12,10 @@ enum TokenNames : size_t {
     SYMBOL_TOKEN,
     QUOTE_TOKEN,
     DOT_TOKEN,
+    BIG_CONSTANT_TOKEN,
+    FLOAT_CONSTANT_TOKEN,
+    VECTOR_OPEN_TOKEN,
+    STRING_TOKEN,
 };
 
 const std::string kQuoteSymbolName = "quote";
@@ -26,6 +30,11 @@ Object* SpecifySymbolObject(const SymbolToken& symbol_token);
 
 // Parser functions
 
-Object* Read(Tokenizer* tokenizer);
-Cell* ReadList(Tokenizer* tokenizer);
+// Lists, vectors and quotes may be nested at most this deep
+const size_t kDefaultMaxReadDepth = 10000;
+
+// Reads one datum. Unfinished lists are kept on an explicit stack, so neither the length
+// of a list nor the nesting takes native stack; deeper nesting than max_depth is
+// a SyntaxError.
+Object* Read(Tokenizer* tokenizer, size_t max_depth = kDefaultMaxReadDepth);
 bool AtCloseBracket(Tokenizer* tokenizer);
\ No newline at end of file
@@ -0,0 +1,87 @@
+// scheme_tidy_repl [file]
+// With a file evaluates it as a program and prints the value of its last form,
+// otherwise reads forms from the standard input and prints the value of each of them.
+
+#include <iostream>
+#include <string>
+
+#include <scheme.h>
+
+// Brackets opened and not closed yet by the line, brackets inside strings are skipped
+static int64_t CountOpenBrackets(const std::string& line, bool* is_in_string) {
+    int64_t balance = 0;
+    for (size_t i = 0; i < line.size(); ++i) {
+        if (*is_in_string) {
+            if (line[i] == BackslashChar) {
+                ++i;
+            } else if (line[i] == DoubleQuoteChar) {
+                *is_in_string = false;
+            }
+        } else if (line[i] == DoubleQuoteChar) {
+            *is_in_string = true;
+        } else if (IsOpenBracket(line[i])) {
+            ++balance;
+        } else if (IsCloseBracket(line[i])) {
+            --balance;
+        }
+    }
+    return balance;
+}
+
+static void PrintError(const std::exception& error) {
+    std::cerr << "Error: " << error.what() << "\n";
+}
+
+static int RunFile(Interpreter* interpreter, const std::string& path) {
+    try {
+        std::cout << interpreter->RunFile(path) << "\n";
+    } catch (const std::exception& error) {
+        PrintError(error);
+        return 1;
+    }
+    return 0;
+}
+
+// The reader looks one token past a form, so the input is passed to the interpreter
+// by whole lines once their brackets are balanced
+static int RunInteractive(Interpreter* interpreter) {
+    std::string forms;
+    std::string line;
+    int64_t open_brackets = 0;
+    bool is_in_string = false;
+    std::cout << "$ " << std::flush;
+    while (std::getline(std::cin, line)) {
+        forms += line;
+        forms += '\n';
+        open_brackets += CountOpenBrackets(line, &is_in_string);
+        if (open_brackets > 0 || is_in_string) {
+            continue;
+        }
+        for (const BatchResult& result : interpreter->RunForms(forms)) {
+            try {
+                if (result.error) {
+                    std::rethrow_exception(result.error);
+                }
+                std::cout << "> " << result.value << "\n";
+            } catch (const std::exception& error) {
+                PrintError(error);
+            }
+        }
+        forms.clear();
+        open_brackets = 0;
+        std::cout << "$ " << std::flush;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Interpreter interpreter;
+    if (argc > 2) {
+        std::cerr << "Usage: " << argv[0] << " [file]\n";
+        return 2;
+    }
+    if (argc == 2) {
+        return RunFile(&interpreter, argv[1]);
+    }
+    return RunInteractive(&interpreter);
+}
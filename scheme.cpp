@@ -1,21 +1,239 @@
 #include "scheme.h"
 
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "image.h"
+
+// A batch collects garbage when the heap has grown this many times since the last collection,
+// so that the cost of marking is amortized over the allocations
+constexpr size_t kBatchHeapGrowthFactor = 2;
+
+// ... but not before it has this many objects
+constexpr size_t kMinBatchCollectedObjects = 1 << 16;
+
+// Read-only mapping of a whole file, the tokenizer reads it without copying
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int descriptor = open(path.c_str(), O_RDONLY);
+        struct stat file_stat;
+        if (descriptor < 0 || fstat(descriptor, &file_stat) != 0) {
+            if (descriptor >= 0) {
+                close(descriptor);
+            }
+            throw RuntimeError("Can't open file " + path + ".");
+        }
+        size_ = file_stat.st_size;
+        if (size_ > 0) {
+            data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        }
+        close(descriptor);
+        if (data_ == MAP_FAILED) {
+            throw RuntimeError("Can't read file " + path + ".");
+        }
+        if (data_) {
+            // the forms are read once from the start to the end
+            madvise(data_, size_, MADV_SEQUENTIAL);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (data_) {
+            munmap(data_, size_);
+        }
+    }
+
+    std::string_view GetContents() const {
+        return {static_cast<const char*>(data_), size_};
+    }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
+
 std::string Interpreter::Run(const std::string& expression) {
-    std::stringstream expression_stream{expression};
-    Tokenizer tokenizer{&expression_stream};
-    ObjectPtr ast = Read(&tokenizer);
+    if (run_cache_capacity_ > 0) {
+        return ExecuteForm(GetCachedForm(expression));
+    }
+    Tokenizer tokenizer{expression};
+    ObjectPtr ast = AnalyzeForm(Read(&tokenizer, max_read_depth_));
     if (!tokenizer.IsEnd()) {
         throw SyntaxError("Wrong syntax!");
     }
-    ObjectPtr evaluated_ast = EvaluateExpression(ast, context_);
-    std::string serialized_result = SerializeAST(evaluated_ast);
+    std::string serialized_result = EvaluateForm(ast);
     Heap::Instance().MarkAndSweep();
     return serialized_result;
 }
 
+PreparedExpression Interpreter::Prepare(const std::string& expression) {
+    PreparedForm* form = ReadForm(expression);
+    form->SetAST(AnalyzeForm(form->GetDatum()), optimization_level_);
+    return PreparedExpression{form};
+}
+
+std::string Interpreter::Execute(const PreparedExpression& expression) {
+    if (!expression.form_) {
+        throw RuntimeError("Expression isn't prepared.");
+    }
+    return ExecuteForm(expression.form_);
+}
+
+void Interpreter::SetRunCacheCapacity(size_t capacity) {
+    run_cache_capacity_ = capacity;
+    while (run_cache_.size() > capacity) {
+        run_cache_index_.erase(run_cache_.back().expression);
+        run_cache_.pop_back();
+    }
+}
+
+PreparedForm* Interpreter::ReadForm(const std::string& expression) {
+    Tokenizer tokenizer{expression};
+    ObjectPtr datum = Read(&tokenizer, max_read_depth_);
+    if (!tokenizer.IsEnd()) {
+        throw SyntaxError("Wrong syntax!");
+    }
+    return Heap::Instance().Make<PreparedForm>(datum);
+}
+
+PreparedForm* Interpreter::GetCachedForm(const std::string& expression) {
+    auto found = run_cache_index_.find(expression);
+    if (found != run_cache_index_.end()) {
+        run_cache_.splice(run_cache_.begin(), run_cache_, found->second);
+        return found->second->prepared.form_;
+    }
+    // a form which can't be read isn't cached
+    PreparedForm* form = ReadForm(expression);
+    if (run_cache_.size() == run_cache_capacity_) {
+        run_cache_index_.erase(run_cache_.back().expression);
+        run_cache_.pop_back();
+    }
+    run_cache_.push_front({expression, PreparedExpression{form}});
+    run_cache_index_.emplace(run_cache_.front().expression, run_cache_.begin());
+    return form;
+}
+
+// Forms are analyzed on their first evaluation, so a cached form fails the same way
+// as a fresh one if its analysis throws. Pinned forms are marked by every collection,
+// so garbage is collected only when the heap has grown, like in RunBatch.
+std::string Interpreter::ExecuteForm(PreparedForm* form) {
+    if (!form->IsAnalyzed(optimization_level_)) {
+        form->SetAST(AnalyzeForm(form->GetDatum()), optimization_level_);
+    }
+    std::string serialized_result = EvaluateForm(form->GetAST());
+    CollectIfGrown(&live_objects_count_);
+    return serialized_result;
+}
+
+std::vector<BatchResult> Interpreter::RunBatch(const std::vector<std::string>& expressions) {
+    std::vector<BatchResult> results;
+    results.reserve(expressions.size());
+    size_t live_objects_count = Heap::Instance().GetObjectsCount();
+    for (const std::string& expression : expressions) {
+        try {
+            Tokenizer tokenizer{expression};
+            ObjectPtr ast = AnalyzeForm(Read(&tokenizer, max_read_depth_));
+            if (!tokenizer.IsEnd()) {
+                throw SyntaxError("Wrong syntax!");
+            }
+            results.push_back({EvaluateForm(ast), nullptr});
+        } catch (...) {
+            results.push_back({"", std::current_exception()});
+        }
+        CollectIfGrown(&live_objects_count);
+    }
+    Heap::Instance().MarkAndSweep();
+    return results;
+}
+
+std::vector<BatchResult> Interpreter::RunForms(const std::string& forms) {
+    std::vector<BatchResult> results;
+    size_t live_objects_count = Heap::Instance().GetObjectsCount();
+    try {
+        Tokenizer tokenizer{forms};
+        while (!tokenizer.IsEnd()) {
+            ObjectPtr form = Read(&tokenizer, max_read_depth_);
+            try {
+                results.push_back({EvaluateForm(AnalyzeForm(form)), nullptr});
+            } catch (...) {
+                results.push_back({"", std::current_exception()});
+            }
+            CollectIfGrown(&live_objects_count);
+        }
+    } catch (...) {
+        results.push_back({"", std::current_exception()});
+    }
+    Heap::Instance().MarkAndSweep();
+    return results;
+}
+
+std::string Interpreter::RunProgram(std::istream& program) {
+    Tokenizer tokenizer{&program};
+    return RunProgram(&tokenizer);
+}
+
+std::string Interpreter::RunFile(const std::string& path) {
+    MappedFile file{path};
+    Tokenizer tokenizer{file.GetContents()};
+    return RunProgram(&tokenizer);
+}
+
+void Interpreter::SaveImage(const std::string& path) {
+    std::string image = MakeImage(context_);
+    std::ofstream file{path, std::ios::binary};
+    if (!file.write(image.data(), image.size()) || !file.flush()) {
+        throw RuntimeError("Can't write file " + path + ".");
+    }
+}
+
+void Interpreter::LoadImage(const std::string& path) {
+    MappedFile file{path};
+    RestoreImage(file.GetContents(), context_);
+    // contexts of the image are copied by the closures made of them
+    Heap::Instance().MarkAndSweep();
+}
+
+std::string Interpreter::RunProgram(Tokenizer* tokenizer) {
+    std::string serialized_result = kEmptyListString;
+    size_t live_objects_count = Heap::Instance().GetObjectsCount();
+    while (!tokenizer->IsEnd()) {
+        serialized_result = EvaluateForm(AnalyzeForm(Read(tokenizer, max_read_depth_)));
+        CollectIfGrown(&live_objects_count);
+    }
+    Heap::Instance().MarkAndSweep();
+    return serialized_result;
+}
+
+ObjectPtr Interpreter::AnalyzeForm(ObjectPtr form) {
+    Optimizer optimizer{context_, optimization_level_};
+    return optimizer.Optimize(Analyze(form, context_));
+}
+
+std::string Interpreter::EvaluateForm(ObjectPtr ast) {
+    return SerializeAST(EvaluateExpression(ast, context_));
+}
+
+void Interpreter::CollectIfGrown(size_t* live_objects_count) {
+    size_t objects_count = Heap::Instance().GetObjectsCount();
+    if (objects_count < kMinBatchCollectedObjects ||
+        objects_count < *live_objects_count * kBatchHeapGrowthFactor) {
+        return;
+    }
+    Heap::Instance().MarkAndSweep();
+    *live_objects_count = Heap::Instance().GetObjectsCount();
+}
+
 std::string Interpreter::SerializeAST(ObjectPtr ast) {
     if (!ast) {
         return kEmptyListString;
     }
     return ast->Serialize();
-}
\ No newline at end of file
+}
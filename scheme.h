@@ -1,8 +1,96 @@
 #pragma once
 
+#include <exception>
+#include <list>
 #include <sstream>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include "parser.h"
+#include "analyzer.h"
+#include "optimizer.h"
+
+// Result of one expression of a batch: its serialized value or the exception it has thrown
+struct BatchResult {
+    std::string value;
+    std::exception_ptr error;
+};
+
+// A read form together with its syntax tree. The tree is built again from the datum
+// when macros have changed or the optimization level is another one since the analysis.
+
+class PreparedForm : public Object {
+public:
+    explicit PreparedForm(ObjectPtr datum) : datum_(datum) {
+    }
+
+    ObjectPtr GetDatum() const {
+        return datum_;
+    }
+
+    bool IsAnalyzed(OptimizationLevel level) const {
+        return is_analyzed_ && syntax_epoch_ == GetSyntaxEpoch() && level_ == level;
+    }
+
+    ObjectPtr GetAST() const {
+        return ast_;
+    }
+
+    void SetAST(ObjectPtr ast, OptimizationLevel level) {
+        ast_ = ast;
+        level_ = level;
+        syntax_epoch_ = GetSyntaxEpoch();
+        is_analyzed_ = true;
+    }
+
+protected:
+    void MarkReferences() override {
+        MarkReference(datum_);
+        MarkReference(ast_);
+    }
+
+private:
+    ObjectPtr datum_;
+    ObjectPtr ast_ = nullptr;
+    OptimizationLevel level_ = kDefaultOptimizationLevel;
+    uint64_t syntax_epoch_ = 0;
+    bool is_analyzed_ = false;
+};
+
+// Handle of a form made by Interpreter::Prepare, the form is pinned in the heap
+// until the handle is destroyed
+
+class PreparedExpression {
+public:
+    PreparedExpression() = default;
+
+    PreparedExpression(const PreparedExpression&) = delete;
+    PreparedExpression& operator=(const PreparedExpression&) = delete;
+
+    PreparedExpression(PreparedExpression&& other) : form_(std::exchange(other.form_, nullptr)) {
+    }
+
+    PreparedExpression& operator=(PreparedExpression&& other) {
+        std::swap(form_, other.form_);
+        return *this;
+    }
+
+    ~PreparedExpression() {
+        if (form_) {
+            Heap::Instance().Unpin(form_);
+        }
+    }
+
+private:
+    friend class Interpreter;
+
+    explicit PreparedExpression(PreparedForm* form) : form_(form) {
+        Heap::Instance().Pin(form_);
+    }
+
+    PreparedForm* form_ = nullptr;
+};
 
 class Interpreter {
 public:
@@ -14,7 +102,70 @@ public:
     }
     std::string Run(const std::string& expression);
 
+    // Reads and analyzes the expression once, so that Execute evaluates it at once
+    // as many times as needed. Macros are expanded by the definitions at hand: the form
+    // is analyzed again by Execute after a macro is defined or its name is rebound.
+    // Execute collects garbage only when the heap has grown enough, like RunBatch.
+    PreparedExpression Prepare(const std::string& expression);
+    std::string Execute(const PreparedExpression& expression);
+
+    // Run keeps the forms of this many last expressions and evaluates an expression
+    // with the same text without reading it again, like Execute. 0 (by default) turns
+    // the cache off.
+    void SetRunCacheCapacity(size_t capacity);
+
+    // Evaluates the expressions in order, an error of one of them doesn't stop the batch.
+    // Garbage is collected only when the heap has grown enough, and once at the end.
+    std::vector<BatchResult> RunBatch(const std::vector<std::string>& expressions);
+
+    // Evaluates every form of the buffer in order, like RunBatch. The reader can't
+    // recover from a broken form, so a syntax error of reading ends the batch.
+    std::vector<BatchResult> RunForms(const std::string& forms);
+
+    // Reads and evaluates the program's top-level forms one at a time, so that only the
+    // current form is kept in memory. Returns the value of the last form, the first error
+    // stops the program. Garbage is collected between forms like in RunBatch.
+    std::string RunProgram(std::istream& program);
+    // The file is mapped to memory and read without copying
+    std::string RunFile(const std::string& path);
+
+    // Saves the global names with everything reachable from them to an image file
+    // (see image.h), so that another interpreter restores them by LoadImage at once
+    // instead of evaluating the forms which have made them
+    void SaveImage(const std::string& path);
+    void LoadImage(const std::string& path);
+
+    void SetOptimizationLevel(OptimizationLevel level) {
+        optimization_level_ = level;
+    }
+
+    // Forms nested deeper than this are rejected with a SyntaxError when they are read
+    void SetMaxReadDepth(size_t max_depth) {
+        max_read_depth_ = max_depth;
+    }
+
 private:
+    struct RunCacheEntry {
+        std::string expression;
+        PreparedExpression prepared;
+    };
+    using RunCacheEntries = std::list<RunCacheEntry>;
+
+    PreparedForm* ReadForm(const std::string& expression);
+    PreparedForm* GetCachedForm(const std::string& expression);
+    std::string ExecuteForm(PreparedForm* form);
+    std::string RunProgram(Tokenizer* tokenizer);
+    ObjectPtr AnalyzeForm(ObjectPtr form);
+    std::string EvaluateForm(ObjectPtr ast);
+    void CollectIfGrown(size_t* live_objects_count);
     std::string SerializeAST(ObjectPtr);
     ContextPtr context_;
+    OptimizationLevel optimization_level_ = kDefaultOptimizationLevel;
+    size_t max_read_depth_ = kDefaultMaxReadDepth;
+    size_t run_cache_capacity_ = 0;
+    // objects left by the last collection of Execute
+    size_t live_objects_count_ = 0;
+    // the most recently used entry goes first, keys of the index view texts of entries
+    RunCacheEntries run_cache_;
+    std::unordered_map<std::string_view, RunCacheEntries::iterator> run_cache_index_;
 };
@@ -1,10 +1,22 @@
 add_library(scheme_tidy
+        symbol_table.cpp
         tokenizer.cpp
+        char_kernels.cpp
         parser.cpp
         scheme.cpp
         useful_char_functions.cpp
         object.cpp
         helper_functions.cpp
+        hash_table.cpp
+        bignum.cpp
+        numeric_kernels.cpp
+        analyzer.cpp
+        macro.cpp
+        stream.cpp
+        parallel.cpp
+        optimizer.cpp
+        jit.cpp
+        image.cpp
 
         # maybe more .cpp files here
 )
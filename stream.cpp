@@ -0,0 +1,322 @@
+#include "stream.h"
+
+#include <array>
+#include <limits>
+
+// StreamGenerator's realization
+
+bool StreamGenerator::Next(ObjectPtr* value) {
+    if (is_running_) {
+        throw RuntimeError("Stream is forced while computing its own element.");
+    } else if (has_escaped_) {
+        throw RuntimeError("Stream was left by an escape while computing its element.");
+    }
+    auto& promise = handle_.promise();
+    if (!handle_.done()) {
+        is_running_ = true;
+        handle_.resume();
+        is_running_ = false;
+        if (handle_.done()) {
+            // the locals the roots point to are gone with the coroutine body
+            promise.roots.clear();
+        }
+    }
+    if (promise.exception) {
+        std::rethrow_exception(promise.exception);
+    } else if (handle_.done()) {
+        return false;
+    }
+    *value = promise.current;
+    has_escaped_ = IsEscaping(*value);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Promise's realization
+
+Promise::Promise(ObjectPtr expression, ContextPtr context) : expression_(expression) {
+    context_ = Heap::Instance().Make<Context>(*context);
+    AddDependency(expression);
+    AddDependency(context_);
+}
+
+ObjectPtr Promise::Force() {
+    if (is_forced_) {
+        return value_;
+    }
+    ObjectPtr value = nullptr;
+    if (generator_) {
+        ObjectPtr element = nullptr;
+        if (generator_->Next(&element)) {
+            if (IsEscaping(element)) {
+                return element;
+            }
+            auto& heap_ref = Heap::Instance();
+            value = heap_ref.Make<Cell>(element, heap_ref.Make<Promise>(generator_));
+        }
+        generator_.reset();
+    } else {
+        value = EvaluateExpression(expression_, context_);
+        if (IsEscaping(value)) {
+            return value;
+        } else if (is_forced_) {
+            // the expression has forced this promise itself, the first value stays
+            return value_;
+        }
+        RemoveDependency(expression_);
+        RemoveDependency(context_);
+        expression_ = nullptr;
+        context_ = nullptr;
+    }
+    value_ = value;
+    AddDependency(value);
+    is_forced_ = true;
+    return value_;
+}
+
+void Promise::MarkReferences() {
+    if (generator_) {
+        for (ObjectPtr* root : generator_->GetRoots()) {
+            MarkReference(*root);
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Helper functions
+
+static ObjectPtr MakeStream(StreamGenerator generator) {
+    auto shared_generator = std::make_shared<StreamGenerator>(std::move(generator));
+    return Heap::Instance().Make<Promise>(std::move(shared_generator))->Force();
+}
+
+static Cell* GetStreamPair(ObjectPtr stream, const std::string& function_name) {
+    auto cell = As<Cell>(stream);
+    if (!cell || !Is<Promise>(cell->GetSecond())) {
+        throw RuntimeError("Operand for " + function_name + " must be stream pair.");
+    }
+    return cell;
+}
+
+static void ThrowIfNotStream(ObjectPtr stream, const std::string& message) {
+    if (stream && (!Is<Cell>(stream) || !Is<Promise>(As<Cell>(stream)->GetSecond()))) {
+        throw RuntimeError(message);
+    }
+}
+
+// The rest of a stream pair, kEscapeMarker if forcing it escapes
+static ObjectPtr GetStreamRest(ObjectPtr stream, const std::string& function_name) {
+    ObjectPtr rest = As<Promise>(GetStreamPair(stream, function_name)->GetSecond())->Force();
+    if (!IsEscaping(rest)) {
+        ThrowIfNotStream(rest, "Promise in cdr of stream must give stream.");
+    }
+    return rest;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Stream producers
+// An escape from a function they apply is yielded as is, such producer is never resumed.
+
+static StreamGenerator GenerateRange(int64_t first, int64_t past, int64_t step,
+                                     bool is_infinite) {
+    for (int64_t value = first; is_infinite || (step > 0 ? value < past : value > past);) {
+        co_yield Heap::Instance().Make<Number>(value);
+        if (__builtin_add_overflow(value, step, &value)) {
+            throw RuntimeError("Stream of numbers overflowed.");
+        }
+    }
+}
+
+static StreamGenerator GenerateMap(ObjectPtr function, ObjectPtr stream) {
+    co_await TrackRoots(&function, &stream);
+    while (stream) {
+        ObjectPtr element = As<Cell>(stream)->GetFirst();
+        co_yield function->Apply(ObjectPtrSpan(&element, 1));
+        stream = GetStreamRest(stream, "stream-map");
+        if (IsEscaping(stream)) {
+            co_yield stream;
+        }
+    }
+}
+
+static StreamGenerator GenerateFilter(ObjectPtr predicate, ObjectPtr stream) {
+    co_await TrackRoots(&predicate, &stream);
+    while (stream) {
+        ObjectPtr element = As<Cell>(stream)->GetFirst();
+        ObjectPtr result = predicate->Apply(ObjectPtrSpan(&element, 1));
+        if (IsEscaping(result)) {
+            co_yield result;
+        } else if (IsTruthy(result)) {
+            co_yield element;
+        }
+        stream = GetStreamRest(stream, "stream-filter");
+        if (IsEscaping(stream)) {
+            co_yield stream;
+        }
+    }
+}
+
+static StreamGenerator GenerateTake(int64_t count, ObjectPtr stream) {
+    co_await TrackRoots(&stream);
+    for (int64_t i = 0; i < count && stream; ++i) {
+        co_yield As<Cell>(stream)->GetFirst();
+        // the rest after the last taken element is never forced
+        if (i + 1 < count) {
+            stream = GetStreamRest(stream, "stream-take");
+            if (IsEscaping(stream)) {
+                co_yield stream;
+            }
+        }
+    }
+}
+
+static StreamGenerator GenerateList(ObjectPtr list) {
+    co_await TrackRoots(&list);
+    for (; list; list = As<Cell>(list)->GetSecond()) {
+        co_yield As<Cell>(list)->GetFirst();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Promise and stream functions' realization
+
+ObjectPtr ForceFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Force");
+    // forcing anything but a promise gives the object itself
+    auto promise = As<Promise>(arguments[0]);
+    return (promise) ? promise->Force() : arguments[0];
+}
+
+ObjectPtr MakePromiseFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Make-promise");
+    if (Is<Promise>(arguments[0])) {
+        return arguments[0];
+    }
+    return Heap::Instance().Make<Promise>(arguments[0]);
+}
+
+ObjectPtr StreamPairPredicateFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Predicate");
+    auto cell = As<Cell>(arguments[0]);
+    return GetBooleanSymbol(cell && Is<Promise>(cell->GetSecond()));
+}
+
+ObjectPtr StreamCarFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Stream-car");
+    return GetStreamPair(arguments[0], "stream-car")->GetFirst();
+}
+
+ObjectPtr StreamCdrFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "Stream-cdr");
+    return GetStreamRest(arguments[0], "stream-cdr");
+}
+
+ObjectPtr StreamRangeFunction::Apply(ObjectPtrSpan arguments) {
+    if (arguments.size() != 2 && arguments.size() != 3) {
+        throw RuntimeError("Wrong number of arguments for stream-range.");
+    }
+    ThrowIfMismatchOperandsType<Number>(arguments, "Operands for stream-range must be numbers.");
+    int64_t step = (arguments.size() == 3) ? As<Number>(arguments[2])->GetValue() : 1;
+    if (step == 0) {
+        throw RuntimeError("Step for stream-range must not be zero.");
+    }
+    return MakeStream(GenerateRange(As<Number>(arguments[0])->GetValue(),
+                                    As<Number>(arguments[1])->GetValue(), step, false));
+}
+
+ObjectPtr StreamFromFunction::Apply(ObjectPtrSpan arguments) {
+    if (arguments.empty() || arguments.size() > 2) {
+        throw RuntimeError("Wrong number of arguments for stream-from.");
+    }
+    ThrowIfMismatchOperandsType<Number>(arguments, "Operands for stream-from must be numbers.");
+    int64_t step = (arguments.size() == 2) ? As<Number>(arguments[1])->GetValue() : 1;
+    return MakeStream(GenerateRange(As<Number>(arguments[0])->GetValue(), 0, step, true));
+}
+
+ObjectPtr StreamMapFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(2, arguments, "Stream-map");
+    if (!arguments[0]) {
+        throw RuntimeError("First operand for stream-map must be applicable.");
+    }
+    ThrowIfNotStream(arguments[1], "Second operand for stream-map must be stream.");
+    return MakeStream(GenerateMap(arguments[0], arguments[1]));
+}
+
+ObjectPtr StreamFilterFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(2, arguments, "Stream-filter");
+    if (!arguments[0]) {
+        throw RuntimeError("First operand for stream-filter must be applicable.");
+    }
+    ThrowIfNotStream(arguments[1], "Second operand for stream-filter must be stream.");
+    return MakeStream(GenerateFilter(arguments[0], arguments[1]));
+}
+
+ObjectPtr StreamTakeFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(2, arguments, "Stream-take");
+    ThrowIfMismatchOperandType<Number>(0, arguments,
+                                       "First operand for stream-take must be number.");
+    ThrowIfNotStream(arguments[1], "Second operand for stream-take must be stream.");
+    return MakeStream(GenerateTake(As<Number>(arguments[0])->GetValue(), arguments[1]));
+}
+
+ObjectPtr ListToStreamFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(1, arguments, "List->stream");
+    if (!IsTruthy(CheckIfList(arguments[0]))) {
+        throw RuntimeError("Operand for list->stream must be proper list.");
+    }
+    return MakeStream(GenerateList(arguments[0]));
+}
+
+ObjectPtr StreamToListFunction::Apply(ObjectPtrSpan arguments) {
+    if (arguments.empty() || arguments.size() > 2) {
+        throw RuntimeError("Wrong number of arguments for stream->list.");
+    }
+    ThrowIfNotStream(arguments[0], "First operand for stream->list must be stream.");
+    int64_t count = std::numeric_limits<int64_t>::max();
+    if (arguments.size() == 2) {
+        ThrowIfMismatchOperandType<Number>(1, arguments,
+                                           "Count for stream->list must be number.");
+        count = As<Number>(arguments[1])->GetValue();
+    }
+    ObjectPtrVector elements;
+    ObjectPtr stream = arguments[0];
+    for (int64_t i = 0; i < count && stream; ++i) {
+        elements.push_back(As<Cell>(stream)->GetFirst());
+        if (i + 1 < count) {
+            stream = GetStreamRest(stream, "stream->list");
+            if (IsEscaping(stream)) {
+                return stream;
+            }
+        }
+    }
+    ObjectPtr list = nullptr;
+    for (auto it = elements.rbegin(); it != elements.rend(); ++it) {
+        list = Heap::Instance().Make<Cell>(*it, list);
+    }
+    return list;
+}
+
+ObjectPtr StreamFoldFunction::Apply(ObjectPtrSpan arguments) {
+    ThrowIfWrongNumberOfArguments(3, arguments, "Stream-fold");
+    if (!arguments[0]) {
+        throw RuntimeError("First operand for stream-fold must be applicable.");
+    }
+    ThrowIfNotStream(arguments[2], "Third operand for stream-fold must be stream.");
+    std::array<ObjectPtr, 2> call_arguments = {arguments[1], nullptr};
+    for (ObjectPtr stream = arguments[2]; stream;) {
+        call_arguments[1] = As<Cell>(stream)->GetFirst();
+        call_arguments[0] = arguments[0]->Apply(call_arguments);
+        if (IsEscaping(call_arguments[0])) {
+            return call_arguments[0];
+        }
+        stream = GetStreamRest(stream, "stream-fold");
+        if (IsEscaping(stream)) {
+            return stream;
+        }
+    }
+    return call_arguments[0];
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+#include "object.h"
+
+// Native stream producers
+// A producer is a C++20 coroutine which co_yields the elements of a stream one by one.
+// Forcing the cdr of a native stream resumes its producer up to the next element,
+// so a pipeline of producers computes only the elements which are consumed and holds
+// no more than its current positions.
+
+// co_await TrackRoots(&local, ...) registers objects kept in the coroutine frame,
+// which the collector can't see otherwise. Only locals of the coroutine's outermost
+// block may be registered, the pointers are followed until the coroutine finishes.
+class TrackRoots {
+public:
+    template <typename... Roots>
+    explicit TrackRoots(Roots... roots) : roots_{roots...} {
+    }
+
+    const std::vector<ObjectPtr*>& GetRoots() const {
+        return roots_;
+    }
+
+private:
+    std::vector<ObjectPtr*> roots_;
+};
+
+class StreamGenerator {
+public:
+    struct promise_type {
+        StreamGenerator get_return_object() {
+            return StreamGenerator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        // nothing is computed before the first element is forced
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_always yield_value(ObjectPtr value) {
+            current = value;
+            return {};
+        }
+
+        std::suspend_never await_transform(const TrackRoots& track) {
+            roots.insert(roots.end(), track.GetRoots().begin(), track.GetRoots().end());
+            return {};
+        }
+
+        void return_void() {
+        }
+
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+
+        ObjectPtr current = nullptr;
+        std::vector<ObjectPtr*> roots;
+        std::exception_ptr exception;
+    };
+
+    StreamGenerator(StreamGenerator&& other) noexcept
+        : handle_(std::exchange(other.handle_, nullptr)) {
+    }
+
+    StreamGenerator(const StreamGenerator&) = delete;
+    StreamGenerator& operator=(const StreamGenerator&) = delete;
+    StreamGenerator& operator=(StreamGenerator&&) = delete;
+
+    ~StreamGenerator() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    // Resumes the producer up to its next element, false when it has finished.
+    // An exception of the producer is rethrown by this and every following call.
+    bool Next(ObjectPtr* value);
+
+    const std::vector<ObjectPtr*>& GetRoots() const {
+        return handle_.promise().roots;
+    }
+
+private:
+    explicit StreamGenerator(std::coroutine_handle<promise_type> handle) : handle_(handle) {
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+    bool is_running_ = false;
+    // the producer yielded an escape marker, its frame was left mid-element
+    bool has_escaped_ = false;
+};
@@ -0,0 +1,26 @@
+#include "symbol_table.h"
+
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+
+// Lets the table be searched by a string_view
+struct NameHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view name) const {
+        return std::hash<std::string_view>{}(name);
+    }
+};
+
+const std::string& InternSymbolName(std::string_view name) {
+    // nodes of unordered_set are never moved, so the references stay valid
+    static std::unordered_set<std::string, NameHash, std::equal_to<>> names;
+    static std::mutex mutex;
+    std::lock_guard lock(mutex);
+    auto it = names.find(name);
+    if (it == names.end()) {
+        it = names.emplace(name).first;
+    }
+    return *it;
+}
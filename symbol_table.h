@@ -0,0 +1,9 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+// Every name of a symbol is stored once and never freed, so symbols keep just a pointer to it,
+// and a name read from a source buffer is looked up by its view without a temporary string.
+// Safe to call from parallel tasks.
+const std::string& InternSymbolName(std::string_view name);
@@ -28,6 +28,10 @@ public:
         REQUIRE_THROWS_AS(interpreter_.Run(expression), NameError);
     }
 
+    void SetOptimizationLevel(OptimizationLevel level) {
+        interpreter_.SetOptimizationLevel(level);
+    }
+
 private:
     Interpreter interpreter_;
 };
@@ -0,0 +1,68 @@
+#include "scheme_test.h"
+
+#include <string>
+#include <vector>
+
+static void RequireValue(const BatchResult& result, const std::string& value) {
+    REQUIRE_FALSE(result.error);
+    REQUIRE(result.value == value);
+}
+
+template <typename ErrorType>
+static void RequireError(const BatchResult& result) {
+    REQUIRE(result.error);
+    REQUIRE_THROWS_AS(std::rethrow_exception(result.error), ErrorType);
+}
+
+TEST_CASE("RunBatch") {
+    Interpreter interpreter;
+    std::vector<BatchResult> results = interpreter.RunBatch(
+        {"(define (square x) (* x x))", "(square 7)", "(car '())", "undefined-name", "(+ 1",
+         "1 2", "(define l (list (square 2) (square 3)))", "l"});
+    REQUIRE(results.size() == 8);
+    RequireValue(results[0], "()");
+    RequireValue(results[1], "49");
+    RequireError<RuntimeError>(results[2]);
+    RequireError<NameError>(results[3]);
+    RequireError<SyntaxError>(results[4]);
+    RequireError<SyntaxError>(results[5]);
+    RequireValue(results[7], "(4 9)");
+
+    REQUIRE(interpreter.RunBatch({}).empty());
+    REQUIRE(interpreter.Run("(square (car l))") == "16");
+}
+
+TEST_CASE("RunForms") {
+    Interpreter interpreter;
+    std::vector<BatchResult> results =
+        interpreter.RunForms("(define x 10)\n(set! x (+ x 1)) x\n (car 5) (if) 'done");
+    REQUIRE(results.size() == 6);
+    RequireValue(results[0], "()");
+    RequireValue(results[2], "11");
+    RequireError<RuntimeError>(results[3]);
+    RequireError<SyntaxError>(results[4]);
+    RequireValue(results[5], "done");
+
+    // a broken form ends the batch
+    results = interpreter.RunForms("(+ x 1) (+ x");
+    REQUIRE(results.size() == 2);
+    RequireValue(results[0], "12");
+    RequireError<SyntaxError>(results[1]);
+
+    REQUIRE(interpreter.RunForms("  ").empty());
+}
+
+TEST_CASE("BatchCollectsGarbage") {
+    Interpreter interpreter;
+    interpreter.RunForms("(define (range a b) (if (< a b) (cons a (range (+ a 1) b)) '()))"
+                         "(define kept (range 0 10))");
+    std::vector<std::string> expressions(200, "(list-ref (range 0 1000) 999)");
+    expressions.push_back("kept");
+    std::vector<BatchResult> results = interpreter.RunBatch(expressions);
+    RequireValue(results[0], "999");
+    RequireValue(results.back(), "(0 1 2 3 4 5 6 7 8 9)");
+    // the garbage of the batch is collected by its end
+    size_t objects_count = Heap::Instance().GetObjectsCount();
+    interpreter.Run("kept");
+    REQUIRE(Heap::Instance().GetObjectsCount() <= objects_count + 1);
+}
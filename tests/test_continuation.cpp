@@ -0,0 +1,57 @@
+#include "scheme_test.h"
+
+TEST_CASE_METHOD(SchemeTest, "EscapeContinuation") {
+    ExpectEq("(call/ec (lambda (k) 1))", "1");
+    ExpectEq("(call/ec (lambda (k) (k 2) 3))", "2");
+    ExpectEq("(+ 1 (call/ec (lambda (k) (+ 10 (k 2)))))", "3");
+    ExpectEq("(call-with-escape-continuation (lambda (k) (if (k 'out) 1 2)))", "out");
+    ExpectEq("(call/ec (lambda (k) (k)))", "()");
+}
+
+TEST_CASE_METHOD(SchemeTest, "EscapeFromDeepRecursion") {
+    ExpectNoError("(define (find-first pred l)"
+                  "  (call/ec (lambda (return)"
+                  "    (define (walk l)"
+                  "      (if (null? l) #f"
+                  "          (begin (if (pred (car l)) (return (car l))) (walk (cdr l)))))"
+                  "    (walk l))))");
+    ExpectEq("(find-first (lambda (x) (> x 2)) '(1 2 3 4))", "3");
+    ExpectEq("(find-first (lambda (x) (> x 5)) '(1 2 3 4))", "#f");
+
+    // scopes of the abandoned calls are popped
+    ExpectNoError(
+        "(define (deep n k) (let ((m n)) (if (= m 0) (k 'bottom) (+ 1 (deep (- m 1) k)))))");
+    ExpectEq("(call/ec (lambda (k) (deep 1000 k)))", "bottom");
+    ExpectNoError("(define m 5)");
+    ExpectEq("m", "5");
+}
+
+TEST_CASE_METHOD(SchemeTest, "EscapeThroughSpecialForms") {
+    ExpectEq("(call/ec (lambda (k) (let loop ((i 0)) (if (= i 10) (k i)) (loop (+ i 1)))))", "10");
+    ExpectEq("(call/ec (lambda (k) (and 1 (k 2) 3)))", "2");
+    ExpectEq("(call/ec (lambda (k) (or #f (k 2) 3)))", "2");
+    ExpectEq("(call/ec (lambda (k) (cond ((k 1) 2) (else 3))))", "1");
+    ExpectEq("(call/ec (lambda (k) (case (k 1) ((1) 2))))", "1");
+    ExpectEq("(call/ec (lambda (k) (let* ((a 1) (b (k a))) 5)))", "1");
+    ExpectNoError("(define x 0)");
+    ExpectEq("(call/ec (lambda (k) (define x (k 1))))", "1");
+    ExpectEq("(call/ec (lambda (k) (set! x (k 2))))", "2");
+    ExpectEq("x", "0");
+}
+
+TEST_CASE_METHOD(SchemeTest, "NestedEscapes") {
+    ExpectEq("(call/ec (lambda (outer) (+ 1 (call/ec (lambda (inner) (outer 5))))))", "5");
+    ExpectEq("(call/ec (lambda (outer) (+ 1 (call/ec (lambda (inner) (inner 5))))))", "6");
+
+    ExpectNoError("(define f (memoize (lambda (k) (k 1) 2)))");
+    ExpectEq("(call/ec f)", "1");
+    ExpectEq("(memoize-stats f)", "(0 1 0)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "EscapeContinuationExtent") {
+    ExpectNoError("(define saved (call/ec (lambda (k) k)))");
+    ExpectRuntimeError("(saved 1)");
+    ExpectRuntimeError("(call/ec 1)");
+    ExpectRuntimeError("(call/ec (lambda (k) (k 1 2)))");
+    ExpectEq("(call/cc (lambda (k) (k 1)))", "1");
+}
@@ -21,3 +21,72 @@ TEST_CASE_METHOD(SchemeTest, "IfSyntax") {
     ExpectSyntaxError("(if)");
     ExpectSyntaxError("(if 1 2 3 4)");
 }
+
+TEST_CASE_METHOD(SchemeTest, "SpecialFormsAreCheckedBeforeEvaluation") {
+    ExpectSyntaxError("(if #f (lambda))");
+    ExpectSyntaxError("(define (foo) (set! 1 2))");
+    ExpectNameError("(foo)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "Begin") {
+    ExpectEq("(begin 1 2 3)", "3");
+    ExpectEq("(begin)", "()");
+    ExpectNoError("(begin (define x 1) (define y 2))");
+    ExpectEq("(+ x y)", "3");
+}
+
+TEST_CASE_METHOD(SchemeTest, "Cond") {
+    ExpectNoError("(define (sign x) (cond ((< x 0) 'negative) ((= x 0) 'zero) (else 'positive)))");
+    ExpectEq("(sign -5)", "negative");
+    ExpectEq("(sign 0)", "zero");
+    ExpectEq("(sign 7)", "positive");
+
+    ExpectEq("(cond (#f 1))", "()");
+    ExpectEq("(cond ((+ 1 2)) (else 5))", "3");
+    ExpectEq("(cond (#f 1) ((cdr '(1 2)) => car) (else 5))", "2");
+    ExpectEq("(cond (#f 1) (else (define z 1) (+ z 1)))", "2");
+}
+
+TEST_CASE_METHOD(SchemeTest, "CondSyntax") {
+    ExpectSyntaxError("(cond (else 1) (#t 2))");
+    ExpectSyntaxError("(cond (else))");
+    ExpectSyntaxError("(cond (#t =>))");
+    ExpectSyntaxError("(cond 1)");
+    ExpectRuntimeError("(cond (1 => 2))");
+}
+
+TEST_CASE_METHOD(SchemeTest, "Case") {
+    ExpectNoError(
+        "(define (classify x) (case x ((1 2 3) 'small) ((100 -100) 'large) ((a b) 'symbol)"
+        "  ((#t) 'true) (else 'other)))");
+    ExpectEq("(classify 2)", "small");
+    ExpectEq("(classify -100)", "large");
+    ExpectEq("(classify 'b)", "symbol");
+    ExpectEq("(classify #t)", "true");
+    ExpectEq("(classify 4)", "other");
+    ExpectEq("(classify 100000000000000000000)", "other");
+    ExpectEq("(classify '(1))", "other");
+
+    // the first clause with a datum wins
+    ExpectEq("(case 1 ((1) 'first) ((1) 'second))", "first");
+    ExpectEq("(case 5 ((1) 'one))", "()");
+    ExpectEq("(case (* 2 3) ((2 3 5 7) 'prime) ((1 4 6 8 9) 'composite))", "composite");
+    ExpectEq("(case -9223372036854775807 ((9223372036854775807) 'max) (else 'other))", "other");
+}
+
+TEST_CASE_METHOD(SchemeTest, "CaseDispatchesManyClauses") {
+    ExpectNoError(
+        "(define (step op acc)"
+        "  (case op ((0) (+ acc 1)) ((1) (- acc 1)) ((2) (* acc 2)) ((3) 0)"
+        "           ((push) (+ acc 10)) ((pop) (- acc 10)) (else acc)))");
+    ExpectEq("(let loop ((i 0) (acc 5)) (if (= i 3) acc (loop (+ i 1) (step i acc))))", "10");
+    ExpectEq("(step 'push 1)", "11");
+    ExpectEq("(step 'nop 1)", "1");
+}
+
+TEST_CASE_METHOD(SchemeTest, "CaseSyntax") {
+    ExpectSyntaxError("(case)");
+    ExpectSyntaxError("(case 1 (else 1) ((1) 2))");
+    ExpectSyntaxError("(case 1 ((1)))");
+    ExpectSyntaxError("(case 1 (1 2))");
+}
@@ -0,0 +1,62 @@
+#include "scheme_test.h"
+
+TEST_CASE_METHOD(SchemeTest, "FloatsAreSelfEvaluating") {
+    ExpectEq("1.5", "1.5");
+    ExpectEq("-2.", "-2.0");
+    ExpectEq("+0.25", "0.25");
+    ExpectEq("1e3", "1000.0");
+    ExpectEq("1.5e-3", "0.0015");
+    ExpectEq("1e400", "+inf.0");
+    ExpectEq(".5", "0.5");
+    ExpectEq("(list -.5 +.5)", "(-0.5 0.5)");
+    ExpectEq("(+ .25 1)", "1.25");
+    ExpectSyntaxError("1e");
+}
+
+TEST_CASE_METHOD(SchemeTest, "FloatPredicate") {
+    ExpectEq("(number? 1.5)", "#t");
+    ExpectEq("(number? (/ 1 2.0))", "#t");
+}
+
+TEST_CASE_METHOD(SchemeTest, "MixedArithmetics") {
+    ExpectEq("(/ 7 2)", "3");
+    ExpectEq("(/ 7 2.0)", "3.5");
+    ExpectEq("(/ 10 4 2.0)", "1.25");
+    ExpectEq("(+ 1 2.5)", "3.5");
+    ExpectEq("(- 1 0.5)", "0.5");
+    ExpectEq("(* 0.5 4)", "2.0");
+    ExpectEq("(+ 99999999999999999999 0.5)", "1e+20");
+    ExpectEq("(max 1 2.5)", "2.5");
+    ExpectEq("(min 1 2.5)", "1.0");
+    ExpectEq("(abs -2.5)", "2.5");
+    ExpectEq("(/ 1.0 0.0)", "+inf.0");
+    ExpectRuntimeError("(/ 1.0 0)");
+    ExpectRuntimeError("(+ 1.5 #t)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "MixedComparison") {
+    ExpectEq("(< 1 1.5 2)", "#t");
+    ExpectEq("(= 1 1.0)", "#t");
+    ExpectEq("(> 2.5 2)", "#t");
+    ExpectEq("(<= 2.5 2)", "#f");
+    ExpectEq("(< 99999999999999999999 1e30)", "#t");
+
+    // integers aren't rounded to doubles
+    ExpectEq("(= 9007199254740993 9007199254740992.0)", "#f");
+    ExpectEq("(> 9007199254740993 9007199254740992.0)", "#t");
+    ExpectEq("(<= 9007199254740992.0 9007199254740993)", "#t");
+    ExpectEq("(= 9007199254740992 9007199254740992.0)", "#t");
+    ExpectEq("(= 100000000000000000000 1e20)", "#t");
+    ExpectEq("(= 100000000000000000001 1e20)", "#f");
+    ExpectEq("(< 1e20 100000000000000000001)", "#t");
+    ExpectEq("(< -9007199254740993 -9007199254740992.0 -2.5 -2)", "#t");
+    ExpectEq("(> -2 -2.5)", "#t");
+}
+
+TEST_CASE_METHOD(SchemeTest, "FloatLoops") {
+    ExpectNoError("(define (average a b) (/ (+ a b) 2.0))");
+    ExpectEq("(average 3 4)", "3.5");
+    ExpectNoError("(define (grow x n) (if (= n 0) x (grow (* x 2.0) (- n 1))))");
+    ExpectEq("(grow 1 10)", "1024.0");
+    ExpectEq("(grow 0.5 10)", "512.0");
+}
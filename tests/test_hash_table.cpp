@@ -0,0 +1,79 @@
+#include "scheme_test.h"
+
+TEST_CASE_METHOD(SchemeTest, "HashTableBasics") {
+    ExpectNoError("(define h (make-hash-table))");
+    ExpectEq("(hash-table? h)", "#t");
+    ExpectEq("(hash-table? '(1))", "#f");
+    ExpectEq("(hash-table-count h)", "0");
+
+    ExpectNoError("(hash-table-set! h 'a 1)");
+    ExpectNoError("(hash-table-set! h 42 'answer)");
+    ExpectNoError("(hash-table-set! h \"key\" '(1 2))");
+    ExpectEq("(hash-table-ref h 'a)", "1");
+    ExpectEq("(hash-table-ref h 42)", "answer");
+    ExpectEq("(hash-table-ref h \"key\")", "(1 2)");
+    ExpectEq("(hash-table-count h)", "3");
+
+    ExpectNoError("(hash-table-set! h 'a 2)");
+    ExpectEq("(hash-table-ref h 'a)", "2");
+    ExpectEq("(hash-table-count h)", "3");
+
+    ExpectEq("(hash-table-ref h 'missing 0)", "0");
+    ExpectRuntimeError("(hash-table-ref h 'missing)");
+
+    ExpectNoError("(hash-table-delete! h 'a)");
+    ExpectNoError("(hash-table-delete! h 'a)");
+    ExpectEq("(hash-table-ref h 'a #f)", "#f");
+    ExpectEq("(hash-table-count h)", "2");
+
+    ExpectRuntimeError("(hash-table-ref '(1) 1)");
+    ExpectRuntimeError("(make-hash-table 'eq)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "HashTableEquivalences") {
+    ExpectNoError("(define equal-table (make-hash-table 'equal))");
+    ExpectNoError("(hash-table-set! equal-table '(1 (2 3)) 'list)");
+    ExpectNoError("(hash-table-set! equal-table #(1 2) 'vector)");
+    ExpectNoError("(hash-table-set! equal-table '() 'empty)");
+    ExpectEq("(hash-table-ref equal-table (list 1 (list 2 3)))", "list");
+    ExpectEq("(hash-table-ref equal-table (vector 1 2))", "vector");
+    ExpectEq("(hash-table-ref equal-table '())", "empty");
+    ExpectEq("(hash-table-ref equal-table 1.0 'none)", "none");
+
+    ExpectNoError("(define eqv-table (make-hash-table 'eqv))");
+    ExpectNoError("(define key '(1 2))");
+    ExpectNoError("(hash-table-set! eqv-table key 'same)");
+    ExpectNoError("(hash-table-set! eqv-table 99999999999999999999 'big)");
+    ExpectEq("(hash-table-ref eqv-table key)", "same");
+    ExpectEq("(hash-table-ref eqv-table '(1 2) 'other)", "other");
+    ExpectEq("(hash-table-ref eqv-table (+ 99999999999999999998 1))", "big");
+}
+
+TEST_CASE_METHOD(SchemeTest, "HashTableGrowsAndShrinks") {
+    ExpectNoError("(define h (make-hash-table))");
+    ExpectNoError(
+        "(define (fill n) (hash-table-set! h n (* n n)) (if (> n 0) (fill (- n 1))))");
+    ExpectNoError(
+        "(define (drop n) (hash-table-delete! h n) (if (> n 0) (drop (- n 2))))");
+    ExpectNoError("(fill 999)");
+    ExpectEq("(hash-table-count h)", "1000");
+    ExpectEq("(hash-table-ref h 777)", "603729");
+
+    // every other key is deleted, the rest must still be found
+    ExpectNoError("(drop 998)");
+    ExpectEq("(hash-table-count h)", "500");
+    ExpectEq("(hash-table-ref h 998 'none)", "none");
+    ExpectEq("(hash-table-ref h 997)", "994009");
+    ExpectEq("(hash-table-ref h 1)", "1");
+    ExpectNoError("(define (len l) (if (null? l) 0 (+ 1 (len (cdr l)))))");
+    ExpectEq("(len (hash-table-keys h))", "500");
+}
+
+TEST_CASE_METHOD(SchemeTest, "HashTableKeepsItsEntries") {
+    ExpectNoError("(define h (make-hash-table))");
+    ExpectNoError("(hash-table-set! h (list 'k) (list 1 2 3))");
+    // entries are reachable through the table only, so they must survive collections
+    ExpectEq("(list 4 5 6)", "(4 5 6)");
+    ExpectEq("(hash-table-ref h '(k))", "(1 2 3)");
+    ExpectEq("(hash-table-keys h)", "((k))");
+}
@@ -0,0 +1,219 @@
+#include "scheme_test.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+static std::string GetImagePath(const std::string& name) {
+    return std::filesystem::temp_directory_path() / ("scheme_tidy_" + name + ".image");
+}
+
+TEST_CASE("ImageOfData") {
+    std::string path = GetImagePath("data");
+    {
+        Interpreter interpreter;
+        interpreter.Run("(define n 42)");
+        interpreter.Run("(define big 123456789012345678901234567890)");
+        interpreter.Run("(define x 2.5)");
+        interpreter.Run("(define s \"a string which is longer than fifteen chars\")");
+        interpreter.Run("(define l '(a #t #f \"str\" (1 . 2)))");
+        interpreter.Run("(define cycle (list 1 2))");
+        interpreter.Run("(set-cdr! (cdr cycle) cycle)");
+        interpreter.Run("(define v (vector 1 l 'sym))");
+        interpreter.Run("(vector-set! v 0 v)");
+        interpreter.Run("(define sv (s64vector 1 2 3))");
+        interpreter.Run("(define fv (f64vector 0.5 1.5))");
+        interpreter.Run("(define h (make-hash-table 'equal))");
+        interpreter.Run("(hash-table-set! h '(1 2) 'list)");
+        interpreter.Run("(hash-table-set! h \"key\" v)");
+        interpreter.SaveImage(path);
+    }
+    Interpreter interpreter;
+    interpreter.LoadImage(path);
+    REQUIRE(interpreter.Run("n") == "42");
+    REQUIRE(interpreter.Run("big") == "123456789012345678901234567890");
+    REQUIRE(interpreter.Run("(* x 2)") == "5.0");
+    REQUIRE(interpreter.Run("(string-length s)") == "43");
+    REQUIRE(interpreter.Run("l") == "(a #t #f \"str\" (1 . 2))");
+    // shared and cyclic structure is kept
+    interpreter.Run("(set-car! cycle 'x)");
+    REQUIRE(interpreter.Run("(car (cdr (cdr cycle)))") == "x");
+    interpreter.Run("(vector-set! (vector-ref v 0) 2 'changed)");
+    REQUIRE(interpreter.Run("(vector-ref v 2)") == "changed");
+    REQUIRE(interpreter.Run("(vector-ref v 1)") == "(a #t #f \"str\" (1 . 2))");
+    REQUIRE(interpreter.Run("sv") == "#s64(1 2 3)");
+    REQUIRE(interpreter.Run("fv") == "#f64(0.5 1.5)");
+    REQUIRE(interpreter.Run("(hash-table-ref h (list 1 2))") == "list");
+    REQUIRE(interpreter.Run("(vector-ref (hash-table-ref h \"key\") 2)") == "changed");
+    REQUIRE(interpreter.Run("(car '(1 2))") == "1");
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("ImageOfProcedures") {
+    std::string path = GetImagePath("procedures");
+    {
+        Interpreter interpreter;
+        interpreter.Run("(define (fact n) (if (< n 2) 1 (* n (fact (- n 1)))))");
+        interpreter.Run(
+            "(define make-counter (lambda () (let ((count 0))"
+            " (lambda () (set! count (+ count 1)) count))))");
+        interpreter.Run("(define counter (make-counter))");
+        interpreter.Run("(counter)");
+        interpreter.Run(
+            "(define (sum-to n) (let loop ((i 0) (total 0))"
+            " (if (> i n) total (loop (+ i 1) (+ total i)))))");
+        interpreter.Run(
+            "(define (classify x) (case x ((1 2 3) 'small) ((a b) 'symbol) (else 'other)))");
+        interpreter.Run(
+            "(define (shift x) (cond ((and (> x 0) x) => (lambda (y) (+ y 100))) (else 0)))");
+        interpreter.Run("(define (both a b) (and a (or b (* 60 60 24))))");
+        interpreter.Run("(define-memoized (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))");
+        interpreter.Run("(define-syntax swap! (syntax-rules () ((_ a b) (let ((tmp a))"
+                        " (set! a b) (set! b tmp)))))");
+        interpreter.Run("(define first car)");
+        interpreter.Run("(define (twice x) (define-syntax double (syntax-rules ()"
+                        " ((_ e) (* 2 e)))) (double x))");
+        interpreter.SaveImage(path);
+    }
+    Interpreter interpreter;
+    interpreter.LoadImage(path);
+    REQUIRE(interpreter.Run("(fact 20)") == "2432902008176640000");
+    REQUIRE(interpreter.Run("(counter)") == "2");
+    REQUIRE(interpreter.Run("((make-counter))") == "1");
+    REQUIRE(interpreter.Run("(sum-to 100)") == "5050");
+    REQUIRE(interpreter.Run("(list (classify 2) (classify 'b) (classify 7))") ==
+            "(small symbol other)");
+    REQUIRE(interpreter.Run("(list (shift 5) (shift -5))") == "(105 0)");
+    REQUIRE(interpreter.Run("(both #t #f)") == "86400");
+    REQUIRE(interpreter.Run("(fib 80)") == "23416728348467685");
+    REQUIRE(interpreter.Run("(define p 1)") == "()");
+    REQUIRE(interpreter.Run("(define q 2)") == "()");
+    REQUIRE(interpreter.Run("(begin (swap! p q) (list p q))") == "(2 1)");
+    REQUIRE(interpreter.Run("(first '(1 2))") == "1");
+    REQUIRE(interpreter.Run("(twice 21)") == "42");
+
+    // closures of the image see rebound names like any others
+    interpreter.Run("(define (* a b c) 0)");
+    REQUIRE(interpreter.Run("(both #t #f)") == "0");
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("WrongImages") {
+    Interpreter interpreter;
+    interpreter.Run("(define p (delay 1))");
+    std::string path = GetImagePath("wrong");
+    REQUIRE_THROWS_AS(interpreter.SaveImage(path), RuntimeError);
+    REQUIRE_THROWS_AS(interpreter.LoadImage("no/such/file.image"), RuntimeError);
+
+    interpreter.Run("(define p (list 1 2 3))");
+    interpreter.SaveImage(path);
+    std::string image;
+    {
+        std::ifstream file{path, std::ios::binary};
+        image.assign(std::istreambuf_iterator<char>(file), {});
+    }
+    auto write_image = [&](const std::string& contents) {
+        std::ofstream file{path, std::ios::binary};
+        file << contents;
+    };
+    write_image("(define p 1)");
+    REQUIRE_THROWS_AS(interpreter.LoadImage(path), RuntimeError);
+    for (size_t size : {size_t{12}, size_t{30}, image.size() / 2, image.size() - 1}) {
+        write_image(image.substr(0, size));
+        REQUIRE_THROWS_AS(interpreter.LoadImage(path), RuntimeError);
+    }
+    write_image(image);
+    Interpreter other;
+    other.LoadImage(path);
+    REQUIRE(other.Run("p") == "(1 2 3)");
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("CorruptedImages") {
+    std::string path = GetImagePath("corrupted");
+    std::string image;
+    {
+        Interpreter interpreter;
+        interpreter.Run("(define (f x) (if (> x 0) (list x 'pos) (car '(neg))))");
+        interpreter.Run("(define-memoized (g y) (* y 2))");
+        interpreter.Run("(define-syntax twice (syntax-rules () ((_ e) (list e e))))");
+        interpreter.Run("(define s \"not a symbol\")");
+        interpreter.SaveImage(path);
+        std::ifstream file{path, std::ios::binary};
+        image.assign(std::istreambuf_iterator<char>(file), {});
+    }
+
+    // the header is the magic, the version, the byte order mark and the count of records,
+    // a record is a tag, the size of its fields and the fields
+    struct Record {
+        size_t fields;
+        size_t size;
+    };
+    auto read_word = [&](size_t position) {
+        uint64_t word;
+        std::memcpy(&word, image.data() + position, sizeof(word));
+        return word;
+    };
+    std::vector<Record> records;
+    for (size_t position = 24; position < image.size();) {
+        uint64_t size = read_word(position + 1);
+        records.push_back({position + 9, size});
+        position += 9 + size;
+    }
+    REQUIRE(records.size() == read_word(16));
+    // number of the record of a symbol or a string, whose fields are its name
+    auto find_named = [&](const std::string& name) {
+        for (size_t i = 0; i < records.size(); ++i) {
+            if (records[i].size == 8 + name.size() && read_word(records[i].fields) == name.size() &&
+                image.compare(records[i].fields + 8, name.size(), name) == 0) {
+                return i + 1;
+            }
+        }
+        FAIL("No record of " << name);
+        return size_t{0};
+    };
+
+    // the first reference of a record to an argument, to whatever refers to an argument
+    // and so on is replaced by a reference to the string: lambdas get it as an argument,
+    // memoized functions as their function, the macro as its pattern
+    uint64_t string_number = find_named("not a symbol");
+    std::unordered_set<uint64_t> targets{find_named("x"), find_named("y"), find_named("e")};
+    size_t corrupted_count = 0;
+    for (int depth = 0; depth < 3; ++depth) {
+        std::unordered_set<uint64_t> referring;
+        for (size_t i = 0; i < records.size(); ++i) {
+            for (size_t offset = 0; offset + 8 <= records[i].size; ++offset) {
+                size_t position = records[i].fields + offset;
+                if (!targets.contains(read_word(position)) || !referring.insert(i + 1).second) {
+                    continue;
+                }
+                std::string corrupted = image;
+                std::memcpy(corrupted.data() + position, &string_number, sizeof(string_number));
+                {
+                    std::ofstream file{path, std::ios::binary};
+                    file << corrupted;
+                }
+                ++corrupted_count;
+                Interpreter interpreter;
+                try {
+                    interpreter.LoadImage(path);
+                } catch (const RuntimeError&) {
+                    continue;
+                }
+                // whatever is loaded fails only with errors of the language
+                for (const char* expression : {"(f 1)", "(f 0)", "(g 2)", "(twice 1)"}) {
+                    try {
+                        interpreter.Run(expression);
+                    } catch (const std::runtime_error&) {
+                    }
+                }
+            }
+        }
+        targets = std::move(referring);
+    }
+    REQUIRE(corrupted_count > 10);
+    std::filesystem::remove(path);
+}
@@ -112,3 +112,42 @@ TEST_CASE_METHOD(SchemeTest, "IntegerAbsEdgeCases") {
     ExpectRuntimeError("(abs #t)");
     ExpectRuntimeError("(abs 1 2)");
 }
+
+TEST_CASE_METHOD(SchemeTest, "IntegerOverflowPromotesToBignum") {
+    ExpectEq("(+ 9223372036854775807 1)", "9223372036854775808");
+    ExpectEq("(- -9223372036854775808 1)", "-9223372036854775809");
+    ExpectEq("(* 9223372036854775807 -2)", "-18446744073709551614");
+    ExpectEq("(/ -9223372036854775808 -1)", "9223372036854775808");
+    ExpectEq("(abs -9223372036854775808)", "9223372036854775808");
+    ExpectEq("(- 9223372036854775808 1)", "9223372036854775807");
+    ExpectEq("(number? (+ 9223372036854775807 1))", "#t");
+}
+
+TEST_CASE_METHOD(SchemeTest, "BignumLiterals") {
+    ExpectEq("123456789012345678901234567890", "123456789012345678901234567890");
+    ExpectEq("-123456789012345678901234567890", "-123456789012345678901234567890");
+    ExpectEq("+99999999999999999999", "99999999999999999999");
+    ExpectEq("-9223372036854775808", "-9223372036854775808");
+}
+
+TEST_CASE_METHOD(SchemeTest, "BignumArithmetics") {
+    ExpectNoError("(define (fact n) (if (= n 0) 1 (* n (fact (- n 1)))))");
+    ExpectEq("(fact 30)", "265252859812191058636308480000000");
+    ExpectEq("(/ (fact 30) (fact 28))", "870");
+    ExpectEq("(- (fact 25) (fact 25))", "0");
+    ExpectEq("(/ 5 99999999999999999999)", "0");
+    ExpectEq("(/ (- 0 (fact 40)) (fact 39))", "-40");
+
+    // operands long enough for Karatsuba multiplication
+    ExpectEq("(= (* (fact 300) (fact 300)) (* (fact 300) 300 (fact 299)))", "#t");
+    ExpectEq("(= (/ (* (fact 300) (fact 250)) (fact 250)) (fact 300))", "#t");
+}
+
+TEST_CASE_METHOD(SchemeTest, "BignumComparison") {
+    ExpectEq("(< 1 99999999999999999999)", "#t");
+    ExpectEq("(< -99999999999999999999 -9223372036854775808 0)", "#t");
+    ExpectEq("(= 99999999999999999999 99999999999999999999)", "#t");
+    ExpectEq("(>= 99999999999999999999 100000000000000000000)", "#f");
+    ExpectEq("(max 1 99999999999999999999 3)", "99999999999999999999");
+    ExpectEq("(min 1 -99999999999999999999 3)", "-99999999999999999999");
+}
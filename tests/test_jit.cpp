@@ -0,0 +1,72 @@
+#include "scheme_test.h"
+
+TEST_CASE_METHOD(SchemeTest, "NativeTierKeepsResults") {
+    for (auto level : {OptimizationLevel::CONSTANT_FOLDING, OptimizationLevel::NATIVE_CODE}) {
+        SetOptimizationLevel(level);
+        ExpectNoError("(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))");
+        ExpectEq("(fib 20)", "6765");
+        ExpectEq("(fib 15)", "610");
+
+        ExpectNoError("(define (even2? n) (if (= n 0) #t (not (even2? (- n 1)))))");
+        ExpectEq("(even2? 1500)", "#t");
+        ExpectEq("(even2? 1501)", "#f");
+
+        ExpectNoError("(define (f a b) (max (abs a) (min b 7) (/ a 2) (* a b -1)))");
+        ExpectNoError("(define (g n) (if (<= n 0) 0 (+ (f (- 0 n) n) (g (- n 1)))))");
+        ExpectEq("(g 1200)", "576720200");
+    }
+}
+
+#if defined(__x86_64__) && defined(__linux__)
+TEST_CASE_METHOD(SchemeTest, "NativeTierRunsSelfTailCallsInLoop") {
+    SetOptimizationLevel(OptimizationLevel::NATIVE_CODE);
+    ExpectNoError("(define (sum-to acc n) (if (= n 0) acc (sum-to (+ acc n) (- n 1))))");
+    ExpectEq("(sum-to 0 1500)", "1125750");
+    // far deeper than the interpreter's recursion can go
+    ExpectEq("(sum-to 0 1000000)", "500000500000");
+}
+#endif
+
+TEST_CASE_METHOD(SchemeTest, "NativeTierDeoptimizes") {
+    SetOptimizationLevel(OptimizationLevel::NATIVE_CODE);
+    ExpectNoError("(define (sum-to acc n) (if (= n 0) acc (sum-to (+ acc n) (- n 1))))");
+    ExpectEq("(sum-to 0 1500)", "1125750");
+    ExpectRuntimeError("(sum-to 0 #t)");
+    ExpectRuntimeError("(sum-to 0 1 2)");
+    ExpectEq("(sum-to 0 10)", "55");
+
+    ExpectNoError("(define (safe-div a b) (/ a b))");
+    ExpectNoError("(define (drive n) (if (= n 0) 0 (+ (safe-div n 1) (drive (- n 1)))))");
+    ExpectEq("(drive 1500)", "1125750");
+    ExpectEq("(safe-div 7 2)", "3");
+    ExpectRuntimeError("(safe-div 1 0)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "NativeTierRespectsRedefinitions") {
+    SetOptimizationLevel(OptimizationLevel::NATIVE_CODE);
+    ExpectNoError("(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))");
+    ExpectEq("(fib 20)", "6765");
+    ExpectNoError("(define + -)");
+    ExpectEq("(fib 10)", "-1");
+
+    ExpectNoError("(define (count n) (if (= n 0) 0 (- (count (- n 1)) -1)))");
+    ExpectEq("(count 1500)", "1500");
+    ExpectNoError("(define counters (list count))");
+    ExpectNoError("(define (count n) 100)");
+    ExpectEq("((car counters) 5)", "101");
+}
+
+TEST_CASE_METHOD(SchemeTest, "NativeTierRespectsLocalBindings") {
+    SetOptimizationLevel(OptimizationLevel::NATIVE_CODE);
+    ExpectNoError("(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))");
+    ExpectEq("(fib 20)", "6765");
+    // local bindings of built-in names are seen by the code inside of their scopes only
+    ExpectNoError("(define (shadowed n) (define + -) (list (fib n) (+ n 1)))");
+    ExpectEq("(shadowed 10)", "(55 9)");
+    ExpectNoError("(define (reassigned n) (define + *) (set! + -) (+ (fib n) 1))");
+    ExpectEq("(reassigned 10)", "54");
+    ExpectNoError("(define (apply-op + n) (if (= n 0) 0 (+ n (apply-op + (- n 1)))))");
+    ExpectEq("(apply-op - 1500)", "750");
+    ExpectEq("(apply-op * 5)", "0");
+    ExpectEq("(fib 10)", "55");
+}
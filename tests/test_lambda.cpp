@@ -157,3 +157,9 @@ TEST_CASE_METHOD(SchemeTest, "Redefinition and scoping") {
     ExpectEq("((foobar) 1 2)", "3");
     ExpectEq("(+ 1 2 -3)", "0");
 }
+
+TEST_CASE_METHOD(SchemeTest, "ArgumentsAreEvaluatedBeforeCall") {
+    ExpectNoError("(define (swap-args x y) (if (= x 0) y (swap-args y x)))");
+    ExpectEq("(swap-args 1 0)", "1");
+    ExpectEq("(swap-args 0 5)", "5");
+}
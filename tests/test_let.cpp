@@ -0,0 +1,105 @@
+#include "scheme_test.h"
+
+TEST_CASE_METHOD(SchemeTest, "Let") {
+    ExpectEq("(let ((x 1) (y 2)) (+ x y))", "3");
+    ExpectEq("(let () 5)", "5");
+
+    ExpectNoError("(define x 10)");
+    // values are evaluated outside of the new scope
+    ExpectEq("(let ((x 1) (y x)) y)", "10");
+    ExpectEq("(let ((x 1)) (set! x (+ x 1)) x)", "2");
+    ExpectEq("x", "10");
+
+    ExpectNoError("(define (make-counter) (let ((n 0)) (lambda () (set! n (+ n 1)) n)))");
+    ExpectNoError("(define counter (make-counter))");
+    ExpectNoError("(counter)");
+    ExpectEq("(counter)", "2");
+}
+
+TEST_CASE_METHOD(SchemeTest, "LetStar") {
+    ExpectEq("(let* ((x 1) (y (+ x 1)) (x (* y 10))) (list x y))", "(20 2)");
+    ExpectEq("(let* () 1)", "1");
+}
+
+TEST_CASE_METHOD(SchemeTest, "Letrec") {
+    ExpectEq("(letrec ((even? (lambda (n) (if (= n 0) #t (odd? (- n 1)))))"
+             "         (odd? (lambda (n) (if (= n 0) #f (even? (- n 1))))))"
+             "  (even? 100))",
+             "#t");
+    ExpectEq("(letrec ((f (lambda () g)) (g 2)) (f))", "2");
+    ExpectEq("(letrec ((a (begin (set! b 5) b)) (b 1)) (list a b))", "(5 1)");
+
+    // names can't be read before their values are assigned
+    ExpectRuntimeError("(letrec ((a b) (b 1)) a)");
+    ExpectRuntimeError("(letrec ((f (lambda () g)) (x (f)) (g 2)) x)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "LetShadowsBuiltIns") {
+    ExpectEq("(let ((+ *)) (+ 2 3))", "6");
+    ExpectEq("(+ 2 3)", "5");
+}
+
+TEST_CASE_METHOD(SchemeTest, "NamedLet") {
+    ExpectEq("(let loop ((i 0) (acc '())) (if (= i 3) acc (loop (+ i 1) (cons i acc))))",
+             "(2 1 0)");
+    // calls in non-tail position are ordinary calls
+    ExpectEq("(let fact ((n 20)) (if (= n 0) 1 (* n (fact (- n 1)))))", "2432902008176640000");
+}
+
+TEST_CASE_METHOD(SchemeTest, "NamedLetRunsInConstantStack") {
+    ExpectEq("(let loop ((i 0)) (if (< i 1000000) (loop (+ i 1)) i))", "1000000");
+    ExpectEq("(let loop ((i 0))"
+             "  (and (< i 1000000) (or (> i 999998) (let ((j (+ i 1))) (loop j)))))",
+             "#t");
+
+    ExpectNoError("(define (count-to n)"
+                  "  (let loop ((i 0) (sum 0)) (if (> i n) sum (loop (+ i 1) (+ sum i)))))");
+    ExpectEq("(count-to 100000)", "5000050000");
+}
+
+TEST_CASE_METHOD(SchemeTest, "NamedLetAccumulatesInLinearMemory") {
+    // the accumulator isn't copied on every iteration
+    alloc_checker::ResetCounters();
+    ExpectEq("(let loop ((i 0) (acc '())) (if (= i 20000) (car acc) (loop (+ i 1) (cons i acc))))",
+             "19999");
+    REQUIRE(alloc_checker::AllocCount() < 20 * 20000);
+}
+
+TEST_CASE_METHOD(SchemeTest, "NamedLetClosures") {
+    // every iteration has its own bindings
+    ExpectNoError("(define thunks (let loop ((i 0) (acc '())) (if (= i 3) acc"
+                  "  (loop (+ i 1) (cons (lambda () i) acc)))))");
+    ExpectEq("((car thunks))", "2");
+    ExpectEq("((car (cdr (cdr thunks))))", "0");
+
+    // the loop function may escape
+    ExpectNoError("(define g (let loop ((n 0)) (if (= n 0) (lambda (m) (loop m)) n)))");
+    ExpectEq("(g 5)", "5");
+}
+
+TEST_CASE_METHOD(SchemeTest, "NamedLetRebinding") {
+    // a call of the rebound name is not a jump to the next iteration
+    ExpectEq("(let loop ((i 0))"
+             "  (if (= i 0) (let () (set! loop (lambda (x) (* x 100))) (loop 5)) i))",
+             "500");
+    ExpectEq("(let loop ((loop 1)) loop)", "1");
+}
+
+TEST_CASE_METHOD(SchemeTest, "LetSyntax") {
+    ExpectSyntaxError("(let)");
+    ExpectSyntaxError("(let ((x 1)))");
+    ExpectSyntaxError("(let (x 1) x)");
+    ExpectSyntaxError("(let ((x)) x)");
+    ExpectSyntaxError("(let ((1 2)) 1)");
+    ExpectSyntaxError("(let* x 1)");
+    ExpectSyntaxError("(letrec ((x 1 2)) x)");
+    ExpectSyntaxError("(let loop ((i 0)))");
+}
+
+TEST_CASE_METHOD(SchemeTest, "NamedLetTailCallsThroughControlFlow") {
+    ExpectEq("(let loop ((i 0))"
+             "  (cond ((= i 1000000) i)"
+             "        ((< i 500000) (begin (+ 1 2) (loop (+ i 1))))"
+             "        (else (case (- i 500000) ((0) (loop (+ i 1))) (else (loop (+ i 1)))))))",
+             "1000000");
+}
@@ -0,0 +1,127 @@
+#include "scheme_test.h"
+
+TEST_CASE_METHOD(SchemeTest, "SyntaxRules") {
+    ExpectNoError("(define-syntax my-if (syntax-rules () ((_ c t e) (cond (c t) (else e)))))");
+    ExpectEq("(my-if #t 1 2)", "1");
+    ExpectEq("(my-if #f 1 2)", "2");
+
+    ExpectNoError(
+        "(define-syntax my-or (syntax-rules () ((_) #f) ((_ e) e)"
+        "  ((_ e r ...) (let ((t e)) (if t t (my-or r ...))))))");
+    ExpectEq("(my-or)", "#f");
+    ExpectEq("(my-or #f 2 3)", "2");
+    ExpectEq("(my-or #f #f)", "#f");
+
+    ExpectNoError("(define-syntax while"
+                  "  (syntax-rules ()"
+                  "    ((_ condition body ...)"
+                  "     (let loop () (if condition (begin body ... (loop)))))))");
+    ExpectNoError("(define i 0)");
+    ExpectNoError("(while (< i 100000) (set! i (+ i 1)))");
+    ExpectEq("i", "100000");
+}
+
+TEST_CASE_METHOD(SchemeTest, "SyntaxRulesEllipsis") {
+    ExpectNoError(
+        "(define-syntax my-list (syntax-rules () ((_ (a b) ...) (list (cons a b) ...))))");
+    ExpectEq("(my-list (1 2) (3 4))", "((1 . 2) (3 . 4))");
+    ExpectEq("(my-list)", "()");
+
+    ExpectNoError("(define-syntax flatten (syntax-rules () ((_ (a ...) ...) '(a ... ...))))");
+    ExpectSyntaxError("(flatten (1 2) (3))");
+
+    ExpectNoError("(define-syntax rev-args (syntax-rules () ((_ f a ... z) (f z a ...))))");
+    ExpectEq("(rev-args list 1 2 3)", "(3 1 2)");
+
+    ExpectNoError("(define-syntax tail (syntax-rules () ((_ a . rest) 'rest)))");
+    ExpectEq("(tail 1 2 3)", "(2 3)");
+
+    ExpectNoError(
+        "(define-syntax nested (syntax-rules () ((_ (k v ...) ...) '((k . (v ...)) ...))))");
+    ExpectEq("(nested (a 1 2) (b) (c 3))", "((a 1 2) (b) (c 3))");
+}
+
+TEST_CASE_METHOD(SchemeTest, "SyntaxRulesLiterals") {
+    ExpectNoError(
+        "(define-syntax arrow (syntax-rules (->) ((_ a -> b) (list a b)) ((_ a b c) 'no)))");
+    ExpectEq("(arrow 1 -> 2)", "(1 2)");
+    ExpectEq("(arrow 1 2 3)", "no");
+    ExpectSyntaxError("(arrow 1)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "SyntaxRulesHygiene") {
+    ExpectNoError("(define-syntax swap!"
+                  "  (syntax-rules () ((_ a b) (let ((tmp a)) (set! a b) (set! b tmp)))))");
+    ExpectNoError("(define tmp 1)");
+    ExpectNoError("(define other 2)");
+    ExpectNoError("(swap! tmp other)");
+    ExpectEq("(list tmp other)", "(2 1)");
+
+    ExpectNoError("(define-syntax my-or2"
+                  "  (syntax-rules () ((_ a b) (let ((t a)) (if t t b)))))");
+    ExpectNoError("(define t 5)");
+    ExpectEq("(my-or2 #f t)", "5");
+
+    // quoted symbols of a template are not renamed
+    ExpectNoError("(define-syntax name-of (syntax-rules () ((_) (let ((x 1)) 'x))))");
+    ExpectEq("(name-of)", "x");
+}
+
+TEST_CASE_METHOD(SchemeTest, "SyntaxRulesShadowedByLocalNames") {
+    ExpectNoError("(define-syntax swap!"
+                  "  (syntax-rules () ((_ a b) (let ((tmp a)) (set! a b) (set! b tmp)))))");
+    ExpectEq("((lambda (swap!) (swap! 1 2)) +)", "3");
+    ExpectEq("(let ((swap! list)) (swap! 1 2))", "(1 2)");
+    ExpectEq("(let* ((swap! max) (x (swap! 1 2))) x)", "2");
+    ExpectEq("(letrec ((swap! (lambda (a b) (- a b)))) (swap! 5 2))", "3");
+    ExpectEq("(let loop ((swap! *) (i 0)) (if (= i 1) (swap! 3 4) (loop swap! 1)))", "12");
+    ExpectNoError("(define (f) (define (swap! a b) (* a b)) (swap! 6 7))");
+    ExpectEq("(f)", "42");
+
+    // the macro is expanded outside of the scopes of the names
+    ExpectNoError("(define x 1)");
+    ExpectNoError("(define y 2)");
+    ExpectNoError("((lambda (swap) (swap! x y)) 0)");
+    ExpectEq("(list x y)", "(2 1)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "SyntaxRulesInLambdaBody") {
+    ExpectNoError("(define-syntax inc!"
+                  "  (syntax-rules () ((_ v) (set! v (+ v 1))) ((_ v n) (set! v (+ v n)))))");
+    ExpectNoError("(define (count-up n)"
+                  "  (let loop ((i 0) (acc 0))"
+                  "    (if (= i n) acc (begin (inc! acc 2) (loop (+ i 1) acc)))))");
+    ExpectEq("(count-up 1000)", "2000");
+    ExpectEq("(count-up 10)", "20");
+}
+
+TEST_CASE_METHOD(SchemeTest, "DefineSyntaxInScopeWhereEvaluated") {
+    // a macro of a body is seen by the rest of the body only
+    ExpectNoError("(define (f x) (define-syntax twice (syntax-rules () ((_ e) (* 2 e))))"
+                  "  (twice x))");
+    ExpectNameError("(twice 1)");
+    ExpectEq("(f 21)", "42");
+    ExpectNameError("(twice 1)");
+    ExpectNoError("(define (g) (define-syntax never (syntax-rules () ((_) 1))) 0)");
+    ExpectNameError("(never)");
+
+    // nothing is bound if the form fails before the definition is evaluated
+    ExpectRuntimeError("(begin (car '()) (define-syntax later (syntax-rules () ((_) 1))))");
+    ExpectNameError("(later)");
+    ExpectNoError("(if #f (define-syntax unused (syntax-rules () ((_) 1))))");
+    ExpectNameError("(unused)");
+
+    ExpectEq("(begin (define-syntax one (syntax-rules () ((_) 1))) (+ (one) (one)))", "2");
+    ExpectEq("(one)", "1");
+}
+
+TEST_CASE_METHOD(SchemeTest, "SyntaxRulesErrors") {
+    ExpectSyntaxError("(define-syntax)");
+    ExpectSyntaxError("(define-syntax m 1)");
+    ExpectSyntaxError("(define-syntax m (syntax-rules (1) ((_) 1)))");
+    ExpectSyntaxError("(define-syntax m (syntax-rules () (_ 1)))");
+    ExpectNoError("(define-syntax m (syntax-rules () ((_ a ...) a)))");
+    ExpectSyntaxError("(m 1 2)");
+    ExpectNoError("(define-syntax m2 (syntax-rules () ((_ a) (a ...))))");
+    ExpectSyntaxError("(m2 1)");
+}
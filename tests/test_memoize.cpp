@@ -0,0 +1,75 @@
+#include "scheme_test.h"
+
+TEST_CASE_METHOD(SchemeTest, "MemoizedRecursion") {
+    ExpectNoError(
+        "(define fib (memoize (lambda (n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))))");
+    ExpectEq("(fib 90)", "2880067194370816120");
+    ExpectEq("(memoize-stats fib)", "(88 91 91)");
+
+    ExpectNoError("(define-memoized (paths x y)"
+                  "  (if (or (= x 0) (= y 0)) 1 (+ (paths (- x 1) y) (paths x (- y 1)))))");
+    ExpectEq("(paths 30 30)", "118264581564861424");
+}
+
+TEST_CASE_METHOD(SchemeTest, "MemoizeKeysAreStructural") {
+    ExpectNoError("(define calls 0)");
+    ExpectNoError("(define f (memoize (lambda (l) (set! calls (+ calls 1)) (car l))))");
+    ExpectEq("(f '(1 2))", "1");
+    ExpectEq("(f (list 1 2))", "1");
+    ExpectEq("(f '(2 1))", "2");
+    ExpectEq("calls", "2");
+}
+
+TEST_CASE_METHOD(SchemeTest, "MemoizeKeepsCopiesOfArguments") {
+    ExpectNoError("(define calls 0)");
+    ExpectNoError("(define f (memoize (lambda (l) (set! calls (+ calls 1)) (car l)) 2))");
+    ExpectNoError("(define l (list 1 2))");
+    ExpectEq("(f l)", "1");
+    // the cached entry is still the one of (1 2)
+    ExpectNoError("(set-car! l 5)");
+    ExpectEq("(f l)", "5");
+    ExpectEq("(f '(1 2))", "1");
+    ExpectEq("calls", "2");
+    // both entries are evicted
+    ExpectEq("(f '(3))", "3");
+    ExpectEq("(f '(4))", "4");
+    ExpectEq("(f l)", "5");
+    ExpectEq("(f '(1 2))", "1");
+    ExpectEq("calls", "6");
+    ExpectEq("(memoize-stats f)", "(1 6 2)");
+
+    ExpectNoError("(define g (memoize (lambda (v) (set! calls (+ calls 1)) (vector-ref v 0)) 1))");
+    ExpectNoError("(define v (vector (list 1) 2))");
+    ExpectEq("(g v)", "(1)");
+    ExpectNoError("(set-car! (vector-ref v 0) 7)");
+    ExpectNoError("(vector-set! v 1 3)");
+    ExpectEq("(g v)", "(7)");
+    ExpectEq("(g (vector (list 1) 2))", "(1)");
+    ExpectEq("calls", "9");
+}
+
+TEST_CASE_METHOD(SchemeTest, "MemoizeEvictsLeastRecentlyUsed") {
+    ExpectNoError("(define calls 0)");
+    ExpectNoError("(define square (memoize (lambda (x) (set! calls (+ calls 1)) (* x x)) 2))");
+    ExpectNoError("(square 1)");
+    ExpectNoError("(square 2)");
+    ExpectNoError("(square 1)");
+    // 2 is the least recently used one now
+    ExpectNoError("(square 3)");
+    ExpectEq("calls", "3");
+    ExpectNoError("(square 1)");
+    ExpectEq("calls", "3");
+    ExpectNoError("(square 2)");
+    ExpectEq("calls", "4");
+    ExpectEq("(memoize-stats square)", "(2 4 2)");
+
+    ExpectNoError("(memoize-clear! square)");
+    ExpectEq("(memoize-stats square)", "(0 0 0)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "MemoizeErrors") {
+    ExpectRuntimeError("(memoize +)");
+    ExpectRuntimeError("(memoize (lambda (x) x) 0)");
+    ExpectRuntimeError("(memoize-stats (lambda (x) x))");
+    ExpectSyntaxError("(define-memoized f 1)");
+}
@@ -0,0 +1,131 @@
+#include "scheme_test.h"
+
+#include <numeric_kernels.h>
+
+#include <vector>
+
+TEST_CASE_METHOD(SchemeTest, "NumericVectorConstructors") {
+    ExpectEq("(s64vector 1 2 3)", "#s64(1 2 3)");
+    ExpectEq("(f64vector 1 2.5)", "#f64(1.0 2.5)");
+    ExpectEq("(make-s64vector 3)", "#s64(0 0 0)");
+    ExpectEq("(make-f64vector 2 1.5)", "#f64(1.5 1.5)");
+    ExpectEq("(list->s64vector '(4 5))", "#s64(4 5)");
+    ExpectEq("(f64vector->list (f64vector 1 2))", "(1.0 2.0)");
+    ExpectEq("(s64vector? (s64vector))", "#t");
+    ExpectEq("(f64vector? (s64vector))", "#f");
+
+    ExpectRuntimeError("(s64vector 1.5)");
+    ExpectRuntimeError("(f64vector 'a)");
+    ExpectRuntimeError("(make-s64vector -1)");
+    ExpectRuntimeError("(list->f64vector '(1 . 2))");
+}
+
+TEST_CASE_METHOD(SchemeTest, "NumericVectorAccess") {
+    ExpectNoError("(define v (make-s64vector 5))");
+    ExpectNoError("(s64vector-set! v 4 7)");
+    ExpectEq("(s64vector-ref v 4)", "7");
+    ExpectEq("(s64vector-length v)", "5");
+
+    ExpectRuntimeError("(s64vector-ref v 5)");
+    ExpectRuntimeError("(s64vector-set! v 0 1.5)");
+    ExpectRuntimeError("(f64vector-ref v 0)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "NumericVectorFolds") {
+    ExpectNoError("(define v (s64vector 3 -1 4 1 -5 9 2 6 5))");
+    ExpectEq("(s64vector-sum v)", "24");
+    ExpectEq("(s64vector-min v)", "-5");
+    ExpectEq("(s64vector-max v)", "9");
+    ExpectEq("(s64vector-sum (s64vector))", "0");
+    ExpectRuntimeError("(s64vector-min (s64vector))");
+
+    ExpectNoError("(define w (f64vector 0.5 2 -1.5 8 4.25))");
+    ExpectEq("(f64vector-sum w)", "13.25");
+    ExpectEq("(f64vector-min w)", "-1.5");
+    ExpectEq("(f64vector-max w)", "8.0");
+}
+
+TEST_CASE_METHOD(SchemeTest, "NumericVectorOverflows") {
+    ExpectEq("(s64vector-sum (make-s64vector 6 9223372036854775807))", "55340232221128654842");
+    ExpectEq("(s64vector-sum (s64vector 9223372036854775807 1 -2))", "9223372036854775806");
+    ExpectEq("(s64vector-dot (s64vector 4294967296 3) (s64vector 4294967296 2))",
+             "18446744073709551622");
+
+    ExpectRuntimeError("(s64vector-add (s64vector 9223372036854775807) (s64vector 1))");
+    ExpectRuntimeError("(s64vector-scale (s64vector 1 4611686018427387904) 2)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "NumericVectorElementwise") {
+    ExpectEq("(s64vector-add (s64vector 1 2 3 4 5) (s64vector 10 20 30 40 50))",
+             "#s64(11 22 33 44 55)");
+    ExpectEq("(s64vector-mul (s64vector 1 2 3) (s64vector 4 5 6))", "#s64(4 10 18)");
+    ExpectEq("(s64vector-scale (s64vector 1 -2 3) 3)", "#s64(3 -6 9)");
+    ExpectEq("(s64vector-dot (s64vector 1 2 3) (s64vector 4 5 6))", "32");
+
+    ExpectEq("(f64vector-add (f64vector 1 2) (f64vector 0.5 0.25))", "#f64(1.5 2.25)");
+    ExpectEq("(f64vector-mul (f64vector 1 2 3 4 5) (f64vector 2 2 2 2 2))",
+             "#f64(2.0 4.0 6.0 8.0 10.0)");
+    ExpectEq("(f64vector-scale (f64vector 1 2) 0.5)", "#f64(0.5 1.0)");
+    ExpectEq("(f64vector-dot (f64vector 1 2 3 4 5) (f64vector 1 1 1 1 2))", "20.0");
+
+    ExpectRuntimeError("(s64vector-add (s64vector 1) (s64vector 1 2))");
+    ExpectRuntimeError("(f64vector-dot (f64vector 1) (s64vector 1))");
+}
+
+TEST_CASE_METHOD(SchemeTest, "NumericVectorMasks") {
+    ExpectNoError("(define v (s64vector 5 1 7 3 5 9))");
+    ExpectEq("(s64vector-mask < v 5)", "#s64(0 1 0 1 0 0)");
+    ExpectEq("(s64vector-mask <= v 5)", "#s64(1 1 0 1 1 0)");
+    ExpectEq("(s64vector-mask = v 5)", "#s64(1 0 0 0 1 0)");
+    ExpectEq("(s64vector-mask > v 5)", "#s64(0 0 1 0 0 1)");
+    ExpectEq("(s64vector-mask >= v 5)", "#s64(1 0 1 0 1 1)");
+    ExpectEq("(s64vector-sum (f64vector-mask > (f64vector 0.5 1.5 2.5 -1 3) 1))", "3");
+
+    ExpectRuntimeError("(s64vector-mask + v 5)");
+}
+
+TEST_CASE("Numeric kernels agree with scalar ones") {
+    const NumericKernels& kernels = GetNumericKernels();
+    const NumericKernels& scalar = GetScalarNumericKernels();
+    // every length around the lane count, integer values so that sums are exact
+    for (size_t size = 1; size < 20; ++size) {
+        std::vector<int64_t> integers(size);
+        std::vector<double> doubles(size);
+        std::vector<double> other_doubles(size);
+        for (size_t i = 0; i < size; ++i) {
+            integers[i] = static_cast<int64_t>((i * 7919) % 23) - 11;
+            doubles[i] = static_cast<double>(integers[i]) / 4;
+            other_doubles[i] = static_cast<double>(size - i);
+        }
+        int64_t sum = 0;
+        int64_t scalar_sum = 0;
+        REQUIRE(kernels.sum_s64(integers.data(), size, &sum));
+        REQUIRE(scalar.sum_s64(integers.data(), size, &scalar_sum));
+        REQUIRE(sum == scalar_sum);
+        REQUIRE(kernels.sum_f64(doubles.data(), size) == scalar.sum_f64(doubles.data(), size));
+        REQUIRE(kernels.min_s64(integers.data(), size) == scalar.min_s64(integers.data(), size));
+        REQUIRE(kernels.max_s64(integers.data(), size) == scalar.max_s64(integers.data(), size));
+        REQUIRE(kernels.min_f64(doubles.data(), size) == scalar.min_f64(doubles.data(), size));
+        REQUIRE(kernels.max_f64(doubles.data(), size) == scalar.max_f64(doubles.data(), size));
+        REQUIRE(kernels.dot_f64(doubles.data(), other_doubles.data(), size) ==
+                scalar.dot_f64(doubles.data(), other_doubles.data(), size));
+
+        std::vector<double> result(size);
+        std::vector<double> scalar_result(size);
+        kernels.mul_f64(doubles.data(), other_doubles.data(), result.data(), size);
+        scalar.mul_f64(doubles.data(), other_doubles.data(), scalar_result.data(), size);
+        REQUIRE(result == scalar_result);
+
+        std::vector<int64_t> mask(size);
+        std::vector<int64_t> scalar_mask(size);
+        for (Comparison comparison : {Comparison::LESS, Comparison::LESS_EQUAL, Comparison::EQUAL,
+                                      Comparison::GREATER, Comparison::GREATER_EQUAL}) {
+            kernels.mask_s64(integers.data(), 3, comparison, mask.data(), size);
+            scalar.mask_s64(integers.data(), 3, comparison, scalar_mask.data(), size);
+            REQUIRE(mask == scalar_mask);
+            kernels.mask_f64(doubles.data(), 0.75, comparison, mask.data(), size);
+            scalar.mask_f64(doubles.data(), 0.75, comparison, scalar_mask.data(), size);
+            REQUIRE(mask == scalar_mask);
+        }
+    }
+}
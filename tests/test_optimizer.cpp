@@ -0,0 +1,48 @@
+#include "scheme_test.h"
+
+TEST_CASE_METHOD(SchemeTest, "FoldedExpressionsKeepTheirValues") {
+    for (auto level : {OptimizationLevel::NONE, OptimizationLevel::CONSTANT_FOLDING}) {
+        SetOptimizationLevel(level);
+        ExpectEq("(* 60 60 24)", "86400");
+        ExpectEq("(+ 1 (* 2 3) (- 10 4))", "13");
+        ExpectEq("(< 1 2 3)", "#t");
+        ExpectEq("(number? (abs -5))", "#t");
+        ExpectEq("(if (> 1 2) 'yes 'no)", "no");
+        ExpectEq("(if #f 1)", "()");
+        ExpectEq("(and 1 #t (= 2 2))", "#t");
+        ExpectEq("(and 1 #f (unknown-function))", "#f");
+        ExpectEq("(or #f (= 1 2) 3)", "3");
+        ExpectEq("(or #f #f)", "#f");
+    }
+}
+
+TEST_CASE_METHOD(SchemeTest, "FoldingKeepsRuntimeErrors") {
+    ExpectNoError("(define (div-by-zero) (/ 1 0))");
+    ExpectRuntimeError("(div-by-zero)");
+    ExpectEq("(if #t 2 (/ 1 0))", "2");
+    ExpectRuntimeError("(+ 1 #t)");
+    ExpectRuntimeError("(if #t ())");
+}
+
+TEST_CASE_METHOD(SchemeTest, "FoldingRespectsRedefinitions") {
+    ExpectNoError("(define (seconds-per-day) (* 60 60 24))");
+    ExpectNoError("(define (pick) (if (< 1 2) 'less 'greater))");
+    ExpectEq("(seconds-per-day)", "86400");
+    ExpectEq("(pick)", "less");
+
+    ExpectNoError("(define * +)");
+    ExpectNoError("(define < >)");
+    ExpectEq("(seconds-per-day)", "144");
+    ExpectEq("(pick)", "greater");
+
+    ExpectNoError("(define (local-plus) (define (+ x y) (- x y)) (+ 5 3))");
+    ExpectEq("(local-plus)", "2");
+    ExpectEq("((lambda (max) (max 1 2)) min)", "1");
+
+    // aliases of built-ins aren't folded, rebinding them doesn't advance the epoch
+    ExpectNoError("(define plus +)");
+    ExpectNoError("(define (f) (plus 1 2))");
+    ExpectEq("(f)", "3");
+    ExpectNoError("(define plus -)");
+    ExpectEq("(f)", "-1");
+}
@@ -0,0 +1,78 @@
+#include "scheme_test.h"
+
+TEST_CASE_METHOD(SchemeTest, "Futures") {
+    ExpectNoError("(define (fib n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))");
+    ExpectNoError("(define a (future (lambda () (fib 15))))");
+    ExpectNoError("(define b (future (lambda () (fib 16))))");
+    ExpectEq("(future? a)", "#t");
+    ExpectEq("(+ (touch a) (touch b))", "1597");
+    ExpectEq("(touch a)", "610");
+    ExpectEq("(touch (future (lambda () (list 1 2))))", "(1 2)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "NestedFutures") {
+    ExpectNoError("(define (psum l)"
+                  "  (if (null? (cdr l)) (car l)"
+                  "      (let ((rest (future (lambda () (psum (cdr l))))))"
+                  "        (+ (car l) (touch rest)))))");
+    ExpectEq("(psum '(1 2 3 4 5 6 7 8 9 10))", "55");
+}
+
+TEST_CASE_METHOD(SchemeTest, "ParallelMap") {
+    ExpectNoError("(define (range a b) (if (< a b) (cons a (range (+ a 1) b)) '()))");
+    ExpectNoError("(define l (range 0 100))");
+    ExpectEq("(list-ref (pmap (lambda (x) (* x x)) l) 99)", "9801");
+    ExpectEq("(pmap (lambda (x) (+ x 1)) '(1 2 3))", "(2 3 4)");
+    ExpectEq("(pmap car '())", "()");
+    ExpectEq("(pmap (lambda (x) (pmap (lambda (y) (* x y)) '(1 2 3))) '(1 10))",
+             "((1 2 3) (10 20 30))");
+
+    // calls of one lambda run at once with their own scopes
+    ExpectNoError("(define (count-down n) (let loop ((i n) (acc 0)) "
+                  "(if (= i 0) acc (loop (- i 1) (+ acc i)))))");
+    ExpectEq("(pmap count-down '(10 100 1000 10))", "(55 5050 500500 55)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "ParallelFold") {
+    ExpectNoError("(define (range a b) (if (< a b) (cons a (range (+ a 1) b)) '()))");
+    ExpectEq("(pfold + 0 (range 1 101))", "5050");
+    ExpectEq("(pfold + 10 '())", "10");
+    // order of the elements is kept for associative functions
+    ExpectEq("(pfold string-append \"\" '(\"a\" \"b\" \"c\" \"d\" \"e\" \"f\" \"g\" \"h\" \"i\"))",
+             "\"abcdefghi\"");
+}
+
+TEST_CASE_METHOD(SchemeTest, "ParallelResultsSurviveCollection") {
+    ExpectNoError("(define squares (pmap (lambda (x) (list x (* x x))) '(1 2 3 4 5 6 7 8)))");
+    ExpectNoError("(define f (future (lambda () (list 'a 'b))))");
+    ExpectNoError("(touch f)");
+    ExpectEq("squares", "((1 1) (2 4) (3 9) (4 16) (5 25) (6 36) (7 49) (8 64))");
+    ExpectEq("(touch f)", "(a b)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "ParallelErrors") {
+    ExpectRuntimeError("(pmap car '(1 2))");
+    ExpectRuntimeError("(pmap car 5)");
+    ExpectRuntimeError("(touch 5)");
+    ExpectRuntimeError("(future 5)");
+    ExpectRuntimeError("(future '(lambda () 1))");
+    ExpectRuntimeError("(pmap 5 '(1 2))");
+    ExpectRuntimeError("(pfold \"+\" 0 '(1 2))");
+    ExpectEq("(pmap car '((1) (2)))", "(1 2)");
+    ExpectNoError("(define f (future (lambda () (car 1))))");
+    ExpectRuntimeError("(touch f)");
+    ExpectRuntimeError("(touch f)");
+    ExpectNameError("(touch (future (lambda () undefined-name)))");
+    ExpectRuntimeError("(call/ec (lambda (k) (pmap (lambda (x) (k x)) '(1 2))))");
+    ExpectEq("(call/ec (lambda (k) (touch (future (lambda () (call/ec (lambda (j) (j 5))))))))",
+             "5");
+}
+
+TEST_CASE_METHOD(SchemeTest, "ParallelSectionsInARow") {
+    // workers of a finished section must not take the tasks of the next one
+    ExpectNoError("(define (run n total)"
+                  "  (if (= n 0) total"
+                  "      (run (- n 1) (+ total (touch (future (lambda () n)))"
+                  "                    (pfold + 0 (pmap (lambda (x) (* x n)) '(1 2 3)))))))");
+    ExpectEq("(run 2000 0)", "14007000");
+}
@@ -153,4 +153,63 @@ TEST_CASE("Invalid") {
     REQUIRE_THROWS_AS(ReadFull("(1 . ()"), SyntaxError);
     REQUIRE_THROWS_AS(ReadFull("(1 . )"), SyntaxError);
     REQUIRE_THROWS_AS(ReadFull("(1 . 2 3)"), SyntaxError);
+    REQUIRE_THROWS_AS(ReadFull(")"), SyntaxError);
+    REQUIRE_THROWS_AS(ReadFull("#(1 . 2)"), SyntaxError);
+    REQUIRE_THROWS_AS(ReadFull("#(1"), SyntaxError);
+    REQUIRE_THROWS_AS(ReadFull("'(1 '"), SyntaxError);
+}
+
+TEST_CASE("Long lists") {
+    const size_t size = 500000;
+    std::string list = "(";
+    for (size_t i = 0; i < size; ++i) {
+        list += std::to_string(i) + " ";
+    }
+    list += ". end)";
+    auto node = ReadFull(list);
+    size_t read_count = 0;
+    while (Is<Cell>(node) &&
+           As<Number>(As<Cell>(node)->GetFirst())->GetValue() == static_cast<int64_t>(read_count)) {
+        node = As<Cell>(node)->GetSecond();
+        ++read_count;
+    }
+    REQUIRE(read_count == size);
+    REQUIRE(As<Symbol>(node)->GetName() == "end");
+
+    list[0] = '#';
+    list.insert(list.begin() + 1, '(');
+    list.replace(list.find(". end)"), 6, ")");
+    node = ReadFull(list);
+    REQUIRE(As<Vector>(node)->GetSize() == size);
+}
+
+TEST_CASE("Deep nesting") {
+    auto nested = [](size_t depth, const std::string& open, const std::string& close) {
+        std::string result;
+        for (size_t i = 0; i < depth; ++i) {
+            result += open;
+        }
+        result += "x";
+        for (size_t i = 0; i < depth; ++i) {
+            result += close;
+        }
+        return result;
+    };
+    auto node = ReadFull(nested(kDefaultMaxReadDepth, "(", ")"));
+    size_t depth = 0;
+    while (Is<Cell>(node) && !As<Cell>(node)->GetSecond()) {
+        node = As<Cell>(node)->GetFirst();
+        ++depth;
+    }
+    REQUIRE(depth == kDefaultMaxReadDepth);
+    REQUIRE(As<Symbol>(node)->GetName() == "x");
+
+    REQUIRE_THROWS_AS(ReadFull(nested(kDefaultMaxReadDepth + 1, "(", ")")), SyntaxError);
+    REQUIRE_THROWS_AS(ReadFull(nested(kDefaultMaxReadDepth + 1, "#(", ")")), SyntaxError);
+    REQUIRE_THROWS_AS(ReadFull("'" + nested(kDefaultMaxReadDepth, "(", ")")), SyntaxError);
+
+    std::stringstream ss{nested(3, "(", ")") + " " + nested(4, "(", ")")};
+    Tokenizer tokenizer{&ss};
+    REQUIRE(Read(&tokenizer, 3));
+    REQUIRE_THROWS_AS(Read(&tokenizer, 3), SyntaxError);
 }
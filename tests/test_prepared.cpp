@@ -0,0 +1,78 @@
+#include "scheme_test.h"
+
+#include <string>
+#include <utility>
+
+TEST_CASE("PrepareAndExecute") {
+    Interpreter interpreter;
+    interpreter.Run("(define counter 0)");
+    PreparedExpression increment =
+        interpreter.Prepare("(begin (set! counter (+ counter 1)) counter)");
+    REQUIRE(interpreter.Execute(increment) == "1");
+    REQUIRE(interpreter.Execute(increment) == "2");
+
+    // the prepared form survives collections of other forms
+    for (size_t i = 0; i < 100; ++i) {
+        interpreter.Run("(list 1 2 3)");
+    }
+    REQUIRE(interpreter.Execute(increment) == "3");
+
+    PreparedExpression moved = std::move(increment);
+    REQUIRE(interpreter.Execute(moved) == "4");
+    REQUIRE_THROWS_AS(interpreter.Execute(increment), RuntimeError);
+
+    PreparedExpression failing = interpreter.Prepare("(car '())");
+    REQUIRE_THROWS_AS(interpreter.Execute(failing), RuntimeError);
+    REQUIRE_THROWS_AS(interpreter.Execute(failing), RuntimeError);
+
+    REQUIRE_THROWS_AS(interpreter.Prepare("(+ 1"), SyntaxError);
+    REQUIRE_THROWS_AS(interpreter.Prepare("1 2"), SyntaxError);
+    REQUIRE_THROWS_AS(interpreter.Prepare("(if)"), SyntaxError);
+}
+
+TEST_CASE("PreparedFormsFollowMacros") {
+    Interpreter interpreter;
+    interpreter.Run("(define (twice x) (* 2 x))");
+    PreparedExpression call = interpreter.Prepare("(twice 21)");
+    REQUIRE(interpreter.Execute(call) == "42");
+
+    interpreter.Run("(define-syntax twice (syntax-rules () ((_ x) (list x x))))");
+    REQUIRE(interpreter.Execute(call) == "(21 21)");
+
+    interpreter.Run("(define (twice x) (+ x x))");
+    REQUIRE(interpreter.Execute(call) == "42");
+
+    // built-ins rebound after the optimization are called again
+    PreparedExpression folded = interpreter.Prepare("(+ 1 2)");
+    REQUIRE(interpreter.Execute(folded) == "3");
+    interpreter.Run("(define (+ a b) (* a b))");
+    REQUIRE(interpreter.Execute(folded) == "2");
+}
+
+TEST_CASE("RunCache") {
+    Interpreter interpreter;
+    interpreter.SetRunCacheCapacity(2);
+    interpreter.Run("(define x 1)");
+    REQUIRE(interpreter.Run("(+ x 1)") == "2");
+    interpreter.Run("(set! x 10)");
+    REQUIRE(interpreter.Run("(+ x 1)") == "11");
+    REQUIRE(interpreter.Run("(set! x 10)") == "()");
+
+    // errors are thrown by cached forms the same way
+    REQUIRE_THROWS_AS(interpreter.Run("(+ 1"), SyntaxError);
+    REQUIRE_THROWS_AS(interpreter.Run("y"), NameError);
+    REQUIRE_THROWS_AS(interpreter.Run("y"), NameError);
+    interpreter.Run("(define y 5)");
+    REQUIRE(interpreter.Run("y") == "5");
+
+    interpreter.Run("(define-syntax inc! (syntax-rules () ((_ v) (set! v (+ v 1)))))");
+    REQUIRE(interpreter.Run("(begin (inc! x) x)") == "11");
+    REQUIRE(interpreter.Run("(begin (inc! x) x)") == "12");
+
+    // evicted forms are collected, the cache can be turned off
+    for (size_t i = 0; i < 100; ++i) {
+        REQUIRE(interpreter.Run("(+ x " + std::to_string(i) + ")") == std::to_string(12 + i));
+    }
+    interpreter.SetRunCacheCapacity(0);
+    REQUIRE(interpreter.Run("(+ x 1)") == "13");
+}
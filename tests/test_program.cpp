@@ -0,0 +1,69 @@
+#include "scheme_test.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+TEST_CASE("RunProgram") {
+    Interpreter interpreter;
+    std::istringstream program{
+        "(define (square x) (* x x))\n"
+        "(define (sum-squares l) (if (null? l) 0 (+ (square (car l)) (sum-squares (cdr l)))))\n"
+        "(sum-squares '(1 2 3))"};
+    REQUIRE(interpreter.RunProgram(program) == "14");
+    REQUIRE(interpreter.Run("(square 5)") == "25");
+
+    std::istringstream empty_program{"  \n "};
+    REQUIRE(interpreter.RunProgram(empty_program) == "()");
+
+    // the forms before an error are evaluated
+    std::istringstream failing_program{"(define y 1) (car '()) (define z 2)"};
+    REQUIRE_THROWS_AS(interpreter.RunProgram(failing_program), RuntimeError);
+    REQUIRE(interpreter.Run("y") == "1");
+    REQUIRE_THROWS_AS(interpreter.Run("z"), NameError);
+
+    std::istringstream broken_program{"(define w 1) (+ w"};
+    REQUIRE_THROWS_AS(interpreter.RunProgram(broken_program), SyntaxError);
+}
+
+TEST_CASE("RunLongProgram") {
+    Interpreter interpreter;
+    std::stringstream program;
+    program << "(define counter 0)\n";
+    for (size_t i = 0; i < 20000; ++i) {
+        program << "(set! counter (+ counter (list-ref (list 1 2 3 " << i << ") 1)))\n";
+    }
+    program << "counter";
+    REQUIRE(interpreter.RunProgram(program) == "40000");
+}
+
+TEST_CASE("RunFile") {
+    Interpreter interpreter;
+    REQUIRE_THROWS_AS(interpreter.RunFile("no/such/file.scm"), RuntimeError);
+
+    std::string path = std::filesystem::temp_directory_path() / "scheme_tidy_program.scm";
+    {
+        std::ofstream file{path};
+        file << "(define (fact n) (if (< n 2) 1 (* n (fact (- n 1)))))\n(fact 10)\n";
+    }
+    REQUIRE(interpreter.RunFile(path) == "3628800");
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("LongAndDeepForms") {
+    Interpreter interpreter;
+    std::string list = "'(";
+    for (size_t i = 0; i < 500000; ++i) {
+        list += std::to_string(i) + " ";
+    }
+    list += ")";
+    // the list is cloned by define and traced by every collection
+    REQUIRE(interpreter.Run("(define l " + list + ")") == "()");
+    REQUIRE(interpreter.Run("(list-ref l 499999)") == "499999");
+
+    std::string nested = "'" + std::string(100, '(') + std::string(100, ')');
+    REQUIRE(interpreter.Run(nested) == nested.substr(1));
+    interpreter.SetMaxReadDepth(50);
+    REQUIRE_THROWS_AS(interpreter.Run(nested), SyntaxError);
+    REQUIRE(interpreter.Run("(list-ref l 0)") == "0");
+}
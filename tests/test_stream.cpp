@@ -0,0 +1,124 @@
+#include "scheme_test.h"
+
+TEST_CASE_METHOD(SchemeTest, "DelayIsForcedOnce") {
+    ExpectNoError("(define calls 0)");
+    ExpectNoError("(define p (delay (begin (set! calls (+ calls 1)) (* 6 7))))");
+    ExpectEq("calls", "0");
+    ExpectEq("(promise? p)", "#t");
+    ExpectEq("(force p)", "42");
+    ExpectEq("(force p)", "42");
+    ExpectEq("calls", "1");
+
+    ExpectEq("(force (make-promise 5))", "5");
+    ExpectEq("(promise? (make-promise p))", "#t");
+    ExpectEq("(force 5)", "5");
+    ExpectEq("(promise? 5)", "#f");
+}
+
+TEST_CASE_METHOD(SchemeTest, "DelayCapturesContext") {
+    ExpectNoError("(define (make-counter-promise x) (delay (+ x 1)))");
+    ExpectNoError("(define p (make-counter-promise 10))");
+    ExpectNoError("(define x 100)");
+    ExpectEq("(force p)", "11");
+    ExpectEq("(let ((y 2)) (force (delay (* y 3))))", "6");
+}
+
+TEST_CASE_METHOD(SchemeTest, "StreamCons") {
+    ExpectNoError("(define (integers n) (stream-cons n (integers (+ n 1))))");
+    ExpectNoError("(define s (integers 1))");
+    ExpectEq("(stream-pair? s)", "#t");
+    ExpectEq("(stream-car s)", "1");
+    ExpectEq("(stream-car (stream-cdr (stream-cdr s)))", "3");
+    ExpectEq("(stream->list s 5)", "(1 2 3 4 5)");
+    ExpectEq("(stream-null? (stream-cdr (stream-cons 1 '())))", "#t");
+    ExpectEq("(stream-pair? '(1 2))", "#f");
+}
+
+TEST_CASE_METHOD(SchemeTest, "StreamsComputeOnlyWhatIsConsumed") {
+    ExpectNoError("(define calls 0)");
+    ExpectNoError("(define (square x) (set! calls (+ calls 1)) (* x x))");
+    ExpectNoError("(define s (stream-map square (stream-from 1)))");
+    ExpectEq("calls", "1");
+    ExpectEq("(stream->list (stream-take 3 s))", "(1 4 9)");
+    ExpectEq("calls", "3");
+    // forced elements are memoized
+    ExpectEq("(stream->list s 3)", "(1 4 9)");
+    ExpectEq("calls", "3");
+}
+
+TEST_CASE_METHOD(SchemeTest, "StreamPipelines") {
+    ExpectEq("(stream->list (stream-range 0 5))", "(0 1 2 3 4)");
+    ExpectEq("(stream->list (stream-range 10 0 -3))", "(10 7 4 1)");
+    ExpectEq("(stream->list (stream-range 0 0))", "()");
+    ExpectEq("(stream->list (stream-filter (lambda (x) (< 2 x)) (list->stream '(1 5 2 7))))",
+             "(5 7)");
+    ExpectEq("(stream-fold + 0 (stream-take 100 (stream-from 1)))", "5050");
+    ExpectEq("(stream-fold (lambda (acc x) (cons x acc)) '() (stream-range 0 3))", "(2 1 0)");
+
+    // producers over streams built with stream-cons
+    ExpectNoError("(define (evens n) (stream-cons n (evens (+ n 2))))");
+    ExpectEq("(stream->list (stream-map (lambda (x) (* x x)) (evens 0)) 4)", "(0 4 16 36)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "StreamsSurviveCollection") {
+    // every Run collects garbage, the suspended producers must keep their sources alive
+    ExpectNoError("(define s (stream-map (lambda (x) (+ x 1)) "
+                  "(stream-filter (lambda (x) (< 10 x)) (stream-from 0))))");
+    ExpectNoError("(define t (stream-cdr s))");
+    ExpectNoError("(define u (stream-cdr t))");
+    ExpectEq("(stream->list u 3)", "(14 15 16)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "LongStreamFolds") {
+    ExpectEq("(stream-fold + 0 (stream-map (lambda (x) (* 2 x)) (stream-range 0 300000)))",
+             "89999700000");
+    ExpectEq("(stream-fold (lambda (acc x) (list x (car acc))) '(0) (stream-range 0 300000))",
+             "(299999 299998)");
+    ExpectEq("(stream-fold (lambda (acc x) (+ acc (stream-fold + 0 (stream-range 0 x))))"
+             " 0 (stream-range 0 2000))",
+             "1331334000");
+
+    // the values stored by the folded function and the held streams are kept
+    ExpectNoError("(define last '())");
+    ExpectNoError("(define s (stream-range 0 200000))");
+    ExpectEq("(stream-fold (lambda (acc x) (set! last (list x)) (+ acc x)) 0 s)", "19999900000");
+    ExpectEq("last", "(199999)");
+    ExpectEq("(stream->list (stream-cdr s) 3)", "(1 2 3)");
+    ExpectEq("(stream-fold + 0 s)", "19999900000");
+
+    ExpectNoError("(define (integers n) (stream-cons n (integers (+ n 1))))");
+    ExpectEq("(stream-fold + 0 (stream-take 200000 (integers 0)))", "19999900000");
+}
+
+TEST_CASE_METHOD(SchemeTest, "StreamFoldKeepsArgumentsOfEnclosingCalls") {
+    // the pairs and the stream are held only by the arguments of probe when the fold runs
+    ExpectNoError("(define c (cons 1 2))");
+    ExpectNoError("(define (probe x n) (list (cdr x) n))");
+    ExpectEq("(probe c (stream-fold (lambda (a e) (if (= e 0) (begin (set-cdr! c (list 42 43 44))"
+             " (set! c 0))) (+ a 1)) 0 (stream-range 0 400000)))",
+             "((42 43 44) 400000)");
+
+    ExpectNoError("(define t (stream-range 0 3))");
+    ExpectNoError("(define (probe-stream s n) (list (stream->list s) n))");
+    ExpectEq("(probe-stream t (stream-fold (lambda (a e) (if (= e 0) (begin (stream->list t)"
+             " (set! t 0))) (+ a 1)) 0 (stream-range 0 400000)))",
+             "((0 1 2) 400000)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "StreamsAndEscapes") {
+    ExpectEq("(call/ec (lambda (k) (stream-fold (lambda (acc x) (if (< 3 x) (k acc) (+ acc x)))"
+             " 0 (stream-from 1))))",
+             "6");
+    ExpectEq("(call/ec (lambda (k) (force (delay (k 1)))))", "1");
+}
+
+TEST_CASE_METHOD(SchemeTest, "StreamErrors") {
+    ExpectSyntaxError("(delay)");
+    ExpectSyntaxError("(stream-cons 1)");
+    ExpectRuntimeError("(stream-car '(1 2))");
+    ExpectRuntimeError("(stream-cdr '())");
+    ExpectRuntimeError("(stream-range 0 5 0)");
+    ExpectRuntimeError("(stream-map car 5)");
+    ExpectRuntimeError("(list->stream '(1 . 2))");
+    ExpectRuntimeError("(stream->list (stream-map car (stream-range 0 2)))");
+}
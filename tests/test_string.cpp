@@ -0,0 +1,75 @@
+#include "scheme_test.h"
+
+TEST_CASE_METHOD(SchemeTest, "StringLiterals") {
+    ExpectEq("\"hello\"", "\"hello\"");
+    ExpectEq("\"\"", "\"\"");
+    ExpectEq(R"("a\"b\\c\nd\te")", R"("a\"b\\c\nd\te")");
+    ExpectEq(R"('("a b" c))", R"(("a b" c))");
+    ExpectEq("(string? \"a\")", "#t");
+    ExpectEq("(string? 'a)", "#f");
+
+    ExpectSyntaxError("\"abc");
+    ExpectSyntaxError(R"("a\qb")");
+}
+
+TEST_CASE_METHOD(SchemeTest, "StringFunctions") {
+    ExpectEq("(string-length \"hello\")", "5");
+    ExpectEq(R"((string-length "a\nb"))", "3");
+    ExpectEq("(string-append)", "\"\"");
+    ExpectEq("(string-append \"ab\" \"\" \"cd\")", "\"abcd\"");
+    ExpectEq("(substring \"hello\" 1 3)", "\"el\"");
+    ExpectEq("(substring \"hello\" 2)", "\"llo\"");
+    ExpectEq("(substring \"hello\" 5 5)", "\"\"");
+
+    ExpectRuntimeError("(substring \"hello\" 3 2)");
+    ExpectRuntimeError("(substring \"hello\" 0 6)");
+    ExpectRuntimeError("(string-append \"a\" 'b)");
+    ExpectRuntimeError("(string-length 'a)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "StringComparisons") {
+    ExpectEq("(string=? \"abc\" \"abc\")", "#t");
+    ExpectEq("(string=? \"abc\" \"abd\")", "#f");
+    ExpectEq("(string=? \"a\" \"a\" \"a\")", "#t");
+    ExpectEq("(string<? \"abc\" \"abd\")", "#t");
+    ExpectEq("(string<? \"ab\" \"abc\" \"b\")", "#t");
+    ExpectEq("(string<? \"b\" \"a\")", "#f");
+
+    ExpectRuntimeError("(string=? \"a\" 1)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "StringSymbolConversions") {
+    ExpectEq("(symbol->string 'abc)", "\"abc\"");
+    ExpectEq("(string->symbol \"abc\")", "abc");
+    ExpectEq("(symbol? (string->symbol \"abc\"))", "#t");
+
+    ExpectRuntimeError("(symbol->string \"abc\")");
+    ExpectRuntimeError("(string->symbol 'abc)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "LongStringsAreBuiltByAppends") {
+    ExpectNoError("(define s \"\")");
+    ExpectNoError("(define piece \"0123456789abcdefghijklmnopqrstuvwxyz\")");
+    ExpectNoError(
+        "(define (append-times n)"
+        "  (set! s (string-append s piece))"
+        "  (if (> n 1) (append-times (- n 1))))");
+    ExpectNoError("(append-times 1000)");
+    ExpectEq("(string-length s)", "36000");
+    ExpectEq("(substring s 35990 36000)", "\"qrstuvwxyz\"");
+    ExpectEq("(string=? (substring s 36 72) piece)", "#t");
+
+    ExpectNoError("(define t (string-append s s))");
+    ExpectEq("(string-length t)", "72000");
+    ExpectEq("(substring t 35999 36001)", "\"z0\"");
+}
+
+TEST_CASE_METHOD(SchemeTest, "StringsSharingBufferStayImmutable") {
+    ExpectNoError("(define base (string-append \"0123456789\" \"0123456789\"))");
+    ExpectNoError("(define a (string-append base \"a\"))");
+    ExpectNoError("(define b (string-append base \"b\"))");
+    ExpectEq("a", "\"01234567890123456789a\"");
+    ExpectEq("b", "\"01234567890123456789b\"");
+    ExpectEq("base", "\"01234567890123456789\"");
+    ExpectEq("(string-append a a)", "\"01234567890123456789a01234567890123456789a\"");
+}
@@ -2,8 +2,11 @@
 
 #include <error.h>
 #include <tokenizer.h>
+#include <char_kernels.h>
 
+#include <cctype>
 #include <sstream>
+#include <vector>
 
 TEST_CASE("Tokenizer works on simple case") {
     std::stringstream ss{"4+)'."};
@@ -70,6 +73,28 @@ TEST_CASE("Symbol names") {
     REQUIRE(tokenizer.GetToken() == Token{SymbolToken{"Am1good?"}});
 }
 
+TEST_CASE("Macro pattern symbols") {
+    std::stringstream ss{"(_ x ...) . _tmp"};
+    Tokenizer tokenizer{&ss};
+
+    REQUIRE(tokenizer.GetToken() == Token{BracketToken::OPEN});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{SymbolToken{"_"}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{SymbolToken{"x"}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{SymbolToken{"..."}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{BracketToken::CLOSE});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{DotToken{}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{SymbolToken{"_tmp"}});
+
+    std::stringstream wrong_ss{".."};
+    REQUIRE_THROWS_AS(Tokenizer{&wrong_ss}, SyntaxError);
+}
+
 TEST_CASE("GetToken is not moving") {
     std::stringstream ss{"1234+4"};
     Tokenizer tokenizer{&ss};
@@ -78,6 +103,95 @@ TEST_CASE("GetToken is not moving") {
     REQUIRE(tokenizer.GetToken() == Token{ConstantToken{1234}});
 }
 
+TEST_CASE("Big literals") {
+    std::stringstream ss{"-9223372036854775808 99999999999999999999 -99999999999999999999"};
+    Tokenizer tokenizer{&ss};
+
+    REQUIRE(tokenizer.GetToken() == Token{ConstantToken{INT64_MIN}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{BigConstantToken{"99999999999999999999"}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{BigConstantToken{"-99999999999999999999"}});
+}
+
+TEST_CASE("Vector literals") {
+    std::stringstream ss{"#(1) #t"};
+    Tokenizer tokenizer{&ss};
+
+    REQUIRE(tokenizer.GetToken() == Token{VectorOpenToken{}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{ConstantToken{1}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{BracketToken::CLOSE});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{SymbolToken{"#t"}});
+}
+
+TEST_CASE("String literals") {
+    std::stringstream ss{R"("a b" "q\"\\\n" x)"};
+    Tokenizer tokenizer{&ss};
+
+    REQUIRE(tokenizer.GetToken() == Token{StringToken{"a b"}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{StringToken{"q\"\\\n"}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{SymbolToken{"x"}});
+}
+
+TEST_CASE("Float literals") {
+    std::stringstream ss{"1.5 -2. 1e3 +2.5E-1 (1 . 2)"};
+    Tokenizer tokenizer{&ss};
+
+    REQUIRE(tokenizer.GetToken() == Token{FloatConstantToken{1.5}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{FloatConstantToken{-2.0}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{FloatConstantToken{1000.0}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{FloatConstantToken{0.25}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{BracketToken::OPEN});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{ConstantToken{1}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{DotToken{}});
+}
+
+TEST_CASE("Float literals without integer digits") {
+    std::string source = ".5 -.5 +.25e1 (1 . 2) (- .x) (-. 3) -.";
+    std::stringstream ss{source};
+    Tokenizer stream_tokenizer{&ss};
+    Tokenizer buffer_tokenizer{std::string_view(source)};
+    std::vector<Token> expected = {FloatConstantToken{0.5},
+                                   FloatConstantToken{-0.5},
+                                   FloatConstantToken{2.5},
+                                   BracketToken::OPEN,
+                                   ConstantToken{1},
+                                   DotToken{},
+                                   ConstantToken{2},
+                                   BracketToken::CLOSE,
+                                   BracketToken::OPEN,
+                                   SymbolToken{"-"},
+                                   DotToken{},
+                                   SymbolToken{"x"},
+                                   BracketToken::CLOSE,
+                                   BracketToken::OPEN,
+                                   SymbolToken{"-"},
+                                   DotToken{},
+                                   ConstantToken{3},
+                                   BracketToken::CLOSE,
+                                   SymbolToken{"-"},
+                                   DotToken{}};
+    for (const Token& token : expected) {
+        REQUIRE(stream_tokenizer.GetToken() == token);
+        REQUIRE(buffer_tokenizer.GetToken() == token);
+        stream_tokenizer.Next();
+        buffer_tokenizer.Next();
+    }
+    REQUIRE(stream_tokenizer.IsEnd());
+    REQUIRE(buffer_tokenizer.IsEnd());
+}
+
 TEST_CASE("Tokenizer is streaming") {
     std::stringstream ss;
     ss << "2 ";
@@ -153,3 +267,93 @@ TEST_CASE("Empty string handled correctly") {
 
     REQUIRE(tokenizer.IsEnd());
 }
+
+TEST_CASE("Tokenizer over a buffer") {
+    std::string source = "(define (f x) '(1.5 -2 99999999999999999999 #(\"s\\n\") . ...)) ";
+    std::stringstream ss{source};
+    Tokenizer stream_tokenizer{&ss};
+    Tokenizer buffer_tokenizer{std::string_view(source)};
+
+    // both backends give the same tokens
+    while (!stream_tokenizer.IsEnd()) {
+        REQUIRE(!buffer_tokenizer.IsEnd());
+        REQUIRE(buffer_tokenizer.GetToken() == stream_tokenizer.GetToken());
+        stream_tokenizer.Next();
+        buffer_tokenizer.Next();
+    }
+    REQUIRE(buffer_tokenizer.IsEnd());
+
+    REQUIRE(Tokenizer{std::string_view("   ")}.IsEnd());
+    REQUIRE_THROWS_AS(Tokenizer{std::string_view("..")}, SyntaxError);
+    REQUIRE_THROWS_AS(Tokenizer{std::string_view("\"abc")}, SyntaxError);
+    REQUIRE_THROWS_AS(Tokenizer{std::string_view("1e")}, SyntaxError);
+}
+
+TEST_CASE("Symbol names are not copied") {
+    std::string source = "alpha beta";
+    Tokenizer tokenizer{std::string_view(source)};
+    std::string_view name = std::get<SymbolToken>(tokenizer.GetToken()).GetName();
+    REQUIRE(name == "alpha");
+    REQUIRE(name.data() == source.data());
+
+    // names read from a stream outlive the tokenizer's lexeme
+    std::stringstream ss{"gamma gamma"};
+    Tokenizer stream_tokenizer{&ss};
+    std::string_view first = std::get<SymbolToken>(stream_tokenizer.GetToken()).GetName();
+    stream_tokenizer.Next();
+    std::string_view second = std::get<SymbolToken>(stream_tokenizer.GetToken()).GetName();
+    REQUIRE(first == "gamma");
+    REQUIRE(first.data() == second.data());
+}
+
+TEST_CASE("Char classes agree with the C locale") {
+    for (int c = 0; c < 128; ++c) {
+        REQUIRE(IsAlphabet(c) == static_cast<bool>(std::isalpha(c)));
+        REQUIRE(IsDigit(c) == static_cast<bool>(std::isdigit(c)));
+        REQUIRE(IsSpace(c) == static_cast<bool>(std::isspace(c)));
+    }
+    for (int c = 128; c < 256; ++c) {
+        REQUIRE(kCharClasses[c] == 0);
+    }
+}
+
+TEST_CASE("Char kernels agree with scalar ones") {
+    const CharKernels& kernels = GetCharKernels();
+    const CharKernels& scalar = GetScalarCharKernels();
+    // runs of every length around the chunk sizes, ended by chars of every other kind
+    std::string run_chars[] = {" \t\n\r\v\f", "0123456789", "az<=>*/#_-?!AZ09"};
+    std::string stop_chars = "()'.\"+,;[\x7f\x80\xff";
+    for (const std::string& chars : run_chars) {
+        for (size_t length = 0; length < 70; ++length) {
+            for (char stop_char : stop_chars) {
+                std::string data;
+                for (size_t i = 0; i < length; ++i) {
+                    data.push_back(chars[i % chars.size()]);
+                }
+                data.push_back(stop_char);
+                for (size_t size : {length, length + 1}) {
+                    REQUIRE(kernels.skip_spaces(data.data(), size) ==
+                            scalar.skip_spaces(data.data(), size));
+                    REQUIRE(kernels.skip_digits(data.data(), size) ==
+                            scalar.skip_digits(data.data(), size));
+                    REQUIRE(kernels.skip_symbol_chars(data.data(), size) ==
+                            scalar.skip_symbol_chars(data.data(), size));
+                }
+            }
+        }
+    }
+    std::string symbol(100, 'x');
+    REQUIRE(kernels.skip_symbol_chars(symbol.data(), symbol.size()) == 100);
+    REQUIRE(kernels.skip_spaces(symbol.data(), symbol.size()) == 0);
+}
+
+TEST_CASE("Long runs in a buffer") {
+    std::string name(1000, 'a');
+    std::string source = std::string(100, ' ') + name + "\n\t " + std::string(50, '7') + "  ";
+    Tokenizer tokenizer{std::string_view(source)};
+    REQUIRE(tokenizer.GetToken() == Token{SymbolToken{name}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.GetToken() == Token{BigConstantToken{std::string(50, '7')}});
+    tokenizer.Next();
+    REQUIRE(tokenizer.IsEnd());
+}
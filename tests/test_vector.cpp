@@ -0,0 +1,85 @@
+#include "scheme_test.h"
+
+TEST_CASE_METHOD(SchemeTest, "VectorLiterals") {
+    ExpectEq("#(1 2 3)", "#(1 2 3)");
+    ExpectEq("#()", "#()");
+    ExpectEq("#(1 (2 3) #(a) #t)", "#(1 (2 3) #(a) #t)");
+    ExpectEq("'#(1 2)", "#(1 2)");
+
+    ExpectSyntaxError("#(1 2");
+    ExpectSyntaxError("#(1 . 2)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "VectorConstructors") {
+    ExpectEq("(vector)", "#()");
+    ExpectEq("(vector 1 (+ 1 1) 'a)", "#(1 2 a)");
+    ExpectEq("(make-vector 3)", "#(0 0 0)");
+    ExpectEq("(make-vector 2 'x)", "#(x x)");
+    ExpectEq("(make-vector 0)", "#()");
+
+    ExpectRuntimeError("(make-vector -1)");
+    ExpectRuntimeError("(make-vector 'a)");
+    ExpectRuntimeError("(make-vector)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "VectorAccess") {
+    ExpectNoError("(define v (vector 1 2 3))");
+    ExpectEq("(vector-length v)", "3");
+    ExpectEq("(vector-ref v 0)", "1");
+    ExpectEq("(vector-ref v 2)", "3");
+
+    ExpectNoError("(vector-set! v 1 '(4 5))");
+    ExpectEq("v", "#(1 (4 5) 3)");
+    ExpectEq("(vector-ref v 1)", "(4 5)");
+
+    ExpectRuntimeError("(vector-ref v 3)");
+    ExpectRuntimeError("(vector-ref v -1)");
+    ExpectRuntimeError("(vector-ref '(1 2) 0)");
+    ExpectRuntimeError("(vector-set! v 'a 1)");
+    ExpectRuntimeError("(vector-length 1)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "VectorConversions") {
+    ExpectEq("(vector->list #(1 2 3))", "(1 2 3)");
+    ExpectEq("(vector->list #())", "()");
+    ExpectEq("(list->vector '(1 2 3))", "#(1 2 3)");
+    ExpectEq("(list->vector '())", "#()");
+
+    ExpectRuntimeError("(list->vector '(1 . 2))");
+    ExpectRuntimeError("(vector->list '(1 2))");
+}
+
+TEST_CASE_METHOD(SchemeTest, "VectorPredicate") {
+    ExpectEq("(vector? #(1))", "#t");
+    ExpectEq("(vector? '(1))", "#f");
+    ExpectEq("(pair? #(1))", "#f");
+}
+
+TEST_CASE_METHOD(SchemeTest, "VectorIsSharedByReference") {
+    ExpectNoError("(define v (make-vector 2))");
+    ExpectNoError("(define w v)");
+    ExpectNoError("(define (fill! vec x) (vector-set! vec 0 x) (vector-set! vec 1 x))");
+    ExpectNoError("(fill! w 7)");
+    ExpectEq("v", "#(7 7)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "VectorElementsSurviveCollection") {
+    ExpectNoError("(define v (make-vector 3))");
+    ExpectNoError("(vector-set! v 0 (list 1 2))");
+    ExpectNoError("(vector-set! v 2 v)");
+    // the list is kept by the vector only, so it must survive collections
+    ExpectEq("(list 1 2 3)", "(1 2 3)");
+    ExpectEq("(vector-ref v 0)", "(1 2)");
+    ExpectEq("(vector-ref (vector-ref v 2) 0)", "(1 2)");
+}
+
+TEST_CASE_METHOD(SchemeTest, "SharedVectorSurvivesRebinding") {
+    ExpectNoError("(define v (vector 1 2))");
+    ExpectNoError("(define w v)");
+    // w still keeps the vector once v is bound to something else
+    ExpectNoError("(define v 2)");
+    ExpectEq("(list 1 2 3)", "(1 2 3)");
+    ExpectEq("w", "#(1 2)");
+    ExpectNoError("(set! w 3)");
+    ExpectEq("(list w v)", "(3 2)");
+}
@@ -1,5 +1,10 @@
 #include "tokenizer.h"
 
+#include <cstdlib>
+
+#include "char_kernels.h"
+#include "symbol_table.h"
+
 bool SymbolToken::operator==(const SymbolToken& other) const {
     return name == other.name;
 }
@@ -16,52 +21,208 @@ bool ConstantToken::operator==(const ConstantToken& other) const {
     return value == other.value;
 }
 
-Tokenizer::Tokenizer(std::istream* in) {
-    token_stream_ = in;
+bool BigConstantToken::operator==(const BigConstantToken& other) const {
+    return digits == other.digits;
+}
+
+bool FloatConstantToken::operator==(const FloatConstantToken& other) const {
+    return value == other.value;
+}
+
+bool VectorOpenToken::operator==(const VectorOpenToken&) const {
+    return true;
+}
+
+bool StringToken::operator==(const StringToken& other) const {
+    return value == other.value;
+}
+
+Tokenizer::Tokenizer(std::istream* in) : token_stream_(in) {
     Next();
 }
 
-void Tokenizer::ProcessPlusMinusToken(char cur_char) {
-    std::string cur_token_string;
-    cur_token_string.push_back(cur_char);
-    while (IsDigit(token_stream_->peek())) {
-        cur_char = token_stream_->get();
-        cur_token_string.push_back(cur_char);
-    }
-    if (cur_token_string.size() == 1) {
-        last_processed_token_ = SymbolToken{cur_token_string};
+Tokenizer::Tokenizer(std::string_view source) : source_(source) {
+    Next();
+}
+
+void Tokenizer::StartLexeme(char first_char) {
+    if (token_stream_) {
+        lexeme_.assign(1, first_char);
+    } else {
+        lexeme_start_ = position_ - 1;
+    }
+}
+
+void Tokenizer::TakeChar() {
+    if (token_stream_) {
+        lexeme_.push_back(token_stream_->get());
     } else {
-        last_processed_token_ = ConstantToken{std::stoi(cur_token_string)};
+        ++position_;
+    }
+}
+
+void Tokenizer::UntakeChar() {
+    if (token_stream_) {
+        token_stream_->unget();
+        lexeme_.pop_back();
+    } else {
+        --position_;
+    }
+}
+
+std::string_view Tokenizer::GetLexeme() {
+    if (token_stream_) {
+        return lexeme_;
+    }
+    return source_.substr(lexeme_start_, position_ - lexeme_start_);
+}
+
+std::string_view Tokenizer::GetSymbolName() {
+    if (token_stream_) {
+        return InternSymbolName(lexeme_);
+    }
+    return GetLexeme();
+}
+
+void Tokenizer::ProcessPlusMinusToken(char cur_char) {
+    StartLexeme(cur_char);
+    if (IsDot(PeekChar())) {
+        // a number like -.5, otherwise the sign is a symbol followed by a dot
+        TakeChar();
+        if (IsDigit(PeekChar())) {
+            ReadNumberDigits();
+            SetConstantToken(GetLexeme());
+            return;
+        }
+        UntakeChar();
+    }
+    if (!IsDigit(PeekChar())) {
+        last_processed_token_ = SymbolToken{GetSymbolName()};
+        return;
     }
+    ReadNumberDigits();
+    SetConstantToken(GetLexeme());
 }
 
 void Tokenizer::ProcessConstantToken(char cur_char) {
-    std::string cur_token_string;
-    cur_token_string.push_back(cur_char);
-    while (IsDigit(token_stream_->peek())) {
-        cur_char = token_stream_->get();
-        cur_token_string.push_back(cur_char);
+    StartLexeme(cur_char);
+    ReadNumberDigits();
+    SetConstantToken(GetLexeme());
+}
+
+void Tokenizer::ReadNumberDigits() {
+    auto read_digits = [this]() {
+        if (!token_stream_) {
+            SkipRun(DIGIT_CLASS, GetCharKernels().skip_digits);
+            return;
+        }
+        while (IsDigit(PeekChar())) {
+            TakeChar();
+        }
+    };
+    read_digits();
+    if (IsDot(PeekChar())) {
+        TakeChar();
+        read_digits();
+    }
+    if (PeekChar() == 'e' || PeekChar() == 'E') {
+        TakeChar();
+        if (IsPlus(PeekChar()) || IsMinus(PeekChar())) {
+            TakeChar();
+        }
+        if (!IsDigit(PeekChar())) {
+            throw SyntaxError("Exponent of a number must have digits.");
+        }
+        read_digits();
+    }
+}
+
+void Tokenizer::SetConstantToken(std::string_view digits) {
+    // from_chars doesn't accept the plus sign
+    size_t start = (IsPlus(digits[0])) ? 1 : 0;
+    const char* first = digits.data() + start;
+    const char* last = digits.data() + digits.size();
+    if (digits.find_first_of(".eE") != std::string_view::npos) {
+        double value = 0;
+        if (std::from_chars(first, last, value).ec == std::errc::result_out_of_range) {
+            // strtod gives infinity or zero for too large or too small exponents
+            value = std::strtod(std::string(digits).c_str(), nullptr);
+        }
+        last_processed_token_ = FloatConstantToken{value};
+        return;
+    }
+    int64_t value = 0;
+    if (std::from_chars(first, last, value).ec == std::errc::result_out_of_range) {
+        last_processed_token_ = BigConstantToken{std::string(digits)};
+    } else {
+        last_processed_token_ = ConstantToken{value};
     }
-    last_processed_token_ = ConstantToken{std::stoll(cur_token_string)};
 }
 
 void Tokenizer::ProcessSymbolToken(char cur_char) {
-    std::string cur_token_string;
-    cur_token_string.push_back(cur_char);
-    while (IsPartOfSymbol(token_stream_->peek())) {
-        cur_char = token_stream_->get();
-        cur_token_string.push_back(cur_char);
+    StartLexeme(cur_char);
+    if (!token_stream_) {
+        SkipRun(PART_OF_SYMBOL_CLASS, GetCharKernels().skip_symbol_chars);
+    }
+    while (IsPartOfSymbol(PeekChar())) {
+        TakeChar();
     }
-    last_processed_token_ = SymbolToken{cur_token_string};
+    last_processed_token_ = SymbolToken{GetSymbolName()};
+}
+
+void Tokenizer::ProcessDotToken() {
+    if (IsDigit(PeekChar())) {
+        StartLexeme(DotChar);
+        ReadNumberDigits();
+        SetConstantToken(GetLexeme());
+        return;
+    } else if (!IsDot(PeekChar())) {
+        last_processed_token_ = DotToken{};
+        return;
+    }
+    GetChar();
+    if (!IsDot(GetChar())) {
+        throw SyntaxError("Cannot tokenize. Wrong syntax.");
+    }
+    last_processed_token_ = SymbolToken{kEllipsisName};
+}
+
+void Tokenizer::ProcessStringToken() {
+    std::string value;
+    while (true) {
+        int cur_char = GetChar();
+        if (cur_char == std::char_traits<char>::eof()) {
+            throw SyntaxError("String literal must be closed.");
+        } else if (cur_char == DoubleQuoteChar) {
+            break;
+        } else if (cur_char == BackslashChar) {
+            int escaped_char = GetChar();
+            if (escaped_char == 'n') {
+                value.push_back('\n');
+            } else if (escaped_char == 't') {
+                value.push_back('\t');
+            } else if (escaped_char == DoubleQuoteChar || escaped_char == BackslashChar) {
+                value.push_back(escaped_char);
+            } else {
+                throw SyntaxError("Unknown escape sequence in a string literal.");
+            }
+        } else {
+            value.push_back(cur_char);
+        }
+    }
+    last_processed_token_ = StringToken{std::move(value)};
 }
 
 void Tokenizer::Next() {
     if (is_end_) {
         throw SyntaxError("Wrong syntax!");
     }
-    char cur_char = token_stream_->get();
+    if (!token_stream_) {
+        SkipRun(SPACE_CLASS, GetCharKernels().skip_spaces);
+    }
+    char cur_char = GetChar();
     while (IsSpace(cur_char)) {
-        cur_char = token_stream_->get();
+        cur_char = GetChar();
     }
     if (cur_char == std::char_traits<char>::eof()) {
         is_end_ = true;
@@ -74,7 +235,12 @@ void Tokenizer::Next() {
     } else if (IsCloseBracket(cur_char)) {
         last_processed_token_ = BracketToken::CLOSE;
     } else if (IsDot(cur_char)) {
-        last_processed_token_ = DotToken{};
+        ProcessDotToken();
+    } else if (cur_char == DoubleQuoteChar) {
+        ProcessStringToken();
+    } else if (cur_char == PoundChar && IsOpenBracket(PeekChar())) {
+        GetChar();
+        last_processed_token_ = VectorOpenToken{};
     } else if (IsPlus(cur_char) || IsMinus(cur_char)) {
         ProcessPlusMinusToken(cur_char);
     } else if (IsDigit(cur_char)) {
@@ -1,10 +1,15 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <variant>
 #include <optional>
 #include <istream>
 #include <string>
+#include <string_view>
 #include <cctype>
+#include <charconv>
 
 #include "error.h"
 
@@ -23,42 +28,93 @@ enum AllowedChars : char {
     ExclamationSignChar = '!',
     QuestionSignChar = '?',
     SpaceChar = ' ',
+    DoubleQuoteChar = '"',
+    BackslashChar = '\\',
+    UnderscoreChar = '_',
 };
 
-bool IsOpenBracket(const char c);
-
-bool IsCloseBracket(const char c);
-
-bool IsDot(const char c);
-
-bool IsMinus(const char c);
-
-bool IsPlus(const char c);
-
-bool IsQuote(const char c);
-
-bool IsAsterix(const char c);
+// The only symbol with dots, used by patterns of syntax-rules
+const std::string kEllipsisName = "...";
+
+constexpr bool IsOpenBracket(const char c) {
+    return c == OpenBracketChar;
+}
+
+constexpr bool IsCloseBracket(const char c) {
+    return c == CloseBracketChar;
+}
+
+constexpr bool IsDot(const char c) {
+    return c == DotChar;
+}
+
+constexpr bool IsMinus(const char c) {
+    return c == MinusChar;
+}
+
+constexpr bool IsPlus(const char c) {
+    return c == PlusChar;
+}
+
+constexpr bool IsQuote(const char c) {
+    return c == QuoteChar;
+}
+
+constexpr bool IsAsterix(const char c) {
+    return c == AsterixChar;
+}
+
+constexpr bool IsSlash(const char c) {
+    return c == SlashChar;
+}
+
+constexpr bool IsComparisonSign(const char c) {
+    return LessSignChar <= c && c <= GreaterSignChar;
+}
+
+// Classes of chars, looked up in a table instead of chains of comparisons and locale calls.
+// Bytes outside of ASCII belong to none of them.
+enum CharClass : uint8_t {
+    ALPHABET_CLASS = 1 << 0,
+    DIGIT_CLASS = 1 << 1,
+    SPACE_CLASS = 1 << 2,
+    START_OF_SYMBOL_CLASS = 1 << 3,
+    PART_OF_SYMBOL_CLASS = 1 << 4,
+};
 
-bool IsSlash(const char c);
+extern const std::array<uint8_t, 256> kCharClasses;
 
-bool IsAlphabet(const char c);
+inline bool HasCharClass(const char c, CharClass char_class) {
+    return kCharClasses[static_cast<unsigned char>(c)] & char_class;
+}
 
-bool IsDigit(const char c);
+inline bool IsAlphabet(const char c) {
+    return HasCharClass(c, ALPHABET_CLASS);
+}
 
-bool IsSpace(const char c);
+inline bool IsDigit(const char c) {
+    return HasCharClass(c, DIGIT_CLASS);
+}
 
-bool IsComparisonSign(const char c);
+inline bool IsSpace(const char c) {
+    return HasCharClass(c, SPACE_CLASS);
+}
 
-bool IsStartOfSymbol(const char c);
+inline bool IsStartOfSymbol(const char c) {
+    return HasCharClass(c, START_OF_SYMBOL_CLASS);
+}
 
-bool IsPartOfSymbol(const char c);
+inline bool IsPartOfSymbol(const char c) {
+    return HasCharClass(c, PART_OF_SYMBOL_CLASS);
+}
 
+// The name is a view into the tokenizer's buffer or an interned name (see symbol_table.h)
 struct SymbolToken {
-    const std::string& GetName() const {
+    std::string_view GetName() const {
         return name;
     }
     bool operator==(const SymbolToken& other) const;
-    std::string name;
+    std::string_view name;
 };
 
 struct QuoteToken {
@@ -77,12 +133,43 @@ struct ConstantToken {
     bool operator==(const ConstantToken& other) const;
 };
 
-using Token = std::variant<ConstantToken, BracketToken, SymbolToken, QuoteToken, DotToken>;
+// Integer literal which doesn't fit into int64_t
+struct BigConstantToken {
+    std::string digits;
+
+    bool operator==(const BigConstantToken& other) const;
+};
+
+// Decimal literal with a fraction or an exponent: 1.5, -2., 1e-3
+struct FloatConstantToken {
+    double value;
+
+    bool operator==(const FloatConstantToken& other) const;
+};
+
+// Opening of a vector literal: #(
+struct VectorOpenToken {
+    bool operator==(const VectorOpenToken&) const;
+};
 
+// String literal, escapes are already replaced: "a\"b\n"
+struct StringToken {
+    std::string value;
+
+    bool operator==(const StringToken& other) const;
+};
+
+using Token = std::variant<ConstantToken, BracketToken, SymbolToken, QuoteToken, DotToken,
+                           BigConstantToken, FloatConstantToken, VectorOpenToken, StringToken>;
+
+// Reads tokens from a stream, or from a contiguous buffer without copying: names of
+// symbols are then views into the buffer, which must outlive the tokens.
 class Tokenizer {
 public:
     Tokenizer(std::istream* in);
 
+    explicit Tokenizer(std::string_view source);
+
     bool IsEnd() {
         return is_end_;
     }
@@ -95,9 +182,66 @@ public:
 
 private:
     bool is_end_ = false;
-    std::istream* token_stream_;
+    // null for a buffer
+    std::istream* token_stream_ = nullptr;
+    std::string_view source_;
+    size_t position_ = 0;
+    // the current number or symbol: its start in the buffer or a copy of the stream's chars
+    size_t lexeme_start_ = 0;
+    std::string lexeme_;
     Token last_processed_token_;
+
+    int PeekChar() {
+        if (token_stream_) {
+            return token_stream_->peek();
+        }
+        if (position_ == source_.size()) {
+            return std::char_traits<char>::eof();
+        }
+        return std::char_traits<char>::to_int_type(source_[position_]);
+    }
+
+    int GetChar() {
+        if (token_stream_) {
+            return token_stream_->get();
+        }
+        int cur_char = PeekChar();
+        position_ += (position_ < source_.size());
+        return cur_char;
+    }
+
+    // Moves the buffer's position past the run of chars of the class. Most runs are short and
+    // are scanned right here, only the rest of a long one is left to the kernel, which scans
+    // many chars at a time (see char_kernels.h).
+    void SkipRun(CharClass char_class, size_t (*skip)(const char* data, size_t size)) {
+        constexpr size_t kInlineRunLength = 16;
+        size_t end = std::min(source_.size(), position_ + kInlineRunLength);
+        while (position_ < end && HasCharClass(source_[position_], char_class)) {
+            ++position_;
+        }
+        if (position_ == end) {
+            position_ += skip(source_.data() + position_, source_.size() - position_);
+        }
+    }
+
+    // Starts the lexeme with the char which has just been read
+    void StartLexeme(char first_char);
+    // Moves the next char into the lexeme
+    void TakeChar();
+    // Puts the last taken char back
+    void UntakeChar();
+    std::string_view GetLexeme();
+    // Names read from a stream are interned, since the lexeme is overwritten by the next one
+    std::string_view GetSymbolName();
+
     void ProcessPlusMinusToken(char cur_char);
     void ProcessConstantToken(char cur_char);
+    // Reads the digits of a literal after its first character
+    void ReadNumberDigits();
+    void SetConstantToken(std::string_view digits);
     void ProcessSymbolToken(char cur_char);
+    // A single dot, the ellipsis or a number like .5
+    void ProcessDotToken();
+    // Reads a string literal after its opening quote
+    void ProcessStringToken();
 };
\ No newline at end of file
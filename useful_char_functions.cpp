@@ -1,58 +1,25 @@
 #include "tokenizer.h"
 
-bool IsOpenBracket(const char c) {
-    return c == OpenBracketChar;
-}
-
-bool IsCloseBracket(const char c) {
-    return c == CloseBracketChar;
-}
-
-bool IsDot(const char c) {
-    return c == DotChar;
-}
-
-bool IsMinus(const char c) {
-    return c == MinusChar;
-}
-
-bool IsPlus(const char c) {
-    return c == PlusChar;
-}
-
-bool IsQuote(const char c) {
-    return c == QuoteChar;
-}
-
-bool IsAsterix(const char c) {
-    return c == AsterixChar;
-}
-
-bool IsSlash(const char c) {
-    return c == SlashChar;
-}
-
-bool IsAlphabet(const char c) {
-    return std::isalpha(c);
-}
-
-bool IsDigit(const char c) {
-    return std::isdigit(c);
-}
-
-bool IsSpace(const char c) {
-    return std::isspace(c);
-}
-
-bool IsComparisonSign(const char c) {
-    return LessSignChar <= c && c <= GreaterSignChar;
-}
-
-bool IsStartOfSymbol(const char c) {
-    return IsAlphabet(c) || IsComparisonSign(c) || IsAsterix(c) || IsSlash(c) || c == PoundChar;
-}
-
-bool IsPartOfSymbol(const char c) {
-    return IsStartOfSymbol(c) || IsDigit(c) || IsMinus(c) || c == QuestionSignChar ||
-           c == ExclamationSignChar;
-}
\ No newline at end of file
+// Same as the classification of the "C" locale
+static constexpr uint8_t ClassifyChar(char c) {
+    bool is_alphabet = ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z');
+    bool is_digit = '0' <= c && c <= '9';
+    bool is_space = c == SpaceChar || ('\t' <= c && c <= '\r');
+    bool is_start_of_symbol = is_alphabet || IsComparisonSign(c) || IsAsterix(c) || IsSlash(c) ||
+                              c == PoundChar || c == UnderscoreChar;
+    bool is_part_of_symbol = is_start_of_symbol || is_digit || IsMinus(c) ||
+                             c == QuestionSignChar || c == ExclamationSignChar;
+    return (is_alphabet ? ALPHABET_CLASS : 0) | (is_digit ? DIGIT_CLASS : 0) |
+           (is_space ? SPACE_CLASS : 0) | (is_start_of_symbol ? START_OF_SYMBOL_CLASS : 0) |
+           (is_part_of_symbol ? PART_OF_SYMBOL_CLASS : 0);
+}
+
+static constexpr std::array<uint8_t, 256> MakeCharClasses() {
+    std::array<uint8_t, 256> char_classes{};
+    for (size_t i = 0; i < char_classes.size(); ++i) {
+        char_classes[i] = ClassifyChar(static_cast<char>(i));
+    }
+    return char_classes;
+}
+
+const std::array<uint8_t, 256> kCharClasses = MakeCharClasses();